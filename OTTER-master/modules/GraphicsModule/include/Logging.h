@@ -43,5 +43,12 @@ private:
 #define LOG_WARN(...)  ::Logger::GetLogger()->warn(__VA_ARGS__)
 #define LOG_ERROR(...) { ::Logger::GetLogger()->error(__VA_ARGS__); ::Logger::GetLogger()->error("Location: \n{}", ::Logger::DumpStackTrace()); }
 
+// __debugbreak is MSVC only, other compilers get a trap instead so the toolkit can build on Linux
+#ifdef _MSC_VER
+#define LOG_DEBUG_BREAK() __debugbreak()
+#else
+#define LOG_DEBUG_BREAK() __builtin_trap()
+#endif
+
 // Allows us to assert if a value is true, and automagically debug break if it is false
-#define LOG_ASSERT(x, ...) { if (!(x)) { ::Logger::GetLogger()->error(__VA_ARGS__); __debugbreak(); } }
\ No newline at end of file
+#define LOG_ASSERT(x, ...) { if (!(x)) { ::Logger::GetLogger()->error(__VA_ARGS__); LOG_DEBUG_BREAK(); } }
\ No newline at end of file
@@ -3,7 +3,7 @@ NOU Framework - Created for INFR 2310 at Ontario Tech.
 (c) Samantha Stahlke 2020
 
 GLObjects.h
-Classes for managing OpenGL vertex buffers and vertex array objects.
+Classes for managing OpenGL vertex buffers, index buffers and vertex array objects.
 You'll be learning a LOT more about this in your graphics class.
 */
 
@@ -13,6 +13,7 @@ You'll be learning a LOT more about this in your graphics class.
 #include <vector>
 #include <map>
 #include <string>
+#include <type_traits>
 
 #include "glad/glad.h"
 
@@ -113,6 +114,92 @@ namespace nou
 		bool m_dynamic;
 	};
 
+	//Class for managing OpenGL Index Buffers (also called Element Buffers or EBOs).
+	//An index buffer stores a list of which vertices make up each face, so that
+	//vertices shared between faces only need to be stored (and shaded) once.
+	//Indices can be 8, 16, or 32-bit - smaller indices save memory and bandwidth,
+	//but can only refer to up to 256 or 65536 vertices respectively.
+	//As with VertexBuffer, this class is intended to be used via pointers.
+	class IndexBuffer
+	{
+		public:
+
+		template<typename T>
+		IndexBuffer(const std::vector<T>& data, bool dynamic = false)
+		{
+			m_len = 0;
+			m_elementSize = 0;
+			m_type = GL_UNSIGNED_INT;
+			m_dynamic = dynamic;
+
+			glGenBuffers(1, &m_id);
+			UpdateData(data);
+		}
+
+		~IndexBuffer()
+		{
+			glDeleteBuffers(1, &m_id);
+		}
+
+		IndexBuffer(const IndexBuffer&) = delete;
+
+		//The number of indices in our buffer.
+		GLsizei Length() const { return m_len; }
+
+		//The size of a single index in bytes.
+		GLsizei ElementSize() const { return m_elementSize; }
+
+		//The OpenGL type of our indices (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT).
+		GLenum IndexType() const { return m_type; }
+
+		GLuint GetID() const { return m_id; }
+
+		//This uploads the indices specified into our OpenGL buffer on the GPU.
+		//T must be GLubyte, GLushort or GLuint.
+		template<typename T>
+		void UpdateData(const std::vector<T>& data)
+		{
+			static_assert(std::is_same_v<T, GLubyte> || std::is_same_v<T, GLushort> || std::is_same_v<T, GLuint>,
+						  "Indices must be GLubyte, GLushort or GLuint!");
+
+			m_len = (GLsizei)data.size();
+			m_elementSize = sizeof(T);
+
+			if constexpr (std::is_same_v<T, GLubyte>)
+				m_type = GL_UNSIGNED_BYTE;
+			else if constexpr (std::is_same_v<T, GLushort>)
+				m_type = GL_UNSIGNED_SHORT;
+			else
+				m_type = GL_UNSIGNED_INT;
+
+			GLenum usage = (m_dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+
+			//The element buffer binding is part of whichever VAO is bound,
+			//so we unbind our VAO first to avoid changing some other object's indices.
+			glBindVertexArray(0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_len * m_elementSize, 
+						 (m_len > 0) ? &(data[0]) : nullptr, usage);
+		}
+
+		protected:
+
+		//The OpenGL ID of our EBO.
+		GLuint m_id;
+
+		//The number of indices in our buffer.
+		GLsizei m_len;
+
+		//The size of a single index in bytes.
+		GLsizei m_elementSize;
+
+		//The OpenGL type of a single index.
+		GLenum m_type;
+
+		//Whether we expect to update this data frequently.
+		bool m_dynamic;
+	};
+
 	//Class for managing OpenGL Vertex Array Objects (VAOs).
 	//Just as with VertexBuffer, as written, this class is intended to be used via pointers.
 	class VertexArray
@@ -136,6 +223,7 @@ namespace nou
 			m_drawMode = DrawMode::TRIANGLES;
 			glGenVertexArrays(1, &m_id);
 			m_len = 0;
+			m_ibo = nullptr;
 		}
 
 		~VertexArray()
@@ -240,6 +328,17 @@ namespace nou
 														 (long long)buf.ElementSize()));
 		}
 
+		//This associates an IndexBuffer with our vertex array object.
+		//Once we have indices, Draw() will draw the faces they describe instead of
+		//drawing our vertices in order. Passing nullptr goes back to drawing in order.
+		void BindIndices(const IndexBuffer* buf)
+		{
+			m_ibo = buf;
+
+			glBindVertexArray(m_id);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (buf != nullptr) ? buf->GetID() : 0);
+		}
+
 		void SetDrawMode(DrawMode drawMode)
 		{
 			m_drawMode = drawMode;
@@ -247,9 +346,16 @@ namespace nou
 
 		void Draw()
 		{
-			m_len = m_vbos.begin()->second->Length();
-
 			glBindVertexArray(m_id);
+
+			//If we have an index buffer, OpenGL will read our indices from it directly.
+			if (m_ibo != nullptr)
+			{
+				glDrawElements((int)m_drawMode, m_ibo->Length(), m_ibo->IndexType(), nullptr);
+				return;
+			}
+
+			m_len = m_vbos.begin()->second->Length();
 			glDrawArrays((int)m_drawMode, 0, m_len);
 		}
 
@@ -275,6 +381,9 @@ namespace nou
 
 		//A record of the VBOs associated with this VAO.
 		std::map<GLint, const VertexBuffer*> m_vbos;
+
+		//The index buffer associated with this VAO, if any.
+		const IndexBuffer* m_ibo;
 	};
 }
 
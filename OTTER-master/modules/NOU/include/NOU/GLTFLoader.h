@@ -28,6 +28,8 @@ namespace nou::GLTF
 		size_t len;
 		int stride;
 		int elementSize;
+		//The TINYGLTF_COMPONENT_TYPE of each component (e.g., float, unsigned short).
+		int componentType;
 	};
 
 	//Loads a 3D model into the mesh object given.
@@ -41,17 +43,21 @@ namespace nou::GLTF
 	bool ParseGLTF(const std::string& filename, tinygltf::Model& gltf,
 				   std::string& err, std::string& warn);
 
-	//Takes a glTF model and extracts vertex positions, normals, and texture coordinates.
+	//Takes a glTF model and extracts vertex positions, normals, texture coordinates, and indices.
 	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
 					     std::string& err, std::string& warn);
 
+	//Appends the vertices of a primitive, and its indices offset to point at them.
 	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex, 
 					      std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
-						  std::vector<glm::vec3>& normals, bool flipUVY,
-						  bool& hasNormals, bool& hasUVs,
+						  std::vector<glm::vec3>& normals, std::vector<GLuint>& indices,
+						  bool flipUVY, bool& hasNormals, bool& hasUVs,
 						  std::string& err, std::string& warn);
 
 	//Utility functions for more easily accessing data stored in glTF buffers.
 	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name);
+	//Returns a getter with null data if the accessor can't be read.
 	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex);
+	//Reads an 8, 16, or 32-bit unsigned index from an index accessor.
+	size_t ReadIndex(const DataGetter& getter, size_t i);
 }
\ No newline at end of file
@@ -41,18 +41,46 @@ namespace nou
 		void SetNormals(const std::vector<glm::vec3>& normals);
 		void SetUVs(const std::vector<glm::vec2>& uvs);
 
+		//Sets the list of vertices that make up each face.
+		//The indices are stored on the GPU as 16-bit values if they all fit,
+		//or 32-bit values otherwise.
+		//Passing an empty list goes back to drawing the vertices in order.
+		void SetIndices(const std::vector<GLuint>& indices);
+
 		//Fetches a vertex buffer associated with the desired attribute.
 		//Used by mesh rendering components to grab the requisite data
 		//associated with this model in OpenGL.
 		const VertexBuffer* GetVBO(Attrib attrib) const;
 
+		//Fetches the index buffer for this mesh, or nullptr if the mesh is not indexed.
+		const IndexBuffer* GetIBO() const { return m_ibo.get(); }
+
+		size_t GetVertexCount() const { return m_verts.size(); }
+		size_t GetIndexCount() const { return m_indices.size(); }
+
 		protected:
 
 		std::vector<glm::vec3> m_verts;
 		std::vector<glm::vec3> m_normals;
 		std::vector<glm::vec2> m_uvs;
+		std::vector<GLuint> m_indices;
 
 		std::map<Attrib, std::unique_ptr<VertexBuffer>> m_vbo;
+		std::unique_ptr<IndexBuffer> m_ibo;
+
+		//Sets up the IndexBuffer with the indices converted to the given type.
+		template<typename T>
+		void SetIBO()
+		{
+			std::vector<T> data(m_indices.begin(), m_indices.end());
+
+			//We can't change the type of an existing buffer's indices in place,
+			//but UpdateData will take care of that for us.
+			if (m_ibo == nullptr)
+				m_ibo = std::make_unique<IndexBuffer>(data);
+			else
+				m_ibo->UpdateData(data);
+		}
 
 		//Sets up a VertexBuffer for the desired attribute.
 		template<typename T>
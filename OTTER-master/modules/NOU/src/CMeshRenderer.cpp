@@ -48,6 +48,9 @@ namespace nou
 
 		if ((vbo = mesh.GetVBO(Mesh::Attrib::UV)) != nullptr)
 			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::UV);
+
+		//If the mesh is indexed, we'll draw through its index buffer.
+		m_vao->BindIndices(mesh.GetIBO());
 	}
 
 	void CMeshRenderer::SetMaterial(Material& mat)
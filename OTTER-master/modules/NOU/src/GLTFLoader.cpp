@@ -9,6 +9,7 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 
 #include "NOU/GLTFLoader.h"
 
+#include <cstring>
 #include <sstream>
 
 #include "tiny_gltf.h"
@@ -60,7 +61,7 @@ namespace nou::GLTF
 
 		std::string tinygltfErr, tinygltfWarn;
 
-		size_t extIndex = filename.find('.');
+		size_t extIndex = filename.rfind('.');
 		
 		if (extIndex == std::string::npos || extIndex >= filename.length() - 1)
 		{
@@ -122,12 +123,13 @@ namespace nou::GLTF
 		std::vector<glm::vec3> verts;
 		std::vector<glm::vec3> normals;
 		std::vector<glm::vec2> uvs;
+		std::vector<GLuint> indices;
 
 		bool hasNormals = true, hasUVs = true;
 
 		for (size_t i = 0; i < meshData.primitives.size(); ++i)
 		{
-			if(!ProcessPrimitive(gltf, i, verts, uvs, normals, 
+			if(!ProcessPrimitive(gltf, i, verts, uvs, normals, indices,
 						         flipUVY, hasNormals, hasUVs, err, warn))
 				return false;
 		}
@@ -140,37 +142,22 @@ namespace nou::GLTF
 		if(hasUVs)
 			mesh.SetUVs(uvs);
 
+		mesh.SetIndices(indices);
+
 		return true;
 	}
 
 	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex,
 		                  std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
-		                  std::vector<glm::vec3>& normals, bool flipUVY,
-						  bool& hasNormals, bool& hasUVs,
+		                  std::vector<glm::vec3>& normals, std::vector<GLuint>& indices,
+						  bool flipUVY, bool& hasNormals, bool& hasUVs,
 		                  std::string& err, std::string& warn)
 	{
-		const tinygltf::Primitive geom = gltf.meshes[0].primitives[geomIndex];
-
-		if (geom.indices == -1)
-		{
-			err = "File is missing primitive indices. "\
-				"Consider changing your GLTF export settings, or else this loader " \
-				"must be augmented to support files without indices.";
-
-			return false;
-		}
-
-		//glTF stores data per-vertex.
-		//This indexer will allow us to access the data that tells
-		//us which vertices make up the faces of the object.
-		//This allows us to specify our data in the order we need it
-		//for OpenGL vertex buffers - in other words, spelling out the vertex
-		//data as a set of triangles.
-		DataGetter faceIndexer = BuildGetter(gltf, geom.indices);
+		const tinygltf::Primitive& geom = gltf.meshes[0].primitives[geomIndex];
 
-		if (faceIndexer.elementSize != sizeof(GLshort))
+		if (geom.mode != -1 && geom.mode != TINYGLTF_MODE_TRIANGLES)
 		{
-			err = "Primitive indices are in a currently unsupported format. " \
+			err = "Primitive " + std::to_string(geomIndex) + " is not made of triangles. " \
 				"Consider changing your GLTF export settings, or else this loader " \
 				"must be augmented to support the provided format.";
 
@@ -201,7 +188,9 @@ namespace nou::GLTF
 
 		vGetter = BuildGetter(gltf, vID);
 
-		if (vGetter.elementSize != sizeof(glm::vec3))
+		if (vGetter.data == nullptr ||
+			vGetter.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+			vGetter.elementSize != sizeof(glm::vec3))
 		{
 			err = "Vertex position data is in a currently unsupported format. " \
 				"Consider changing your GLTF export settings, or else this loader " \
@@ -214,7 +203,10 @@ namespace nou::GLTF
 		{
 			nGetter = BuildGetter(gltf, nID);
 
-			if (nGetter.elementSize != sizeof(glm::vec3))
+			if (nGetter.data == nullptr ||
+				nGetter.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+				nGetter.elementSize != sizeof(glm::vec3) ||
+				nGetter.len != vGetter.len)
 			{
 				hasNormals = false;
 				warn += "\nNormal data is in a currently unsupported format. " \
@@ -228,7 +220,10 @@ namespace nou::GLTF
 		{
 			uvGetter = BuildGetter(gltf, uvID);
 
-			if (uvGetter.elementSize != sizeof(glm::vec2))
+			if (uvGetter.data == nullptr ||
+				uvGetter.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+				uvGetter.elementSize != sizeof(glm::vec2) ||
+				uvGetter.len != vGetter.len)
 			{
 				hasUVs = false;
 				warn += "\nUV data is in a currently unsupported format. " \
@@ -237,36 +232,37 @@ namespace nou::GLTF
 			}
 		}
 
-		size_t startIndex = verts.size();
+		//glTF stores data per-vertex, and each primitive has its own list of vertices.
+		//We keep the vertices as they are, and append them to the vertices of the
+		//primitives before this one. That way vertices shared between faces are only
+		//stored (and run through the vertex shader) once.
+		size_t startVert = verts.size();
 
-		verts.resize(verts.size() + faceIndexer.len);
+		verts.resize(startVert + vGetter.len);
 
 		if (hasNormals)
-			normals.resize(normals.size() + faceIndexer.len);
+			normals.resize(startVert + vGetter.len);
 
 		if (hasUVs)
-			uvs.resize(uvs.size() + faceIndexer.len);
+			uvs.resize(startVert + vGetter.len);
 
-		//This is the bit where we actually get to extracting our data.
-		for (size_t i = startIndex, f = 0; i < startIndex + faceIndexer.len && f < faceIndexer.len; ++i, ++f)
+		//Accessors can be interleaved with other data, so we always step by the stride
+		//rather than assuming the data is tightly packed.
+		for (size_t v = 0; v < vGetter.len; ++v)
 		{
-			//What vertex do we need to look at?
-			GLshort vertIndex;
-			memcpy(&vertIndex, &faceIndexer.data[f * faceIndexer.stride], sizeof(GLshort));
-
-			size_t vert = vertIndex;
+			size_t i = startVert + v;
 
 			//Grab our vertex position.
-			memcpy(&verts[i], &vGetter.data[vert * vGetter.stride], sizeof(glm::vec3));
+			memcpy(&verts[i], &vGetter.data[v * vGetter.stride], sizeof(glm::vec3));
 
 			//Grab our vertex normal.
 			if (hasNormals)
-				memcpy(&normals[i], &nGetter.data[vert * nGetter.stride], sizeof(glm::vec3));
+				memcpy(&normals[i], &nGetter.data[v * nGetter.stride], sizeof(glm::vec3));
 
 			//Grab our texture coordinates.
 			if (hasUVs)
 			{
-				memcpy(&uvs[i], &uvGetter.data[vert * uvGetter.stride], sizeof(glm::vec2));
+				memcpy(&uvs[i], &uvGetter.data[v * uvGetter.stride], sizeof(glm::vec2));
 
 				//We may need to flip our vertical UV-coordinate.
 				//You will probably need to do this, depending on your export settings/texture.
@@ -275,9 +271,77 @@ namespace nou::GLTF
 			}
 		}
 
+		//Primitives without indices just use each vertex once, in order.
+		if (geom.indices == -1)
+		{
+			for (size_t v = 0; v < vGetter.len; ++v)
+				indices.push_back(static_cast<GLuint>(startVert + v));
+
+			return true;
+		}
+
+		//The indices tell us which vertices make up the faces of the object.
+		//They can be stored as 8, 16, or 32-bit unsigned integers.
+		DataGetter faceIndexer = BuildGetter(gltf, geom.indices);
+
+		if (faceIndexer.data == nullptr ||
+			(faceIndexer.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+			 faceIndexer.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT &&
+			 faceIndexer.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT))
+		{
+			err = "Primitive indices are in a currently unsupported format. " \
+				"Consider changing your GLTF export settings, or else this loader " \
+				"must be augmented to support the provided format.";
+
+			return false;
+		}
+
+		size_t startIndex = indices.size();
+		indices.resize(startIndex + faceIndexer.len);
+
+		for (size_t f = 0; f < faceIndexer.len; ++f)
+		{
+			size_t vert = ReadIndex(faceIndexer, f);
+
+			if (vert >= vGetter.len)
+			{
+				err = "Primitive " + std::to_string(geomIndex) + " has an index out of range.";
+				return false;
+			}
+
+			//The indices are relative to this primitive's vertices,
+			//so we offset them by the vertices of the primitives before it.
+			indices[startIndex + f] = static_cast<GLuint>(startVert + vert);
+		}
+
 		return true;
 	}
 
+	size_t ReadIndex(const DataGetter& getter, size_t i)
+	{
+		const unsigned char* src = &getter.data[i * getter.stride];
+
+		switch (getter.componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				return *src;
+
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				GLushort index;
+				memcpy(&index, src, sizeof(GLushort));
+				return index;
+			}
+
+			default:
+			{
+				GLuint index;
+				memcpy(&index, src, sizeof(GLuint));
+				return index;
+			}
+		}
+	}
+
 	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name)
 	{
 		auto it = geom.attributes.find(name);
@@ -291,15 +355,29 @@ namespace nou::GLTF
 	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex)
 	{
 		const tinygltf::Accessor& acc = gltf.accessors[accIndex];
+
+		//Accessors without a buffer view (e.g., sparse accessors that are all zero)
+		//aren't supported, so we hand back an empty getter.
+		if (acc.bufferView < 0 || acc.bufferView >= (int)gltf.bufferViews.size())
+			return { nullptr, 0, 0, 0, acc.componentType };
+
 		const tinygltf::BufferView& bv = gltf.bufferViews[acc.bufferView];
 		const tinygltf::Buffer& buf = gltf.buffers[bv.buffer];
 
-		const unsigned char* data = &(buf.data[bv.byteOffset + acc.byteOffset]);
 		size_t len = acc.count;
 		int stride = acc.ByteStride(bv);
 		int size = tinygltf::GetComponentSizeInBytes(acc.componentType) *
 				   tinygltf::GetNumComponentsInType(acc.type);
 
-		return { data, len, stride, size };
+		//Make sure the last element actually fits in the buffer before we hand out a pointer.
+		size_t start = bv.byteOffset + acc.byteOffset;
+
+		if (stride <= 0 || size <= 0 ||
+			(len > 0 && start + (len - 1) * stride + size > buf.data.size()))
+			return { nullptr, 0, 0, 0, acc.componentType };
+
+		const unsigned char* data = buf.data.data() + start;
+
+		return { data, len, stride, size, acc.componentType };
 	}
 }
\ No newline at end of file
@@ -8,6 +8,8 @@ Very basic class for managing the data associated with a 3D model.
 
 #include "NOU/Mesh.h"
 
+#include <algorithm>
+
 namespace nou
 {
 	void Mesh::SetVerts(const std::vector<glm::vec3>& verts)
@@ -28,6 +30,27 @@ namespace nou
 		SetVBO(Attrib::UV, 2, m_uvs);
 	}
 
+	void Mesh::SetIndices(const std::vector<GLuint>& indices)
+	{
+		m_indices = indices;
+
+		if (m_indices.size() == 0)
+		{
+			m_ibo = nullptr;
+			return;
+		}
+
+		//Smaller indices mean less memory and bandwidth, so we use 16-bit
+		//indices whenever every index fits. (8-bit indices are valid too, but
+		//many GPUs have to convert them on the fly, so they aren't worth it.)
+		GLuint maxIndex = *std::max_element(m_indices.begin(), m_indices.end());
+
+		if (maxIndex <= 0xFFFF)
+			SetIBO<GLushort>();
+		else
+			SetIBO<GLuint>();
+	}
+
 	const VertexBuffer* Mesh::GetVBO(Mesh::Attrib attrib) const
 	{
 		auto it = m_vbo.find(attrib);
@@ -35,8 +35,12 @@ void Logger::Init(const LoggerSettings& settings) {
 		myLogger->set_level(spdlog::level::trace);
 		// The default color for trace is the same as info, so we get our color output
 		auto console_sink = dynamic_cast<spdlog::sinks::stdout_color_sink_mt*>(myLogger->sinks().back().get());
-		// and make trace cyan instead
+		// and make trace cyan instead (the Windows console sink uses attributes, the ANSI one uses escape codes)
+		#ifdef WINDOWS
 		console_sink->set_color(spdlog::level::trace, console_sink->CYAN);
+		#else
+		console_sink->set_color(spdlog::level::trace, console_sink->cyan);
+		#endif
 
 		#ifdef WINDOWS 
 		// Get the process handle
@@ -0,0 +1,125 @@
+-- Standalone build of the Week 11 asset import benchmark (the sample's --bench-assets mode, see src/main.cpp)
+
+-- The sample itself only builds through the root Premake5.lua on Windows, since it needs GLFW, ImGui and opengl32.
+-- This workspace only builds the loaders and the libraries they use. It has no GLFW or windowing, and it only links
+-- against OpenGL if --with-egl is given, so it can build and run headless on Linux
+--
+-- Usage (from this folder):
+--   premake5 gmake2 [--with-egl]
+--   make -C build config=release
+--   bin/Release/AssetBenchmark [directory] [output.json] [--upload] [--no-synthetic]
+--
+-- --upload needs a build made with --with-egl, which times the GL uploads through a surfaceless EGL context
+
+newoption {
+	trigger     = "with-egl",
+	description = "Adds the GL upload phase to the benchmark, through a headless EGL context (Linux only)"
+}
+
+-- The root of the OTTER repository, and the source folder of the Week 11 sample
+local rootDir = path.getabsolute("../../../..")
+local sampleDir = path.getabsolute("../src")
+
+workspace "AssetBenchmark"
+	architecture "x64"
+	location "build"
+
+	configurations {
+		"Debug",
+		"Release"
+	}
+
+project "AssetBenchmark"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir "bin/%{cfg.buildcfg}"
+	objdir "obj/%{cfg.buildcfg}"
+
+	-- Only the parts of the sample the benchmark uses, the rest of Utilities pulls in the scene and GLFW
+	files {
+		"src/**.cpp",
+		sampleDir .. "/Benchmarks/AssetImportBenchmark.cpp",
+		sampleDir .. "/Graphics/IBuffer.cpp",
+		sampleDir .. "/Graphics/ITexture.cpp",
+		sampleDir .. "/Graphics/MeshletSet.cpp",
+		sampleDir .. "/Graphics/PixelUploadRing.cpp",
+		sampleDir .. "/Graphics/Texture2D.cpp",
+		sampleDir .. "/Graphics/Texture2DData.cpp",
+		sampleDir .. "/Graphics/TextureCubeMap.cpp",
+		sampleDir .. "/Graphics/TextureCubeMapData.cpp",
+		sampleDir .. "/Graphics/VertexArrayObject.cpp",
+		sampleDir .. "/Utilities/AssetPack.cpp",
+		sampleDir .. "/Utilities/BcEncoder.cpp",
+		sampleDir .. "/Utilities/MemoryMappedFile.cpp",
+		sampleDir .. "/Utilities/MemoryStats.cpp",
+		sampleDir .. "/Utilities/MeshCache.cpp",
+		sampleDir .. "/Utilities/MeshFactory.cpp",
+		sampleDir .. "/Utilities/MeshOptimizer.cpp",
+		sampleDir .. "/Utilities/MeshSimplifier.cpp",
+		sampleDir .. "/Utilities/MeshletBuilder.cpp",
+		sampleDir .. "/Utilities/MipGenerator.cpp",
+		sampleDir .. "/Utilities/NotObjLoader.cpp",
+		sampleDir .. "/Utilities/ObjLoader.cpp",
+		sampleDir .. "/Utilities/TangentGenerator.cpp",
+		sampleDir .. "/Utilities/TextureContainer.cpp",
+		sampleDir .. "/Utilities/TextureCooker.cpp",
+		sampleDir .. "/Utilities/TextureRegistry.cpp",
+		sampleDir .. "/Utilities/VertexPacking.cpp",
+		sampleDir .. "/Utilities/VertexTypes.cpp",
+		sampleDir .. "/Utilities/VirtualFileSystem.cpp",
+		-- Glad is only the table of GL function pointers, nothing gets loaded into it unless we're uploading
+		rootDir .. "/dependencies/glad/src/glad.c",
+		rootDir .. "/dependencies/spdlog/src/*.cpp",
+		rootDir .. "/dependencies/stbs/stb_impl.cpp",
+		rootDir .. "/dependencies/tinygltf/tiny_gltf_impl.cpp",
+		rootDir .. "/modules/NOU/src/GLTFLoader.cpp",
+		rootDir .. "/modules/NOU/src/Mesh.cpp",
+		rootDir .. "/modules/toolkit/src/Logging.cpp"
+	}
+
+	includedirs {
+		sampleDir,
+		rootDir .. "/dependencies/glad/include",
+		rootDir .. "/dependencies/GLM/include",
+		rootDir .. "/dependencies/stbs",
+		rootDir .. "/dependencies/spdlog/include",
+		rootDir .. "/dependencies/gzip",
+		rootDir .. "/dependencies/tinygltf",
+		rootDir .. "/dependencies/json",
+		rootDir .. "/modules/toolkit/include",
+		rootDir .. "/modules/NOU/include"
+	}
+
+	defines {
+		"SPDLOG_COMPILED_LIB",
+		"_CRT_SECURE_NO_WARNINGS"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+		defines { "WINDOWS" }
+		links {
+			rootDir .. "/dependencies/gzip/zlib.lib",
+			"imagehlp.lib"
+		}
+
+	filter "system:linux"
+		links {
+			"z",
+			"pthread",
+			"dl"
+		}
+
+	filter { "system:linux", "options:with-egl" }
+		defines { "ASSET_BENCH_EGL" }
+		links { "EGL" }
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
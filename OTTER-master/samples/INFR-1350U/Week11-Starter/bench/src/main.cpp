@@ -0,0 +1,111 @@
+#include <Logging.h>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#ifdef ASSET_BENCH_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "Benchmarks/AssetImportBenchmark.h"
+
+// This is the standalone version of the sample's --bench-assets mode. It only builds the loaders and what they
+// need, with no GLFW or windowing, so it can run headless on a build machine. See premake5.lua for how to build it
+
+#ifdef ASSET_BENCH_EGL
+EGLDisplay display = EGL_NO_DISPLAY;
+EGLContext context = EGL_NO_CONTEXT;
+
+/// <summary>
+/// Makes an OpenGL 4.5 core context with no surface through EGL, so the upload phase can run without a window or
+/// display server (ex: over SSH or on a CI machine with Mesa)
+/// </summary>
+bool InitHeadlessGL() {
+	// The surfaceless platform doesn't need a display server, fall back to the default display if it's missing
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != nullptr) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API)) {
+		LOG_ERROR("Failed to initialize EGL (0x{:x})", eglGetError());
+		return false;
+	}
+
+	const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	eglChooseConfig(display, configAttribs, &config, 1, &configCount);
+
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		LOG_ERROR("Failed to create an OpenGL 4.5 context (0x{:x})", eglGetError());
+		return false;
+	}
+
+	if (gladLoadGLLoader((GLADloadproc)eglGetProcAddress) == 0) {
+		LOG_ERROR("Failed to initialize Glad");
+		return false;
+	}
+	LOG_INFO("Uploading with {} ({})", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	return true;
+}
+
+void ShutdownHeadlessGL() {
+	if (display != EGL_NO_DISPLAY) {
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (context != EGL_NO_CONTEXT) {
+			eglDestroyContext(display, context);
+		}
+		eglTerminate(display);
+	}
+}
+#else
+bool InitHeadlessGL() {
+	LOG_ERROR("This build has no GL upload phase, regenerate it with --with-egl to use --upload");
+	return false;
+}
+
+void ShutdownHeadlessGL() { }
+#endif
+
+// Usage: AssetBenchmark [directory] [output] [--upload] [--no-synthetic]
+int main(int argc, char** argv) {
+	Logger::Init();
+
+	AssetImportBenchmarkOptions options;
+	std::vector<std::string> paths;
+	for (int ix = 1; ix < argc; ix++) {
+		const std::string arg = argv[ix];
+		if (arg == "--upload") {
+			options.Upload = true;
+		} else if (arg == "--no-synthetic") {
+			options.SyntheticScales.clear();
+		} else {
+			paths.push_back(arg);
+		}
+	}
+	if (paths.size() > 0) {
+		options.ResourceDirectory = paths[0];
+	}
+	if (options.Upload && !InitHeadlessGL()) {
+		ShutdownHeadlessGL();
+		Logger::Uninitialize();
+		return 1;
+	}
+	const bool written = AssetImportBenchmark::Run(options, paths.size() > 1 ? paths[1] : "asset_benchmark.json");
+	if (options.Upload) {
+		ShutdownHeadlessGL();
+	}
+	Logger::Uninitialize();
+	return written ? 0 : 1;
+}
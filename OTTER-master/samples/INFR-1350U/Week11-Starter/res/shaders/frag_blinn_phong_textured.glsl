@@ -6,10 +6,17 @@ layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+layout(location = 4) in vec4 inTangent;
+layout(location = 5) flat in ivec4 inLayers;
 
-uniform sampler2D s_Diffuse;
+// Diffuse textures are packed into arrays (see TextureArrayPacker), this must be the first array set on the
+// material, so that its layer is in inLayers.x
+uniform sampler2DArray s_Diffuse;
 uniform sampler2D s_Diffuse2;
 uniform sampler2D s_Specular;
+// Tangent space normal map, only used for meshes with tangents (see qtangent.glsl)
+uniform sampler2D s_NormalMap;
+uniform float u_NormalMapStrength;
 
 uniform vec3  u_AmbientCol;
 uniform float u_AmbientStrength;
@@ -41,6 +48,8 @@ uniform vec3  u_CamPos;
 
 out vec4 frag_color;
 
+#include "qtangent.glsl"
+
 // https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
 void main() {
 	// Lecture 5
@@ -48,6 +57,12 @@ void main() {
 
 	// Diffuse
 	vec3 N = normalize(inNormal);
+	if (u_NormalMapStrength > 0.0 && inTangent.w != 0.0) {
+		vec3 tangentNormal = texture(s_NormalMap, inUV).xyz * 2.0 - 1.0;
+		tangentNormal.xy *= u_NormalMapStrength;
+		// MikkTSpace expects the interpolated vectors as-is, normalizing them first would skew the result
+		N = TangentToWorld(inNormal, inTangent, tangentNormal);
+	}
 	vec3 lightDir = normalize(u_LightPos - inPos);
 
 	float dif = max(dot(N, lightDir), 0.0);
@@ -77,7 +92,7 @@ void main() {
 	vec3 specular = u_SpecularLightStrength * texSpec * spec * u_LightCol; // Can also use a specular color
 
 	// Get the albedo from the diffuse / albedo map
-	vec4 textureColor1 = texture(s_Diffuse, inUV);
+	vec4 textureColor1 = texture(s_Diffuse, vec3(inUV, inLayers.x));
 	vec4 textureColor2 = texture(s_Diffuse2, inUV);
 	vec4 textureColor = mix(textureColor1, textureColor2, u_TextureMix);
 
@@ -0,0 +1,23 @@
+// Helpers for meshes that store their tangent frame as a QTangent (see VertexPackedPosQTangentTexCol), include this
+// with #include "qtangent.glsl". Matches VertexPacking::DecodeQTangent
+
+// Unpacks a QTangent into a normal and a tangent, with the bitangent sign in tangent.w
+void QTangentDecode(vec4 q, out vec3 normal, out vec4 tangent) {
+	q = normalize(q);
+	tangent = vec4(
+		1.0 - 2.0 * (q.y * q.y + q.z * q.z),
+		2.0 * (q.x * q.y + q.w * q.z),
+		2.0 * (q.x * q.z - q.w * q.y),
+		q.w < 0.0 ? -1.0 : 1.0);
+	normal = vec3(
+		2.0 * (q.x * q.z + q.w * q.y),
+		2.0 * (q.y * q.z - q.w * q.x),
+		1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+}
+
+// Takes a normal from a tangent space normal map into the same space as normal and tangent. The bitangent is
+// rebuilt the same way MikkTSpace does it, so maps from most bakers will line up
+vec3 TangentToWorld(vec3 normal, vec4 tangent, vec3 tangentNormal) {
+	vec3 bitangent = tangent.w * cross(normal, tangent.xyz);
+	return normalize(tangentNormal.x * tangent.xyz + tangentNormal.y * bitangent + tangentNormal.z * normal);
+}
@@ -2,31 +2,85 @@
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec3 inNormal;
+layout(location = 2) in vec4 inNormal;
 layout(location = 3) in vec2 inUV;
 
 layout(location = 0) out vec3 outPos;
 layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
+// World space tangent with the bitangent sign in w, all 0 if the mesh has no tangents
+layout(location = 4) out vec4 outTangent;
+// The texture array layers to sample from (see ShaderMaterial::Layers)
+layout(location = 5) flat out ivec4 outLayers;
 
+// The per instance data for instanced draws, this must match InstanceData in main.cpp
+#define MAX_INSTANCES 64
+struct InstanceData {
+	mat4  Model;
+	// Only the upper 3x3 is used, storing a mat4 keeps the std140 layout the same as the C++ side
+	mat4  NormalMatrix;
+	ivec4 Layers;
+};
+layout(std140) uniform b_Instances {
+	InstanceData Instances[MAX_INSTANCES];
+};
+// 1 if this is an instanced draw, in which case the model matrices and layers come from b_Instances
+uniform int  u_Instanced;
+
+uniform mat4 u_ViewProjection;
 uniform mat4 u_ModelViewProjection;
 uniform mat4 u_View;
 uniform mat4 u_Model;
 uniform mat3 u_NormalMatrix;
 uniform vec3 u_LightPos;
+// 1 if the mesh stores its normals as 2 component octahedral vectors (see VertexPacking.h)
+uniform int  u_OctahedralNormals;
+// 1 if the mesh stores a QTangent in place of its normal (see qtangent.glsl)
+uniform int  u_QTangents;
+// The material's texture array layers, for draws that aren't instanced
+uniform ivec4 u_Layers;
+
+#include "qtangent.glsl"
+
+// Unfolds a normal that was packed onto an octahedron back into a unit vector
+vec3 OctahedralDecode(vec2 e) {
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
 
 
 void main() {
 
-	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	mat4 model = u_Model;
+	mat3 normalMatrix = u_NormalMatrix;
+	outLayers = u_Layers;
+	if (u_Instanced != 0) {
+		model = Instances[gl_InstanceID].Model;
+		normalMatrix = mat3(Instances[gl_InstanceID].NormalMatrix);
+		outLayers = Instances[gl_InstanceID].Layers;
+		gl_Position = u_ViewProjection * model * vec4(inPosition, 1.0);
+	} else {
+		gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	}
 
 	// Lecture 5
 	// Pass vertex pos in world space to frag shader
-	outPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+	outPos = (model * vec4(inPosition, 1.0)).xyz;
 
 	// Normals
-	outNormal = u_NormalMatrix * inNormal;
+	vec3 normal;
+	vec4 tangent = vec4(0.0);
+	if (u_QTangents != 0) {
+		QTangentDecode(inNormal, normal, tangent);
+	} else {
+		normal = u_OctahedralNormals != 0 ? OctahedralDecode(inNormal.xy) : inNormal.xyz;
+	}
+	outNormal = normalMatrix * normal;
+	outTangent = vec4(mat3(model) * tangent.xyz, tangent.w);
 
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
@@ -0,0 +1,663 @@
+#include "AssetImportBenchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <glad/glad.h>
+#include <json.hpp>
+#include <stb_image_write.h>
+#include <tiny_gltf.h>
+#include <NOU/GLTFLoader.h>
+#include <NOU/Mesh.h>
+
+#include "Logging.h"
+#include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DData.h"
+#include "Graphics/TextureCubeMap.h"
+#include "Graphics/TextureCubeMapData.h"
+#include "Utilities/MemoryStats.h"
+#include "Utilities/NotObjLoader.h"
+#include "Utilities/ObjLoader.h"
+
+// Bump this whenever the layout of the JSON output changes, so tools comparing results can tell
+static constexpr int AssetBenchmarkFormatVersion = 1;
+
+// The suffixes TextureCubeMapData::LoadFromImages appends to the root path, in face order
+static const char* const CUBE_FACE_SUFFIXES[6] = { "_pos_x", "_neg_x", "_pos_y", "_neg_y", "_pos_z", "_neg_z" };
+
+/// <summary>
+/// The timings for one half (CPU or upload) of an asset's import, over every iteration
+/// </summary>
+struct ImportPhase
+{
+	double BestSeconds;
+	double TotalSeconds;
+	// The allocations made by the last iteration, these should be the same for every iteration
+	size_t Allocations;
+	size_t AllocatedBytes;
+	// The number of bytes the phase consumed, the source file for the CPU or the data sent to the GPU for the upload
+	size_t Bytes;
+
+	ImportPhase() :
+		BestSeconds(std::numeric_limits<double>::max()),
+		TotalSeconds(0.0),
+		Allocations(0),
+		AllocatedBytes(0),
+		Bytes(0)
+	{ }
+};
+
+/// <summary>
+/// Everything we measured for a single asset
+/// </summary>
+struct ImportResult
+{
+	std::string    Loader;
+	std::string    Path;
+	bool           Synthetic;
+	int            Iterations;
+	ImportPhase    Cpu;
+	ImportPhase    Upload;
+	size_t         PeakResidentBytes;
+	bool           PeakIsPerAsset;
+	nlohmann::json Output;
+	std::string    Error;
+};
+
+/// <summary>
+/// Loads an asset once, timing each phase into the result. Returns false if the loader did not produce anything
+/// </summary>
+typedef bool(*ImportFunc)(const std::string& path, bool upload, ImportResult& result);
+
+/// <summary>
+/// An asset to load, and the loader to load it with
+/// </summary>
+struct ImportCase
+{
+	const char* Loader;
+	ImportFunc  Load;
+	std::string Path;
+	size_t      Bytes;
+	bool        Synthetic;
+};
+
+/// <summary>
+/// Measures the wall time and allocations between its creation and the call to Stop
+/// </summary>
+class ImportPhaseTimer
+{
+public:
+	ImportPhaseTimer() :
+		_allocations(MemoryStats::GetAllocationCount()),
+		_allocatedBytes(MemoryStats::GetAllocatedBytes()),
+		_start(std::chrono::high_resolution_clock::now())
+	{ }
+
+	void Stop(ImportPhase& phase, size_t bytes) {
+		const auto end = std::chrono::high_resolution_clock::now();
+		const double seconds = std::chrono::duration<double>(end - _start).count();
+		phase.BestSeconds = std::min(phase.BestSeconds, seconds);
+		phase.TotalSeconds += seconds;
+		phase.Allocations = MemoryStats::GetAllocationCount() - _allocations;
+		phase.AllocatedBytes = MemoryStats::GetAllocatedBytes() - _allocatedBytes;
+		phase.Bytes = bytes;
+	}
+
+private:
+	size_t _allocations;
+	size_t _allocatedBytes;
+	std::chrono::high_resolution_clock::time_point _start;
+};
+
+/// <summary>
+/// Bakes a mesh into a VAO and waits for the GPU to finish with it, timing it as the upload phase
+/// </summary>
+template <typename VertType>
+void TimeMeshUpload(const MeshBuilder<VertType>& mesh, ImportResult& result) {
+	ImportPhaseTimer timer;
+	VertexArrayObject::sptr vao = mesh.Bake();
+	glFinish();
+	timer.Stop(result.Upload, mesh.GetVertexCount() * sizeof(VertType) + vao->GetIndexBuffer()->GetTotalSize());
+}
+
+bool ImportObj(const std::string& path, bool upload, ImportResult& result) {
+	// We want to time the parser, not the cooked mesh cache
+	ObjLoadOptions options;
+	options.UseCache = false;
+	MeshBuilder<VertexPosNormTexCol> mesh;
+
+	ImportPhaseTimer timer;
+	ObjLoader::LoadMeshData(path, mesh, options);
+	timer.Stop(result.Cpu, result.Cpu.Bytes);
+	result.Output = { { "vertices", mesh.GetVertexCount() }, { "indices", mesh.GetIndexCount() } };
+
+	if (mesh.GetVertexCount() == 0) {
+		return false;
+	}
+	if (upload) {
+		TimeMeshUpload(mesh, result);
+	}
+	return true;
+}
+
+bool ImportNotObj(const std::string& path, bool upload, ImportResult& result) {
+	NotObjLoadOptions options;
+	options.UseCache = false;
+	MeshBuilder<VertexPosNormTexCol> mesh;
+
+	ImportPhaseTimer timer;
+	NotObjLoader::LoadMeshData(path, mesh, options);
+	timer.Stop(result.Cpu, result.Cpu.Bytes);
+	result.Output = { { "vertices", mesh.GetVertexCount() }, { "indices", mesh.GetIndexCount() } };
+
+	if (mesh.GetVertexCount() == 0) {
+		return false;
+	}
+	if (upload) {
+		TimeMeshUpload(mesh, result);
+	}
+	return true;
+}
+
+bool ImportGltf(const std::string& path, bool upload, ImportResult& result) {
+	// nou::GLTF::LoadMesh parses and uploads in one go, so we run its two halves ourselves (ParseGLTF plus
+	// ProcessPrimitive is everything ExtractGeometry does before it hands the attributes to the mesh)
+	tinygltf::Model gltf;
+	std::string err, warn;
+	std::vector<glm::vec3> verts, normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<GLuint> indices;
+	bool hasNormals = true, hasUVs = true;
+
+	ImportPhaseTimer timer;
+	bool loaded = nou::GLTF::ParseGLTF(path, gltf, err, warn) && !gltf.meshes.empty();
+	for (size_t ix = 0; loaded && ix < gltf.meshes[0].primitives.size(); ix++) {
+		loaded = nou::GLTF::ProcessPrimitive(gltf, ix, verts, uvs, normals, indices, true, hasNormals, hasUVs, err, warn);
+	}
+	timer.Stop(result.Cpu, result.Cpu.Bytes);
+	result.Output = { { "vertices", verts.size() }, { "indices", indices.size() } };
+
+	if (!loaded || verts.empty()) {
+		if (!err.empty()) {
+			result.Error = err;
+		}
+		return false;
+	}
+	if (upload) {
+		size_t bytes = verts.size() * sizeof(glm::vec3);
+		bytes += hasNormals ? normals.size() * sizeof(glm::vec3) : 0;
+		bytes += hasUVs ? uvs.size() * sizeof(glm::vec2) : 0;
+		if (!indices.empty()) {
+			bytes += indices.size() * (*std::max_element(indices.begin(), indices.end()) <= 0xFFFF ? sizeof(GLushort) : sizeof(GLuint));
+		}
+
+		ImportPhaseTimer uploadTimer;
+		nou::Mesh mesh;
+		mesh.SetVerts(verts);
+		if (hasNormals) {
+			mesh.SetNormals(normals);
+		}
+		if (hasUVs) {
+			mesh.SetUVs(uvs);
+		}
+		mesh.SetIndices(indices);
+		glFinish();
+		uploadTimer.Stop(result.Upload, bytes);
+	}
+	return true;
+}
+
+bool ImportTexture2D(const std::string& path, bool upload, ImportResult& result) {
+	ImportPhaseTimer timer;
+	Texture2DData::sptr data = Texture2DData::LoadFromFile(path);
+	timer.Stop(result.Cpu, result.Cpu.Bytes);
+
+	if (data == nullptr) {
+		return false;
+	}
+	result.Output = { { "width", data->GetWidth() }, { "height", data->GetHeight() }, { "decoded_bytes", data->GetDataSize() } };
+	if (upload) {
+		ImportPhaseTimer uploadTimer;
+		Texture2D::sptr texture = Texture2D::Create();
+		texture->LoadData(data);
+		glFinish();
+		uploadTimer.Stop(result.Upload, data->GetDataSize());
+	}
+	return true;
+}
+
+bool ImportCubeMap(const std::string& path, bool upload, ImportResult& result) {
+	ImportPhaseTimer timer;
+	TextureCubeMapData::sptr data = TextureCubeMapData::LoadFromImages(path);
+	timer.Stop(result.Cpu, result.Cpu.Bytes);
+
+	if (data == nullptr) {
+		return false;
+	}
+	result.Output = { { "face_size", data->GetSize() }, { "decoded_bytes", data->GetDataSize() } };
+	if (upload) {
+		ImportPhaseTimer uploadTimer;
+		TextureCubeMap::sptr texture = TextureCubeMap::Create();
+		texture->LoadData(data);
+		glFinish();
+		uploadTimer.Stop(result.Upload, data->GetDataSize());
+	}
+	return true;
+}
+
+/// <summary>
+/// Gets the extension of a path in lower case
+/// </summary>
+std::string GetLowerExtension(const std::filesystem::path& path) {
+	std::string result = path.extension().string();
+	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return result;
+}
+
+/// <summary>
+/// Finds every asset under a directory that one of our loaders can load. The faces of cube maps are grouped
+/// into a single cube map load (by their _pos_x face), rather than being loaded as 2D textures
+/// </summary>
+void FindImportCases(const std::filesystem::path& directory, const std::filesystem::path& skip, bool synthetic, std::vector<ImportCase>& cases) {
+	namespace fs = std::filesystem;
+
+	std::error_code error;
+	for (fs::recursive_directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+		std::error_code skipError;
+		if (it->is_directory() && !skip.empty() && fs::equivalent(it->path(), skip, skipError)) {
+			it.disable_recursion_pending();
+			continue;
+		}
+		if (!it->is_regular_file()) {
+			continue;
+		}
+
+		const fs::path path = it->path().lexically_normal();
+		const std::string extension = GetLowerExtension(path);
+		const size_t bytes = static_cast<size_t>(it->file_size());
+		if (extension == ".obj") {
+			cases.push_back({ "ObjLoader", ImportObj, path.generic_string(), bytes, synthetic });
+		}
+		else if (extension == ".notobj") {
+			cases.push_back({ "NotObjLoader", ImportNotObj, path.generic_string(), bytes, synthetic });
+		}
+		else if (extension == ".gltf" || extension == ".glb") {
+			cases.push_back({ "nou::GLTF", ImportGltf, path.generic_string(), bytes, synthetic });
+		}
+		else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".tga") {
+			const std::string stem = path.stem().string();
+			const auto isFace = [&](const char* suffix) {
+				const size_t length = strlen(suffix);
+				return stem.size() > length && stem.compare(stem.size() - length, length, suffix) == 0;
+			};
+			if (!std::any_of(std::begin(CUBE_FACE_SUFFIXES), std::end(CUBE_FACE_SUFFIXES), isFace)) {
+				cases.push_back({ "Texture2DData", ImportTexture2D, path.generic_string(), bytes, synthetic });
+			}
+			else if (isFace(CUBE_FACE_SUFFIXES[0])) {
+				const std::string root = stem.substr(0, stem.size() - strlen(CUBE_FACE_SUFFIXES[0]));
+				size_t totalBytes = 0;
+				for (const char* suffix : CUBE_FACE_SUFFIXES) {
+					totalBytes += static_cast<size_t>(fs::file_size(path.parent_path() / (root + suffix + path.extension().string()), skipError));
+				}
+				cases.push_back({ "TextureCubeMapData", ImportCubeMap, (path.parent_path() / (root + path.extension().string())).generic_string(), totalBytes, synthetic });
+			}
+		}
+	}
+	if (error) {
+		LOG_WARN("Failed to list the files in \"{}\": {}", directory.string(), error.message());
+	}
+}
+
+/// <summary>
+/// Generates a wavy N x N quad grid, used for the synthetic OBJ and glTF inputs
+/// </summary>
+void BuildSyntheticGrid(uint32_t size, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices) {
+	const uint32_t rowLength = size + 1;
+	positions.reserve(rowLength * rowLength);
+	normals.reserve(rowLength * rowLength);
+	uvs.reserve(rowLength * rowLength);
+	for (uint32_t y = 0; y <= size; y++) {
+		for (uint32_t x = 0; x <= size; x++) {
+			const float fx = static_cast<float>(x) / size;
+			const float fy = static_cast<float>(y) / size;
+			const float height = 0.05f * std::sin(fx * 40.0f) * std::cos(fy * 30.0f);
+			const glm::vec3 slope = glm::vec3(2.0f * std::cos(fx * 40.0f) * std::cos(fy * 30.0f), -1.5f * std::sin(fx * 40.0f) * std::sin(fy * 30.0f), 0.0f);
+			positions.push_back(glm::vec3(fx * 2.0f - 1.0f, fy * 2.0f - 1.0f, height));
+			normals.push_back(glm::normalize(glm::vec3(-slope.x, -slope.y, 1.0f)));
+			uvs.push_back(glm::vec2(fx, fy));
+		}
+	}
+	indices.reserve(size * size * 6);
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			const uint32_t corner = y * rowLength + x;
+			indices.insert(indices.end(), { corner, corner + 1, corner + rowLength + 1, corner, corner + rowLength + 1, corner + rowLength });
+		}
+	}
+}
+
+bool WriteSyntheticObj(const std::string& path, uint32_t size) {
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<uint32_t> indices;
+	BuildSyntheticGrid(size, positions, normals, uvs, indices);
+
+	fmt::memory_buffer buffer;
+	fmt::format_to(buffer, "# Synthetic {}x{} grid for the asset import benchmark\n", size, size);
+	for (const glm::vec3& pos : positions) {
+		fmt::format_to(buffer, "v {:.6f} {:.6f} {:.6f}\n", pos.x, pos.y, pos.z);
+	}
+	for (const glm::vec2& uv : uvs) {
+		fmt::format_to(buffer, "vt {:.6f} {:.6f}\n", uv.x, uv.y);
+	}
+	for (const glm::vec3& normal : normals) {
+		fmt::format_to(buffer, "vn {:.6f} {:.6f} {:.6f}\n", normal.x, normal.y, normal.z);
+	}
+	for (size_t ix = 0; ix < indices.size(); ix += 3) {
+		const uint32_t a = indices[ix] + 1, b = indices[ix + 1] + 1, c = indices[ix + 2] + 1;
+		fmt::format_to(buffer, "f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", a, b, c);
+	}
+	std::ofstream stream(path, std::ios::binary);
+	stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	return static_cast<bool>(stream);
+}
+
+bool WriteSyntheticGlb(const std::string& path, uint32_t size) {
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<uint32_t> indices;
+	BuildSyntheticGrid(size, positions, normals, uvs, indices);
+
+	// Every attribute is a multiple of 4 bytes, so the views can be packed back to back
+	const size_t positionBytes = positions.size() * sizeof(glm::vec3);
+	const size_t normalBytes = normals.size() * sizeof(glm::vec3);
+	const size_t uvBytes = uvs.size() * sizeof(glm::vec2);
+	const size_t indexBytes = indices.size() * sizeof(uint32_t);
+	std::vector<char> bin;
+	bin.reserve(positionBytes + normalBytes + uvBytes + indexBytes);
+	bin.insert(bin.end(), reinterpret_cast<const char*>(positions.data()), reinterpret_cast<const char*>(positions.data()) + positionBytes);
+	bin.insert(bin.end(), reinterpret_cast<const char*>(normals.data()), reinterpret_cast<const char*>(normals.data()) + normalBytes);
+	bin.insert(bin.end(), reinterpret_cast<const char*>(uvs.data()), reinterpret_cast<const char*>(uvs.data()) + uvBytes);
+	bin.insert(bin.end(), reinterpret_cast<const char*>(indices.data()), reinterpret_cast<const char*>(indices.data()) + indexBytes);
+
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max()), max = glm::vec3(std::numeric_limits<float>::lowest());
+	for (const glm::vec3& pos : positions) {
+		min = glm::min(min, pos);
+		max = glm::max(max, pos);
+	}
+
+	nlohmann::json gltf;
+	gltf["asset"] = { { "version", "2.0" } };
+	gltf["buffers"] = { { { "byteLength", bin.size() } } };
+	gltf["bufferViews"] = {
+		{ { "buffer", 0 }, { "byteOffset", 0 }, { "byteLength", positionBytes }, { "target", 34962 } },
+		{ { "buffer", 0 }, { "byteOffset", positionBytes }, { "byteLength", normalBytes }, { "target", 34962 } },
+		{ { "buffer", 0 }, { "byteOffset", positionBytes + normalBytes }, { "byteLength", uvBytes }, { "target", 34962 } },
+		{ { "buffer", 0 }, { "byteOffset", positionBytes + normalBytes + uvBytes }, { "byteLength", indexBytes }, { "target", 34963 } }
+	};
+	gltf["accessors"] = {
+		{ { "bufferView", 0 }, { "componentType", 5126 }, { "count", positions.size() }, { "type", "VEC3" },
+			{ "min", { min.x, min.y, min.z } }, { "max", { max.x, max.y, max.z } } },
+		{ { "bufferView", 1 }, { "componentType", 5126 }, { "count", normals.size() }, { "type", "VEC3" } },
+		{ { "bufferView", 2 }, { "componentType", 5126 }, { "count", uvs.size() }, { "type", "VEC2" } },
+		{ { "bufferView", 3 }, { "componentType", 5125 }, { "count", indices.size() }, { "type", "SCALAR" } }
+	};
+	gltf["meshes"] = { { { "primitives", { { { "attributes", { { "POSITION", 0 }, { "NORMAL", 1 }, { "TEXCOORD_0", 2 } } }, { "indices", 3 } } } } } };
+	gltf["nodes"] = { { { "mesh", 0 } } };
+	gltf["scenes"] = { { { "nodes", { 0 } } } };
+	gltf["scene"] = 0;
+
+	// Chunks have to be 4 byte aligned, the JSON chunk is padded with spaces
+	std::string json = gltf.dump();
+	json.resize((json.size() + 3) & ~static_cast<size_t>(3), ' ');
+	const uint32_t header[3] = { 0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size()) };
+	const uint32_t jsonChunk[2] = { static_cast<uint32_t>(json.size()), 0x4E4F534A };
+	const uint32_t binChunk[2] = { static_cast<uint32_t>(bin.size()), 0x004E4942 };
+
+	std::ofstream stream(path, std::ios::binary);
+	stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(jsonChunk), sizeof(jsonChunk));
+	stream.write(json.data(), static_cast<std::streamsize>(json.size()));
+	stream.write(reinterpret_cast<const char*>(binChunk), sizeof(binChunk));
+	stream.write(bin.data(), static_cast<std::streamsize>(bin.size()));
+	return static_cast<bool>(stream);
+}
+
+bool WriteSyntheticNotObj(const std::string& path, uint32_t primitiveCount) {
+	// A small LCG keeps the scene the same from run to run
+	uint32_t state = 0x12345678u;
+	const auto random = [&]() {
+		state = state * 1664525u + 1013904223u;
+		return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+	};
+
+	fmt::memory_buffer buffer;
+	fmt::format_to(buffer, "# Synthetic scene with {} primitives for the asset import benchmark\n", primitiveCount);
+	for (uint32_t ix = 0; ix < primitiveCount; ix++) {
+		const float x = random() * 100.0f - 50.0f, y = random() * 100.0f - 50.0f, z = random() * 10.0f;
+		const float r = random(), g = random(), b = random();
+		switch (ix % 4) {
+		case 0:
+			fmt::format_to(buffer, "cube {:.3f} {:.3f} {:.3f}  {:.3f} {:.3f} {:.3f}  0.0 0.0 {:.1f}  {:.3f} {:.3f} {:.3f}\n",
+				x, y, z, 0.5f + random(), 0.5f + random(), 0.5f + random(), random() * 360.0f, r, g, b);
+			break;
+		case 1:
+			fmt::format_to(buffer, "plane {:.3f} {:.3f} {:.3f}  0.0 0.0 1.0  1.0 0.0 0.0  {:.3f} {:.3f}  {:.3f} {:.3f} {:.3f}\n",
+				x, y, z, 1.0f + random() * 4.0f, 1.0f + random() * 4.0f, r, g, b);
+			break;
+		case 2:
+			fmt::format_to(buffer, "sphere ico 2 {:.3f} {:.3f} {:.3f}  {:.3f} {:.3f} {:.3f}  {:.3f} {:.3f} {:.3f}\n",
+				x, y, z, 0.5f, 0.5f, 0.5f, r, g, b);
+			break;
+		default:
+			fmt::format_to(buffer, "sphere uv 2 {:.3f} {:.3f} {:.3f}  {:.3f} {:.3f} {:.3f}  {:.3f} {:.3f} {:.3f}\n",
+				x, y, z, 0.5f, 0.5f, 0.5f, r, g, b);
+			break;
+		}
+	}
+	std::ofstream stream(path, std::ios::binary);
+	stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	return static_cast<bool>(stream);
+}
+
+bool WriteSyntheticImage(const std::string& path, uint32_t size, uint32_t seed) {
+	// Smooth gradients with some grain on top, so the PNG compresses about as well as a real texture would
+	std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 3);
+	uint32_t state = seed * 2654435761u + 1u;
+	for (uint32_t y = 0; y < size; y++) {
+		for (uint32_t x = 0; x < size; x++) {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			const float fx = static_cast<float>(x) / size, fy = static_cast<float>(y) / size;
+			const int grain = static_cast<int>(state & 15) - 8;
+			uint8_t* pixel = &pixels[(static_cast<size_t>(y) * size + x) * 3];
+			pixel[0] = static_cast<uint8_t>(std::clamp(static_cast<int>(127.5f + 100.0f * std::sin(fx * 12.0f + seed)) + grain, 0, 255));
+			pixel[1] = static_cast<uint8_t>(std::clamp(static_cast<int>(127.5f + 100.0f * std::cos(fy * 9.0f)) + grain, 0, 255));
+			pixel[2] = static_cast<uint8_t>(std::clamp(static_cast<int>(255.0f * fx * fy) + grain, 0, 255));
+		}
+	}
+	return stbi_write_png(path.c_str(), static_cast<int>(size), static_cast<int>(size), 3, pixels.data(), static_cast<int>(size * 3)) != 0;
+}
+
+/// <summary>
+/// Generates every synthetic input that does not exist yet
+/// </summary>
+void GenerateSyntheticInputs(const std::string& directory, const std::vector<uint32_t>& scales) {
+	namespace fs = std::filesystem;
+	std::error_code error;
+	fs::create_directories(directory, error);
+
+	// Writes a file with the given generator, unless it's already been made by an earlier run
+	const auto generate = [&](const std::string& name, auto&& writer) {
+		const std::string path = (fs::path(directory) / name).string();
+		if (fs::exists(path)) {
+			return;
+		}
+		LOG_INFO("Generating \"{}\"", path);
+		if (!writer(path)) {
+			LOG_WARN("Failed to write \"{}\"", path);
+			fs::remove(path, error);
+		}
+	};
+
+	for (uint32_t scale : scales) {
+		generate(fmt::format("grid_{}.obj", scale), [&](const std::string& path) { return WriteSyntheticObj(path, scale); });
+		generate(fmt::format("grid_{}.glb", scale), [&](const std::string& path) { return WriteSyntheticGlb(path, scale); });
+		generate(fmt::format("scene_{}.notobj", scale), [&](const std::string& path) { return WriteSyntheticNotObj(path, std::max(scale * scale / 16, 1u)); });
+		generate(fmt::format("noise_{}.png", scale * 4), [&](const std::string& path) { return WriteSyntheticImage(path, scale * 4, 0); });
+		for (int face = 0; face < 6; face++) {
+			generate(fmt::format("sky_{}{}.png", scale * 2, CUBE_FACE_SUFFIXES[face]), [&](const std::string& path) { return WriteSyntheticImage(path, scale * 2, face + 1); });
+		}
+	}
+}
+
+/// <summary>
+/// Loads an asset for every iteration, stopping at the first failure
+/// </summary>
+ImportResult RunImportCase(const ImportCase& importCase, const AssetImportBenchmarkOptions& options) {
+	ImportResult result;
+	result.Loader = importCase.Loader;
+	result.Path = importCase.Path;
+	result.Synthetic = importCase.Synthetic;
+	result.Iterations = 0;
+	result.Cpu.Bytes = importCase.Bytes;
+	result.PeakIsPerAsset = MemoryStats::ResetPeakResidentBytes();
+
+	for (int ix = 0; ix < options.Iterations; ix++) {
+		try {
+			if (!importCase.Load(importCase.Path, options.Upload, result)) {
+				if (result.Error.empty()) {
+					result.Error = "The loader did not return any data";
+				}
+				break;
+			}
+		}
+		catch (const std::exception& e) {
+			result.Error = e.what();
+			break;
+		}
+		result.Iterations++;
+	}
+	result.PeakResidentBytes = MemoryStats::GetPeakResidentBytes();
+	return result;
+}
+
+/// <summary>
+/// Converts a phase to JSON
+/// </summary>
+nlohmann::json PhaseToJson(const ImportPhase& phase, int iterations) {
+	return {
+		{ "best_ms", phase.BestSeconds * 1000.0 },
+		{ "mean_ms", phase.TotalSeconds * 1000.0 / iterations },
+		{ "bytes", phase.Bytes },
+		{ "mb_per_s", phase.Bytes / (1024.0 * 1024.0) / phase.BestSeconds },
+		{ "allocations", phase.Allocations },
+		{ "allocated_bytes", phase.AllocatedBytes }
+	};
+}
+
+bool AssetImportBenchmark::Run(const AssetImportBenchmarkOptions& options, const std::string& outputPath) {
+	namespace fs = std::filesystem;
+
+	std::vector<ImportCase> cases;
+	FindImportCases(options.ResourceDirectory, options.SyntheticDirectory, false, cases);
+	if (!options.SyntheticScales.empty()) {
+		GenerateSyntheticInputs(options.SyntheticDirectory, options.SyntheticScales);
+		FindImportCases(options.SyntheticDirectory, fs::path(), true, cases);
+	}
+	std::stable_sort(cases.begin(), cases.end(), [](const ImportCase& a, const ImportCase& b) {
+		return a.Synthetic != b.Synthetic ? !a.Synthetic : (a.Loader != b.Loader ? strcmp(a.Loader, b.Loader) < 0 : a.Path < b.Path);
+	});
+	if (cases.empty()) {
+		LOG_WARN("No assets found in \"{}\"", options.ResourceDirectory);
+		return false;
+	}
+
+	const int iterations = std::max(options.Iterations, 1);
+	AssetImportBenchmarkOptions runOptions = options;
+	runOptions.Iterations = iterations;
+
+	LOG_INFO("==== Asset Import Benchmark ({} assets, best of {}, upload {}) =====", cases.size(), iterations, options.Upload ? "on" : "off");
+	LOG_INFO("{:<18} {:<40} {:>10} {:>10} {:>9} {:>9} {:>10} {:>9}", "Loader", "File", "Size (KB)", "CPU (ms)", "MB/s", "Allocs", "GPU (ms)", "Peak MB");
+
+	// Allocations are only counted while the benchmark runs, the rest of the game doesn't pay for it
+	const bool wasCounting = MemoryStats::IsCountingAllocations();
+	MemoryStats::SetCountingAllocations(true);
+
+	nlohmann::json assets = nlohmann::json::array();
+	for (const ImportCase& importCase : cases) {
+		const ImportResult result = RunImportCase(importCase, runOptions);
+
+		nlohmann::json entry = {
+			{ "loader", result.Loader },
+			{ "path", result.Path },
+			{ "synthetic", result.Synthetic },
+			{ "source_bytes", importCase.Bytes },
+			{ "iterations", result.Iterations },
+			{ "peak_rss_bytes", result.PeakResidentBytes },
+			{ "peak_rss_per_asset", result.PeakIsPerAsset },
+			{ "output", result.Output }
+		};
+		if (!result.Error.empty()) {
+			entry["error"] = result.Error;
+		}
+		if (result.Iterations == 0) {
+			LOG_WARN("{:<18} {:<40} failed: {}", result.Loader, result.Path, result.Error);
+			entry["cpu"] = nullptr;
+			entry["upload"] = nullptr;
+			assets.push_back(entry);
+			continue;
+		}
+		entry["cpu"] = PhaseToJson(result.Cpu, result.Iterations);
+		entry["upload"] = options.Upload ? PhaseToJson(result.Upload, result.Iterations) : nlohmann::json(nullptr);
+		assets.push_back(entry);
+
+		LOG_INFO("{:<18} {:<40} {:>10.1f} {:>10.2f} {:>9.2f} {:>9} {:>10} {:>9.1f}",
+			result.Loader, result.Path, importCase.Bytes / 1024.0, result.Cpu.BestSeconds * 1000.0,
+			importCase.Bytes / (1024.0 * 1024.0) / result.Cpu.BestSeconds, result.Cpu.Allocations,
+			options.Upload ? fmt::format("{:.2f}", result.Upload.BestSeconds * 1000.0) : std::string("-"),
+			result.PeakResidentBytes / (1024.0 * 1024.0));
+	}
+	MemoryStats::SetCountingAllocations(wasCounting);
+
+	char timestamp[32];
+	const std::time_t now = std::time(nullptr);
+	std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	nlohmann::json report = {
+		{ "format_version", AssetBenchmarkFormatVersion },
+		{ "timestamp", timestamp },
+		#ifdef WINDOWS
+		{ "platform", "windows" },
+		#else
+		{ "platform", "linux" },
+		#endif
+		#ifdef _DEBUG
+		{ "configuration", "debug" },
+		#else
+		{ "configuration", "release" },
+		#endif
+		{ "hardware_threads", std::thread::hardware_concurrency() },
+		{ "iterations", iterations },
+		{ "upload", options.Upload },
+		{ "peak_rss_bytes", MemoryStats::GetPeakResidentBytes() },
+		{ "assets", assets }
+	};
+
+	std::ofstream stream(outputPath);
+	stream << report.dump(2) << std::endl;
+	if (!stream) {
+		LOG_WARN("Failed to write the benchmark results to \"{}\"", outputPath);
+		return false;
+	}
+	LOG_INFO("Wrote the results for {} assets to \"{}\"", assets.size(), outputPath);
+	return true;
+}
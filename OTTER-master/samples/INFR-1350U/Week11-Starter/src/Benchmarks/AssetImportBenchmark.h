@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Options that control what the asset import benchmark loads
+/// </summary>
+struct AssetImportBenchmarkOptions
+{
+	/// <summary>
+	/// The directory to search (recursively) for assets to load
+	/// </summary>
+	std::string           ResourceDirectory;
+	/// <summary>
+	/// The directory to generate the synthetic inputs in, files that already exist are reused
+	/// </summary>
+	std::string           SyntheticDirectory;
+	/// <summary>
+	/// The sizes of the synthetic inputs to generate. Each scale N generates an N x N quad grid (as OBJ and GLB),
+	/// N * N / 16 NotObj primitives, a 4N x 4N image and a cube map with 2N x 2N faces. Leave empty to only load
+	/// what is in the resource directory
+	/// </summary>
+	std::vector<uint32_t> SyntheticScales;
+	/// <summary>
+	/// The number of times to load each asset
+	/// </summary>
+	int                   Iterations;
+	/// <summary>
+	/// True to also upload everything that was loaded to the GPU and time that separately, this needs a current
+	/// OpenGL context. False runs headless, and only times the parsing and decoding
+	/// </summary>
+	bool                  Upload;
+
+	AssetImportBenchmarkOptions() :
+		ResourceDirectory("."),
+		SyntheticDirectory("bench_synthetic"),
+		SyntheticScales({ 128, 512 }),
+		Iterations(3),
+		Upload(false)
+	{ }
+};
+
+/// <summary>
+/// Times every asset loader (ObjLoader, NotObjLoader, nou::GLTF, Texture2DData and TextureCubeMapData) over the
+/// resource directory and a set of generated, scaled up inputs. For each asset the time, throughput, allocation
+/// count and peak resident memory of the CPU side (parsing and decoding) and the GPU upload are recorded
+/// separately, and written to a JSON file so results can be compared between releases. Run it with the
+/// --bench-assets argument (see main.cpp), or build the standalone AssetBenchmark in bench/ to run it headless on
+/// Linux without GLFW
+/// </summary>
+class AssetImportBenchmark
+{
+public:
+	/// <summary>
+	/// Runs the benchmark, logging a summary table and writing the full results to a JSON file
+	/// </summary>
+	/// <param name="options">The options for the benchmark</param>
+	/// <param name="outputPath">The path of the JSON file to write the results to</param>
+	/// <returns>True if the results were written, false if otherwise</returns>
+	static bool Run(const AssetImportBenchmarkOptions& options, const std::string& outputPath);
+
+protected:
+	AssetImportBenchmark() = default;
+	~AssetImportBenchmark() = default;
+};
@@ -0,0 +1,113 @@
+#include "ObjLoaderBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "Logging.h"
+#include "Utilities/ObjLoader.h"
+
+/// <summary>
+/// Loads the file the given number of times, returning the fastest time in seconds
+/// </summary>
+double TimeObjLoad(const std::string& path, const ObjLoadOptions& options, int iterations, size_t& vertexCount, size_t& indexCount) {
+	double best = std::numeric_limits<double>::max();
+	for (int ix = 0; ix < iterations; ix++) {
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		auto start = std::chrono::high_resolution_clock::now();
+		ObjLoader::LoadMeshData(path, mesh, options);
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double>(end - start).count());
+		vertexCount = mesh.GetVertexCount();
+		indexCount = mesh.GetIndexCount();
+	}
+	return best;
+}
+
+void ObjLoaderBenchmark::Run(const std::string& directory, int iterations) {
+	namespace fs = std::filesystem;
+
+	std::vector<fs::path> files;
+	for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".obj") {
+			files.push_back(entry.path());
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	if (files.empty()) {
+		LOG_WARN("No .obj files found in \"{}\"", directory);
+		return;
+	}
+
+	ObjLoadOptions streamed;
+	streamed.UseMemoryMap = false;
+	ObjLoadOptions mapped;
+	mapped.UseMemoryMap = true;
+
+	LOG_INFO("==== OBJ Loader Benchmark (best of {}) =====", iterations);
+	LOG_INFO("{:<20} {:>10} {:>12} {:>12} {:>9}", "File", "Size (KB)", "ifstream MB/s", "mapped MB/s", "Speedup");
+	for (const fs::path& path : files) {
+		const double megabytes = fs::file_size(path) / (1024.0 * 1024.0);
+
+		size_t streamVerts = 0, streamIndices = 0;
+		size_t mappedVerts = 0, mappedIndices = 0;
+		const double streamTime = TimeObjLoad(path.string(), streamed, iterations, streamVerts, streamIndices);
+		const double mappedTime = TimeObjLoad(path.string(), mapped, iterations, mappedVerts, mappedIndices);
+
+		LOG_INFO("{:<20} {:>10.1f} {:>12.2f} {:>12.2f} {:>8.2f}x",
+			path.filename().string(), megabytes * 1024.0, megabytes / streamTime, megabytes / mappedTime, streamTime / mappedTime);
+
+		// Both paths should agree on the mesh they produce, if not something is off
+		if (streamVerts != mappedVerts || streamIndices != mappedIndices) {
+			LOG_WARN("\tMesh mismatch! ifstream: {} verts / {} indices, mapped: {} verts / {} indices",
+				streamVerts, streamIndices, mappedVerts, mappedIndices);
+		}
+	}
+}
+
+void ObjLoaderBenchmark::RunThreadScaling(const std::string& path, int maxThreads, int iterations) {
+	namespace fs = std::filesystem;
+
+	if (!fs::is_regular_file(path)) {
+		LOG_WARN("Could not find \"{}\"", path);
+		return;
+	}
+	if (maxThreads <= 0) {
+		maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	}
+
+	const double megabytes = fs::file_size(path) / (1024.0 * 1024.0);
+	if (megabytes * 1024.0 * 1024.0 < ObjLoadOptions::MinBytesPerThread * 2) {
+		LOG_WARN("\"{}\" is smaller than {} KB, so it will not be split across threads", path, ObjLoadOptions::MinBytesPerThread * 2 / 1024);
+	}
+
+	LOG_INFO("==== OBJ Loader Thread Scaling: {} ({:.1f} KB, best of {}) =====", path, megabytes * 1024.0, iterations);
+	LOG_INFO("{:>8} {:>12} {:>9}", "Threads", "MB/s", "Speedup");
+
+	size_t baseVerts = 0, baseIndices = 0;
+	double baseTime = 0.0;
+	for (int threads = 1; threads <= maxThreads; threads++) {
+		ObjLoadOptions options;
+		options.UseMemoryMap = true;
+		options.ThreadCount = static_cast<uint32_t>(threads);
+
+		size_t verts = 0, indices = 0;
+		const double time = TimeObjLoad(path, options, iterations, verts, indices);
+		if (threads == 1) {
+			baseTime = time;
+			baseVerts = verts;
+			baseIndices = indices;
+		}
+
+		LOG_INFO("{:>8} {:>12.2f} {:>8.2f}x", threads, megabytes / time, baseTime / time);
+
+		if (verts != baseVerts || indices != baseIndices) {
+			LOG_WARN("\tMesh mismatch! 1 thread: {} verts / {} indices, {} threads: {} verts / {} indices",
+				baseVerts, baseIndices, threads, verts, indices);
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+/// <summary>
+/// Measures the throughput of the OBJ loading paths, this does not need an OpenGL context so it
+/// can be run before the window is created (see the --bench-obj argument in main.cpp)
+/// </summary>
+class ObjLoaderBenchmark
+{
+public:
+	/// <summary>
+	/// Loads every .obj file in the given directory with each parsing path and logs the throughput
+	/// in MB/s for each, using the best time of a number of iterations
+	/// </summary>
+	/// <param name="directory">The directory to search for .obj files in</param>
+	/// <param name="iterations">The number of times to load each file with each loader</param>
+	static void Run(const std::string& directory, int iterations = 5);
+
+	/// <summary>
+	/// Loads a single .obj file using the memory mapped path with 1 to maxThreads threads, and logs the
+	/// throughput and speedup over the single threaded load for each thread count
+	/// </summary>
+	/// <param name="path">The path of the .obj file to load</param>
+	/// <param name="maxThreads">The largest thread count to test, 0 will use the number of hardware threads</param>
+	/// <param name="iterations">The number of times to load the file for each thread count</param>
+	static void RunThreadScaling(const std::string& path, int maxThreads = 0, int iterations = 5);
+
+protected:
+	ObjLoaderBenchmark() = default;
+	~ObjLoaderBenchmark() = default;
+};
@@ -0,0 +1,131 @@
+#include "TextureUploadBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Logging.h"
+#include "Graphics/PixelUploadRing.h"
+#include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DData.h"
+#include "Utilities/MipGenerator.h"
+
+/// <summary>
+/// One of the images that gets uploaded by the benchmark
+/// </summary>
+struct UploadBenchmarkCase
+{
+	std::string         Name;
+	Texture2DData::sptr Data;
+};
+
+/// <summary>
+/// The best times for uploading an image one way, in seconds
+/// </summary>
+struct UploadBenchmarkTimes
+{
+	double Stage;
+	double Submit;
+	double Total;
+
+	UploadBenchmarkTimes() :
+		Stage(std::numeric_limits<double>::max()),
+		Submit(std::numeric_limits<double>::max()),
+		Total(std::numeric_limits<double>::max())
+	{ }
+};
+
+/// <summary>
+/// Makes an image filled with a pattern that the driver can't skip over (ex: by noticing it is all zeros)
+/// </summary>
+Texture2DData::sptr MakeUploadBenchmarkImage(uint32_t width, uint32_t height, PixelFormat format, InternalFormat internalFormat, bool mips) {
+	std::vector<uint8_t> texels((size_t)width * height * GetTexelSize(format, PixelType::UByte));
+	uint32_t state = 0x9E3779B9u;
+	for (uint8_t& texel : texels) {
+		state = state * 1664525u + 1013904223u;
+		texel = static_cast<uint8_t>(state >> 24);
+	}
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(width, height, format, PixelType::UByte, texels.data(), internalFormat);
+	if (mips) {
+		MipGenerationOptions options;
+		options.UseKaiser = false;
+		result->GenerateMipMaps(options);
+	}
+	return result;
+}
+
+/// <summary>
+/// Uploads an image into a texture a number of times, either straight from client memory or through the ring
+/// </summary>
+UploadBenchmarkTimes TimeUpload(const Texture2D::sptr& texture, const Texture2DData::sptr& data, bool useRing, int iterations) {
+	typedef std::chrono::high_resolution_clock Clock;
+	UploadBenchmarkTimes result;
+	for (int ix = 0; ix < iterations; ix++) {
+		// Start every iteration with the GPU idle and the ring empty, so one upload can't eat into the next one's time
+		glFinish();
+		PixelUploadRing::Retire();
+
+		const Clock::time_point start = Clock::now();
+		if (useRing && !data->Stage()) {
+			LOG_WARN("The upload ring is too small for the benchmark, this iteration uploads from client memory");
+		}
+		const Clock::time_point staged = Clock::now();
+		texture->LoadData(data);
+		const Clock::time_point submitted = Clock::now();
+		glFinish();
+		const Clock::time_point end = Clock::now();
+
+		result.Stage = std::min(result.Stage, std::chrono::duration<double>(staged - start).count());
+		result.Submit = std::min(result.Submit, std::chrono::duration<double>(submitted - staged).count());
+		result.Total = std::min(result.Total, std::chrono::duration<double>(end - start).count());
+	}
+	return result;
+}
+
+void TextureUploadBenchmark::Run(uint32_t size, int iterations) {
+	size = std::max(size, 2u);
+	iterations = std::max(iterations, 1);
+
+	// The odd sizes have rows that aren't a multiple of 4 bytes, which used to be uploaded with the wrong alignment
+	std::vector<UploadBenchmarkCase> cases;
+	cases.push_back({ "RGBA8", MakeUploadBenchmarkImage(size, size, PixelFormat::RGBA, InternalFormat::RGBA8, false) });
+	cases.push_back({ "RGBA8 + mips", MakeUploadBenchmarkImage(size, size, PixelFormat::RGBA, InternalFormat::RGBA8, true) });
+	cases.push_back({ "RGB8", MakeUploadBenchmarkImage(size, size, PixelFormat::RGB, InternalFormat::RGB8, false) });
+	cases.push_back({ "RGB8 (odd)", MakeUploadBenchmarkImage(size - 1, size - 1, PixelFormat::RGB, InternalFormat::RGB8, false) });
+	cases.push_back({ "RG8 + mips", MakeUploadBenchmarkImage(size, size, PixelFormat::RG, InternalFormat::RG8, true) });
+
+	// Use our own ring if the app hasn't made one, with room for the largest case
+	size_t largest = 0;
+	for (const UploadBenchmarkCase& test : cases) {
+		largest = std::max(largest, test.Data->GetDataSize());
+	}
+	const bool ownsRing = !PixelUploadRing::IsInitialized();
+	if (ownsRing) {
+		PixelUploadRing::Init(largest * 2);
+	}
+
+	LOG_INFO("==== Texture Upload Benchmark ({}x{}, best of {}) =====", size, size, iterations);
+	LOG_INFO("{:<14} {:>9} {:>14} {:>14} {:>14} {:>14} {:>9}", "Image", "MB", "client (MB/s)", "ring (MB/s)", "stage (ms)", "submit (ms)", "Speedup");
+	for (const UploadBenchmarkCase& test : cases) {
+		Texture2DDescription description;
+		description.GenerateMipMaps = test.Data->GetLevelCount() > 1;
+		Texture2D::sptr texture = Texture2D::Create(description);
+		// The first upload allocates the storage, which we don't want to count against either path
+		texture->LoadData(test.Data);
+
+		const UploadBenchmarkTimes client = TimeUpload(texture, test.Data, false, iterations);
+		const UploadBenchmarkTimes ring = TimeUpload(texture, test.Data, true, iterations);
+		const double megabytes = test.Data->GetDataSize() / (1024.0 * 1024.0);
+		LOG_INFO("{:<14} {:>9.2f} {:>14.1f} {:>14.1f} {:>14.3f} {:>14.3f} {:>8.2f}x", test.Name, megabytes,
+			megabytes / client.Total, megabytes / ring.Total, ring.Stage * 1000.0, ring.Submit * 1000.0, client.Total / ring.Total);
+		// The GL thread only pays for the submit when the loader threads do the staging
+		LOG_INFO("{:<14} {:>9} GL thread: {:.1f} MB/s from client memory, {:.1f} MB/s from the ring", "", "",
+			megabytes / client.Submit, megabytes / ring.Submit);
+	}
+
+	if (ownsRing) {
+		PixelUploadRing::Shutdown();
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+/// <summary>
+/// Measures texture upload throughput from client memory against uploads through the PixelUploadRing. This needs
+/// a current OpenGL context, see the --bench-texture-upload argument in main.cpp
+/// </summary>
+class TextureUploadBenchmark
+{
+public:
+	/// <summary>
+	/// Uploads a set of generated images (aligned and unaligned rows, with and without mip chains) with each path, and
+	/// logs the throughput in MB/s using the best time of a number of iterations. Each upload is timed until glFinish
+	/// returns, since the driver may still be copying after the call. For the ring, the time spent staging (which the
+	/// loader threads normally pay for) and the time the GL thread spends issuing the copies are logged separately
+	/// </summary>
+	/// <param name="size">The width and height of the largest image, in texels (at least 2)</param>
+	/// <param name="iterations">The number of times to upload each image with each path (at least 1)</param>
+	static void Run(uint32_t size = 2048, int iterations = 10);
+
+protected:
+	TextureUploadBenchmark() = default;
+	~TextureUploadBenchmark() = default;
+};
@@ -0,0 +1,208 @@
+#include "VertexDedupBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "Logging.h"
+#include "Utilities/FlatHashMap.h"
+#include "Utilities/MemoryMappedFile.h"
+#include "Utilities/TextTokenizer.h"
+
+/// <summary>
+/// A face corner, as absolute 1-based attribute indices
+/// </summary>
+struct DedupCorner
+{
+	int32_t VertIx, UvIx, NormIx;
+
+	bool operator ==(const DedupCorner& other) const {
+		return VertIx == other.VertIx && UvIx == other.UvIx && NormIx == other.NormIx;
+	}
+};
+
+struct DedupCornerHash
+{
+	size_t operator ()(const DedupCorner& key) const {
+		uint64_t hash = static_cast<uint32_t>(key.VertIx);
+		hash = (hash * 0x100000001B3ull) ^ static_cast<uint32_t>(key.UvIx);
+		hash = (hash * 0x100000001B3ull) ^ static_cast<uint32_t>(key.NormIx);
+		return static_cast<size_t>(hash ^ (hash >> 29));
+	}
+};
+
+/// <summary>
+/// The map and key packing that the OBJ loader used before, kept here as a baseline
+/// </summary>
+struct PackedKeyDedup
+{
+	std::unordered_map<uint64_t, uint32_t> Map;
+
+	void Reserve(size_t count) { Map.reserve(count); }
+	void Add(const DedupCorner& corner) {
+		const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+		const uint64_t key = ((corner.VertIx & mask) << 42) | ((corner.UvIx & mask) << 21) | (corner.NormIx & mask);
+		Map.try_emplace(key, static_cast<uint32_t>(Map.size()));
+	}
+	size_t Size() const { return Map.size(); }
+};
+
+/// <summary>
+/// std::unordered_map keyed on the full index triple, this is correct but still allocates a node per vertex
+/// </summary>
+struct FullKeyDedup
+{
+	std::unordered_map<DedupCorner, uint32_t, DedupCornerHash> Map;
+
+	void Reserve(size_t count) { Map.reserve(count); }
+	void Add(const DedupCorner& corner) { Map.try_emplace(corner, static_cast<uint32_t>(Map.size())); }
+	size_t Size() const { return Map.size(); }
+};
+
+/// <summary>
+/// The flat hash map keyed on the full index triple, same as the OBJ loader uses now
+/// </summary>
+struct FlatDedup
+{
+	FlatHashMap<DedupCorner, uint32_t, DedupCornerHash> Map;
+
+	void Reserve(size_t count) { Map.Reserve(count); }
+	void Add(const DedupCorner& corner) { Map.TryEmplace(corner, static_cast<uint32_t>(Map.Size())); }
+	size_t Size() const { return Map.Size(); }
+};
+
+/// <summary>
+/// Reads all the face corners out of an OBJ file, along with the largest attribute count (which is what the loader reserves)
+/// </summary>
+bool CollectObjCorners(const std::string& path, std::vector<DedupCorner>& corners, size_t& expectedVerts) {
+	MemoryMappedFile file(path);
+	if (!file.IsOpen()) {
+		return false;
+	}
+
+	int32_t positions = 0, uvs = 0, normals = 0;
+	TextTokenizer tokenizer(file.GetData(), file.GetEnd());
+	while (!tokenizer.IsEOF()) {
+		const std::string_view command = tokenizer.ReadToken();
+		if (command == "v") { positions++; }
+		else if (command == "vt") { uvs++; }
+		else if (command == "vn") { normals++; }
+		else if (command == "f") {
+			while (true) {
+				DedupCorner corner = { 0, 0, 0 };
+				if (!tokenizer.ReadInt(corner.VertIx)) {
+					break;
+				}
+				if (tokenizer.TryConsume('/')) {
+					if (!tokenizer.TryConsume('/')) {
+						tokenizer.ReadInt(corner.UvIx);
+						if (tokenizer.TryConsume('/')) {
+							tokenizer.ReadInt(corner.NormIx);
+						}
+					} else {
+						tokenizer.ReadInt(corner.NormIx);
+					}
+				}
+				corner.VertIx += corner.VertIx < 0 ? positions + 1 : 0;
+				corner.UvIx   += corner.UvIx < 0 ? uvs + 1 : 0;
+				corner.NormIx += corner.NormIx < 0 ? normals + 1 : 0;
+				corners.push_back(corner);
+			}
+		}
+		tokenizer.SkipLine();
+	}
+	expectedVerts = static_cast<size_t>(std::max({ positions, uvs, normals }));
+	return true;
+}
+
+/// <summary>
+/// Times how long it takes to de-duplicate the corners produced by generate with the given map type, returning the best time in seconds
+/// </summary>
+template <typename Dedup, typename Generator>
+double TimeDedup(const Generator& generate, size_t expectedVerts, int iterations, size_t& uniqueCount) {
+	double best = std::numeric_limits<double>::max();
+	for (int ix = 0; ix < iterations; ix++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		Dedup dedup;
+		dedup.Reserve(expectedVerts);
+		generate([&](const DedupCorner& corner) { dedup.Add(corner); });
+		uniqueCount = dedup.Size();
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double>(end - start).count());
+	}
+	return best;
+}
+
+/// <summary>
+/// Runs both maps over a set of corners and logs a row of the results
+/// </summary>
+template <typename Generator>
+void CompareDedup(const std::string& name, const Generator& generate, size_t cornerCount, size_t expectedVerts, int iterations) {
+	size_t packedUnique = 0, fullUnique = 0, flatUnique = 0;
+	const double packedTime = TimeDedup<PackedKeyDedup>(generate, expectedVerts, iterations, packedUnique);
+	const double fullTime = TimeDedup<FullKeyDedup>(generate, expectedVerts, iterations, fullUnique);
+	const double flatTime = TimeDedup<FlatDedup>(generate, expectedVerts, iterations, flatUnique);
+
+	LOG_INFO("{:<20} {:>10} {:>10} {:>14.2f} {:>14.2f} {:>14.2f} {:>8.2f}x",
+		name, cornerCount, flatUnique, packedTime * 1000.0, fullTime * 1000.0, flatTime * 1000.0, packedTime / flatTime);
+	if (packedUnique != flatUnique) {
+		LOG_WARN("\tThe packed keys found {} unique vertices instead of {}, the 21-bit indices collided", packedUnique, flatUnique);
+	}
+	if (fullUnique != flatUnique) {
+		LOG_WARN("\tThe full key unordered_map found {} unique vertices instead of {}", fullUnique, flatUnique);
+	}
+}
+
+void VertexDedupBenchmark::Run(const std::string& directory, int iterations) {
+	namespace fs = std::filesystem;
+
+	std::vector<fs::path> files;
+	if (fs::is_directory(directory)) {
+		for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+			if (entry.is_regular_file() && entry.path().extension() == ".obj") {
+				files.push_back(entry.path());
+			}
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	LOG_INFO("==== Vertex De-duplication Benchmark (best of {}) =====", iterations);
+	LOG_INFO("{:<20} {:>10} {:>10} {:>14} {:>14} {:>14} {:>9}", "Mesh", "Corners", "Unique", "packed (ms)", "full key (ms)", "flat (ms)", "Speedup");
+	for (const fs::path& path : files) {
+		std::vector<DedupCorner> corners;
+		size_t expectedVerts = 0;
+		if (!CollectObjCorners(path.string(), corners, expectedVerts)) {
+			LOG_WARN("Failed to read \"{}\"", path.string());
+			continue;
+		}
+		auto generate = [&](const auto& add) {
+			for (const DedupCorner& corner : corners) {
+				add(corner);
+			}
+		};
+		CompareDedup(path.filename().string(), generate, corners.size(), expectedVerts, iterations);
+	}
+
+	// A 2237 x 2237 quad grid is just over 10 million triangles and 5 million vertices, which is more than
+	// the 2,097,150 the packed keys can represent. We generate the corners on the fly rather than storing them
+	const int32_t gridSize = 2237;
+	const int32_t rowSize = gridSize + 1;
+	auto generateGrid = [&](const auto& add) {
+		for (int32_t y = 0; y < gridSize; y++) {
+			for (int32_t x = 0; x < gridSize; x++) {
+				const int32_t a = y * rowSize + x + 1;
+				const int32_t b = a + 1;
+				const int32_t c = a + rowSize;
+				const int32_t d = c + 1;
+				add({ a, a, 1 }); add({ b, b, 1 }); add({ c, c, 1 });
+				add({ b, b, 1 }); add({ d, d, 1 }); add({ c, c, 1 });
+			}
+		}
+	};
+	const size_t gridTriangles = static_cast<size_t>(gridSize) * gridSize * 2;
+	CompareDedup("synthetic grid", generateGrid, gridTriangles * 3, static_cast<size_t>(rowSize) * rowSize, std::min(iterations, 2));
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+/// <summary>
+/// Compares the flat hash map we use for de-duplicating OBJ vertices against the std::unordered_map
+/// with packed 21-bit keys that we used before, and a std::unordered_map keyed on the full index triple.
+/// Does not need an OpenGL context, see the --bench-dedup argument in main.cpp
+/// </summary>
+class VertexDedupBenchmark
+{
+public:
+	/// <summary>
+	/// De-duplicates the face corners of every .obj file in the directory, followed by a synthetic
+	/// 10 million triangle grid, with each map and logs the time taken and the unique vertex counts
+	/// </summary>
+	/// <param name="directory">The directory to search for .obj files in</param>
+	/// <param name="iterations">The number of times to run each map over each mesh</param>
+	static void Run(const std::string& directory, int iterations = 5);
+
+protected:
+	VertexDedupBenchmark() = default;
+	~VertexDedupBenchmark() = default;
+};
@@ -1,12 +1,73 @@
 #pragma once
+#include <algorithm>
+#include <limits>
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshLodSet.h"
+#include "Graphics/MeshletSet.h"
 #include "Gameplay/ShaderMaterial.h"
 
 class RendererComponent {
 public:
+	// The mesh that will be drawn, if the renderer has levels of detail this is the currently selected level
 	VertexArrayObject::sptr Mesh;
 	ShaderMaterial::sptr    Material;
+	// The levels of detail to pick from, or nullptr to always draw Mesh
+	MeshLodSet::sptr        Lods;
+	// The index of the level in Lods that is currently being drawn
+	size_t                  CurrentLod = 0;
+	// The meshlets of Mesh, or nullptr to always draw all of Mesh
+	MeshletSet::sptr        Meshlets;
 
-	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; return *this; }
+	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; Lods = nullptr; CurrentLod = 0; Meshlets = nullptr; return *this; }
 	RendererComponent& SetMaterial(const ShaderMaterial::sptr& material) { Material = material; return *this; }
-};
\ No newline at end of file
+	RendererComponent& SetLods(const MeshLodSet::sptr& lods) { Lods = lods; CurrentLod = 0; Mesh = lods->GetLevel(0).Mesh; Meshlets = nullptr; return *this; }
+	RendererComponent& SetMeshlets(const MeshletSet::sptr& meshlets) { Meshlets = meshlets; Mesh = meshlets->GetMesh(); Lods = nullptr; CurrentLod = 0; return *this; }
+
+	/// <summary>
+	/// Forces the renderer to draw a given level of detail, clamped to the levels that are available
+	/// </summary>
+	/// <param name="level">The level to draw, where 0 is the most detailed</param>
+	void SetLod(size_t level) {
+		if (Lods != nullptr && Lods->GetLevelCount() > 0) {
+			CurrentLod = std::min(level, Lods->GetLevelCount() - 1);
+			Mesh = Lods->GetLevel(CurrentLod).Mesh;
+		}
+	}
+
+	/// <summary>
+	/// Picks the level of detail to draw based on how large the object is on screen, does nothing if there are no levels
+	/// </summary>
+	/// <param name="model">The world transform of the object</param>
+	/// <param name="view">The camera's view matrix</param>
+	/// <param name="projection">The camera's projection matrix</param>
+	/// <returns>The projected size of the object, as a fraction of the viewport height</returns>
+	float SelectLod(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
+		if (Lods == nullptr || Lods->GetLevelCount() == 0) {
+			return 0.0f;
+		}
+		const float size = Lods->GetProjectedSize(model, view, projection);
+		SetLod(Lods->SelectLevel(size, CurrentLod));
+		return size;
+	}
+
+	/// <summary>
+	/// Gets how large the object is on screen, using the bounds of its levels of detail, meshlets or mesh. Meshes
+	/// that don't know their bounds (ex: ones put together by hand) are treated as filling the screen
+	/// </summary>
+	/// <param name="model">The world transform of the object</param>
+	/// <param name="view">The camera's view matrix</param>
+	/// <param name="projection">The camera's projection matrix</param>
+	/// <returns>The projected size of the object, as a fraction of the viewport height</returns>
+	float GetProjectedSize(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) const {
+		if (Lods != nullptr) {
+			return Lods->GetProjectedSize(model, view, projection);
+		}
+		if (Meshlets != nullptr) {
+			return MeshLodSet::ProjectSphere(Meshlets->GetBoundsCenter(), Meshlets->GetBoundsRadius(), model, view, projection);
+		}
+		if (Mesh != nullptr && Mesh->HasBounds()) {
+			return MeshLodSet::ProjectSphere(Mesh->GetBoundsCenter(), Mesh->GetBoundsRadius(), model, view, projection);
+		}
+		return std::numeric_limits<float>::max();
+	}
+};
@@ -1,5 +1,8 @@
 #include "ShaderMaterial.h"
 
+#include <algorithm>
+#include <string_view>
+
 template<typename T>
 void SubmitUniforms(const Shader::sptr& shader, const std::unordered_map<ShaderParamName, T>& values) {
 	for (auto& kvp : values) {
@@ -14,8 +17,22 @@ void SubmitUniformsMat(const Shader::sptr& shader, const std::unordered_map<Shad
 	}
 }
 
+/// <summary>
+/// Hashes the parameters in a map, the result doesn't depend on the order the map is in. Values are hashed by their
+/// bytes, so the same value always gives the same hash
+/// </summary>
+template<typename T>
+size_t HashParams(const std::unordered_map<ShaderParamName, T>& values) {
+	size_t result = values.size();
+	for (auto& kvp : values) {
+		const size_t value = std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(&kvp.second), sizeof(T)));
+		result += std::hash<ShaderParamName>()(kvp.first) * 31 + value;
+	}
+	return result;
+}
+
 ShaderMaterial::ShaderMaterial()
-	: Shader(nullptr),  RenderLayer(0)
+	: Shader(nullptr),  RenderLayer(0), _batchKey(0), _batchKeyDirty(true)
 {
 }
 
@@ -40,6 +57,62 @@ void ShaderMaterial::Apply()
 	SubmitUniforms(Shader, Vec4Params);
 	SubmitUniformsMat(Shader, Mat4Params);
 	SubmitUniformsMat(Shader, Mat3Params);
+	ApplyLayers();
+}
+
+void ShaderMaterial::ApplyLayers() {
+	if (!Layers.empty()) {
+		Shader->SetUniform("u_Layers", GetLayers());
+	}
+}
+
+glm::ivec4 ShaderMaterial::GetLayers() const {
+	glm::ivec4 result(0);
+	for (size_t ix = 0; ix < std::min<size_t>(Layers.size(), 4); ix++) {
+		result[(int)ix] = Layers[ix].second;
+	}
+	return result;
+}
+
+bool ShaderMaterial::CanBatchWith(const ShaderMaterial& other) const {
+	if (Shader != other.Shader || RenderLayer != other.RenderLayer || Layers.size() != other.Layers.size()) {
+		return false;
+	}
+	// The arrays themselves are in Textures, so only the names of the layers need to match
+	for (size_t ix = 0; ix < Layers.size(); ix++) {
+		if (Layers[ix].first != other.Layers[ix].first) {
+			return false;
+		}
+	}
+	return
+		Textures == other.Textures &&
+		FloatParams == other.FloatParams &&
+		Vec2Params == other.Vec2Params &&
+		Vec3Params == other.Vec3Params &&
+		Vec4Params == other.Vec4Params &&
+		Mat4Params == other.Mat4Params &&
+		Mat3Params == other.Mat3Params;
+}
+
+size_t ShaderMaterial::GetBatchKey() const {
+	if (_batchKeyDirty) {
+		size_t result = std::hash<void*>()(Shader.get()) * 31 + RenderLayer;
+		for (auto& kvp : Textures) {
+			result += std::hash<ShaderParamName>()(kvp.first) * 31 + std::hash<void*>()(kvp.second.get());
+		}
+		for (auto& layer : Layers) {
+			result = result * 31 + std::hash<std::string>()(layer.first);
+		}
+		result += HashParams(FloatParams);
+		result += HashParams(Vec2Params);
+		result += HashParams(Vec3Params);
+		result += HashParams(Vec4Params);
+		result += HashParams(Mat4Params);
+		result += HashParams(Mat3Params);
+		_batchKey = result;
+		_batchKeyDirty = false;
+	}
+	return _batchKey;
 }
 
 void ShaderMaterial::Set(const std::string& name, const ITexture::sptr& texture) {
@@ -47,6 +120,18 @@ void ShaderMaterial::Set(const std::string& name, const ITexture::sptr& texture)
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Textures[pName] = texture;
+	_batchKeyDirty = true;
+}
+
+void ShaderMaterial::Set(const std::string& name, const TextureArraySlot& slot) {
+	Set(name, std::static_pointer_cast<ITexture>(slot.Array));
+	auto it = std::find_if(Layers.begin(), Layers.end(), [&](const std::pair<std::string, int>& layer) { return layer.first == name; });
+	if (it != Layers.end()) {
+		it->second = static_cast<int>(slot.Layer);
+	} else {
+		LOG_ASSERT(Layers.size() < 4, "Materials can only use 4 texture arrays, see ShaderMaterial::Layers");
+		Layers.push_back({ name, static_cast<int>(slot.Layer) });
+	}
 }
 
 void ShaderMaterial::Set(const std::string& name, float value) {
@@ -54,6 +139,7 @@ void ShaderMaterial::Set(const std::string& name, float value) {
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	FloatParams[pName] = value;
+	_batchKeyDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec2& value) {
@@ -61,6 +147,7 @@ void ShaderMaterial::Set(const std::string& name, const glm::vec2& value) {
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Vec2Params[pName] = value;
+	_batchKeyDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec3& value) {
@@ -68,6 +155,7 @@ void ShaderMaterial::Set(const std::string& name, const glm::vec3& value) {
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Vec3Params[pName] = value;
+	_batchKeyDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec4& value) {
@@ -75,6 +163,7 @@ void ShaderMaterial::Set(const std::string& name, const glm::vec4& value) {
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Vec4Params[pName] = value;
+	_batchKeyDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat4& value) {
@@ -82,6 +171,7 @@ void ShaderMaterial::Set(const std::string& name, const glm::mat4& value) {
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Mat4Params[pName] = value;
+	_batchKeyDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat3& value) {
@@ -89,4 +179,5 @@ void ShaderMaterial::Set(const std::string& name, const glm::mat3& value) {
 	ShaderParamName pName = name;
 	pName.Location = Shader->GetUniformLocation(name);
 	Mat3Params[pName] = value;
+	_batchKeyDirty = true;
 }
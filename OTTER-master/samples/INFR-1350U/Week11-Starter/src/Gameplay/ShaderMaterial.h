@@ -1,7 +1,10 @@
 #pragma once
 #include <string>
+#include <utility>
+#include <vector>
 #include "Graphics/Shader.h"
 #include "Graphics/ITexture.h"
+#include "Graphics/Texture2DArray.h"
 #include "Utilities/Macros.h"
 #include <EnumToString.h>
 
@@ -45,13 +48,44 @@ public:
 	std::unordered_map<ShaderParamName, glm::vec4> Vec4Params;
 	std::unordered_map<ShaderParamName, glm::mat4> Mat4Params;
 	std::unordered_map<ShaderParamName, glm::mat3> Mat3Params;
+	/// <summary>
+	/// The layer of each texture array the material samples from, in the order the arrays were first set (see
+	/// Set with a TextureArraySlot). The first four are passed to the shader as the components of u_Layers, or
+	/// through the instance data for instanced draws
+	/// </summary>
+	std::vector<std::pair<std::string, int>> Layers;
 
 	int RenderLayer;
 	std::string DebugName;
 
 	void Apply();
+	/// <summary>
+	/// Uploads only the texture array layers, for switching to this material from one that it can batch with
+	/// </summary>
+	void ApplyLayers();
+
+	/// <summary>
+	/// Gets the first four layers, in the form the shader takes them in (see Layers)
+	/// </summary>
+	glm::ivec4 GetLayers() const;
+	/// <summary>
+	/// Returns true if the only thing that differs between the two materials is which texture array layers they use,
+	/// in which case they can be drawn with the same state (or merged into one instanced draw), as long as each
+	/// draw gets its own layers
+	/// </summary>
+	bool CanBatchWith(const ShaderMaterial& other) const;
+	/// <summary>
+	/// Gets a hash of everything that CanBatchWith compares, for sorting materials that can batch next to each
+	/// other. This is cached, so changes have to go through Set to be picked up
+	/// </summary>
+	size_t GetBatchKey() const;
 
 	void Set(const std::string& name, const ITexture::sptr& texture);
+	/// <summary>
+	/// Points a sampler2DArray at one layer of a texture array. Materials that only differ by their layers can batch
+	/// together (see CanBatchWith)
+	/// </summary>
+	void Set(const std::string& name, const TextureArraySlot& slot);
 	void Set(const std::string& name, float value);
 	void Set(const std::string& name, const glm::vec2& value);
 	void Set(const std::string& name, const glm::vec3& value);
@@ -60,4 +94,6 @@ public:
 	void Set(const std::string& name, const glm::mat3& value);
 
 protected:
+	mutable size_t _batchKey;
+	mutable bool   _batchKeyDirty;
 };
@@ -1,9 +1,11 @@
 #include "IBuffer.h"
+#include "Logging.h"
 
 IBuffer::IBuffer(GLenum type, GLenum usage) :
 	_elementCount(0),
 	_elementSize(0),
-	_handle(0)
+	_handle(0),
+	_immutable(false)
 {
 	_type = type;
 	_usage = usage;
@@ -18,12 +20,26 @@ IBuffer::~IBuffer() {
 }
 
 void IBuffer::LoadData(const void* data, size_t elementSize, size_t elementCount) {
+	LOG_ASSERT(!_immutable, "Can't reload a buffer that was allocated with AllocateStorage!");
 	// Note, this is part of the bindless state access stuff added in 4.5    
 	glNamedBufferData(_handle, elementSize * elementCount, data, _usage);
 	_elementCount = elementCount;
 	_elementSize = elementSize;
 }
 
+void IBuffer::AllocateStorage(size_t elementSize, size_t elementCount, GLbitfield flags) {
+	LOG_ASSERT(!_immutable, "Buffer storage can only be allocated once!");
+	glNamedBufferStorage(_handle, elementSize * elementCount, nullptr, flags);
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+	_immutable = true;
+}
+
+void IBuffer::UpdateData(const void* data, size_t byteOffset, size_t byteCount) {
+	LOG_ASSERT(byteOffset + byteCount <= _elementCount * _elementSize, "Update is outside of the buffer's data store!");
+	glNamedBufferSubData(_handle, byteOffset, byteCount, data);
+}
+
 void IBuffer::Bind() {
 	glBindBuffer(_type, _handle);
 }
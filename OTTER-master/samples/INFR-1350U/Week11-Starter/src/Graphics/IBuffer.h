@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <glad/glad.h>
 
 /// <summary>
@@ -38,6 +39,25 @@ public:
 		IBuffer::LoadData((const void*)(data), sizeof(T), count);
 	}
 
+	/// <summary>
+	/// Allocates an immutable data store for this buffer without filling it, using the bindless method glNamedBufferStorage.
+	/// The size can never change afterwards (so LoadData can't be used anymore), but the driver can place the store
+	/// up front and the data can be filled in over time with UpdateData
+	/// </summary>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to make room for</param>
+	/// <param name="flags">The storage flags, GL_DYNAMIC_STORAGE_BIT is needed to be able to call UpdateData</param>
+	void AllocateStorage(size_t elementSize, size_t elementCount, GLbitfield flags = GL_DYNAMIC_STORAGE_BIT);
+
+	/// <summary>
+	/// Overwrites part of this buffer's data store, using the bindless method glNamedBufferSubData. The buffer must
+	/// already have room for the data (see LoadData, which can be passed nullptr to just allocate the store)
+	/// </summary>
+	/// <param name="data">The data to copy into the buffer</param>
+	/// <param name="byteOffset">The offset into the buffer to write to, in bytes</param>
+	/// <param name="byteCount">The number of bytes to write</param>
+	void UpdateData(const void* data, size_t byteOffset, size_t byteCount);
+
 	/// <summary>
 	/// Returns the number of elements that are loaded into this buffer
 	/// </summary>
@@ -59,6 +79,10 @@ public:
 	/// </summary>
 	GLenum GetUsage() const { return _usage; }
 	/// <summary>
+	/// Returns true if this buffer's store was allocated with AllocateStorage, and can't be resized
+	/// </summary>
+	bool GetIsImmutable() const { return _immutable; }
+	/// <summary>
 	/// Returns the underlying OpenGL handle that this class is wrapping around
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
@@ -86,4 +110,5 @@ protected:
 	GLuint _handle; // The OpenGL handle for the underlying buffer
 	GLenum _usage; // The buffer usage mode (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	GLenum _type; // The buffer type (ex GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)
+	bool   _immutable; // True if the store was allocated with glNamedBufferStorage
 };
@@ -14,6 +14,7 @@ ITexture::ITexture()
 		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &_limits.MAX_TEXTURE_UNITS);
 		glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &_limits.MAX_3D_TEXTURE_SIZE);
 		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &_limits.MAX_TEXTURE_IMAGE_UNITS);
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &_limits.MAX_ARRAY_TEXTURE_LAYERS);
 		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &_limits.MAX_ANISOTROPY);
 
 		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
@@ -23,6 +24,7 @@ ITexture::ITexture()
 		LOG_INFO("\tUnits:      {}", _limits.MAX_TEXTURE_UNITS);
 		LOG_INFO("\t3D Size:    {}", _limits.MAX_3D_TEXTURE_SIZE);
 		LOG_INFO("\tUnits (FS): {}", _limits.MAX_TEXTURE_IMAGE_UNITS);
+		LOG_INFO("\tLayers:     {}", _limits.MAX_ARRAY_TEXTURE_LAYERS);
 		LOG_INFO("\tMax Aniso.: {}", _limits.MAX_ANISOTROPY);
 		
 		_isStaticInit = true;
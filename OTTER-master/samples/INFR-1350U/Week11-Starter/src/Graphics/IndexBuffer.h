@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <stdexcept>
 #include <memory>
+#include <vector>
 
 /// <summary>
 /// The index buffer will store indices for rendering (uint8_t, uint16_t and uint32_t)
@@ -39,6 +40,18 @@ public:
 		_elementType = elementType;
 	}
 	/// <summary>
+	/// Allocates an immutable store for indices without filling it, see IBuffer::AllocateStorage. Like LoadData,
+	/// this hides the base version so the element type always gets set
+	/// </summary>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to make room for</param>
+	/// <param name="elementType">The type of elements you are storing (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)</param>
+	/// <param name="flags">The storage flags, GL_DYNAMIC_STORAGE_BIT is needed to be able to call UpdateData</param>
+	inline void AllocateStorage(size_t elementSize, size_t elementCount, GLenum elementType, GLbitfield flags = GL_DYNAMIC_STORAGE_BIT) {
+		IBuffer::AllocateStorage(elementSize, elementCount, flags);
+		_elementType = elementType;
+	}
+	/// <summary>
 	/// Loads data of a known type into this index buffer
 	/// </summary>
 	/// <typeparam name="T">The type of data to load, must be uint8_t, uint16_t or uint32_t</typeparam>
@@ -46,6 +59,14 @@ public:
 	/// <param name="count">The number of elements in the array to upload</param>
 	template <typename T>
 	void LoadData(const T* data, size_t count) { throw std::runtime_error("Must be one of uint8_t, uint16_t or uint32_t"); } // Note, see template specializations below
+	/// <summary>
+	/// Loads 32 bit indices into this buffer, storing them as 16 bit indices if every vertex in the mesh can be
+	/// addressed with 16 bits. This halves the size of the buffer (and the index bandwidth) for most meshes
+	/// </summary>
+	/// <param name="data">A pointer to the start of the indices</param>
+	/// <param name="count">The number of indices to upload</param>
+	/// <param name="vertexCount">The number of vertices in the mesh that the indices refer to</param>
+	inline void LoadCompactData(const uint32_t* data, size_t count, size_t vertexCount);
 
 	/// <summary>
 	/// Gets the underlying index type for this buffer (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
@@ -80,3 +101,12 @@ inline void IndexBuffer::LoadData<uint32_t>(const uint32_t* data, size_t count)
 	IBuffer::LoadData<uint32_t>(data, count);
 	_elementType = GL_UNSIGNED_INT;
 }
+
+inline void IndexBuffer::LoadCompactData(const uint32_t* data, size_t count, size_t vertexCount) {
+	if (vertexCount <= 0x10000) {
+		std::vector<uint16_t> narrowed(data, data + count);
+		LoadData(narrowed.data(), narrowed.size());
+	} else {
+		LoadData(data, count);
+	}
+}
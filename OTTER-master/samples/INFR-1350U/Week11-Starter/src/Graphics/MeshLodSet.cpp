@@ -0,0 +1,58 @@
+#include "MeshLodSet.h"
+
+#include <algorithm>
+#include <limits>
+
+MeshLodSet::MeshLodSet() :
+	_levels(),
+	_boundsCenter(glm::vec3(0.0f)),
+	_boundsRadius(0.0f)
+{ }
+
+void MeshLodSet::AddLevel(const VertexArrayObject::sptr& mesh, size_t triangleCount, float maxScreenSize, float error) {
+	Level level;
+	level.Mesh = mesh;
+	level.TriangleCount = triangleCount;
+	level.MaxScreenSize = maxScreenSize;
+	level.Error = error;
+	_levels.push_back(level);
+}
+
+size_t MeshLodSet::SelectLevel(float screenSize, size_t currentLevel, float hysteresis) const {
+	if (_levels.empty()) {
+		return 0;
+	}
+
+	// Step towards lower detail while we're comfortably under the next level's threshold, or back towards
+	// higher detail while we're comfortably over our own. Anything in between keeps the current level
+	size_t level = std::min(currentLevel, _levels.size() - 1);
+	while (level + 1 < _levels.size() && screenSize < _levels[level + 1].MaxScreenSize * (1.0f - hysteresis)) {
+		level++;
+	}
+	while (level > 0 && screenSize > _levels[level].MaxScreenSize * (1.0f + hysteresis)) {
+		level--;
+	}
+	return level;
+}
+
+float MeshLodSet::GetProjectedSize(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) const {
+	return ProjectSphere(_boundsCenter, _boundsRadius, model, view, projection);
+}
+
+float MeshLodSet::ProjectSphere(const glm::vec3& center, float boundsRadius, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
+	// Scale the radius by the largest axis scale, so the sphere still contains the mesh
+	const float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+	const float radius = boundsRadius * scale;
+	const glm::vec4 viewCenter = view * model * glm::vec4(center, 1.0f);
+
+	// projection[1][1] is cot(fov / 2) for perspective projections, and 1 / orthoHeight for orthographic ones
+	// Orthographic projections have a 1 in the bottom right, where perspective ones have a 0
+	if (projection[3][3] == 1.0f) {
+		return radius * projection[1][1];
+	}
+	const float distance = -viewCenter.z;
+	if (distance <= radius) {
+		return std::numeric_limits<float>::max();
+	}
+	return radius * projection[1][1] / distance;
+}
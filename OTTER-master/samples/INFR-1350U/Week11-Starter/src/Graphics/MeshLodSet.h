@@ -0,0 +1,115 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "VertexArrayObject.h"
+
+/// <summary>
+/// A set of meshes representing the same object at decreasing levels of detail. All the levels usually
+/// share one vertex buffer, and only differ in their index buffers. Level 0 is the full detail mesh
+/// </summary>
+class MeshLodSet final
+{
+public:
+	typedef std::shared_ptr<MeshLodSet> sptr;
+	static inline sptr Create() {
+		return std::make_shared<MeshLodSet>();
+	}
+	// We'll disallow moving and copying, these are shared between renderers via pointers
+	MeshLodSet(const MeshLodSet& other) = delete;
+	MeshLodSet(MeshLodSet&& other) = delete;
+	MeshLodSet& operator=(const MeshLodSet& other) = delete;
+	MeshLodSet& operator=(MeshLodSet&& other) = delete;
+
+	/// <summary>
+	/// Represents a single level of detail within the set
+	/// </summary>
+	struct Level
+	{
+		/// <summary>
+		/// The mesh to render for this level
+		/// </summary>
+		VertexArrayObject::sptr Mesh;
+		/// <summary>
+		/// The number of triangles in the mesh
+		/// </summary>
+		size_t TriangleCount;
+		/// <summary>
+		/// The largest projected size (see GetProjectedSize) that this level can be used at
+		/// </summary>
+		float  MaxScreenSize;
+		/// <summary>
+		/// The geometric error of this level, relative to the radius of the mesh
+		/// </summary>
+		float  Error;
+	};
+
+public:
+	MeshLodSet();
+	~MeshLodSet() = default;
+
+	/// <summary>
+	/// Adds a new level to the set, levels should be added from most to least detailed
+	/// </summary>
+	/// <param name="mesh">The mesh for the level</param>
+	/// <param name="triangleCount">The number of triangles in the mesh</param>
+	/// <param name="maxScreenSize">The largest projected size this level should be used at</param>
+	/// <param name="error">The geometric error of the level relative to the radius of the mesh</param>
+	void AddLevel(const VertexArrayObject::sptr& mesh, size_t triangleCount, float maxScreenSize, float error = 0.0f);
+
+	/// <summary>
+	/// Gets the number of levels in the set
+	/// </summary>
+	size_t GetLevelCount() const { return _levels.size(); }
+	/// <summary>
+	/// Gets a level from the set, where 0 is the most detailed
+	/// </summary>
+	const Level& GetLevel(size_t index) const { return _levels[index]; }
+
+	/// <summary>
+	/// Sets the bounding sphere of the mesh, in the mesh's local space
+	/// </summary>
+	void SetBounds(const glm::vec3& center, float radius) { _boundsCenter = center; _boundsRadius = radius; }
+	/// <summary>
+	/// Gets the center of the mesh's bounding sphere, in the mesh's local space
+	/// </summary>
+	const glm::vec3& GetBoundsCenter() const { return _boundsCenter; }
+	/// <summary>
+	/// Gets the radius of the mesh's bounding sphere, in the mesh's local space
+	/// </summary>
+	float GetBoundsRadius() const { return _boundsRadius; }
+
+	/// <summary>
+	/// Picks the level to use for a given projected size, with hysteresis so that objects sitting right on
+	/// a threshold don't flicker between levels every frame
+	/// </summary>
+	/// <param name="screenSize">The projected size of the mesh, see GetProjectedSize</param>
+	/// <param name="currentLevel">The level that was used last frame</param>
+	/// <param name="hysteresis">How far past a threshold the size must be before we switch, as a fraction of the threshold</param>
+	/// <returns>The index of the level to use</returns>
+	size_t SelectLevel(float screenSize, size_t currentLevel, float hysteresis = 0.1f) const;
+
+	/// <summary>
+	/// Gets the projected size of this set's bounding sphere, as a fraction of the viewport height
+	/// </summary>
+	/// <param name="model">The world transform of the object</param>
+	/// <param name="view">The camera's view matrix</param>
+	/// <param name="projection">The camera's projection matrix (perspective or orthographic)</param>
+	float GetProjectedSize(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) const;
+	/// <summary>
+	/// Gets the projected size of any bounding sphere, as a fraction of the viewport height. This is what
+	/// GetProjectedSize uses, it's exposed for other things with bounds (ex: MeshletSet)
+	/// </summary>
+	/// <param name="center">The center of the sphere, in the mesh's local space</param>
+	/// <param name="radius">The radius of the sphere, in the mesh's local space</param>
+	/// <param name="model">The world transform of the object</param>
+	/// <param name="view">The camera's view matrix</param>
+	/// <param name="projection">The camera's projection matrix (perspective or orthographic)</param>
+	static float ProjectSphere(const glm::vec3& center, float radius, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
+
+protected:
+	std::vector<Level> _levels;
+	glm::vec3 _boundsCenter;
+	float     _boundsRadius;
+};
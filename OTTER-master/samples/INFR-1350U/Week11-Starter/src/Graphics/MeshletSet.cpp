@@ -0,0 +1,103 @@
+#include "MeshletSet.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Logging.h"
+
+MeshletSet::MeshletSet() :
+	_mesh(nullptr),
+	_meshlets(),
+	_indexElementSize(0),
+	_triangleCount(0),
+	_boundsCenter(0.0f),
+	_boundsRadius(0.0f)
+{ }
+
+void MeshletSet::SetMesh(const VertexArrayObject::sptr& mesh, const std::vector<Meshlet>& meshlets) {
+	LOG_ASSERT(mesh != nullptr && mesh->GetIndexBuffer() != nullptr, "Meshlets need an indexed mesh!");
+	_mesh = mesh;
+	_meshlets = meshlets;
+	_indexElementSize = mesh->GetIndexBuffer()->GetElementSize();
+	_triangleCount = 0;
+	for (const Meshlet& meshlet : _meshlets) {
+		_triangleCount += meshlet.IndexCount / 3;
+	}
+
+	// The sphere around the whole mesh is centered on the box around the meshlet spheres, then grown to hold all of them
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+	for (const Meshlet& meshlet : _meshlets) {
+		min = glm::min(min, meshlet.Center - meshlet.Radius);
+		max = glm::max(max, meshlet.Center + meshlet.Radius);
+	}
+	_boundsCenter = _meshlets.empty() ? glm::vec3(0.0f) : (min + max) * 0.5f;
+	_boundsRadius = 0.0f;
+	for (const Meshlet& meshlet : _meshlets) {
+		_boundsRadius = std::max(_boundsRadius, glm::length(meshlet.Center - _boundsCenter) + meshlet.Radius);
+	}
+}
+
+void MeshletSet::Cull(const glm::mat4& model, const glm::mat4& viewProjection, const glm::vec3& cameraPos,
+	bool frustum, bool backface, MeshletDrawList& result) const
+{
+	result.Counts.clear();
+	result.Offsets.clear();
+	result.VisibleMeshlets = 0;
+	result.VisibleTriangles = 0;
+
+	// The planes of the model view projection matrix are the frustum planes in model space (Gribb and Hartmann),
+	// a sphere is outside if it is entirely behind any of them
+	const glm::mat4 mvp = viewProjection * model;
+	const glm::vec4 row0 = glm::vec4(mvp[0][0], mvp[1][0], mvp[2][0], mvp[3][0]);
+	const glm::vec4 row1 = glm::vec4(mvp[0][1], mvp[1][1], mvp[2][1], mvp[3][1]);
+	const glm::vec4 row2 = glm::vec4(mvp[0][2], mvp[1][2], mvp[2][2], mvp[3][2]);
+	const glm::vec4 row3 = glm::vec4(mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3]);
+	glm::vec4 planes[6] = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+	for (glm::vec4& plane : planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	// Whether a triangle faces the camera doesn't change under an affine transform, so we can move the
+	// camera into model space instead of moving every cone out of it
+	const glm::vec3 localCamera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+
+	// Index of the last meshlet we added, so that runs of visible meshlets become a single range
+	size_t lastVisible = _meshlets.size();
+	for (size_t ix = 0; ix < _meshlets.size(); ix++) {
+		const Meshlet& meshlet = _meshlets[ix];
+
+		if (frustum) {
+			bool outside = false;
+			for (const glm::vec4& plane : planes) {
+				if (glm::dot(glm::vec3(plane), meshlet.Center) + plane.w < -meshlet.Radius) {
+					outside = true;
+					break;
+				}
+			}
+			if (outside) {
+				continue;
+			}
+		}
+		if (backface) {
+			const glm::vec3 toCenter = meshlet.Center - localCamera;
+			if (glm::dot(toCenter, meshlet.ConeAxis) >= meshlet.ConeCutoff * glm::length(toCenter) + meshlet.Radius) {
+				continue;
+			}
+		}
+
+		if (lastVisible + 1 == ix && _meshlets[lastVisible].IndexOffset + _meshlets[lastVisible].IndexCount == meshlet.IndexOffset) {
+			result.Counts.back() += static_cast<GLsizei>(meshlet.IndexCount);
+		} else {
+			result.Counts.push_back(static_cast<GLsizei>(meshlet.IndexCount));
+			result.Offsets.push_back(reinterpret_cast<const void*>(static_cast<size_t>(meshlet.IndexOffset) * _indexElementSize));
+		}
+		lastVisible = ix;
+		result.VisibleMeshlets++;
+		result.VisibleTriangles += meshlet.IndexCount / 3;
+	}
+}
+
+void MeshletSet::Render(const MeshletDrawList& drawList) const {
+	_mesh->RenderRanges(drawList.Counts.data(), drawList.Offsets.data(), static_cast<GLsizei>(drawList.Counts.size()));
+}
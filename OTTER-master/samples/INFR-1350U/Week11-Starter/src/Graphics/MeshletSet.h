@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "VertexArrayObject.h"
+
+/// <summary>
+/// A small cluster of triangles (a meshlet) within a larger mesh, with the bounds needed to cull it. The
+/// triangles of a meshlet are stored contiguously in the mesh's index buffer. This is stored as-is in cooked
+/// mesh files, so it should only ever contain plain values
+/// </summary>
+struct Meshlet
+{
+	/// <summary>
+	/// The center of the meshlet's bounding sphere, in model space
+	/// </summary>
+	glm::vec3 Center;
+	/// <summary>
+	/// The radius of the meshlet's bounding sphere
+	/// </summary>
+	float     Radius;
+	/// <summary>
+	/// The average direction of the meshlet's triangle normals, zero if the normals are too spread out to cull
+	/// </summary>
+	glm::vec3 ConeAxis;
+	/// <summary>
+	/// The sine of the angle between the cone axis and the normal furthest from it. The whole meshlet is facing
+	/// away from the camera when dot(Center - camera, ConeAxis) >= ConeCutoff * length(Center - camera) + Radius
+	/// </summary>
+	float     ConeCutoff;
+	/// <summary>
+	/// The index of the meshlet's first index within the index buffer
+	/// </summary>
+	uint32_t  IndexOffset;
+	/// <summary>
+	/// The number of indices in the meshlet (3 per triangle)
+	/// </summary>
+	uint32_t  IndexCount;
+};
+
+/// <summary>
+/// The ranges of a meshlet set that survived culling, ready to be passed to glMultiDrawElements
+/// </summary>
+struct MeshletDrawList
+{
+	/// <summary>
+	/// The number of indices in each range
+	/// </summary>
+	std::vector<GLsizei>     Counts;
+	/// <summary>
+	/// The byte offset of each range within the index buffer
+	/// </summary>
+	std::vector<const void*> Offsets;
+	/// <summary>
+	/// The number of meshlets that were visible, meshlets that are next to each other get merged into one range
+	/// </summary>
+	size_t VisibleMeshlets;
+	/// <summary>
+	/// The number of triangles in the visible meshlets
+	/// </summary>
+	size_t VisibleTriangles;
+
+	MeshletDrawList() :
+		Counts(), Offsets(), VisibleMeshlets(0), VisibleTriangles(0)
+	{ }
+};
+
+/// <summary>
+/// A mesh that has been split into meshlets (see MeshletBuilder), so that the parts of it that are off screen
+/// or facing away from the camera can be skipped on the CPU before drawing
+/// </summary>
+class MeshletSet final
+{
+public:
+	typedef std::shared_ptr<MeshletSet> sptr;
+	static inline sptr Create() {
+		return std::make_shared<MeshletSet>();
+	}
+	// We'll disallow moving and copying, these are shared between renderers via pointers
+	MeshletSet(const MeshletSet& other) = delete;
+	MeshletSet(MeshletSet&& other) = delete;
+	MeshletSet& operator=(const MeshletSet& other) = delete;
+	MeshletSet& operator=(MeshletSet&& other) = delete;
+
+public:
+	MeshletSet();
+	~MeshletSet() = default;
+
+	/// <summary>
+	/// Sets the mesh and its meshlets, the mesh must draw its entire index buffer (see VertexArrayObject::SetIndexBuffer)
+	/// </summary>
+	/// <param name="mesh">The mesh that the meshlets index into</param>
+	/// <param name="meshlets">The meshlets of the mesh, ordered by their index offsets</param>
+	void SetMesh(const VertexArrayObject::sptr& mesh, const std::vector<Meshlet>& meshlets);
+
+	/// <summary>
+	/// Gets the mesh that the meshlets index into, rendering this draws every meshlet
+	/// </summary>
+	const VertexArrayObject::sptr& GetMesh() const { return _mesh; }
+	/// <summary>
+	/// Gets the number of meshlets in the set
+	/// </summary>
+	size_t GetMeshletCount() const { return _meshlets.size(); }
+	/// <summary>
+	/// Gets a meshlet from the set
+	/// </summary>
+	const Meshlet& GetMeshlet(size_t index) const { return _meshlets[index]; }
+	/// <summary>
+	/// Gets the total number of triangles in the set
+	/// </summary>
+	size_t GetTriangleCount() const { return _triangleCount; }
+	/// <summary>
+	/// Gets the center of the sphere around every meshlet, in the mesh's local space
+	/// </summary>
+	const glm::vec3& GetBoundsCenter() const { return _boundsCenter; }
+	/// <summary>
+	/// Gets the radius of the sphere around every meshlet, in the mesh's local space
+	/// </summary>
+	float GetBoundsRadius() const { return _boundsRadius; }
+
+	/// <summary>
+	/// Finds the meshlets that are visible to the camera. The tests are done in model space, so they stay exact
+	/// for objects with non-uniform scales
+	/// </summary>
+	/// <param name="model">The world transform of the object (without the mesh's vertex transform)</param>
+	/// <param name="viewProjection">The camera's view projection matrix</param>
+	/// <param name="cameraPos">The position of the camera in world space</param>
+	/// <param name="frustum">True to skip meshlets that are outside of the view frustum</param>
+	/// <param name="backface">True to skip meshlets whose triangles are all facing away from the camera</param>
+	/// <param name="result">The draw list to fill, any ranges already in it are cleared</param>
+	void Cull(const glm::mat4& model, const glm::mat4& viewProjection, const glm::vec3& cameraPos,
+		bool frustum, bool backface, MeshletDrawList& result) const;
+
+	/// <summary>
+	/// Draws the ranges in a draw list with a single glMultiDrawElements call
+	/// </summary>
+	/// <param name="drawList">The ranges to draw, see Cull</param>
+	void Render(const MeshletDrawList& drawList) const;
+
+protected:
+	VertexArrayObject::sptr _mesh;
+	std::vector<Meshlet>    _meshlets;
+	size_t                  _indexElementSize;
+	size_t                  _triangleCount;
+	glm::vec3               _boundsCenter;
+	float                   _boundsRadius;
+};
@@ -0,0 +1,161 @@
+#include "PixelUploadRing.h"
+
+#include "Logging.h"
+
+std::mutex PixelUploadRing::_lock;
+std::deque<PixelUploadRing::Allocation> PixelUploadRing::_allocations;
+GLuint PixelUploadRing::_handle = 0;
+uint8_t* PixelUploadRing::_mapped = nullptr;
+size_t PixelUploadRing::_capacity = 0;
+size_t PixelUploadRing::_head = 0;
+// Ids start at 1 so a default region never matches an allocation, and keep counting across Init calls so regions
+// from before a Shutdown can't match one either
+uint64_t PixelUploadRing::_nextId = 1;
+size_t PixelUploadRing::_uploadedBytes = 0;
+size_t PixelUploadRing::_misses = 0;
+
+void PixelUploadRing::Init(size_t size) {
+	std::lock_guard<std::mutex> guard(_lock);
+	if (_handle != 0) {
+		return;
+	}
+	size = (size + Alignment - 1) / Alignment * Alignment;
+
+	// Coherent mapping means writes from the loader threads are visible to any copy issued after them, without a flush
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &_handle);
+	glNamedBufferStorage(_handle, size, nullptr, flags);
+	_mapped = static_cast<uint8_t*>(glMapNamedBufferRange(_handle, 0, size, flags));
+	if (_mapped == nullptr) {
+		LOG_WARN("Failed to map the pixel upload ring, textures will upload from client memory");
+		glDeleteBuffers(1, &_handle);
+		_handle = 0;
+		return;
+	}
+	glObjectLabel(GL_BUFFER, _handle, -1, "Pixel Upload Ring");
+	_capacity = size;
+	_head = 0;
+	LOG_INFO("Pixel upload ring created with {:.2f} MB", size / (1024.0f * 1024.0f));
+}
+
+void PixelUploadRing::Shutdown() {
+	std::lock_guard<std::mutex> guard(_lock);
+	if (_handle == 0) {
+		return;
+	}
+	for (const Allocation& allocation : _allocations) {
+		if (allocation.Fence != nullptr) {
+			glClientWaitSync(allocation.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+			glDeleteSync(allocation.Fence);
+		}
+	}
+	_allocations.clear();
+	glUnmapNamedBuffer(_handle);
+	glDeleteBuffers(1, &_handle);
+	_handle = 0;
+	_mapped = nullptr;
+	_capacity = 0;
+	_head = 0;
+}
+
+bool PixelUploadRing::TryAllocate(size_t size, PixelUploadRegion& result) {
+	std::lock_guard<std::mutex> guard(_lock);
+	if (_handle == 0) {
+		return false;
+	}
+	const size_t alignedSize = (size + Alignment - 1) / Alignment * Alignment;
+
+	// The free space is everything from the head up to the oldest live region, wrapping around the end of the buffer.
+	// When the head has caught up with the tail and there are live regions, the ring is full
+	size_t offset = SIZE_MAX;
+	if (_allocations.empty()) {
+		_head = 0;
+		if (alignedSize <= _capacity) {
+			offset = 0;
+		}
+	} else {
+		const size_t tail = _allocations.front().Offset;
+		if (_head > tail) {
+			if (_head + alignedSize <= _capacity) {
+				offset = _head;
+			} else if (alignedSize <= tail) {
+				// Not enough room before the end, so we skip what's left and start again from the front
+				offset = 0;
+			}
+		} else if (_head < tail && _head + alignedSize <= tail) {
+			offset = _head;
+		}
+	}
+	if (offset == SIZE_MAX) {
+		_misses++;
+		return false;
+	}
+
+	_head = offset + alignedSize;
+	result.Data = _mapped + offset;
+	result.Offset = offset;
+	result.Size = size;
+	result.Id = _nextId++;
+	_allocations.push_back({ result.Id, offset, alignedSize, nullptr, false });
+	return true;
+}
+
+void PixelUploadRing::Submit(const PixelUploadRegion& region) {
+	_Finish(region, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+void PixelUploadRing::Release(const PixelUploadRegion& region) {
+	_Finish(region, nullptr);
+}
+
+void PixelUploadRing::_Finish(const PixelUploadRegion& region, GLsync fence) {
+	std::lock_guard<std::mutex> guard(_lock);
+	// The allocations are in id order with no gaps, so we can find the region without searching
+	if (!_allocations.empty() && region.Id >= _allocations.front().Id && region.Id - _allocations.front().Id < _allocations.size()) {
+		Allocation& allocation = _allocations[region.Id - _allocations.front().Id];
+		allocation.Fence = fence;
+		allocation.Finished = true;
+		if (fence != nullptr) {
+			_uploadedBytes += region.Size;
+		}
+	} else if (fence != nullptr) {
+		glDeleteSync(fence);
+	}
+}
+
+void PixelUploadRing::Retire() {
+	std::lock_guard<std::mutex> guard(_lock);
+	while (!_allocations.empty() && _allocations.front().Finished) {
+		Allocation& allocation = _allocations.front();
+		if (allocation.Fence != nullptr) {
+			// A timeout of 0 just checks the fence, if the GPU isn't done with this region it isn't done with the ones after it
+			if (glClientWaitSync(allocation.Fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+				break;
+			}
+			glDeleteSync(allocation.Fence);
+		}
+		_allocations.pop_front();
+	}
+}
+
+void PixelUploadRing::Bind() {
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _handle);
+}
+
+void PixelUploadRing::UnBind() {
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+PixelUploadRingStats PixelUploadRing::GetStats() {
+	std::lock_guard<std::mutex> guard(_lock);
+	PixelUploadRingStats result;
+	result.Capacity = _capacity;
+	result.BytesInUse = 0;
+	for (const Allocation& allocation : _allocations) {
+		result.BytesInUse += allocation.Size;
+	}
+	result.LiveRegions = _allocations.size();
+	result.UploadedBytes = _uploadedBytes;
+	result.Misses = _misses;
+	return result;
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#include <glad/glad.h>
+
+/// <summary>
+/// A piece of the pixel upload ring that texture data has been (or will be) written into
+/// </summary>
+struct PixelUploadRegion
+{
+	/// <summary>
+	/// Where to write the data, this is write only memory so it should never be read back
+	/// </summary>
+	uint8_t* Data;
+	/// <summary>
+	/// The offset of the region within the ring's buffer, this is what gets passed to GL as the pixel pointer
+	/// </summary>
+	size_t   Offset;
+	/// <summary>
+	/// The size of the region, in bytes
+	/// </summary>
+	size_t   Size;
+	/// <summary>
+	/// The number of the allocation, used to find the region again when it is submitted or released
+	/// </summary>
+	uint64_t Id;
+
+	PixelUploadRegion() :
+		Data(nullptr), Offset(0), Size(0), Id(0)
+	{ }
+
+	bool IsValid() const { return Data != nullptr; }
+};
+
+/// <summary>
+/// Statistics about how the pixel upload ring is being used
+/// </summary>
+struct PixelUploadRingStats
+{
+	/// <summary>
+	/// The size of the ring's buffer, in bytes (0 if the ring hasn't been initialized)
+	/// </summary>
+	size_t Capacity;
+	/// <summary>
+	/// The number of bytes that are allocated, including regions the GPU is still copying out of
+	/// </summary>
+	size_t BytesInUse;
+	/// <summary>
+	/// The number of regions that have not been retired yet
+	/// </summary>
+	size_t LiveRegions;
+	/// <summary>
+	/// The total number of bytes that have been uploaded through the ring
+	/// </summary>
+	size_t UploadedBytes;
+	/// <summary>
+	/// The number of allocations that didn't fit in the ring, and had to upload from client memory instead
+	/// </summary>
+	size_t Misses;
+};
+
+/// <summary>
+/// A ring of persistently mapped pixel unpack buffer memory for streaming texture data to the GPU. Loader threads
+/// write their pixels straight into the mapped memory (see Texture2DData::Stage), so all the GL thread has to do
+/// is issue the copy out of the buffer, instead of the driver copying the pixels out of client memory during the
+/// call. Each region gets a fence once its copy has been issued, and the space is reused once the fence has been
+/// signalled, so the GPU is never reading from memory that is being written to.
+///
+/// Regions are retired in the order they were allocated. Allocating never blocks, if the ring is full (or was never
+/// initialized) TryAllocate fails and the caller should upload from client memory like it would have otherwise
+/// </summary>
+class PixelUploadRing
+{
+public:
+	/// <summary>
+	/// Regions start on a multiple of this, which covers the alignment of every pixel type
+	/// </summary>
+	static constexpr size_t Alignment = 16;
+
+	/// <summary>
+	/// Creates and maps the ring's buffer, must be called from the GL thread
+	/// </summary>
+	/// <param name="size">The size of the ring, in bytes. Textures larger than this always upload from client memory</param>
+	static void Init(size_t size = 64 * 1024 * 1024);
+	/// <summary>
+	/// Waits for the GPU to finish with the ring and deletes the buffer, must be called from the GL thread. Regions that
+	/// are still held (ex: by texture data that was never uploaded) become invalid, and are ignored when released
+	/// </summary>
+	static void Shutdown();
+	static bool IsInitialized() { return _handle != 0; }
+
+	/// <summary>
+	/// Allocates a region of the ring to write data into, this is safe to call from any thread. Every region that is
+	/// allocated must be given back with either Submit or Release, and regions that are held on to stop the ring from
+	/// reusing anything allocated after them
+	/// </summary>
+	/// <param name="size">The number of bytes to allocate</param>
+	/// <param name="result">The region that was allocated</param>
+	/// <returns>True if the region was allocated, false if there was no room (or the ring isn't initialized)</returns>
+	static bool TryAllocate(size_t size, PixelUploadRegion& result);
+	/// <summary>
+	/// Marks that the copies out of a region have been issued, so it can be reused once the GPU has finished them.
+	/// Must be called from the GL thread, right after the copies
+	/// </summary>
+	static void Submit(const PixelUploadRegion& region);
+	/// <summary>
+	/// Gives back a region that was never submitted, this is safe to call from any thread
+	/// </summary>
+	static void Release(const PixelUploadRegion& region);
+	/// <summary>
+	/// Frees up every region that the GPU has finished with, without waiting on any that it hasn't. Must be called from
+	/// the GL thread, the AssetLoader does this once per frame
+	/// </summary>
+	static void Retire();
+
+	/// <summary>
+	/// Binds the ring's buffer to GL_PIXEL_UNPACK_BUFFER, so that pixel pointers are read as offsets into the ring
+	/// </summary>
+	static void Bind();
+	/// <summary>
+	/// Unbinds GL_PIXEL_UNPACK_BUFFER, so that pixel pointers point at client memory again
+	/// </summary>
+	static void UnBind();
+
+	/// <summary>
+	/// Gets the current statistics for the ring
+	/// </summary>
+	static PixelUploadRingStats GetStats();
+
+protected:
+	PixelUploadRing() = default;
+	~PixelUploadRing() = default;
+
+	struct Allocation
+	{
+		uint64_t Id;
+		size_t   Offset;
+		size_t   Size;
+		GLsync   Fence;
+		// True once the region has been submitted or released, it can be retired after that (and its fence)
+		bool     Finished;
+	};
+
+	/// <summary>
+	/// Marks an allocation as finished, with the fence that has to be signalled before it can be reused
+	/// </summary>
+	static void _Finish(const PixelUploadRegion& region, GLsync fence);
+
+	static std::mutex _lock;
+	static std::deque<Allocation> _allocations;
+	static GLuint _handle;
+	static uint8_t* _mapped;
+	static size_t _capacity;
+	static size_t _head;
+	static uint64_t _nextId;
+	static size_t _uploadedBytes;
+	static size_t _misses;
+};
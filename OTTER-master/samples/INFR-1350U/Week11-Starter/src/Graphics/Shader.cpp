@@ -1,7 +1,66 @@
 #include "Shader.h"
 #include "Logging.h"
-#include <fstream>
-#include <sstream>
+#include "Utilities/VirtualFileSystem.h"
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Deep enough for any sane include tree, and catches files that include themselves
+static constexpr int MaxIncludeDepth = 16;
+
+/// <summary>
+/// Reads a shader source file, replacing every #include "file" line with the contents of that file (resolved
+/// relative to the including file). #line directives are inserted so compile errors still point at the right
+/// line, with the source string number being the file's index in fileNames
+/// </summary>
+inline void ExpandShaderIncludes(const std::string& path, std::string& output, std::vector<std::string>& fileNames, int depth) {
+	if (depth > MaxIncludeDepth) {
+		LOG_ERROR("Shader includes nested too deeply (recursive include?) at: {}", path);
+		throw std::runtime_error("Shader includes nested too deeply, see logs for more information");
+	}
+	VfsFile file(path);
+	if (!file.IsOpen()) {
+		LOG_ERROR("File not found: {}", path);
+		throw std::runtime_error("File not found, see logs for more information");
+	}
+	const int fileIndex = static_cast<int>(fileNames.size());
+	fileNames.push_back(path);
+	if (depth > 0) {
+		output += "#line 1 " + std::to_string(fileIndex) + "\n";
+	}
+
+	const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	const char* lineStart = file.GetData();
+	int lineNumber = 1;
+	while (lineStart < file.GetEnd()) {
+		const char* lineEnd = std::find(lineStart, file.GetEnd(), '\n');
+		const char* cursor = lineStart;
+		while (cursor < lineEnd && (*cursor == ' ' || *cursor == '\t')) {
+			cursor++;
+		}
+
+		const std::string_view line(cursor, lineEnd - cursor);
+		if (line.rfind("#include", 0) == 0) {
+			const size_t nameStart = line.find('"');
+			const size_t nameEnd = nameStart == std::string_view::npos ? nameStart : line.find('"', nameStart + 1);
+			if (nameEnd == std::string_view::npos) {
+				LOG_ERROR("Malformed #include on line {} of {}, expected #include \"file\"", lineNumber, path);
+				throw std::runtime_error("Malformed shader include, see logs for more information");
+			}
+			const std::string name(line.substr(nameStart + 1, nameEnd - nameStart - 1));
+			ExpandShaderIncludes((directory / name).generic_string(), output, fileNames, depth + 1);
+			output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+		} else {
+			output.append(lineStart, lineEnd);
+			output += '\n';
+		}
+
+		lineStart = lineEnd + 1;
+		lineNumber++;
+	}
+}
 
 Shader::Shader() :
 	_vs(0),
@@ -64,15 +123,17 @@ bool Shader::LoadShaderPart(const char* source, GLenum type)
 }
 
 bool Shader::LoadShaderPartFromFile(const char* path, GLenum type) {
-	std::ifstream file(path);
-	if (!file.is_open()) {
-		LOG_ERROR("File not found: {}", path);
-		throw std::runtime_error("File not found, see logs for more information");
+	// GL wants a null terminated string, which the file's data isn't, so we always build a copy
+	std::string source;
+	std::vector<std::string> fileNames;
+	ExpandShaderIncludes(path, source, fileNames, 0);
+	const bool result = LoadShaderPart(source.c_str(), type);
+	// Errors in included files are reported against their index, which is only useful if we know which is which
+	if (!result && fileNames.size() > 1) {
+		for (size_t ix = 0; ix < fileNames.size(); ix++) {
+			LOG_ERROR("\tSource {}: {}", ix, fileNames[ix]);
+		}
 	}
-	std::stringstream stream;
-	stream << file.rdbuf();
-	bool result = LoadShaderPart(stream.str().c_str(), type);
-	file.close();
 	return result;
 }
 
@@ -173,6 +234,13 @@ void Shader::SetUniform(int location, const glm::bvec4* value, int count) {
 	glProgramUniform4i(location, value->x, value->y, value->z, value->w, 1);
 }
 
+void Shader::SetUniformBlockBinding(const std::string& name, GLuint slot) {
+	const GLuint index = glGetUniformBlockIndex(_handle, name.c_str());
+	if (index != GL_INVALID_INDEX) {
+		glUniformBlockBinding(_handle, index, slot);
+	}
+}
+
 int Shader::GetUniformLocation(const std::string& name) {
 	// Search the map for the given name
 	std::unordered_map<std::string, int>::const_iterator it = _uniformLocs.find(name);
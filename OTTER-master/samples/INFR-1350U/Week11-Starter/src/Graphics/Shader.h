@@ -44,7 +44,8 @@ public:
 	/// <returns>True if the shader is loaded, false if there was an issue</returns>
 	bool LoadShaderPart(const char* source, GLenum type);
 	/// <summary>
-	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader) from an external file (in res)
+	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader) from an external file (in res).
+	/// Lines of the form #include "file" are replaced with the contents of that file, relative to the including file
 	/// </summary>
 	/// <param name="path">The relative path to the file containing the source</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -73,6 +74,13 @@ public:
 	
 public:
 	int GetUniformLocation(const std::string& name);
+	/// <summary>
+	/// Points a uniform block in this shader at a binding slot, so it reads from whichever UniformBuffer is bound
+	/// there. Blocks that the shader doesn't use are ignored
+	/// </summary>
+	/// <param name="name">The name of the uniform block</param>
+	/// <param name="slot">The binding slot to read the block from</param>
+	void SetUniformBlockBinding(const std::string& name, GLuint slot);
 	
 	template <typename T>
 	void SetUniform(const std::string& name, const T& value) {
@@ -1,7 +1,12 @@
 #include "Texture2D.h"
 
+#include <algorithm>
+
+#include "PixelUploadRing.h"
+#include "Utilities/TextureRegistry.h"
+
 Texture2D::Texture2D(const Texture2DDescription& description) :
-	ITexture(), _description(description)
+	ITexture(), _description(description), _levelCount(1)
 {
 
 	_RecreateTexture();
@@ -21,26 +26,58 @@ void Texture2D::_RecreateTexture() {
 
 	if (_description.Width * _description.Height > 0 && _description.Format != InternalFormat::Unknown)
 	{
-		glTextureStorage2D(_handle, 1, *_description.Format, _description.Width, _description.Height);
+		glTextureStorage2D(_handle, _levelCount, *_description.Format, _description.Width, _description.Height);
 
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
 		glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
 		glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
+		glTextureParameterf(_handle, GL_TEXTURE_MIN_LOD, _description.MinLod);
 	}
 }
 
 void Texture2D::LoadData(const Texture2DData::sptr& data) {
+	// Data that a loader thread staged in the upload ring gets copied out of the ring's buffer, so the pointers we
+	// hand to GL are offsets into it instead of client memory
+	const PixelUploadRegion staging = data->TakeStaging();
+	const uint8_t* bytes = static_cast<const uint8_t*>(data->GetDataPtr());
+	if (staging.IsValid()) {
+		PixelUploadRing::Bind();
+		bytes = reinterpret_cast<const uint8_t*>(staging.Offset);
+	}
+
+	if (data->IsCompressed()) {
+		_LoadCompressedData(data, bytes);
+	} else {
+		_LoadPixelData(data, bytes);
+	}
+
+	if (staging.IsValid()) {
+		PixelUploadRing::UnBind();
+		PixelUploadRing::Submit(staging);
+	}
+}
+
+void Texture2D::_LoadPixelData(const Texture2DData::sptr& data, const uint8_t* bytes) {
+	// Data that brings its own mip chain gets exactly those levels, otherwise we make room for the whole chain if
+	// we're going to generate it
+	const uint32_t levelCount = data->GetLevelCount() > 1 ? data->GetLevelCount() :
+		(_description.GenerateMipMaps ? GetMipLevelCount(data->GetWidth(), data->GetHeight()) : 1);
+
+	// Textures that were holding compressed data have to go back to a format we can upload pixels into
 	if (_description.Width != data->GetWidth() ||
-		_description.Height != data->GetHeight()) 
+		_description.Height != data->GetHeight() ||
+		IsCompressedFormat(_description.Format) ||
+		_levelCount != levelCount) 
 	{
 		_description.Width = data->GetWidth();
 		_description.Height = data->GetHeight();
 		
-		if (_description.Format == InternalFormat::Unknown) {
+		if (_description.Format == InternalFormat::Unknown || IsCompressedFormat(_description.Format)) {
 			_description.Format = data->GetRecommendedFormat();
 		}
+		_levelCount = levelCount;
 		
 		_RecreateTexture();
 	}
@@ -50,24 +87,132 @@ void Texture2D::LoadData(const Texture2DData::sptr& data) {
 		glObjectLabel(GL_TEXTURE, _handle, data->DebugName.length(), data->DebugName.c_str());
 	}
 	
-	// Align the data store to the size of a single component in
+	// Upload our data to our image, one level at a time. Our rows are tightly packed, so the unpack alignment has to
+	// match each level's row size or GL will skip over padding that isn't there (ex: RGB8 rows with an odd width)
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
-	int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
-
-	// Upload our data to our image
-	glTextureSubImage2D(_handle, 0, 0, 0, _description.Width, _description.Height, *data->GetFormat(), *data->GetPixelType(), data->GetDataPtr());
+	for (uint32_t level = 0; level < data->GetLevelCount(); level++) {
+		const Texture2DLevel& info = data->GetLevel(level);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, GetUnpackAlignment(info.Size / info.Height));
+		glTextureSubImage2D(_handle, level, 0, 0, info.Width, info.Height, *data->GetFormat(), *data->GetPixelType(), bytes + info.Offset);
+	}
 
-	if (_description.GenerateMipMaps) {
+	// Data without a mip chain (ex: something that was drawn at runtime) falls back to having the driver generate them
+	if (data->GetLevelCount() == 1 && _levelCount > 1) {
 		glGenerateTextureMipmap(_handle);
 	}
 }
 
+void Texture2D::_LoadCompressedData(const Texture2DData::sptr& data, const uint8_t* bytes) {
+	if (_description.Width != data->GetWidth() ||
+		_description.Height != data->GetHeight() ||
+		_description.Format != data->GetRecommendedFormat() ||
+		_levelCount != data->GetLevelCount())
+	{
+		_description.Width = data->GetWidth();
+		_description.Height = data->GetHeight();
+		_description.Format = data->GetRecommendedFormat();
+		_levelCount = data->GetLevelCount();
+
+		_RecreateTexture();
+	}
+
+	if (!data->DebugName.empty()) {
+		glObjectLabel(GL_TEXTURE, _handle, data->DebugName.length(), data->DebugName.c_str());
+	}
+
+	// The driver can't generate mips for compressed formats, so the whole chain comes from the data. If it only has
+	// the one level, the storage only has one level too and the texture stays complete
+	for (uint32_t level = 0; level < _levelCount; level++) {
+		const Texture2DLevel& info = data->GetLevel(level);
+		glCompressedTextureSubImage2D(_handle, level, 0, 0, info.Width, info.Height, *_description.Format, (GLsizei)info.Size, bytes + info.Offset);
+	}
+}
+
+void Texture2D::LoadLevels(const Texture2DData::sptr& data, uint32_t firstLevel) {
+	LOG_ASSERT(firstLevel + data->GetLevelCount() <= _levelCount, "Levels {} to {} are out of range, the texture only has {} levels",
+		firstLevel, firstLevel + data->GetLevelCount() - 1, _levelCount);
+	LOG_ASSERT(data->IsCompressed() ? data->GetRecommendedFormat() == _description.Format : !IsCompressedFormat(_description.Format),
+		"Data in format {} can't be uploaded into a texture with format {}", data->GetRecommendedFormat(), _description.Format);
+
+	const PixelUploadRegion staging = data->TakeStaging();
+	const uint8_t* bytes = static_cast<const uint8_t*>(data->GetDataPtr());
+	if (staging.IsValid()) {
+		PixelUploadRing::Bind();
+		bytes = reinterpret_cast<const uint8_t*>(staging.Offset);
+	}
+
+	for (uint32_t level = 0; level < data->GetLevelCount(); level++) {
+		const Texture2DLevel& info = data->GetLevel(level);
+		LOG_ASSERT(info.Width == std::max(_description.Width >> (firstLevel + level), 1u) && info.Height == std::max(_description.Height >> (firstLevel + level), 1u),
+			"Level {} is {}x{}, which doesn't match the texture", firstLevel + level, info.Width, info.Height);
+		if (data->IsCompressed()) {
+			glCompressedTextureSubImage2D(_handle, firstLevel + level, 0, 0, info.Width, info.Height, *_description.Format, (GLsizei)info.Size, bytes + info.Offset);
+		} else {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, GetUnpackAlignment(info.Size / info.Height));
+			glTextureSubImage2D(_handle, firstLevel + level, 0, 0, info.Width, info.Height, *data->GetFormat(), *data->GetPixelType(), bytes + info.Offset);
+		}
+	}
+
+	if (staging.IsValid()) {
+		PixelUploadRing::UnBind();
+		PixelUploadRing::Submit(staging);
+	}
+}
+
+void Texture2D::Reallocate(InternalFormat format, uint32_t width, uint32_t height, uint32_t levelCount) {
+	// We hold on to the old storage until its levels have been copied over, so _RecreateTexture can't delete it
+	const GLuint oldHandle = _handle;
+	const Texture2DDescription old = _description;
+	const uint32_t oldLevelCount = _levelCount;
+	_handle = 0;
+
+	_description.Format = format;
+	_description.Width = width;
+	_description.Height = height;
+	_levelCount = std::clamp(levelCount, 1u, GetMipLevelCount(width, height));
+	_RecreateTexture();
+
+	if (oldHandle == 0) {
+		return;
+	}
+
+	// The copies stay on the GPU. Sizes are rounded down at every level, so a level of the old chain is the same
+	// size as the matching level of the new one no matter how many levels were added or dropped above it
+	if (old.Format == _description.Format) {
+		for (uint32_t level = 0; level < _levelCount; level++) {
+			const uint32_t levelWidth = std::max(width >> level, 1u);
+			const uint32_t levelHeight = std::max(height >> level, 1u);
+			for (uint32_t oldLevel = 0; oldLevel < oldLevelCount; oldLevel++) {
+				if (std::max(old.Width >> oldLevel, 1u) == levelWidth && std::max(old.Height >> oldLevel, 1u) == levelHeight) {
+					glCopyImageSubData(oldHandle, GL_TEXTURE_2D, oldLevel, 0, 0, 0, _handle, GL_TEXTURE_2D, level, 0, 0, 0, levelWidth, levelHeight, 1);
+					break;
+				}
+			}
+		}
+	}
+
+	// Keep the debug label, since error logs would lose track of the texture otherwise
+	char label[256];
+	GLsizei labelLength = 0;
+	glGetObjectLabel(GL_TEXTURE, oldHandle, sizeof(label), &labelLength, label);
+	if (labelLength > 0) {
+		glObjectLabel(GL_TEXTURE, _handle, labelLength, label);
+	}
+	glDeleteTextures(1, &oldHandle);
+}
+
 Texture2D::sptr Texture2D::LoadFromFile(const std::string& path) {
-	Texture2DData::sptr data = Texture2DData::LoadFromFile(path);
-	LOG_ASSERT(data != nullptr, "Failed to load image from file!");
-	Texture2D::sptr result = Texture2D::Create();
-	result->LoadData(data);
+	return TextureRegistry::Load(path);
+}
+
+size_t Texture2D::GetResidentBytes() const {
+	if (_handle == 0) {
+		return 0;
+	}
+	size_t result = 0;
+	for (uint32_t level = 0; level < _levelCount; level++) {
+		result += GetTextureLevelSize(_description.Format, std::max(_description.Width >> level, 1u), std::max(_description.Height >> level, 1u));
+	}
 	return result;
 }
 
@@ -109,3 +254,10 @@ void Texture2D::SetAnisotropicFiltering(float level)
 		glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
 	}
 }
+
+void Texture2D::SetMinLod(float lod) {
+	_description.MinLod = lod;
+	if (_handle != 0) {
+		glTextureParameterf(_handle, GL_TEXTURE_MIN_LOD, _description.MinLod);
+	}
+}
\ No newline at end of file
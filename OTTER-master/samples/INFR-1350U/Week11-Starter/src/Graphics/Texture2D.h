@@ -18,6 +18,11 @@ struct Texture2DDescription
 	MinFilter      MinificationFilter;
 	MagFilter      MagnificationFilter;
 	float          MaxAnisotropic;
+	/// <summary>
+	/// The most detailed level that sampling is allowed to use, see GL_TEXTURE_MIN_LOD. Fractional values blend
+	/// between levels, which is how the TextureStreamer fades in levels that were just loaded
+	/// </summary>
+	float          MinLod;
 	bool           GenerateMipMaps;
 
 	Texture2DDescription() :
@@ -28,6 +33,7 @@ struct Texture2DDescription
 		MinificationFilter(MinFilter::NearestMipLinear),
 		MagnificationFilter(MagFilter::Linear),
 		MaxAnisotropic(-1.0f),
+		MinLod(0.0f),
 		GenerateMipMaps(true)
 	{ }
 };
@@ -60,13 +66,37 @@ public:
 	~Texture2D() = default;
 
 	/// <summary>
-	/// Uploads data to this texture
+	/// Uploads data to this texture. Block compressed data replaces the texture's format and mip chain with its own,
+	/// since it can't be converted or have mip maps generated for it. Data that has been staged (see Texture2DData::Stage)
+	/// is copied out of the PixelUploadRing instead of client memory
 	/// </summary>
 	/// <param name="data">The texture data to upload into this texture</param>
 	void LoadData(const Texture2DData::sptr& data);
+	/// <summary>
+	/// Uploads levels into the texture's existing storage, without changing its size, format or level count. The data's
+	/// top level goes into firstLevel, and its format has to match the storage (compressed data must be in the same
+	/// block format, pixel data must be going into a format that isn't compressed)
+	/// </summary>
+	/// <param name="data">The levels to upload, see Texture2DData::CopyLevels</param>
+	/// <param name="firstLevel">The level of the texture to upload the data's top level into</param>
+	void LoadLevels(const Texture2DData::sptr& data, uint32_t firstLevel);
+	/// <summary>
+	/// Replaces the texture's storage with a new size and level count, keeping any levels that exist in both the
+	/// old and the new storage (levels are matched by their size, so this can add or drop levels at the top of a
+	/// chain). Anything holding on to this texture picks up the new storage, since the object stays the same. Used by
+	/// the TextureStreamer, where the storage only holds the levels that are resident
+	/// </summary>
+	/// <param name="format">The internal format of the new storage, levels are only kept if this matches the old format</param>
+	/// <param name="width">The width of the new top level, in pixels</param>
+	/// <param name="height">The height of the new top level, in pixels</param>
+	/// <param name="levelCount">The number of levels to allocate</param>
+	void Reallocate(InternalFormat format, uint32_t width, uint32_t height, uint32_t levelCount);
 
 	/// <summary>
-	/// Loads an image directly from a file
+	/// Loads an image directly from a file. Textures are shared through the TextureRegistry, so loading a file
+	/// that is already resident returns the same texture without decoding or uploading anything. Changing the
+	/// sampler settings of the result will change them for everyone who loaded the file, use Create and
+	/// LoadData for a texture of your own
 	/// </summary>
 	/// <param name="path">The path to load the image from</param>
 	/// <returns>A pointer to the loaded image</returns>
@@ -79,17 +109,31 @@ public:
 	MagFilter GetMagFilter() const { return _description.MagnificationFilter; }
 	WrapMode GetWrapS() const { return _description.HorizontalWrap; }
 	WrapMode GetWrapT() const { return _description.VerticalWrap; }
+	float GetMinLod() const { return _description.MinLod; }
 	
 	void SetMinFilter(MinFilter filter);
 	void SetMagFilter(MagFilter filter);
 	void SetWrapS(WrapMode mode);
 	void SetWrapT(WrapMode mode);
 	void SetAnisotropicFiltering(float level = -1.0f);
+	void SetMinLod(float lod);
 
 	const Texture2DDescription& GetDescription() const { return _description; }
+	/// <summary>
+	/// Gets the number of mip levels that the texture's storage was allocated with
+	/// </summary>
+	uint32_t GetLevelCount() const { return _levelCount; }
+	/// <summary>
+	/// Gets the number of bytes of GPU memory used by the texture's storage (an estimate, drivers may pad it)
+	/// </summary>
+	size_t GetResidentBytes() const;
 	
 private:
 	Texture2DDescription _description;
+	uint32_t             _levelCount;
 
 	void _RecreateTexture();
+	// bytes is either the data's pointer, or its offset into the upload ring while the ring is bound
+	void _LoadPixelData(const Texture2DData::sptr& data, const uint8_t* bytes);
+	void _LoadCompressedData(const Texture2DData::sptr& data, const uint8_t* bytes);
 };
@@ -0,0 +1,51 @@
+#include "Texture2DArray.h"
+
+#include <algorithm>
+
+#include "Logging.h"
+
+Texture2DArray::Texture2DArray(const Texture2DArrayDescription& description) :
+	ITexture(), _description(description)
+{
+	LOG_ASSERT(_description.Width * _description.Height * _description.Layers > 0, "Texture arrays need at least one texel and one layer!");
+	LOG_ASSERT(_description.Format != InternalFormat::Unknown, "Texture arrays need a format!");
+	LOG_ASSERT(_description.Layers <= (uint32_t)ITexture::GetLimits().MAX_ARRAY_TEXTURE_LAYERS, "Texture array has {} layers, but the GPU only supports {}",
+		_description.Layers, ITexture::GetLimits().MAX_ARRAY_TEXTURE_LAYERS);
+
+	if (_description.MaxAnisotropic < 0.0f) {
+		_description.MaxAnisotropic = ITexture::GetLimits().MAX_ANISOTROPY;
+	}
+	_description.LevelCount = std::clamp(_description.LevelCount, 1u, GetMipLevelCount(_description.Width, _description.Height));
+
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &_handle);
+	glTextureStorage3D(_handle, _description.LevelCount, *_description.Format, _description.Width, _description.Height, _description.Layers);
+
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
+	glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
+	glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
+}
+
+void Texture2DArray::CopyLayer(uint32_t layer, const Texture2D::sptr& source) {
+	LOG_ASSERT(layer < _description.Layers, "Layer {} is out of range, the array only has {} layers", layer, _description.Layers);
+	LOG_ASSERT(source->GetWidth() == _description.Width && source->GetHeight() == _description.Height, "Texture size does not match the array!");
+	LOG_ASSERT(source->GetFormat() == _description.Format, "Texture format does not match the array!");
+	LOG_ASSERT(source->GetLevelCount() == _description.LevelCount, "Texture has {} levels, but the array has {}", source->GetLevelCount(), _description.LevelCount);
+
+	// The copy stays on the GPU, and works the same for compressed formats since every level is copied whole
+	for (uint32_t level = 0; level < _description.LevelCount; level++) {
+		const GLsizei width = std::max(_description.Width >> level, 1u);
+		const GLsizei height = std::max(_description.Height >> level, 1u);
+		glCopyImageSubData(source->GetHandle(), GL_TEXTURE_2D, level, 0, 0, 0,
+			_handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+	}
+}
+
+size_t Texture2DArray::GetResidentBytes() const {
+	size_t result = 0;
+	for (uint32_t level = 0; level < _description.LevelCount; level++) {
+		result += GetTextureLevelSize(_description.Format, std::max(_description.Width >> level, 1u), std::max(_description.Height >> level, 1u));
+	}
+	return result * _description.Layers;
+}
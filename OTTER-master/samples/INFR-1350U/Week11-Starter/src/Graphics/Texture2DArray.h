@@ -0,0 +1,97 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+
+#include "ITexture.h"
+#include "TextureEnums.h"
+#include "Texture2D.h"
+
+struct Texture2DArrayDescription
+{
+	uint32_t       Width;
+	uint32_t       Height;
+	uint32_t       Layers;
+	uint32_t       LevelCount;
+	InternalFormat Format;
+	WrapMode       HorizontalWrap;
+	WrapMode       VerticalWrap;
+	MinFilter      MinificationFilter;
+	MagFilter      MagnificationFilter;
+	float          MaxAnisotropic;
+
+	Texture2DArrayDescription() :
+		Width(0), Height(0), Layers(0),
+		LevelCount(1),
+		Format(InternalFormat::Unknown),
+		HorizontalWrap(WrapMode::Repeat),
+		VerticalWrap(WrapMode::Repeat),
+		MinificationFilter(MinFilter::NearestMipLinear),
+		MagnificationFilter(MagFilter::Linear),
+		MaxAnisotropic(-1.0f)
+	{ }
+};
+
+/// <summary>
+/// Represents a wrapper around an OpenGL 2D array texture, where every layer is a full 2D image (with its own mip
+/// chain) of the same size and format. Shaders sample it with a sampler2DArray and a layer index, so materials that
+/// only differ by which image they use can share a single binding (see TextureArrayPacker)
+/// </summary>
+class Texture2DArray final : public ITexture
+{
+public:
+	Texture2DArray(const Texture2DArray& other) = delete;
+	Texture2DArray(Texture2DArray&& other) = delete;
+	Texture2DArray& operator=(const Texture2DArray& other) = delete;
+	Texture2DArray& operator=(Texture2DArray&& other) = delete;
+
+	typedef std::shared_ptr<Texture2DArray> sptr;
+	static inline sptr Create(const Texture2DArrayDescription& description) {
+		return std::make_shared<Texture2DArray>(description);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new array texture and allocates storage for all of its layers and levels. The storage is immutable,
+	/// so the size, format, layer count and level count can't be changed afterwards
+	/// </summary>
+	/// <param name="description">The description of the array</param>
+	Texture2DArray(const Texture2DArrayDescription& description);
+	// ITexture handles destroying the OpenGL data, so we can use the default destructor
+	~Texture2DArray() = default;
+
+	/// <summary>
+	/// Copies every level of a resident texture into one layer of this array on the GPU, without reading anything
+	/// back. The texture must have the same size, format and level count as the array
+	/// </summary>
+	/// <param name="layer">The layer to copy into</param>
+	/// <param name="source">The texture to copy from</param>
+	void CopyLayer(uint32_t layer, const Texture2D::sptr& source);
+
+	uint32_t GetWidth() const { return _description.Width; }
+	uint32_t GetHeight() const { return _description.Height; }
+	uint32_t GetLayerCount() const { return _description.Layers; }
+	uint32_t GetLevelCount() const { return _description.LevelCount; }
+	InternalFormat GetFormat() const { return _description.Format; }
+
+	const Texture2DArrayDescription& GetDescription() const { return _description; }
+	/// <summary>
+	/// Gets the number of bytes of GPU memory used by the array's storage (an estimate, drivers may pad it)
+	/// </summary>
+	size_t GetResidentBytes() const;
+
+private:
+	Texture2DArrayDescription _description;
+};
+
+/// <summary>
+/// Refers to a single image inside of a texture array, this is what materials hold in place of a Texture2D
+/// (see ShaderMaterial::Set)
+/// </summary>
+struct TextureArraySlot
+{
+	Texture2DArray::sptr Array;
+	uint32_t             Layer;
+
+	TextureArraySlot() : Array(nullptr), Layer(0) { }
+	TextureArraySlot(const Texture2DArray::sptr& array, uint32_t layer) : Array(array), Layer(layer) { }
+};
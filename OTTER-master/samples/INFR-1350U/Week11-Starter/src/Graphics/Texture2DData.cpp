@@ -1,8 +1,15 @@
 #include "Texture2DData.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <mutex>
+#include <vector>
 #include <stb_image.h>
 
+#include "Utilities/MipGenerator.h"
+#include "Utilities/TextureContainer.h"
+#include "Utilities/VirtualFileSystem.h"
+
 Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
 	_width(width), _height(height), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat)
 {
@@ -13,28 +20,84 @@ Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format
 	if (sourceData != nullptr) {
 		memcpy(_data, sourceData, _dataSize);
 	}
+	_levels.push_back({ width, height, 0, _dataSize });
+}
+
+Texture2DData::Texture2DData(AdoptData, uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* ownedData, InternalFormat recommendedFormat) :
+	_width(width), _height(height), _format(format), _type(type), _data(ownedData), _recommendedFormat(recommendedFormat)
+{
+	LOG_ASSERT(width > 0 & height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
+	LOG_ASSERT(_data != nullptr, "Cannot adopt a null buffer!");
+	_dataSize = width * (size_t)height * GetTexelSize(_format, _type);
+	_levels.push_back({ width, height, 0, _dataSize });
 }
 
 Texture2DData::~Texture2DData() {
+	_ReleaseStaging();
 	free(_data);
 }
 
-Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool forceRgba)
-{
-	// Variables that will store properties about our image
-	int width, height, numChannels;
-	const int targetChannels = forceRgba ? 4 : 0;
+Texture2DData::sptr Texture2DData::CreateCompressed(InternalFormat format, const std::vector<Texture2DLevel>& levels, const void* sourceData, size_t dataSize) {
+	LOG_ASSERT(IsCompressedFormat(format), "Format {} is not block compressed!", format);
+	LOG_ASSERT(!levels.empty(), "Compressed data needs at least one level!");
+	for (const Texture2DLevel& level : levels) {
+		LOG_ASSERT(level.Offset + level.Size <= dataSize, "Level {}x{} is outside of the data!", level.Width, level.Height);
+		LOG_ASSERT(level.Size == GetTextureLevelSize(format, level.Width, level.Height), "Level {}x{} has the wrong size for {}!", level.Width, level.Height, format);
+	}
 
-	// Use STBI to load the image
-	stbi_set_flip_vertically_on_load(true);
-	uint8_t* data = stbi_load(file.c_str(), &width, &height, &numChannels, targetChannels);
+	void* buffer = malloc(dataSize);
+	LOG_ASSERT(buffer != nullptr, "Failed to allocate texture data!");
+	memcpy(buffer, sourceData, dataSize);
 
-	// If we could not load any data, warn and return null
-	if (data == nullptr) {
-		LOG_WARN("STBI Failed to load image from \"{}\"", file); 
-		return nullptr; 
+	// The pixel format and type are never used for compressed data, they're only filled in so they're not garbage
+	Texture2DData::sptr result(new Texture2DData(AdoptData(), levels[0].Width, levels[0].Height, PixelFormat::RGBA, PixelType::UByte, buffer, format));
+	result->_dataSize = dataSize;
+	result->_levels = levels;
+	return result;
+}
+
+void* Texture2DData::_ReleaseData() {
+	_ReleaseStaging();
+	void* result = _data;
+	_data = nullptr;
+	return result;
+}
+
+void Texture2DData::_ReleaseStaging() {
+	if (_staging.IsValid()) {
+		PixelUploadRing::Release(_staging);
+		_staging = PixelUploadRegion();
+	}
+}
+
+bool Texture2DData::Stage() {
+	if (_staging.IsValid()) {
+		return true;
 	}
+	if (!PixelUploadRing::TryAllocate(_dataSize, _staging)) {
+		return false;
+	}
+	memcpy(_staging.Data, _data, _dataSize);
+	return true;
+}
+
+PixelUploadRegion Texture2DData::TakeStaging() {
+	PixelUploadRegion result = _staging;
+	_staging = PixelUploadRegion();
+	return result;
+}
 
+/// <summary>
+/// Makes sure STBI is set up to flip images, the flip setting is a global in STBI, so we only set it once
+/// in case images are being loaded on multiple threads
+/// </summary>
+void InitStbiFlip() {
+	static std::once_flag flipFlag;
+	std::call_once(flipFlag, []() { stbi_set_flip_vertically_on_load(true); });
+}
+
+Texture2DData::sptr Texture2DData::_CreateFromStbi(uint8_t* data, int width, int height, int numChannels, int targetChannels, const std::string& name)
+{
 	// We should estimate a good format for our data
 
 	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
@@ -62,22 +125,130 @@ Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool fo
 		image_format = PixelFormat::RGBA;
 		break;
 	default:
-		LOG_ASSERT(false, "Unsupported texture format for texture \"{}\" with {} channels", file, numChannels)
+		LOG_ASSERT(false, "Unsupported texture format for texture \"{}\" with {} channels", name, numChannels)
 		break;
 	}
 	
-	// This is one of those poorly documented things in OpenGL
+	// This is one of those poorly documented things in OpenGL, rows are expected to be padded out to 4 bytes by default
 	if ((numChannels * width) % 4 != 0) {
-		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+		LOG_WARN("The rows of \"{}\" are not a multiple of 4 bytes, it will be uploaded with a GL_UNPACK_ALIGNMENT of {}", name, GetUnpackAlignment((size_t)numChannels * width));
 	}
 
-	// Create the result and store our image data in it
-	// Note that stbi will always give us an array of unsigned bytes (uint8_t)
-	Texture2DData::sptr result = std::make_shared<Texture2DData>(width, height, image_format, PixelType::UByte, data, internal_format);
-	result->DebugName = std::filesystem::path(file).filename().string();
-	
-	// We now have a copy in our ptr, we can free STBI's copy of it
-	stbi_image_free(data);
+	// Create the result and hand it STBI's buffer, so the decoded image never gets copied
+	// Note that stbi will always give us an array of unsigned bytes (uint8_t), allocated with malloc (see STBI_MALLOC)
+	Texture2DData::sptr result(new Texture2DData(AdoptData(), width, height, image_format, PixelType::UByte, data, internal_format));
+	result->DebugName = name;
 
 	return result;
 }
+
+Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool forceRgba)
+{
+	// Variables that will store properties about our image
+	int width, height, numChannels;
+	const int targetChannels = forceRgba ? 4 : 0;
+
+	// The image may be in an asset pack, so we read it through the file system and let STBI decode it from memory
+	VfsFile encoded(file);
+	if (!encoded.IsOpen()) {
+		LOG_WARN("Image \"{}\" could not be found!", file);
+		return nullptr;
+	}
+	if (TextureContainer::IsContainer(encoded.GetData(), encoded.GetSize())) {
+		return TextureContainer::Read(encoded.GetData(), encoded.GetSize(), std::filesystem::path(file).filename().string());
+	}
+	InitStbiFlip();
+	uint8_t* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(encoded.GetData()), static_cast<int>(encoded.GetSize()), &width, &height, &numChannels, targetChannels);
+
+	// If we could not load any data, warn and return null
+	if (data == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", file); 
+		return nullptr; 
+	}
+
+	return _CreateFromStbi(data, width, height, numChannels, targetChannels, std::filesystem::path(file).filename().string());
+}
+
+Texture2DData::sptr Texture2DData::LoadFromMemory(const void* encoded, size_t size, const std::string& debugName, bool forceRgba)
+{
+	if (TextureContainer::IsContainer(encoded, size)) {
+		return TextureContainer::Read(encoded, size, debugName);
+	}
+
+	int width, height, numChannels;
+	const int targetChannels = forceRgba ? 4 : 0;
+
+	InitStbiFlip();
+	uint8_t* data = stbi_load_from_memory(static_cast<const stbi_uc*>(encoded), static_cast<int>(size), &width, &height, &numChannels, targetChannels);
+
+	if (data == nullptr) {
+		LOG_WARN("STBI Failed to load image \"{}\" from memory", debugName);
+		return nullptr;
+	}
+
+	return _CreateFromStbi(data, width, height, numChannels, targetChannels, debugName);
+}
+
+void Texture2DData::FlipVertically() {
+	LOG_ASSERT(!IsCompressed(), "Compressed texture data cannot be flipped!");
+	_ReleaseStaging();
+	std::vector<uint8_t> row;
+	for (const Texture2DLevel& level : _levels) {
+		const size_t rowSize = level.Size / level.Height;
+		row.resize(rowSize);
+		uint8_t* data = static_cast<uint8_t*>(_data) + level.Offset;
+		for (uint32_t y = 0; y < level.Height / 2; y++) {
+			uint8_t* top = data + y * rowSize;
+			uint8_t* bottom = data + (level.Height - 1 - y) * rowSize;
+			memcpy(row.data(), top, rowSize);
+			memcpy(top, bottom, rowSize);
+			memcpy(bottom, row.data(), rowSize);
+		}
+	}
+}
+
+void Texture2DData::GenerateMipMaps(const MipGenerationOptions& options) {
+	LOG_ASSERT(!IsCompressed(), "Mips can't be generated for compressed texture data!");
+	LOG_ASSERT(_type == PixelType::UByte, "Mips can only be generated for 8 bit images!");
+	if (_levels.size() > 1) {
+		return;
+	}
+	_ReleaseStaging();
+
+	// The top level stays where it is, and the rest of the chain goes after it
+	std::vector<Texture2DLevel> levels = MipGenerator::GetLevelLayout(_width, _height, GetTexelSize(_format, _type));
+	const size_t size = levels.back().Offset + levels.back().Size;
+	void* data = realloc(_data, size);
+	LOG_ASSERT(data != nullptr, "Failed to allocate texture data!");
+	_data = data;
+	_dataSize = size;
+	_levels = levels;
+	MipGenerator::Generate(static_cast<uint8_t*>(_data), _levels, GetTexelComponentCount(_format), options);
+}
+
+Texture2DData::sptr Texture2DData::CopyLevels(uint32_t firstLevel, uint32_t levelCount) const {
+	LOG_ASSERT(firstLevel < _levels.size(), "Level {} is out of range, the data only has {} levels", firstLevel, _levels.size());
+	levelCount = std::min(levelCount, static_cast<uint32_t>(_levels.size()) - firstLevel);
+
+	// Levels are stored back to back, largest first, so the range is a single span of the buffer
+	std::vector<Texture2DLevel> levels(_levels.begin() + firstLevel, _levels.begin() + firstLevel + levelCount);
+	const size_t start = levels.front().Offset;
+	const size_t size = levels.back().Offset + levels.back().Size - start;
+	for (Texture2DLevel& level : levels) {
+		level.Offset -= start;
+	}
+
+	Texture2DData::sptr result;
+	if (IsCompressed()) {
+		result = CreateCompressed(_recommendedFormat, levels, static_cast<const uint8_t*>(_data) + start, size);
+	} else {
+		void* buffer = malloc(size);
+		LOG_ASSERT(buffer != nullptr, "Failed to allocate texture data!");
+		memcpy(buffer, static_cast<const uint8_t*>(_data) + start, size);
+		result = Texture2DData::sptr(new Texture2DData(AdoptData(), levels[0].Width, levels[0].Height, _format, _type, buffer, _recommendedFormat));
+		result->_dataSize = size;
+		result->_levels = levels;
+	}
+	result->DebugName = DebugName;
+	return result;
+}
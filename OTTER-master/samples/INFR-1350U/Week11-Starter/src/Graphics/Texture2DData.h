@@ -1,9 +1,30 @@
 #pragma once
 #include <memory>
 #include <cstdint>
+#include <vector>
 
+#include "PixelUploadRing.h"
 #include "TextureEnums.h"
 
+struct MipGenerationOptions;
+
+/// <summary>
+/// Describes where a single mip level is stored within a Texture2DData's buffer
+/// </summary>
+struct Texture2DLevel
+{
+	uint32_t Width;
+	uint32_t Height;
+	/// <summary>
+	/// The offset of the level from the start of the data, in bytes
+	/// </summary>
+	size_t   Offset;
+	/// <summary>
+	/// The size of the level, in bytes
+	/// </summary>
+	size_t   Size;
+};
+
 /// <summary>
 /// Stores data required to upload texture data into OpenGL
 /// </summary>
@@ -31,12 +52,64 @@ public:
 	~Texture2DData();
 
 	/// <summary>
-	/// Loads image data from an external file
+	/// Creates texture data from a block compressed mip chain (ex: one read out of a DDS or KTX2 file)
+	/// </summary>
+	/// <param name="format">The block compressed format of the data, see IsCompressedFormat</param>
+	/// <param name="levels">The location of every mip level within sourceData, largest first</param>
+	/// <param name="sourceData">A pointer to the compressed data, this is copied</param>
+	/// <param name="dataSize">The size of sourceData, in bytes</param>
+	/// <returns>The new data object</returns>
+	static Texture2DData::sptr CreateCompressed(InternalFormat format, const std::vector<Texture2DLevel>& levels, const void* sourceData, size_t dataSize);
+
+	/// <summary>
+	/// Loads image data from an external file. DDS and KTX2 files are loaded as block compressed data (see
+	/// TextureContainer), anything else is decoded by STBI
 	/// </summary>
 	/// <param name="file">The path of the file to load</param>
 	/// <param name="forceRgba">True to force STBI to load 4 component texture data</param>
 	/// <returns>A pointer to the data loaded from the file, or nullptr if the file failed to load</returns>
 	static Texture2DData::sptr LoadFromFile(const std::string& file, bool forceRgba = false);
+	/// <summary>
+	/// Decodes an image file that has already been loaded into memory (ex: an image embedded in a model)
+	/// </summary>
+	/// <param name="encoded">A pointer to the encoded image (ex: the contents of a PNG file)</param>
+	/// <param name="size">The size of the encoded image, in bytes</param>
+	/// <param name="debugName">The name to give the image in debug messages</param>
+	/// <param name="forceRgba">True to force STBI to load 4 component texture data</param>
+	/// <returns>A pointer to the decoded data, or nullptr if the image failed to decode</returns>
+	static Texture2DData::sptr LoadFromMemory(const void* encoded, size_t size, const std::string& debugName, bool forceRgba = false);
+
+	/// <summary>
+	/// Flips the rows of the image upside down. Images are loaded with the bottom row first to match OpenGL's texture
+	/// coordinates, this is for formats that expect the top row first (ex: glTF). Not supported for compressed data
+	/// </summary>
+	void FlipVertically();
+	/// <summary>
+	/// Builds the rest of the mip chain on the CPU from the top level (see MipGenerator), so the levels can be
+	/// uploaded or cooked along with the image. Does nothing if the data already has a mip chain
+	/// </summary>
+	/// <param name="options">The options for filtering the levels, see MipGenerator::GetDefaultOptions</param>
+	void GenerateMipMaps(const MipGenerationOptions& options);
+	/// <summary>
+	/// Copies a range of the mip chain into new data, where firstLevel becomes the top level. This is for uploading
+	/// part of a chain at a time (see TextureStreamer)
+	/// </summary>
+	/// <param name="firstLevel">The first level to copy, 0 being the largest</param>
+	/// <param name="levelCount">The most levels to copy, the range is clamped to the levels in the data</param>
+	/// <returns>The copied levels, with the same format as this data</returns>
+	Texture2DData::sptr CopyLevels(uint32_t firstLevel, uint32_t levelCount = UINT32_MAX) const;
+	/// <summary>
+	/// Copies the data into the PixelUploadRing, so that uploading it only has to issue the copy on the GL thread. This is
+	/// meant for loader threads to call once the data is final (ex: after GenerateMipMaps), changing the data afterwards
+	/// throws the staged copy away
+	/// </summary>
+	/// <returns>True if the data is staged, false if there was no room in the ring (it will upload from client memory)</returns>
+	bool Stage();
+	/// <summary>
+	/// Takes the data's region of the PixelUploadRing, or an invalid region if it isn't staged. The caller is responsible
+	/// for submitting or releasing the region, see Texture2D::LoadData
+	/// </summary>
+	PixelUploadRegion TakeStaging();
 
 	/// <summary>
 	/// Gets the width of the texture data, in pixels
@@ -60,7 +133,22 @@ public:
 	/// </summary>
 	InternalFormat  GetRecommendedFormat() const { return _recommendedFormat; }
 	/// <summary>
-	/// Get the total size of the underlying data (size of individual pixel * width * height)
+	/// Returns true if the data is a block compressed mip chain, in which case GetFormat and GetPixelType are
+	/// meaningless and GetRecommendedFormat is the compressed format the data must be uploaded as
+	/// </summary>
+	bool IsCompressed() const { return IsCompressedFormat(_recommendedFormat); }
+	/// <summary>
+	/// Gets the number of mip levels stored in the data, this is 1 unless the data was loaded with its mip chain or
+	/// GenerateMipMaps was called
+	/// </summary>
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(_levels.size()); }
+	/// <summary>
+	/// Gets the size and location of one of the mip levels in the data
+	/// </summary>
+	const Texture2DLevel& GetLevel(uint32_t level) const { return _levels[level]; }
+	/// <summary>
+	/// Get the total size of the underlying data (size of individual pixel * width * height, plus the size of every
+	/// other level if the data has a mip chain)
 	/// </summary>
 	size_t  GetDataSize() const { return _dataSize; }
 	/// <summary>
@@ -69,10 +157,31 @@ public:
 	const void* GetDataPtr() const { return _data; }
 
 private:
+	friend class TextureCubeMapData;
+
+	// Tag for the constructor that takes ownership of a buffer instead of copying it
+	struct AdoptData { };
+	Texture2DData(AdoptData, uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* ownedData, InternalFormat recommendedFormat);
+
+	/// <summary>
+	/// Wraps image data that was decoded by STBI, taking ownership of STBI's buffer rather than copying it
+	/// </summary>
+	static Texture2DData::sptr _CreateFromStbi(uint8_t* data, int width, int height, int numChannels, int targetChannels, const std::string& name);
+	/// <summary>
+	/// Hands the pixel buffer over to the caller (who must free() it), leaving this object empty
+	/// </summary>
+	void* _ReleaseData();
+	/// <summary>
+	/// Gives back our region of the upload ring, if we have one
+	/// </summary>
+	void _ReleaseStaging();
+
 	uint32_t    _width, _height;
 	size_t      _dataSize;
 	PixelFormat _format;
 	PixelType   _type;
 	InternalFormat _recommendedFormat;
+	std::vector<Texture2DLevel> _levels;
 	void* _data;
+	PixelUploadRegion _staging;
 };
\ No newline at end of file
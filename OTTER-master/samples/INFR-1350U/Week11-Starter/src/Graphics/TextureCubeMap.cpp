@@ -1,5 +1,7 @@
 #include "TextureCubeMap.h"
 
+#include "PixelUploadRing.h"
+
 TextureCubeMap::TextureCubeMap(const TextureCubeDesc& description) :
 	ITexture(), _description(description)
 {
@@ -17,7 +19,9 @@ void TextureCubeMap::_RecreateTexture() {
 
 	if (_description.Size > 0 && _description.Format != InternalFormat::Unknown)
 	{
-		glTextureStorage2D(_handle, 1, *_description.Format, _description.Size, _description.Size);
+		// The mip chain needs room in the storage, or the generated mips have nowhere to go
+		const GLsizei levels = _description.GenerateMipMaps ? GetMipLevelCount(_description.Size, _description.Size) : 1;
+		glTextureStorage2D(_handle, levels, *_description.Format, _description.Size, _description.Size);
 
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -43,13 +47,33 @@ void TextureCubeMap::LoadData(const TextureCubeMapData::sptr& data) {
 		glObjectLabel(GL_TEXTURE, _handle, data->DebugName.length(), data->DebugName.c_str());
 	}
 
-	// Align the data store to the size of a single component in
+	// Our rows are tightly packed, so the unpack alignment has to match the row size or GL will skip over padding that
+	// isn't there (ex: RGB8 faces with an odd size)
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
-	int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, GetUnpackAlignment(data->GetFaceDataSize() / data->GetSize()));
+
+	// Faces that were staged in the upload ring get copied out of the ring's buffer, so the pointers we hand to GL are
+	// offsets into it instead of client memory
+	const PixelUploadRegion staging = data->TakeStaging();
+	if (staging.IsValid()) {
+		PixelUploadRing::Bind();
+	}
+
+	// Upload our data to our image, one face (layer) at a time since each face has its own buffer
+	for (int face = 0; face < 6; face++) {
+		const void* faceData = data->GetFaceDataPtr((CubeMapFace)face);
+		if (faceData != nullptr) {
+			if (staging.IsValid()) {
+				faceData = reinterpret_cast<const void*>(staging.Offset + data->GetFaceDataSize() * face);
+			}
+			glTextureSubImage3D(_handle, 0, 0, 0, face, _description.Size, _description.Size, 1, *data->GetFormat(), *data->GetPixelType(), faceData);
+		}
+	}
 
-	// Upload our data to our image
-	glTextureSubImage3D(_handle, 0, 0, 0, 0, _description.Size, _description.Size, 6, *data->GetFormat(), *data->GetPixelType(), data->GetDataPtr());
+	if (staging.IsValid()) {
+		PixelUploadRing::UnBind();
+		PixelUploadRing::Submit(staging);
+	}
 
 	if (_description.GenerateMipMaps) {
 		glGenerateTextureMipmap(_handle);
@@ -60,7 +84,9 @@ TextureCubeMap::sptr TextureCubeMap::LoadFromImages(const std::string& path)
 {
 	TextureCubeMapData::sptr data = TextureCubeMapData::LoadFromImages(path);
 	TextureCubeMap::sptr result = TextureCubeMap::Create();
-	result->LoadData(data);
+	if (data != nullptr) {
+		result->LoadData(data);
+	}
 	return result;
 }
 
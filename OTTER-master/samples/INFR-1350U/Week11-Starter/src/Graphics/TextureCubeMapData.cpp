@@ -1,20 +1,37 @@
 #include "TextureCubeMapData.h"
+#include <algorithm>
 #include <filesystem>
 
+#include "Utilities/ParallelFor.h"
+#include "Utilities/VirtualFileSystem.h"
+
 TextureCubeMapData::TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
-	_size(size), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat) {
+	_size(size), _format(format), _type(type), _faces(), _recommendedFormat(recommendedFormat) {
 	LOG_ASSERT(size > 0, "Size must be greater than zero! Got {}", size)
 	_faceDataSize = (size_t)_size * _size * GetTexelSize(_format, _type);
 	_dataSize = _faceDataSize * 6;
-	_data = malloc(_dataSize);
-	LOG_ASSERT(_data != nullptr, "Failed to allocate texture data!")
+	// Faces are only allocated once they're loaded, so decoded images can be handed straight to us
 	if (sourceData != nullptr) {
-		memcpy(_data, sourceData, _dataSize);
+		for (int ix = 0; ix < 6; ix++) {
+			memcpy(_GetOrAllocateFace((CubeMapFace)ix), static_cast<const char*>(sourceData) + _faceDataSize * ix, _faceDataSize);
+		}
 	}
 }
 
 TextureCubeMapData::~TextureCubeMapData() {
-	free(_data);
+	_ReleaseStaging();
+	for (void* face : _faces) {
+		free(face);
+	}
+}
+
+void* TextureCubeMapData::_GetOrAllocateFace(CubeMapFace face) {
+	void*& result = _faces[(size_t)face];
+	if (result == nullptr) {
+		result = malloc(_faceDataSize);
+		LOG_ASSERT(result != nullptr, "Failed to allocate texture data!")
+	}
+	return result;
 }
 
 TextureCubeMapData::sptr TextureCubeMapData::CreateFromImages(const std::vector<Texture2DData::sptr>& images)
@@ -52,33 +69,87 @@ TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& r
 		"_neg_z"
 	};
 
-	std::vector<Texture2DData::sptr> data;
-	data.resize(6);
-
-	for(int ix = 0; ix < 6; ix++) {
+	// Each face gets its own thread, decoding is by far the slowest part of loading a cube map
+	std::vector<Texture2DData::sptr> data(6);
+	ParallelFor(6, [&](size_t ix) {
 		fs::path imagePath = rootFile;
 		imagePath += PATHS[ix];
 		imagePath += extension;
-		if (fs::exists(imagePath)) {
+		if (VirtualFileSystem::Exists(imagePath.string())) {
 			data[ix] = Texture2DData::LoadFromFile(imagePath.string());
+			// Cube maps only take uncompressed faces for now
+			if (data[ix] != nullptr && data[ix]->IsCompressed()) {
+				LOG_WARN("Image \"{}\" is block compressed, which is not supported for cube maps", imagePath.string());
+				data[ix] = nullptr;
+			}
 		}
 		else {
 			LOG_WARN("Image \"{}\" could not be found!", imagePath.string());
 		}
+	});
+
+	// We'll grab our settings from the first face that loaded and assume that they're the same everywhere
+	auto first = std::find_if(data.begin(), data.end(), [](const Texture2DData::sptr& face) { return face != nullptr; });
+	if (first == data.end()) {
+		LOG_WARN("None of the faces for cube map \"{}\" could be loaded!", rootImagePath);
+		return nullptr;
 	}
+	TextureCubeMapData::sptr result = std::make_shared<TextureCubeMapData>((*first)->GetWidth(), (*first)->GetFormat(), (*first)->GetPixelType(), nullptr, (*first)->GetRecommendedFormat());
+	result->DebugName = imagePath.filename().string();
 
-	return CreateFromImages(data);
+	// The decoded images are already laid out the way we need them, so we take their buffers instead of copying them
+	for (int ix = 0; ix < 6; ix++) {
+		if (data[ix] != nullptr) {
+			result->_ValidateFaceData(data[ix], (CubeMapFace)ix);
+			result->_faces[ix] = data[ix]->_ReleaseData();
+		}
+	}
+	result->Stage();
+	return result;
+}
+
+void TextureCubeMapData::_ValidateFaceData(const Texture2DData::sptr& data, CubeMapFace face) const {
+	LOG_ASSERT(!data->IsCompressed(), "Data for face {} is block compressed, cube maps need uncompressed faces!", face);
+	LOG_ASSERT(data->GetWidth() == data->GetHeight() && data->GetWidth() == _size, "Data for face {} is not square or does not match size of cubemap! {}x{} vs {}", face, data->GetWidth(), data->GetHeight(), _size);
+	LOG_ASSERT(data->GetFormat() == _format, "Data format does not match! {} vs {}", data->GetFormat(), _format);
+	LOG_ASSERT(data->GetPixelType() == _type, "Data pixel type does not match! {} vs {}", data->GetPixelType(), _type);
 }
 
 void TextureCubeMapData::LoadFaceData(const Texture2DData::sptr& data, CubeMapFace face) {
 	if (data != nullptr) {
-		LOG_ASSERT(data->GetWidth() == data->GetHeight() && data->GetWidth() == _size, "Data is not square or does not match size of cubemap! {}x{} vs {}", data->GetWidth(), data->GetHeight(), _size);
-		LOG_ASSERT(data->GetFormat() == _format, "Data format does not match! {} vs {}", data->GetFormat(), _format);
-		LOG_ASSERT(data->GetPixelType() == _type, "Data pixel type does not match! {} vs {}", data->GetPixelType(), _type);
-
-		size_t offset = (size_t)face * _faceDataSize;
-		memcpy(static_cast<char*>(_data) + offset, data->GetDataPtr(), _faceDataSize);
+		_ValidateFaceData(data, face);
+		_ReleaseStaging();
+		memcpy(_GetOrAllocateFace(face), data->GetDataPtr(), _faceDataSize);
 	} else {
 		LOG_WARN("Data for face {} was null, ignoring", face);
 	}
 }
+
+void TextureCubeMapData::_ReleaseStaging() {
+	if (_staging.IsValid()) {
+		PixelUploadRing::Release(_staging);
+		_staging = PixelUploadRegion();
+	}
+}
+
+bool TextureCubeMapData::Stage() {
+	if (_staging.IsValid()) {
+		return true;
+	}
+	if (!PixelUploadRing::TryAllocate(_dataSize, _staging)) {
+		return false;
+	}
+	// Faces that were never loaded are skipped when uploading, so their part of the region is left as-is
+	ParallelFor(6, [&](size_t ix) {
+		if (_faces[ix] != nullptr) {
+			memcpy(_staging.Data + _faceDataSize * ix, _faces[ix], _faceDataSize);
+		}
+	});
+	return true;
+}
+
+PixelUploadRegion TextureCubeMapData::TakeStaging() {
+	PixelUploadRegion result = _staging;
+	_staging = PixelUploadRegion();
+	return result;
+}
@@ -44,7 +44,7 @@ public:
 	/// <param name="height">The height of the texture, in pixels</param>
 	/// <param name="format">The pixel format or layout of a pixel (ex: RGBA)</param>
 	/// <param name="type">The component type of the pixel (ex: uint8_t)</param>
-	/// <param name="sourceData">A pointer to the data to upload to this texture</param>
+	/// <param name="sourceData">A pointer to the data for all 6 faces (see CubeMapFace for the ordering), or nullptr to fill the faces in later with LoadFaceData</param>
 	/// <param name="recommendedFormat">The recommended internal format to use when creating textures from this data</param>
 	TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat = InternalFormat::Unknown);
 	~TextureCubeMapData();
@@ -57,7 +57,8 @@ public:
 	static TextureCubeMapData::sptr CreateFromImages(const std::vector<Texture2DData::sptr>& images);
 
 	/// <summary>
-	/// Loads a cubemap from a set of 6 images stored in different files. The files should all follow a common naming scheme, and
+	/// Loads a cubemap from a set of 6 images stored in different files. The faces are decoded in parallel, and the cube map takes
+	/// ownership of the decoded images rather than copying them. The files should all follow a common naming scheme, and
 	/// be the same file type (ex: PNG). The naming will be as follows:
 	/// image_neg_x.png --> CubeMapFace::NegX
 	/// image_pos_x.png --> CubeMapFace::PosX
@@ -77,6 +78,18 @@ public:
 	/// <param name="face">The face to load data into</param>
 	void LoadFaceData(const Texture2DData::sptr& data, CubeMapFace face);
 
+	/// <summary>
+	/// Copies the faces into the PixelUploadRing (one after the other, see CubeMapFace for the ordering), so that uploading
+	/// them only has to issue the copies on the GL thread. Changing a face afterwards throws the staged copy away
+	/// </summary>
+	/// <returns>True if the faces are staged, false if there was no room in the ring (they will upload from client memory)</returns>
+	bool Stage();
+	/// <summary>
+	/// Takes the data's region of the PixelUploadRing, or an invalid region if it isn't staged. The caller is responsible
+	/// for submitting or releasing the region, see TextureCubeMap::LoadData
+	/// </summary>
+	PixelUploadRegion TakeStaging();
+
 	/// <summary>
 	/// Gets the size of the texture (width/height of each individual image in the set)
 	/// </summary>
@@ -104,23 +117,33 @@ public:
 	/// <returns></returns>
 	size_t GetFaceDataSize() const { return _faceDataSize; }
 	/// <summary>
-	/// Gets a readonly copy of the underlying data in this image for upload
+	/// Gets a readonly copy of the data for a single face in this cube map. Each face is stored in its own buffer, so
+	/// faces can be decoded straight into place
 	/// </summary>
-	const void* GetDataPtr() const { return _data; }
+	/// <param name="face">The face to get the data for</param>
+	/// <returns>A const pointer to the start of data for the given face, or nullptr if the face was never loaded</returns>
+	const void* GetFaceDataPtr(CubeMapFace face) const { return _faces[(size_t)face]; }
 
+private:
 	/// <summary>
-	/// Gets a readonly copy of the data for a single face in this cube map
+	/// Gets the buffer for a face, allocating it if the face has not been loaded yet
 	/// </summary>
-	/// <param name="face">The face to get the data for</param>
-	/// <returns>A const pointer to the start of data for the given face</returns>
-	const void* GetFaceDataPtr(CubeMapFace face) const { return static_cast<char*>(_data) + (_faceDataSize * (size_t)face); }
+	void* _GetOrAllocateFace(CubeMapFace face);
+	/// <summary>
+	/// Checks that an image has the right size and format to be used as one of our faces
+	/// </summary>
+	void _ValidateFaceData(const Texture2DData::sptr& data, CubeMapFace face) const;
+	/// <summary>
+	/// Gives back our region of the upload ring, if we have one
+	/// </summary>
+	void _ReleaseStaging();
 
-private:
 	uint32_t    _size;
 	size_t      _dataSize;
 	size_t      _faceDataSize;
 	PixelFormat _format;
 	PixelType   _type;
 	InternalFormat _recommendedFormat;
-	void* _data;
+	void* _faces[6];
+	PixelUploadRegion _staging;
 };
\ No newline at end of file
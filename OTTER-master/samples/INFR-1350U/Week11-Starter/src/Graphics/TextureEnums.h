@@ -5,6 +5,13 @@
 #include "Logging.h"
 #include "glad/glad.h"
 
+// S3TC comes from an extension that every desktop driver supports, but our GL loader doesn't include it
+// https://www.khronos.org/registry/OpenGL/extensions/EXT/EXT_texture_compression_s3tc.txt
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml
 // These are some of our more common available internal formats
 ENUM(InternalFormat, GLint,
@@ -18,7 +25,14 @@ ENUM(InternalFormat, GLint,
 	RGB10        = GL_RGB10,
 	RGB16        = GL_RGB16,
 	RGBA8        = GL_RGBA8,
-	RGBA16       = GL_RGBA16
+	RGBA16       = GL_RGBA16,
+
+	// Block compressed formats, these store 4x4 blocks of texels and can only be uploaded pre-compressed
+	BC1          = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,  // RGB, 8 bytes per block
+	BC3          = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, // RGBA, 16 bytes per block
+	BC4          = GL_COMPRESSED_RED_RGTC1,          // R, 8 bytes per block
+	BC5          = GL_COMPRESSED_RG_RGTC2,           // RG, 16 bytes per block (ex: normal maps)
+	BC7          = GL_COMPRESSED_RGBA_BPTC_UNORM     // RGBA, 16 bytes per block, best quality
 
 	// Note: There are sized internal formats but there is a LOT of them
 );
@@ -126,4 +140,94 @@ constexpr GLint GetTexelComponentCount(PixelFormat format)
  */
 constexpr size_t GetTexelSize(PixelFormat format, PixelType type) {
 	return GetTexelComponentSize(type) * GetTexelComponentCount(format);
-}
\ No newline at end of file
+}
+
+/*
+ * Gets the number of bytes a single texel takes up on the GPU in the given internal format
+ * @param format The internal format of the texture
+ * @returns The size of a single texel in bytes, or 0 if the format is unknown or block compressed
+ */
+constexpr size_t GetInternalFormatSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::R8:
+			return 1;
+		case InternalFormat::R16:
+		case InternalFormat::RG8:
+			return 2;
+		// Drivers pad 3 component formats out to 4 bytes
+		case InternalFormat::RGB8:
+		case InternalFormat::RGB10:
+		case InternalFormat::RGBA8:
+		case InternalFormat::Depth:
+		case InternalFormat::DepthStencil:
+			return 4;
+		case InternalFormat::RGB16:
+		case InternalFormat::RGBA16:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Gets the number of bytes a single 4x4 block takes up in the given block compressed format
+ * @param format The internal format of the texture
+ * @returns The size of a block in bytes, or 0 if the format is not block compressed
+ */
+constexpr size_t GetCompressedBlockSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::BC1:
+		case InternalFormat::BC4:
+			return 8;
+		case InternalFormat::BC3:
+		case InternalFormat::BC5:
+		case InternalFormat::BC7:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Checks if the given internal format stores its texels in compressed blocks
+ */
+constexpr bool IsCompressedFormat(InternalFormat format) {
+	return GetCompressedBlockSize(format) != 0;
+}
+
+/*
+ * Gets the number of bytes a single mip level takes up in the given internal format
+ * @param format The internal format of the texture
+ * @param width The width of the level, in texels
+ * @param height The height of the level, in texels
+ * @returns The size of the level in bytes, compressed levels are rounded up to whole blocks
+ */
+constexpr size_t GetTextureLevelSize(InternalFormat format, uint32_t width, uint32_t height) {
+	const size_t blockSize = GetCompressedBlockSize(format);
+	if (blockSize != 0) {
+		return ((width + 3) / 4) * (size_t)((height + 3) / 4) * blockSize;
+	}
+	return (size_t)width * height * GetInternalFormatSize(format);
+}
+
+/*
+ * Gets the number of levels in a full mip chain for a texture of the given size (down to and including 1x1)
+ * @param width The width of the top level, in texels
+ * @param height The height of the top level, in texels
+ */
+constexpr uint32_t GetMipLevelCount(uint32_t width, uint32_t height) {
+	uint32_t result = 1;
+	for (uint32_t size = width > height ? width : height; size > 1; size >>= 1) {
+		result++;
+	}
+	return result;
+}
+
+/*
+ * Gets the GL_UNPACK_ALIGNMENT to use for tightly packed rows of the given size, this is the largest alignment
+ * (up to 8) that the size is a multiple of, so rows never get treated as if they were padded
+ * @param rowSize The size of a single row of texels, in bytes
+ */
+constexpr GLint GetUnpackAlignment(size_t rowSize) {
+	return rowSize % 8 == 0 ? 8 : (rowSize % 4 == 0 ? 4 : (rowSize % 2 == 0 ? 2 : 1));
+}
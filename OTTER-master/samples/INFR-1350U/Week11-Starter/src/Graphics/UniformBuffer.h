@@ -0,0 +1,34 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// The uniform buffer stores a block of uniforms that can be shared between draws and shaders (ex: the per instance
+/// data for instanced draws). Shaders pick it up through a binding slot, see Shader::SetUniformBlockBinding
+/// </summary>
+class UniformBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<UniformBuffer> sptr;
+	static inline sptr Create(GLenum usage = GL_STREAM_DRAW) {
+		return std::make_shared<UniformBuffer>(usage);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new uniform buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_STREAM_DRAW since uniforms tend to change every frame</param>
+	UniformBuffer(GLenum usage = GL_STREAM_DRAW) : IBuffer(GL_UNIFORM_BUFFER, usage) { }
+
+	/// <summary>
+	/// Binds the whole buffer to a uniform block binding slot
+	/// </summary>
+	/// <param name="slot">The binding slot to bind the buffer to</param>
+	void Bind(GLuint slot) { glBindBufferBase(GL_UNIFORM_BUFFER, slot, _handle); }
+
+	/// <summary>
+	/// Unbinds the uniform buffer from a binding slot
+	/// </summary>
+	static void UnBind(GLuint slot) { glBindBufferBase(GL_UNIFORM_BUFFER, slot, 0); }
+};
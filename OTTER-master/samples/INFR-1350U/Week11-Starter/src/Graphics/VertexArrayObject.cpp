@@ -1,12 +1,25 @@
 #include "VertexArrayObject.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include "IndexBuffer.h"
 #include "Logging.h"
 #include "VertexBuffer.h"
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
+	_indexOffset(0),
+	_indexCount(0),
+	_indexType(GL_UNSIGNED_INT),
 	_handle(0),
-	_vertexCount(0)
+	_vertexCount(0),
+	_vertexTransform(glm::mat4(1.0f)),
+	_octahedralNormals(false),
+	_qtangents(false),
+	_instancedAttributes(false),
+	_boundsCenter(glm::vec3(0.0f)),
+	_boundsRadius(-1.0f)
 {
 	glCreateVertexArrays(1, &_handle);
 }
@@ -24,7 +37,14 @@ void VertexArrayObject::SetDebugName(const std::string& name) {
 }
 
 void VertexArrayObject::SetIndexBuffer(const IndexBuffer::sptr& ibo) {
+	SetIndexBuffer(ibo, 0, 0, ibo != nullptr ? ibo->GetElementType() : GL_UNSIGNED_INT);
+}
+
+void VertexArrayObject::SetIndexBuffer(const IndexBuffer::sptr& ibo, size_t byteOffset, GLsizei count, GLenum type) {
 	_indexBuffer = ibo;
+	_indexOffset = byteOffset;
+	_indexCount = count;
+	_indexType = type;
 	Bind();
 	if (_indexBuffer != nullptr) _indexBuffer->Bind();
 	else IndexBuffer::UnBind();
@@ -33,7 +53,9 @@ void VertexArrayObject::SetIndexBuffer(const IndexBuffer::sptr& ibo) {
 
 void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes)
 {
-	if (_vertexCount == 0) {
+	if (buffer->GetElementSize() == 1) {
+		// Raw byte buffers can be shared between many meshes, so they don't tell us how many vertices we have
+	} else if (_vertexCount == 0) {
 		_vertexCount = buffer->GetElementCount();
 	} else {
 		LOG_ASSERT(buffer->GetElementCount() == _vertexCount, "All buffers bound to a VAO should be of the same size in our implementation!");
@@ -46,8 +68,20 @@ void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const
 	Bind();
 	buffer->Bind();
 	for (const BufferAttribute& attrib : attributes) {
+		// Normals only have 2 components when they're octahedral encoded
+		if (attrib.Usage == AttribUsage::Normal && attrib.Size == 2) {
+			_octahedralNormals = true;
+		}
+		// A 4 component tangent without a normal is a QTangent, which holds the whole tangent frame
+		if (attrib.Usage == AttribUsage::Tangent && attrib.Size == 4) {
+			_qtangents = true;
+		}
 		glEnableVertexArrayAttrib(_handle, attrib.Slot);
 		glVertexAttribPointer(attrib.Slot, attrib.Size, attrib.Type, attrib.Normalized, attrib.Stride, (void*)attrib.Offset);
+		if (attrib.Divisor != 0) {
+			glVertexAttribDivisor(attrib.Slot, attrib.Divisor);
+			_instancedAttributes = true;
+		}
 	}
 	UnBind();
 
@@ -64,9 +98,92 @@ void VertexArrayObject::UnBind() {
 void VertexArrayObject::Render() const {
 	Bind();
 	if (_indexBuffer != nullptr) {
-		glDrawElements(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr);
+		if (_indexCount > 0) {
+			glDrawElements(GL_TRIANGLES, _indexCount, _indexType, (void*)_indexOffset);
+		} else {
+			glDrawElements(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr);
+		}
 	} else {
 		glDrawArrays(GL_TRIANGLES, 0, _vertexCount / 3);
 	}
 	UnBind();
 }
+
+void VertexArrayObject::RenderInstanced(GLsizei instanceCount) const {
+	LOG_ASSERT(!_instancedAttributes, "Meshes with per-instance attributes can't be drawn instanced!");
+	if (instanceCount <= 0) {
+		return;
+	}
+	Bind();
+	if (_indexBuffer != nullptr) {
+		if (_indexCount > 0) {
+			glDrawElementsInstanced(GL_TRIANGLES, _indexCount, _indexType, (void*)_indexOffset, instanceCount);
+		} else {
+			glDrawElementsInstanced(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr, instanceCount);
+		}
+	} else {
+		glDrawArraysInstanced(GL_TRIANGLES, 0, _vertexCount / 3, instanceCount);
+	}
+	UnBind();
+}
+
+void VertexArrayObject::RenderRanges(const GLsizei* counts, const void* const* offsets, GLsizei drawCount) const {
+	LOG_ASSERT(_indexBuffer != nullptr, "Ranges can only be drawn from an indexed mesh!");
+	if (drawCount <= 0) {
+		return;
+	}
+	Bind();
+	glMultiDrawElements(GL_TRIANGLES, counts, _indexCount > 0 ? _indexType : _indexBuffer->GetElementType(), offsets, drawCount);
+	UnBind();
+}
+
+bool VertexArrayObject::CalculateBounds(const void* vertices, size_t vertexCount, const std::vector<BufferAttribute>& attributes,
+	const glm::mat4& vertexTransform, glm::vec3& outCenter, float& outRadius)
+{
+	auto position = std::find_if(attributes.begin(), attributes.end(), [](const BufferAttribute& attrib) {
+		return attrib.Usage == AttribUsage::Position && attrib.Size >= 3;
+	});
+	if (vertices == nullptr || vertexCount == 0 || position == attributes.end()) {
+		return false;
+	}
+	const BufferAttribute attrib = *position;
+	if (attrib.Type != GL_FLOAT && attrib.Type != GL_UNSIGNED_SHORT && attrib.Type != GL_SHORT) {
+		return false;
+	}
+
+	// Reads a position and takes it into model space, integer positions are normalized the same way GL would
+	const uint8_t* vertexData = static_cast<const uint8_t*>(vertices);
+	const auto readPosition = [&](size_t ix) {
+		const uint8_t* data = vertexData + ix * attrib.Stride + attrib.Offset;
+		glm::vec3 result;
+		if (attrib.Type == GL_FLOAT) {
+			memcpy(&result, data, sizeof(glm::vec3));
+		} else if (attrib.Type == GL_UNSIGNED_SHORT) {
+			uint16_t value[3];
+			memcpy(value, data, sizeof(value));
+			result = glm::vec3(value[0], value[1], value[2]) / (attrib.Normalized ? 65535.0f : 1.0f);
+		} else {
+			int16_t value[3];
+			memcpy(value, data, sizeof(value));
+			result = attrib.Normalized ? glm::max(glm::vec3(value[0], value[1], value[2]) / 32767.0f, glm::vec3(-1.0f)) : glm::vec3(value[0], value[1], value[2]);
+		}
+		return glm::vec3(vertexTransform * glm::vec4(result, 1.0f));
+	};
+
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		const glm::vec3 p = readPosition(ix);
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	outCenter = (min + max) * 0.5f;
+
+	float radiusSq = 0.0f;
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		const glm::vec3 delta = readPosition(ix) - outCenter;
+		radiusSq = std::max(radiusSq, glm::dot(delta, delta));
+	}
+	outRadius = std::sqrt(radiusSq);
+	return true;
+}
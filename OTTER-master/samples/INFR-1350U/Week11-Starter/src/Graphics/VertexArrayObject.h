@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <GLM/glm.hpp>
 
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
@@ -65,9 +66,15 @@ struct BufferAttribute
 	/// The approximate usage for this attribute, does not get passed to OpenGL at all
 	/// </summary>
 	AttribUsage Usage;
+	/// <summary>
+	/// How many instances to draw before advancing to the next element, 0 to advance per vertex. Non-instanced
+	/// draws only ever read the first element of an attribute with a non-zero divisor, so this can be used to feed
+	/// a constant value to every vertex
+	/// </summary>
+	GLuint Divisor;
 
-	BufferAttribute(uint32_t slot, uint32_t size, GLenum type, bool normalized, GLsizei stride, size_t offset, AttribUsage usage = AttribUsage::Unknown) :
-		Slot(slot), Size(size), Type(type), Normalized(normalized), Stride(stride), Offset(offset), Usage(usage) { }
+	BufferAttribute(uint32_t slot, uint32_t size, GLenum type, bool normalized, GLsizei stride, size_t offset, AttribUsage usage = AttribUsage::Unknown, GLuint divisor = 0) :
+		Slot(slot), Size(size), Type(type), Normalized(normalized), Stride(stride), Offset(offset), Usage(usage), Divisor(divisor) { }
 };
 
 /// <summary>
@@ -108,10 +115,22 @@ public:
 	/// <param name="ibo">The index buffer to bind to this VAO</param>
 	void SetIndexBuffer(const IndexBuffer::sptr& ibo);
 	/// <summary>
+	/// Sets the index buffer for this VAO, but only draws a range of it. This lets many meshes share one index buffer
+	/// </summary>
+	/// <param name="ibo">The index buffer to bind to this VAO</param>
+	/// <param name="byteOffset">The offset of the first index to draw, in bytes from the start of the buffer</param>
+	/// <param name="count">The number of indices to draw</param>
+	/// <param name="type">The type of the indices in the range (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)</param>
+	void SetIndexBuffer(const IndexBuffer::sptr& ibo, size_t byteOffset, GLsizei count, GLenum type);
+	/// <summary>
 	/// Adds a vertex buffer to this VAO, with the specified attributes
 	/// </summary>
 	/// <param name="buffer">The buffer to add (note, does not take ownership, you will still need to delete later)</param>
 	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
+	/// <remarks>
+	/// Buffers with an element size of 1 are treated as raw bytes that may be shared between many meshes (see GltfLoader),
+	/// they do not need to match the size of the other buffers, and the attribute offsets are used to find the vertices
+	/// </remarks>
 	void AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes);
 
 	/// <summary>
@@ -128,7 +147,85 @@ public:
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 
+	/// <summary>
+	/// Sets the transform that takes the positions stored in the vertex buffer into model space. This is the
+	/// identity for most meshes, meshes with quantized positions use it to scale and offset them back out of
+	/// the 0-1 range they were packed into
+	/// </summary>
+	/// <param name="transform">The new transform to apply to vertex positions</param>
+	void SetVertexTransform(const glm::mat4& transform) { _vertexTransform = transform; }
+	/// <summary>
+	/// Gets the transform that should be applied to the vertex positions before the model matrix
+	/// </summary>
+	const glm::mat4& GetVertexTransform() const { return _vertexTransform; }
+	/// <summary>
+	/// Returns true if the normals in this VAO are stored as 2 component octahedral vectors, which the
+	/// vertex shader needs to decode (see OctahedralDecode in vertex_shader.glsl)
+	/// </summary>
+	bool GetHasOctahedralNormals() const { return _octahedralNormals; }
+	/// <summary>
+	/// Returns true if this VAO stores a QTangent in the normal slot instead of a normal, which the vertex shader
+	/// needs to decode into a normal and tangent (see QTangentDecode in qtangent.glsl)
+	/// </summary>
+	bool GetHasQTangents() const { return _qtangents; }
+	/// <summary>
+	/// Returns true if any attribute has a non-zero divisor. These are meant to feed a constant to every vertex of a
+	/// normal draw (ex: the glTF base colour), an instanced draw would step through them per instance instead, so
+	/// VAOs with them should not be drawn with RenderInstanced
+	/// </summary>
+	bool HasInstancedAttributes() const { return _instancedAttributes; }
+
+	/// <summary>
+	/// Sets the bounding sphere of the mesh, in model space (after the vertex transform)
+	/// </summary>
+	void SetBounds(const glm::vec3& center, float radius) { _boundsCenter = center; _boundsRadius = radius; }
+	/// <summary>
+	/// Returns true if the bounds of the mesh are known. MeshBuilder::Bake and the loaders set them, VAOs that are
+	/// put together by hand don't have any until SetBounds is called
+	/// </summary>
+	bool HasBounds() const { return _boundsRadius >= 0.0f; }
+	/// <summary>
+	/// Gets the center of the mesh's bounding sphere, in model space
+	/// </summary>
+	const glm::vec3& GetBoundsCenter() const { return _boundsCenter; }
+	/// <summary>
+	/// Gets the radius of the mesh's bounding sphere in model space, or a negative value if the bounds are unknown
+	/// </summary>
+	float GetBoundsRadius() const { return _boundsRadius; }
+
+	/// <summary>
+	/// Calculates the bounding sphere of some vertices from their Position attribute, centered on their bounding box
+	/// like MeshSimplifier::CalculateBounds. Float and 16 bit integer positions can be read, the positions are
+	/// taken through the vertex transform first
+	/// </summary>
+	/// <param name="vertices">The vertex data, laid out as described by attributes</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="attributes">The attributes of the vertices, see BufferAttribute</param>
+	/// <param name="vertexTransform">The transform from stored positions to model space, see SetVertexTransform</param>
+	/// <param name="outCenter">Receives the center of the sphere</param>
+	/// <param name="outRadius">Receives the radius of the sphere</param>
+	/// <returns>True if the bounds were calculated, false if there are no vertices or no positions we can read</returns>
+	static bool CalculateBounds(const void* vertices, size_t vertexCount, const std::vector<BufferAttribute>& attributes,
+		const glm::mat4& vertexTransform, glm::vec3& outCenter, float& outRadius);
+
+	/// <summary>
+	/// Gets the index buffer bound to this VAO, or nullptr if it does not have one
+	/// </summary>
+	const IndexBuffer::sptr& GetIndexBuffer() const { return _indexBuffer; }
+
 	void Render() const;
+	/// <summary>
+	/// Draws several instances of the whole mesh with a single call, the shader tells them apart with gl_InstanceID
+	/// </summary>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	void RenderInstanced(GLsizei instanceCount) const;
+	/// <summary>
+	/// Draws several ranges of the index buffer with a single glMultiDrawElements call
+	/// </summary>
+	/// <param name="counts">The number of indices in each range</param>
+	/// <param name="offsets">The byte offset of each range, from the start of the index buffer</param>
+	/// <param name="drawCount">The number of ranges to draw</param>
+	void RenderRanges(const GLsizei* counts, const void* const* offsets, GLsizei drawCount) const;
 	
 protected:
 	// Helper structure to store a buffer and the attributes
@@ -140,10 +237,21 @@ protected:
 	
 	// The index buffer bound to this VAO
 	IndexBuffer::sptr _indexBuffer;
+	// The range of the index buffer to draw, a count of 0 draws the whole buffer
+	size_t  _indexOffset;
+	GLsizei _indexCount;
+	GLenum  _indexType;
 	// The vertex buffers bound to this VAO
 	std::vector<VertexBufferBinding> _vertexBuffers;
 
 	GLsizei _vertexCount;
+
+	glm::mat4 _vertexTransform;
+	bool      _octahedralNormals;
+	bool      _qtangents;
+	bool      _instancedAttributes;
+	glm::vec3 _boundsCenter;
+	float     _boundsRadius;
 	
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
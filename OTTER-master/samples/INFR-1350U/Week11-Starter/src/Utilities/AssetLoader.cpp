@@ -0,0 +1,674 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include "Logging.h"
+#include "Graphics/PixelUploadRing.h"
+#include "MeshCache.h"
+#include "MeshFactory.h"
+#include "MeshOptimizer.h"
+#include "MeshRegistry.h"
+#include "MipGenerator.h"
+#include "TextureCooker.h"
+#include "TextureRegistry.h"
+
+std::vector<std::thread> AssetLoader::_workers;
+std::mutex AssetLoader::_jobLock;
+std::condition_variable AssetLoader::_jobAdded;
+std::condition_variable AssetLoader::_jobsIdle;
+std::deque<std::function<void()>> AssetLoader::_jobs;
+size_t AssetLoader::_activeJobs = 0;
+bool AssetLoader::_running = false;
+
+std::mutex AssetLoader::_uploadLock;
+std::deque<AssetLoader::Upload> AssetLoader::_uploads;
+size_t AssetLoader::_pendingUploadBytes = 0;
+
+std::mutex AssetLoader::_handleLock;
+std::unordered_map<std::string, std::weak_ptr<void>> AssetLoader::_handles;
+
+float AssetLoader::_budgetMs = 2.0f;
+size_t AssetLoader::_budgetBytes = 8 * 1024 * 1024;
+size_t AssetLoader::_frameUploads = 0;
+size_t AssetLoader::_frameUploadBytes = 0;
+float AssetLoader::_frameUploadMs = 0.0f;
+std::atomic<size_t> AssetLoader::_loaded(0);
+std::atomic<size_t> AssetLoader::_failed(0);
+
+/// <summary>
+/// Builds the key for an asset from its type, the canonical version of its path and the hash of its options
+/// </summary>
+std::string MakeAssetKey(const char* type, const std::string& filename, uint64_t optionsHash) {
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(filename, error);
+	std::string result = type;
+	result += '|';
+	result += error ? filename : path.generic_string();
+	result += '|';
+	result += std::to_string(optionsHash);
+	return result;
+}
+
+/// <summary>
+/// The data that is handed from the worker to the main thread when loading a mesh with levels of detail
+/// </summary>
+struct LodLoadData
+{
+	MeshBuilder<VertexPosNormTexCol>           Mesh;
+	MeshBuilder<VertexPackedPosNormTexCol>     Packed;
+	MeshBuilder<VertexQuantizedPosNormTexCol>  Quantized;
+	MeshBuilder<VertexPackedPosQTangentTexCol> QTangent;
+	std::vector<std::vector<uint32_t>>         Levels;
+	std::vector<float>                         Errors;
+	glm::vec3                                  Center;
+	float                                      Radius;
+};
+
+/// <summary>
+/// The state shared between the slices of a mesh that is being streamed in by AssetLoader::StreamObj
+/// </summary>
+struct MeshStreamState
+{
+	CookedMeshView          Source;
+	VertexBuffer::sptr      Vertices;
+	IndexBuffer::sptr       Indices;
+	VertexArrayObject::sptr Mesh;
+};
+
+/// <summary>
+/// Reads a single index out of a cooked index buffer
+/// </summary>
+inline uint32_t ReadStreamIndex(const uint8_t* indices, size_t elementSize, size_t index) {
+	switch (elementSize) {
+		case sizeof(uint8_t):
+			return indices[index];
+		case sizeof(uint16_t):
+		{
+			uint16_t result;
+			memcpy(&result, indices + index * sizeof(uint16_t), sizeof(uint16_t));
+			return result;
+		}
+		default:
+		{
+			uint32_t result;
+			memcpy(&result, indices + index * sizeof(uint32_t), sizeof(uint32_t));
+			return result;
+		}
+	}
+}
+
+void AssetLoader::Init(uint32_t threadCount) {
+	std::lock_guard<std::mutex> guard(_jobLock);
+	if (_running) {
+		return;
+	}
+	if (threadCount == 0) {
+		// Leave a hardware thread for the main thread, but always have at least one worker
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+	_running = true;
+	_workers.reserve(threadCount);
+	for (uint32_t ix = 0; ix < threadCount; ix++) {
+		_workers.emplace_back(&AssetLoader::_WorkerMain);
+	}
+	LOG_INFO("Asset loader started with {} worker threads", threadCount);
+}
+
+void AssetLoader::Shutdown() {
+	{
+		std::lock_guard<std::mutex> guard(_jobLock);
+		if (!_running) {
+			return;
+		}
+		_running = false;
+		_jobs.clear();
+	}
+	_jobAdded.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+
+	std::lock_guard<std::mutex> guard(_uploadLock);
+	_uploads.clear();
+	_pendingUploadBytes = 0;
+}
+
+void AssetLoader::SetUploadBudget(float milliseconds, size_t bytes) {
+	_budgetMs = milliseconds;
+	_budgetBytes = bytes;
+}
+
+void AssetLoader::Update() {
+	typedef std::chrono::high_resolution_clock Clock;
+	const Clock::time_point start = Clock::now();
+
+	// Free up the parts of the upload ring that the GPU has finished copying out of, for the workers to stage into
+	PixelUploadRing::Retire();
+
+	// Note that we only measure the time it takes to submit the uploads, the driver may still be copying
+	// the data after we return, which is why there is a byte budget as well
+	_frameUploads = 0;
+	_frameUploadBytes = 0;
+	while (true) {
+		Upload upload;
+		{
+			std::lock_guard<std::mutex> guard(_uploadLock);
+			if (_uploads.empty()) {
+				break;
+			}
+			// Always do at least one upload per frame, so large assets can't get stuck in the queue
+			if (_frameUploads > 0) {
+				const float elapsed = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+				if (elapsed >= _budgetMs || _frameUploadBytes + _uploads.front().Bytes > _budgetBytes) {
+					break;
+				}
+			}
+			upload = std::move(_uploads.front());
+			_uploads.pop_front();
+			_pendingUploadBytes -= upload.Bytes;
+		}
+		upload.Func();
+		_frameUploads++;
+		_frameUploadBytes += upload.Bytes;
+	}
+	_frameUploadMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+void AssetLoader::Flush() {
+	{
+		std::unique_lock<std::mutex> lock(_jobLock);
+		_jobsIdle.wait(lock, []() { return _jobs.empty() && _activeJobs == 0; });
+	}
+	// Everything has been handed off to the upload queue by now, so we can just drain it
+	while (true) {
+		Upload upload;
+		{
+			std::lock_guard<std::mutex> guard(_uploadLock);
+			if (_uploads.empty()) {
+				break;
+			}
+			upload = std::move(_uploads.front());
+			_uploads.pop_front();
+			_pendingUploadBytes -= upload.Bytes;
+		}
+		upload.Func();
+	}
+}
+
+AssetLoaderStats AssetLoader::GetStats() {
+	AssetLoaderStats result;
+	{
+		std::lock_guard<std::mutex> guard(_jobLock);
+		result.ThreadCount = _workers.size();
+		result.QueuedJobs = _jobs.size();
+		result.ActiveJobs = _activeJobs;
+	}
+	{
+		std::lock_guard<std::mutex> guard(_uploadLock);
+		result.PendingUploads = _uploads.size();
+		result.PendingUploadBytes = _pendingUploadBytes;
+	}
+	result.FrameUploads = _frameUploads;
+	result.FrameUploadBytes = _frameUploadBytes;
+	result.FrameUploadMs = _frameUploadMs;
+	result.Loaded = _loaded.load();
+	result.Failed = _failed.load();
+	return result;
+}
+
+AssetHandle<VertexArrayObject>::sptr AssetLoader::LoadObj(const std::string& filename, const ObjLoadOptions& options) {
+	AssetHandle<VertexArrayObject>::sptr result;
+	const std::string key = MakeAssetKey("obj", filename, options.GetOutputHash());
+
+	// Meshes that are already resident (ex: loaded through MeshRegistry::LoadObj) skip the load and upload
+	VertexArrayObject::sptr resident = MeshRegistry::FindObj(filename, options);
+	if (resident != nullptr) {
+		if (_FindOrCreate(key, filename, resident, result)) {
+			result->_Resolve(resident);
+		}
+		return result;
+	}
+
+	if (!_FindOrCreate(key, filename, GetPlaceholderMesh(), result)) {
+		return result;
+	}
+
+	_Submit<VertexArrayObject, CookedMesh>(result,
+		[filename, options](CookedMesh& mesh) {
+			ObjLoader::LoadCooked(filename, options, mesh);
+			return mesh.GetUploadSize();
+		},
+		[filename, options](const CookedMesh& mesh) {
+			VertexArrayObject::sptr vao = mesh.Bake();
+			vao->SetDebugName(filename);
+			MeshRegistry::RegisterObj(filename, options, vao);
+			return vao;
+		});
+	return result;
+}
+
+AssetHandle<MeshletSet>::sptr AssetLoader::LoadObjMeshlets(const std::string& filename, const ObjLoadOptions& options) {
+	ObjLoadOptions meshletOptions = options;
+	meshletOptions.BuildMeshlets = true;
+
+	// The placeholder is the placeholder cube as a single meshlet, so it gets culled like the real mesh would
+	AssetHandle<MeshletSet>::sptr result;
+	const bool created = _FindOrCreateWith<MeshletSet>(MakeAssetKey("meshlets", filename, meshletOptions.GetOutputHash()), filename, []() {
+		Meshlet cube;
+		cube.Center = glm::vec3(0.0f);
+		cube.Radius = 0.87f;
+		cube.ConeAxis = glm::vec3(0.0f);
+		cube.ConeCutoff = 1.0f;
+		cube.IndexOffset = 0;
+		cube.IndexCount = static_cast<uint32_t>(GetPlaceholderMesh()->GetIndexBuffer()->GetElementCount());
+		MeshletSet::sptr placeholder = MeshletSet::Create();
+		placeholder->SetMesh(GetPlaceholderMesh(), { cube });
+		return placeholder;
+	}, result);
+	if (!created) {
+		return result;
+	}
+
+	_Submit<MeshletSet, CookedMesh>(result,
+		[filename, meshletOptions](CookedMesh& mesh) {
+			ObjLoader::LoadCooked(filename, meshletOptions, mesh);
+			return mesh.GetUploadSize();
+		},
+		[filename](const CookedMesh& mesh) {
+			MeshletSet::sptr meshlets = mesh.BakeMeshlets();
+			meshlets->GetMesh()->SetDebugName(filename);
+			return meshlets;
+		});
+	return result;
+}
+
+AssetHandle<MeshLodSet>::sptr AssetLoader::LoadObjLods(const std::string& filename, const MeshLodOptions& lodOptions, const ObjLoadOptions& options) {
+	AssetHandle<MeshLodSet>::sptr result;
+	const std::string key = MakeAssetKey("lods", filename, MeshRegistry::GetLodOptionsHash(lodOptions, options));
+
+	MeshLodSet::sptr resident = MeshRegistry::FindObjLods(filename, lodOptions, options);
+	if (resident != nullptr) {
+		if (_FindOrCreate(key, filename, resident, result)) {
+			result->_Resolve(resident);
+		}
+		return result;
+	}
+
+	// The placeholder is a single level set around the placeholder cube, so LOD selection still works on it
+	const bool created = _FindOrCreateWith<MeshLodSet>(key, filename, []() {
+		MeshLodSet::sptr placeholder = MeshLodSet::Create();
+		placeholder->AddLevel(GetPlaceholderMesh(), 12, std::numeric_limits<float>::max(), 0.0f);
+		placeholder->SetBounds(glm::vec3(0.0f), 0.87f);
+		return placeholder;
+	}, result);
+	if (!created) {
+		return result;
+	}
+
+	// All of the simplification happens on the worker, the main thread only creates the buffers
+	_Submit<MeshLodSet, LodLoadData>(result,
+		[filename, lodOptions, options](LodLoadData& data) {
+			ObjLoader::LoadMeshData(filename, data.Mesh, options);
+			if (options.Optimize) {
+				MeshOptimizer::Optimize(data.Mesh);
+			}
+			MeshSimplifier::GenerateLods(data.Mesh, lodOptions, data.Levels, data.Errors);
+			MeshSimplifier::CalculateBounds(data.Mesh.GetVertexDataPtr(), sizeof(VertexPosNormTexCol), data.Mesh.GetVertexCount(),
+				MeshSimplifierLayout::FromDecl<VertexPosNormTexCol>(), data.Center, data.Radius);
+
+			size_t vertexSize = sizeof(VertexPosNormTexCol);
+			switch (options.Format) {
+				case VertexFormat::Packed:
+					VertexPacking::Pack(data.Mesh, data.Packed);
+					vertexSize = sizeof(VertexPackedPosNormTexCol);
+					break;
+				case VertexFormat::Quantized:
+					VertexPacking::Quantize(data.Mesh, data.Quantized);
+					vertexSize = sizeof(VertexQuantizedPosNormTexCol);
+					break;
+				case VertexFormat::QTangent:
+					VertexPacking::PackQTangents(data.Mesh, data.QTangent, options.ThreadCount);
+					vertexSize = sizeof(VertexPackedPosQTangentTexCol);
+					break;
+				default:
+					break;
+			}
+
+			size_t bytes = vertexSize * data.Mesh.GetVertexCount();
+			for (const std::vector<uint32_t>& level : data.Levels) {
+				bytes += level.size() * (data.Mesh.GetVertexCount() <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t));
+			}
+			return bytes;
+		},
+		[filename, lodOptions, options](const LodLoadData& data) {
+			MeshLodSet::sptr lods;
+			switch (options.Format) {
+				case VertexFormat::Packed:
+					lods = MeshSimplifier::UploadLods(data.Packed, data.Levels, data.Errors, data.Center, data.Radius, lodOptions);
+					break;
+				case VertexFormat::Quantized:
+					lods = MeshSimplifier::UploadLods(data.Quantized, data.Levels, data.Errors, data.Center, data.Radius, lodOptions);
+					break;
+				case VertexFormat::QTangent:
+					lods = MeshSimplifier::UploadLods(data.QTangent, data.Levels, data.Errors, data.Center, data.Radius, lodOptions);
+					break;
+				default:
+					lods = MeshSimplifier::UploadLods(data.Mesh, data.Levels, data.Errors, data.Center, data.Radius, lodOptions);
+					break;
+			}
+			for (size_t ix = 0; ix < lods->GetLevelCount(); ix++) {
+				lods->GetLevel(ix).Mesh->SetDebugName(filename + " LOD" + std::to_string(ix));
+			}
+			MeshRegistry::RegisterObjLods(filename, lodOptions, options, lods);
+			return lods;
+		});
+	return result;
+}
+
+AssetHandle<VertexArrayObject>::sptr AssetLoader::StreamObj(const std::string& filename, const ObjLoadOptions& options, const MeshStreamOptions& streamOptions) {
+	AssetHandle<VertexArrayObject>::sptr result;
+	if (!_FindOrCreate(MakeAssetKey("stream", filename, options.GetOutputHash()), filename, GetPlaceholderMesh(), result)) {
+		return result;
+	}
+
+	Enqueue([result, filename, options, streamOptions]() {
+		result->_SetState(AssetState::Loading);
+		CookedMeshView view;
+		try {
+			// If the mesh has been cooked, we can stream it right out of the file. Otherwise we have to load it
+			// into memory first, which also cooks it for next time
+			if (!options.UseCache || !MeshCache::TryMap(filename, options.GetOutputHash(), view)) {
+				std::shared_ptr<CookedMesh> mesh = std::make_shared<CookedMesh>();
+				ObjLoader::LoadCooked(filename, options, *mesh);
+				view = CookedMeshView::FromMesh(mesh);
+			}
+			if (view.IndexCount == 0) {
+				throw std::runtime_error("Only indexed meshes can be streamed");
+			}
+		} catch (const std::exception& e) {
+			const std::string message = e.what();
+			EnqueueUpload([result, message]() { _FailHandle<VertexArrayObject>(result, message); }, 0);
+			return;
+		}
+		result->_SetState(AssetState::Uploading);
+		_StreamMesh(result, view, streamOptions);
+	});
+	return result;
+}
+
+AssetHandle<Texture2D>::sptr AssetLoader::LoadTexture(const std::string& filename) {
+	return _LoadTexture(filename, nullptr, 0);
+}
+
+std::vector<AssetHandle<Texture2D>::sptr> AssetLoader::LoadTextures(const std::vector<std::string>& filenames) {
+	std::shared_ptr<UploadSequence> sequence = std::make_shared<UploadSequence>(filenames.size());
+	std::vector<AssetHandle<Texture2D>::sptr> result;
+	result.reserve(filenames.size());
+	for (size_t ix = 0; ix < filenames.size(); ix++) {
+		result.push_back(_LoadTexture(filenames[ix], sequence, ix));
+	}
+	return result;
+}
+
+AssetHandle<TextureArraySet>::sptr AssetLoader::LoadTextureArrays(const std::vector<std::string>& filenames, const TextureArrayPackOptions& options) {
+	// The images take the first slots of the sequence and the packing takes the last one, so it only gets queued
+	// once every image's upload is ahead of it in the upload queue
+	std::shared_ptr<UploadSequence> sequence = std::make_shared<UploadSequence>(filenames.size() + 1);
+	std::vector<AssetHandle<Texture2D>::sptr> textures;
+	textures.reserve(filenames.size());
+	for (size_t ix = 0; ix < filenames.size(); ix++) {
+		textures.push_back(_LoadTexture(filenames[ix], sequence, ix));
+	}
+
+	AssetHandle<TextureArraySet>::sptr result = std::make_shared<AssetHandle<TextureArraySet>>(
+		filenames.empty() ? std::string() : filenames.front(), TextureArrayPacker::CreatePlaceholder(filenames.size()));
+	result->_SetState(AssetState::Loading);
+	_EnqueueSequenced(sequence, filenames.size(), [result, textures, options]() {
+		_PackTextureArrays(result, textures, options);
+	}, 0);
+	return result;
+}
+
+void AssetLoader::_PackTextureArrays(const AssetHandle<TextureArraySet>::sptr& handle, const std::vector<AssetHandle<Texture2D>::sptr>& textures, const TextureArrayPackOptions& options) {
+	// An image that another load had already started fills its slot in our sequence right away, so it can still be on
+	// its way when we get here. We try again once it settles, if it failed it gets packed from its placeholder
+	for (const AssetHandle<Texture2D>::sptr& texture : textures) {
+		const AssetState state = texture->GetState();
+		if (state != AssetState::Resident && state != AssetState::Failed) {
+			texture->OnSettled([handle, textures, options]() {
+				_PackTextureArrays(handle, textures, options);
+			});
+			return;
+		}
+	}
+
+	handle->_SetState(AssetState::Uploading);
+	std::vector<Texture2D::sptr> resident;
+	resident.reserve(textures.size());
+	for (const AssetHandle<Texture2D>::sptr& texture : textures) {
+		resident.push_back(texture->Get());
+	}
+	try {
+		handle->_Resolve(TextureArrayPacker::Pack(resident, options));
+		_loaded++;
+	} catch (const std::exception& e) {
+		_FailHandle<TextureArraySet>(handle, e.what());
+	}
+}
+
+AssetHandle<Texture2D>::sptr AssetLoader::_LoadTexture(const std::string& filename, const std::shared_ptr<UploadSequence>& sequence, size_t slot) {
+	AssetHandle<Texture2D>::sptr result;
+	const std::string key = MakeAssetKey("texture", filename, 0);
+
+	// Textures that are already resident (ex: shared between the last scene and this one) skip the decode and upload
+	Texture2D::sptr resident = TextureRegistry::Find(filename);
+	if (resident != nullptr) {
+		if (_FindOrCreate(key, filename, resident, result)) {
+			result->_Resolve(resident);
+		}
+		_EnqueueSequenced(sequence, slot, nullptr, 0);
+		return result;
+	}
+
+	// The placeholder is made for each load rather than shared, since the image gets loaded into it. Requests that
+	// join a load that is already on its way get that load's texture instead
+	const bool created = _FindOrCreateWith<Texture2D>(key, filename, []() {
+		Texture2D::sptr placeholder = Texture2D::Create();
+		uint8_t grey[4] = { 128, 128, 128, 255 };
+		placeholder->LoadData(std::make_shared<Texture2DData>(1, 1, PixelFormat::RGBA, PixelType::UByte, grey, InternalFormat::RGBA8));
+		return placeholder;
+	}, result);
+	if (!created) {
+		_EnqueueSequenced(sequence, slot, nullptr, 0);
+		return result;
+	}
+	const Texture2D::sptr texture = result->Get();
+
+	_Submit<Texture2D, Texture2DData::sptr>(result,
+		[filename](Texture2DData::sptr& data) {
+			data = Texture2DData::LoadFromFile(TextureCooker::FindCooked(filename));
+			if (data == nullptr) {
+				throw std::runtime_error("Failed to load image from file");
+			}
+			// Building the mips here keeps them off the main thread, cooked textures already have theirs
+			if (!data->IsCompressed()) {
+				data->GenerateMipMaps(MipGenerator::GetDefaultOptions(filename));
+			}
+			// Writing the pixels into the upload ring here leaves the main thread with nothing to do but issue the copy
+			data->Stage();
+			return data->GetDataSize();
+		},
+		[texture, filename](const Texture2DData::sptr& data) {
+			texture->LoadData(data);
+			TextureRegistry::Register(filename, TextureLoadOptions(), texture);
+			return texture;
+		}, sequence, slot);
+	return result;
+}
+
+void AssetLoader::_EnqueueSequenced(const std::shared_ptr<UploadSequence>& sequence, size_t slot, const std::function<void()>& upload, size_t bytes) {
+	if (sequence == nullptr) {
+		if (upload) {
+			EnqueueUpload(upload, bytes);
+		}
+		return;
+	}
+
+	// The uploads are queued while we hold the sequence's lock, so two workers can't interleave their slots
+	std::lock_guard<std::mutex> guard(sequence->Lock);
+	sequence->Uploads[slot] = upload;
+	sequence->Bytes[slot] = bytes;
+	sequence->Done[slot] = true;
+	while (sequence->Next < sequence->Done.size() && sequence->Done[sequence->Next]) {
+		if (sequence->Uploads[sequence->Next]) {
+			EnqueueUpload(sequence->Uploads[sequence->Next], sequence->Bytes[sequence->Next]);
+			sequence->Uploads[sequence->Next] = nullptr;
+		}
+		sequence->Next++;
+	}
+}
+
+void AssetLoader::Enqueue(const std::function<void()>& job) {
+	Init();
+	{
+		std::lock_guard<std::mutex> guard(_jobLock);
+		_jobs.push_back(job);
+	}
+	_jobAdded.notify_one();
+}
+
+void AssetLoader::EnqueueUpload(const std::function<void()>& upload, size_t bytes) {
+	std::lock_guard<std::mutex> guard(_uploadLock);
+	_uploads.push_back({ upload, bytes });
+	_pendingUploadBytes += bytes;
+}
+
+const VertexArrayObject::sptr& AssetLoader::GetPlaceholderMesh() {
+	static VertexArrayObject::sptr placeholder = nullptr;
+	if (placeholder == nullptr) {
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		MeshFactory::AddCube(mesh, glm::vec3(0.0f), glm::vec3(1.0f));
+		placeholder = mesh.Bake();
+		placeholder->SetDebugName("Asset Placeholder");
+	}
+	return placeholder;
+}
+
+void AssetLoader::_StreamMesh(const AssetHandle<VertexArrayObject>::sptr& handle, const CookedMeshView& mesh, const MeshStreamOptions& options) {
+	std::shared_ptr<MeshStreamState> state = std::make_shared<MeshStreamState>();
+	state->Source = mesh;
+
+	// The bounds are worked out here on the worker thread, so the main thread doesn't have to read the whole mesh
+	glm::vec3 boundsCenter(0.0f);
+	float boundsRadius;
+	if (!VertexArrayObject::CalculateBounds(mesh.Vertices, mesh.VertexCount, mesh.Attributes, mesh.VertexTransform, boundsCenter, boundsRadius)) {
+		boundsRadius = -1.0f;
+	}
+
+	// The buffers get their full size right away, so each slice is just a glNamedBufferSubData into them
+	const std::string path = handle->GetPath();
+	EnqueueUpload([state, path, boundsCenter, boundsRadius]() {
+		const CookedMeshView& source = state->Source;
+		state->Vertices = VertexBuffer::Create();
+		state->Vertices->AllocateStorage(source.VertexStride, source.VertexCount);
+		state->Indices = IndexBuffer::Create();
+		state->Indices->AllocateStorage(source.IndexElementSize, source.IndexCount, source.IndexType);
+		state->Mesh = VertexArrayObject::Create();
+		state->Mesh->AddVertexBuffer(state->Vertices, source.Attributes);
+		state->Mesh->SetVertexTransform(source.VertexTransform);
+		state->Mesh->SetBounds(boundsCenter, boundsRadius);
+		state->Mesh->SetDebugName(path);
+	}, 0);
+
+	const size_t vertexStride = mesh.VertexStride;
+	const size_t indexSize = mesh.IndexElementSize;
+	const size_t verticesPerSlice = std::max<size_t>(options.SliceBytes / vertexStride, 1);
+	const size_t indicesPerSlice = std::max<size_t>((options.SliceBytes / indexSize) / 3 * 3, 3);
+
+	// Queues the vertices up to (but not including) end that haven't been queued yet
+	size_t vertexCursor = 0;
+	auto queueVertices = [&](size_t end) {
+		while (vertexCursor < end) {
+			const size_t count = std::min(verticesPerSlice, end - vertexCursor);
+			const size_t byteOffset = vertexCursor * vertexStride;
+			const size_t byteCount = count * vertexStride;
+			EnqueueUpload([state, byteOffset, byteCount]() {
+				const uint8_t* data = state->Source.Vertices + byteOffset;
+				state->Vertices->UpdateData(data, byteOffset, byteCount);
+				state->Source.Release(data, byteCount);
+			}, byteCount);
+			vertexCursor += count;
+		}
+	};
+
+	// Each slice of indices is preceded by every vertex it uses, so once a slice has been uploaded the whole index
+	// range up to the end of it can be drawn. Optimized meshes store their vertices in the order the indices first
+	// use them, so this ends up interleaving the two buffers evenly
+	const bool drawPartial = options.DrawPartial;
+	size_t vertexEnd = 0;
+	for (size_t first = 0; first < mesh.IndexCount; first += indicesPerSlice) {
+		const size_t count = std::min(indicesPerSlice, mesh.IndexCount - first);
+		for (size_t ix = first; ix < first + count; ix++) {
+			vertexEnd = std::max<size_t>(vertexEnd, ReadStreamIndex(mesh.Indices, indexSize, ix) + 1);
+		}
+		const bool last = first + count == mesh.IndexCount;
+		// Vertices that no index uses still need to be uploaded before we call the mesh resident
+		queueVertices(last ? mesh.VertexCount : std::min(vertexEnd, mesh.VertexCount));
+
+		const bool resolve = drawPartial ? first == 0 : last;
+		EnqueueUpload([state, handle, first, count, last, resolve]() {
+			const size_t elementSize = state->Source.IndexElementSize;
+			const uint8_t* data = state->Source.Indices + first * elementSize;
+			state->Indices->UpdateData(data, first * elementSize, count * elementSize);
+			state->Source.Release(data, count * elementSize);
+			state->Mesh->SetIndexBuffer(state->Indices, 0, static_cast<GLsizei>(first + count), state->Indices->GetElementType());
+
+			if (resolve) {
+				handle->_Resolve(state->Mesh);
+				_loaded++;
+			}
+			// Let go of the mapped file (or the mesh in memory) as soon as we're done with it
+			if (last) {
+				state->Source = CookedMeshView();
+			}
+		}, count * indexSize);
+	}
+}
+
+void AssetLoader::_LogFailure(const std::string& path, const std::string& message) {
+	LOG_WARN("Failed to load asset \"{}\": {}", path, message);
+}
+
+void AssetLoader::_WorkerMain() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(_jobLock);
+			_jobAdded.wait(lock, []() { return !_running || !_jobs.empty(); });
+			if (!_running) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+			_activeJobs++;
+		}
+
+		// Jobs queued through _Submit handle their own errors, this is for anything queued directly
+		try {
+			job();
+		} catch (const std::exception& e) {
+			LOG_WARN("Asset loader job failed: {}", e.what());
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(_jobLock);
+			_activeJobs--;
+		}
+		_jobsIdle.notify_all();
+	}
+}
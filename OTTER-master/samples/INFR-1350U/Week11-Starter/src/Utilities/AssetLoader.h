@@ -0,0 +1,522 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshLodSet.h"
+#include "Graphics/MeshletSet.h"
+#include "Graphics/Texture2D.h"
+#include "ObjLoader.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "TextureArrayPacker.h"
+
+/// <summary>
+/// The stages an asset goes through while it is being loaded in the background
+/// </summary>
+enum class AssetState
+{
+	/// <summary>
+	/// Waiting for a worker thread to pick up the load
+	/// </summary>
+	Queued = 0,
+	/// <summary>
+	/// A worker thread is reading and processing the asset
+	/// </summary>
+	Loading,
+	/// <summary>
+	/// The asset is in memory, and waiting for its turn to be uploaded on the main thread
+	/// </summary>
+	Uploading,
+	/// <summary>
+	/// The asset has been uploaded and is ready to use
+	/// </summary>
+	Resident,
+	/// <summary>
+	/// The asset could not be loaded, the handle will keep returning the placeholder
+	/// </summary>
+	Failed
+};
+
+/// <summary>
+/// A handle to an asset that is being loaded by the AssetLoader. Until the asset is resident, Get returns a
+/// placeholder so that the asset can be used right away, and anything that needs the real asset can either
+/// poll the state or register a callback with OnResident
+/// </summary>
+/// <typeparam name="T">The type of asset that the handle is for</typeparam>
+template <typename T>
+class AssetHandle final
+{
+public:
+	typedef std::shared_ptr<AssetHandle<T>> sptr;
+	typedef std::function<void(const std::shared_ptr<T>&)> ResidentCallback;
+	typedef std::function<void()> SettledCallback;
+
+	AssetHandle(const AssetHandle& other) = delete;
+	AssetHandle(AssetHandle&& other) = delete;
+	AssetHandle& operator=(const AssetHandle& other) = delete;
+	AssetHandle& operator=(AssetHandle&& other) = delete;
+
+	AssetHandle(const std::string& path, const std::shared_ptr<T>& placeholder) :
+		_path(path),
+		_state(AssetState::Queued),
+		_asset(nullptr),
+		_placeholder(placeholder),
+		_promise(),
+		_future(_promise.get_future().share()),
+		_callbacks(),
+		_settledCallbacks()
+	{ }
+
+	/// <summary>
+	/// Gets the path of the file that the asset is being loaded from
+	/// </summary>
+	const std::string& GetPath() const { return _path; }
+	/// <summary>
+	/// Gets the stage that the asset is in, this is safe to call from any thread
+	/// </summary>
+	AssetState GetState() const { return _state.load(); }
+	/// <summary>
+	/// Gets whether the asset has finished loading and been uploaded
+	/// </summary>
+	bool IsResident() const { return _state.load() == AssetState::Resident; }
+
+	/// <summary>
+	/// Gets the asset if it is resident, or the placeholder if it is not. Should only be called from the main thread
+	/// </summary>
+	const std::shared_ptr<T>& Get() const { return _asset != nullptr ? _asset : _placeholder; }
+	/// <summary>
+	/// Gets a future that becomes ready when the asset is resident, or holds an exception if it failed to load.
+	/// Note that uploads only happen in AssetLoader::Update, so waiting on this from the main thread will never
+	/// finish, use AssetLoader::Flush if the main thread needs to block until everything is loaded
+	/// </summary>
+	const std::shared_future<std::shared_ptr<T>>& GetFuture() const { return _future; }
+
+	/// <summary>
+	/// Registers a function to call on the main thread when the asset becomes resident, if the asset is already
+	/// resident it is called right away. Callbacks are not called if the asset fails to load
+	/// </summary>
+	/// <param name="callback">The function to call with the resident asset</param>
+	void OnResident(const ResidentCallback& callback) {
+		if (_asset != nullptr) {
+			callback(_asset);
+		} else {
+			_callbacks.push_back(callback);
+		}
+	}
+
+	/// <summary>
+	/// Registers a function to call on the main thread once the asset is either resident or has failed to load, if
+	/// it already has it is called right away. Use this over OnResident when the caller can fall back to the
+	/// placeholder, so that a failed load doesn't leave it waiting forever
+	/// </summary>
+	/// <param name="callback">The function to call once the load is done</param>
+	void OnSettled(const SettledCallback& callback) {
+		const AssetState state = _state.load();
+		if (state == AssetState::Resident || state == AssetState::Failed) {
+			callback();
+		} else {
+			_settledCallbacks.push_back(callback);
+		}
+	}
+
+private:
+	friend class AssetLoader;
+
+	void _SetState(AssetState state) { _state.store(state); }
+
+	// Called by the loader on the main thread once the asset has been uploaded
+	void _Resolve(const std::shared_ptr<T>& asset) {
+		_asset = asset;
+		_state.store(AssetState::Resident);
+		_promise.set_value(asset);
+		std::vector<ResidentCallback> callbacks;
+		callbacks.swap(_callbacks);
+		for (const ResidentCallback& callback : callbacks) {
+			callback(asset);
+		}
+		_Settle();
+	}
+
+	// Called by the loader on the main thread if the asset could not be loaded or uploaded
+	void _Fail(const std::string& message) {
+		_state.store(AssetState::Failed);
+		_promise.set_exception(std::make_exception_ptr(std::runtime_error(message)));
+		_callbacks.clear();
+		_Settle();
+	}
+
+	void _Settle() {
+		std::vector<SettledCallback> callbacks;
+		callbacks.swap(_settledCallbacks);
+		for (const SettledCallback& callback : callbacks) {
+			callback();
+		}
+	}
+
+	std::string _path;
+	std::atomic<AssetState> _state;
+	std::shared_ptr<T> _asset;
+	std::shared_ptr<T> _placeholder;
+	std::promise<std::shared_ptr<T>> _promise;
+	std::shared_future<std::shared_ptr<T>> _future;
+	std::vector<ResidentCallback> _callbacks;
+	std::vector<SettledCallback> _settledCallbacks;
+};
+
+/// <summary>
+/// Statistics about the work that the asset loader has queued up, and how much it has done
+/// </summary>
+struct AssetLoaderStats
+{
+	/// <summary>
+	/// The number of worker threads in the pool
+	/// </summary>
+	size_t ThreadCount;
+	/// <summary>
+	/// The number of loads waiting for a worker thread
+	/// </summary>
+	size_t QueuedJobs;
+	/// <summary>
+	/// The number of loads currently running on worker threads
+	/// </summary>
+	size_t ActiveJobs;
+	/// <summary>
+	/// The number of loads waiting to be uploaded on the main thread
+	/// </summary>
+	size_t PendingUploads;
+	/// <summary>
+	/// The number of bytes waiting to be uploaded on the main thread
+	/// </summary>
+	size_t PendingUploadBytes;
+	/// <summary>
+	/// The number of uploads done in the last call to Update
+	/// </summary>
+	size_t FrameUploads;
+	/// <summary>
+	/// The number of bytes uploaded in the last call to Update
+	/// </summary>
+	size_t FrameUploadBytes;
+	/// <summary>
+	/// The time spent uploading in the last call to Update, in milliseconds
+	/// </summary>
+	float  FrameUploadMs;
+	/// <summary>
+	/// The total number of assets that have become resident
+	/// </summary>
+	size_t Loaded;
+	/// <summary>
+	/// The total number of assets that have failed to load
+	/// </summary>
+	size_t Failed;
+};
+
+/// <summary>
+/// Options that control how AssetLoader::StreamObj splits a mesh up across frames
+/// </summary>
+struct MeshStreamOptions
+{
+	/// <summary>
+	/// The largest number of bytes to upload in a single slice. Every slice counts against the per frame upload
+	/// budget on its own, so smaller slices let a large mesh share the budget with other loads
+	/// </summary>
+	size_t SliceBytes;
+	/// <summary>
+	/// True to hand out the mesh as soon as its first triangles are resident, and draw only the range of the
+	/// index buffer that has been uploaded as the rest streams in. False to keep the placeholder until the
+	/// whole mesh is resident
+	/// </summary>
+	bool   DrawPartial;
+
+	MeshStreamOptions() :
+		SliceBytes(1024 * 1024),
+		DrawPartial(true)
+	{ }
+};
+
+/// <summary>
+/// Loads assets in the background so that the main thread never has to wait on file IO or parsing. Reading,
+/// parsing, optimizing and packing happen on a pool of worker threads, and the finished data is queued for
+/// upload. The main thread calls Update once per frame, which uploads queued assets until it runs out of its
+/// time or byte budget, so a burst of loads gets spread out over several frames instead of causing a hitch.
+///
+/// Loads return an AssetHandle right away, which hands out a placeholder (a cube for meshes, a 1x1 texture
+/// for textures) until the asset is resident. Loading the same file with the same options while an earlier
+/// handle is still alive returns that handle. Textures are loaded into the placeholder itself, so anything
+/// holding on to the texture (ex: materials) picks up the real image without having to do anything.
+///
+/// Other importers can use Enqueue and EnqueueUpload directly to split their own work the same way
+/// </summary>
+class AssetLoader
+{
+public:
+	/// <summary>
+	/// Starts the worker threads, this is called automatically by the first load if it was not called before
+	/// </summary>
+	/// <param name="threadCount">The number of worker threads to start, 0 will use one less than the number of hardware threads</param>
+	static void Init(uint32_t threadCount = 0);
+	/// <summary>
+	/// Stops the worker threads, any loads that have not finished yet are dropped and their handles are left as-is
+	/// </summary>
+	static void Shutdown();
+
+	/// <summary>
+	/// Sets how much uploading Update is allowed to do each frame. At least one upload is always done per frame
+	/// so that assets larger than the budget still get loaded eventually
+	/// </summary>
+	/// <param name="milliseconds">The amount of time to spend uploading per frame</param>
+	/// <param name="bytes">The number of bytes to upload per frame</param>
+	static void SetUploadBudget(float milliseconds, size_t bytes);
+	static float GetUploadBudgetMs() { return _budgetMs; }
+	static size_t GetUploadBudgetBytes() { return _budgetBytes; }
+
+	/// <summary>
+	/// Uploads queued assets until the budget for this frame is spent, and calls the OnResident callbacks
+	/// for anything that was uploaded. Must be called from the main thread once per frame
+	/// </summary>
+	static void Update();
+	/// <summary>
+	/// Blocks until every queued load has finished and been uploaded, ignoring the upload budget. Must be called
+	/// from the main thread
+	/// </summary>
+	static void Flush();
+
+	/// <summary>
+	/// Gets the current statistics for the loader
+	/// </summary>
+	static AssetLoaderStats GetStats();
+
+	/// <summary>
+	/// Loads an OBJ file in the background, see ObjLoader::LoadFromFile. Meshes that are already in the MeshRegistry
+	/// are handed back right away, and finished loads are added to it
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="options">The options to load the file with</param>
+	/// <returns>A handle to the mesh, which returns a cube until the mesh is resident</returns>
+	static AssetHandle<VertexArrayObject>::sptr LoadObj(const std::string& filename, const ObjLoadOptions& options = ObjLoadOptions());
+	/// <summary>
+	/// Loads an OBJ file and generates levels of detail for it in the background, see MeshRegistry::LoadObjLods. Like
+	/// LoadObj, sets that are already in the MeshRegistry are handed back right away, and finished sets are added to it
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="lodOptions">The options for generating the levels of detail</param>
+	/// <param name="options">The options to load the file with</param>
+	/// <returns>A handle to the LOD set, which returns a set with a single cube until the levels are resident</returns>
+	static AssetHandle<MeshLodSet>::sptr LoadObjLods(const std::string& filename, const MeshLodOptions& lodOptions = MeshLodOptions(), const ObjLoadOptions& options = ObjLoadOptions());
+	/// <summary>
+	/// Loads an OBJ file and splits it into meshlets in the background, see ObjLoadOptions::BuildMeshlets
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="options">The options to load the file with, BuildMeshlets is always turned on</param>
+	/// <returns>A handle to the meshlet set, which returns a single meshlet cube until the meshlets are resident</returns>
+	static AssetHandle<MeshletSet>::sptr LoadObjMeshlets(const std::string& filename, const ObjLoadOptions& options = ObjLoadOptions());
+	/// <summary>
+	/// Streams an OBJ file onto the GPU over several frames, for meshes that are too large to upload in one go. The
+	/// buffers are allocated with immutable storage up front and filled in one slice at a time through the upload
+	/// budget, straight out of the mapped cooked file if there is one, so the mesh never has to sit in memory all at
+	/// once. Vertices are always uploaded before the indices that use them, so a prefix of the index buffer can be
+	/// drawn while the rest is still on its way
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="options">The options to load the file with</param>
+	/// <param name="streamOptions">The options for splitting up the upload</param>
+	/// <returns>
+	/// A handle to the mesh, which returns a cube until the mesh is drawable. With MeshStreamOptions::DrawPartial, the
+	/// handle becomes resident once the first slice of triangles is, and the mesh keeps filling in after that
+	/// </returns>
+	static AssetHandle<VertexArrayObject>::sptr StreamObj(const std::string& filename, const ObjLoadOptions& options = ObjLoadOptions(), const MeshStreamOptions& streamOptions = MeshStreamOptions());
+	/// <summary>
+	/// Loads an image file into a texture in the background, see Texture2D::LoadFromFile. Textures that are already
+	/// in the TextureRegistry are handed back right away, and finished loads are added to it. Must be called from
+	/// the main thread, since the placeholder texture is created right away
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <returns>A handle to the texture, the placeholder is the same texture object with a single grey texel</returns>
+	static AssetHandle<Texture2D>::sptr LoadTexture(const std::string& filename);
+	/// <summary>
+	/// Loads a batch of image files into textures in the background. The images are decoded in parallel across the
+	/// worker threads, but are uploaded in the order they are listed, so the upload order (and the frames textures
+	/// pop in on) doesn't depend on which decode happens to finish first. Must be called from the main thread
+	/// </summary>
+	/// <param name="filenames">The paths of the images to load</param>
+	/// <returns>A handle for each texture, in the same order as filenames</returns>
+	static std::vector<AssetHandle<Texture2D>::sptr> LoadTextures(const std::vector<std::string>& filenames);
+	/// <summary>
+	/// Loads a batch of image files like LoadTextures, and once they are all resident packs them into texture arrays
+	/// on the main thread (see TextureArrayPacker). Must be called from the main thread
+	/// </summary>
+	/// <param name="filenames">The paths of the images to load</param>
+	/// <param name="options">The options for grouping the images into arrays</param>
+	/// <returns>
+	/// A handle to the packed set, with a slot for each image in the same order as filenames. The placeholder points
+	/// every slot at a single grey layer. Images that fail to load are packed as the grey texel they were left with
+	/// </returns>
+	static AssetHandle<TextureArraySet>::sptr LoadTextureArrays(const std::vector<std::string>& filenames, const TextureArrayPackOptions& options = TextureArrayPackOptions());
+
+	/// <summary>
+	/// Queues a function to run on one of the worker threads. The function must not touch OpenGL
+	/// </summary>
+	static void Enqueue(const std::function<void()>& job);
+	/// <summary>
+	/// Queues a function to run on the main thread during Update, this is safe to call from any thread
+	/// </summary>
+	/// <param name="upload">The function to run, this is where GL objects should be created</param>
+	/// <param name="bytes">The number of bytes the function uploads, counted against the per frame budget</param>
+	static void EnqueueUpload(const std::function<void()>& upload, size_t bytes);
+
+	/// <summary>
+	/// Gets the mesh that is drawn in place of meshes that are still loading
+	/// </summary>
+	static const VertexArrayObject::sptr& GetPlaceholderMesh();
+
+protected:
+	AssetLoader() = default;
+	~AssetLoader() = default;
+
+	struct Upload
+	{
+		std::function<void()> Func;
+		size_t                Bytes;
+	};
+
+	/// <summary>
+	/// Keeps a batch of loads uploading in the order they were submitted, no matter which order the workers finish
+	/// in. Every load owns a slot, and a finished slot is only handed to the upload queue once all the slots before
+	/// it have been
+	/// </summary>
+	struct UploadSequence
+	{
+		std::mutex                         Lock;
+		std::vector<std::function<void()>> Uploads;
+		std::vector<size_t>                Bytes;
+		std::vector<bool>                  Done;
+		size_t                             Next;
+
+		UploadSequence(size_t count) :
+			Lock(), Uploads(count), Bytes(count, 0), Done(count, false), Next(0)
+		{ }
+	};
+
+	/// <summary>
+	/// Looks up a live handle for a key, or creates a new one with the placeholder that makePlaceholder returns. The
+	/// placeholder is only made if the handle is created, so placeholders that cost something (ex: the textures that
+	/// images get loaded into) aren't thrown away by every request that joins a load. Returns true if the handle was
+	/// created, in which case the caller is responsible for queueing the load
+	/// </summary>
+	template <typename T, typename PlaceholderFunc>
+	static bool _FindOrCreateWith(const std::string& key, const std::string& path, PlaceholderFunc makePlaceholder, typename AssetHandle<T>::sptr& result) {
+		std::lock_guard<std::mutex> guard(_handleLock);
+		auto it = _handles.find(key);
+		if (it != _handles.end()) {
+			std::shared_ptr<void> existing = it->second.lock();
+			if (existing != nullptr) {
+				result = std::static_pointer_cast<AssetHandle<T>>(existing);
+				return false;
+			}
+		}
+		result = std::make_shared<AssetHandle<T>>(path, makePlaceholder());
+		_handles[key] = result;
+		return true;
+	}
+	/// <summary>
+	/// Looks up a live handle for a key, or creates a new one with the given placeholder, see _FindOrCreateWith
+	/// </summary>
+	template <typename T>
+	static bool _FindOrCreate(const std::string& key, const std::string& path, const std::shared_ptr<T>& placeholder, typename AssetHandle<T>::sptr& result) {
+		return _FindOrCreateWith<T>(key, path, [&placeholder]() { return placeholder; }, result);
+	}
+
+	/// <summary>
+	/// Queues the two halves of a load for a handle. load runs on a worker and fills in a Data, returning the number
+	/// of bytes to upload, and upload runs on the main thread and turns the Data into the asset. If a sequence is
+	/// given, the upload waits for its turn in that sequence
+	/// </summary>
+	template <typename T, typename Data, typename LoadFunc, typename UploadFunc>
+	static void _Submit(const typename AssetHandle<T>::sptr& handle, LoadFunc load, UploadFunc upload,
+		const std::shared_ptr<UploadSequence>& sequence = nullptr, size_t slot = 0)
+	{
+		Enqueue([handle, load, upload, sequence, slot]() {
+			handle->_SetState(AssetState::Loading);
+			std::shared_ptr<Data> data = std::make_shared<Data>();
+			size_t bytes = 0;
+			try {
+				bytes = load(*data);
+			} catch (const std::exception& e) {
+				const std::string message = e.what();
+				_EnqueueSequenced(sequence, slot, [handle, message]() { _FailHandle<T>(handle, message); }, 0);
+				return;
+			}
+			handle->_SetState(AssetState::Uploading);
+			_EnqueueSequenced(sequence, slot, [handle, data, upload]() {
+				try {
+					handle->_Resolve(upload(*data));
+					_loaded++;
+				} catch (const std::exception& e) {
+					_FailHandle<T>(handle, e.what());
+				}
+			}, bytes);
+		});
+	}
+
+	template <typename T>
+	static void _FailHandle(const typename AssetHandle<T>::sptr& handle, const std::string& message) {
+		_LogFailure(handle->GetPath(), message);
+		handle->_Fail(message);
+		_failed++;
+	}
+
+	/// <summary>
+	/// Queues the uploads that stream a mesh into a handle one slice at a time, called from a worker thread
+	/// </summary>
+	static void _StreamMesh(const AssetHandle<VertexArrayObject>::sptr& handle, const CookedMeshView& mesh, const MeshStreamOptions& options);
+	/// <summary>
+	/// Queues an upload, or fills in its slot in a sequence if one is given. An empty upload still fills its slot,
+	/// which is how loads that didn't need to do anything (ex: the handle already existed) let the sequence move on
+	/// </summary>
+	static void _EnqueueSequenced(const std::shared_ptr<UploadSequence>& sequence, size_t slot, const std::function<void()>& upload, size_t bytes);
+	/// <summary>
+	/// Shared by LoadTexture and LoadTextures, with an optional sequence to upload in
+	/// </summary>
+	static AssetHandle<Texture2D>::sptr _LoadTexture(const std::string& filename, const std::shared_ptr<UploadSequence>& sequence, size_t slot);
+	/// <summary>
+	/// Packs the textures for LoadTextureArrays into a handle, or waits for the ones that aren't done yet
+	/// </summary>
+	static void _PackTextureArrays(const AssetHandle<TextureArraySet>::sptr& handle, const std::vector<AssetHandle<Texture2D>::sptr>& textures, const TextureArrayPackOptions& options);
+
+	static void _LogFailure(const std::string& path, const std::string& message);
+	static void _WorkerMain();
+
+	static std::vector<std::thread> _workers;
+	static std::mutex _jobLock;
+	static std::condition_variable _jobAdded;
+	static std::condition_variable _jobsIdle;
+	static std::deque<std::function<void()>> _jobs;
+	static size_t _activeJobs;
+	static bool _running;
+
+	static std::mutex _uploadLock;
+	static std::deque<Upload> _uploads;
+	static size_t _pendingUploadBytes;
+
+	static std::mutex _handleLock;
+	static std::unordered_map<std::string, std::weak_ptr<void>> _handles;
+
+	static float _budgetMs;
+	static size_t _budgetBytes;
+	static size_t _frameUploads;
+	static size_t _frameUploadBytes;
+	static float _frameUploadMs;
+	static std::atomic<size_t> _loaded;
+	static std::atomic<size_t> _failed;
+};
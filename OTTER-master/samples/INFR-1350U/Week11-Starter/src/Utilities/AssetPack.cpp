@@ -0,0 +1,225 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <system_error>
+#include <zlib.h>
+
+#include "Logging.h"
+#include "MeshCache.h"
+
+/// <summary>
+/// Rounds an offset up to the next multiple of alignment (which must be a power of two)
+/// </summary>
+inline uint64_t AlignPackOffset(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/// <summary>
+/// Pads a stream with zeros until its position is a multiple of alignment
+/// </summary>
+void PadPackStream(std::ofstream& stream, uint64_t alignment) {
+	static const char zeros[AssetPack::Alignment] = { 0 };
+	const uint64_t position = static_cast<uint64_t>(stream.tellp());
+	const uint64_t padding = AlignPackOffset(position, alignment) - position;
+	stream.write(zeros, static_cast<std::streamsize>(padding));
+}
+
+/// <summary>
+/// Checks if a file's extension (in any case) is in a list of extensions
+/// </summary>
+bool HasPackExtension(const std::filesystem::path& path, const std::vector<std::string>& extensions) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+AssetPack::AssetPack() :
+	_path(),
+	_file(),
+	_entries(nullptr),
+	_entryCount(0),
+	_names(nullptr)
+{ }
+
+AssetPack::sptr AssetPack::Open(const std::string& path) {
+	sptr result = std::make_shared<AssetPack>();
+	result->_path = path;
+	MemoryMappedFile& file = result->_file;
+	if (!file.Open(path) || file.GetSize() < sizeof(AssetPackHeader)) {
+		return nullptr;
+	}
+
+	// Make sure everything the header points to is within the file before we trust any of it
+	AssetPackHeader header;
+	memcpy(&header, file.GetData(), sizeof(AssetPackHeader));
+	if (memcmp(header.Magic, "OPAK", 4) != 0 || header.Version != FormatVersion) {
+		LOG_WARN("\"{}\" is not an asset pack, or was built with a different version", path);
+		return nullptr;
+	}
+	const uint64_t namesEnd = header.NamesOffset + header.NamesSize;
+	const uint64_t directoryEnd = header.DirectoryOffset + header.EntryCount * sizeof(AssetPackEntry);
+	if (namesEnd > file.GetSize() || directoryEnd > file.GetSize() || header.DirectoryOffset % alignof(AssetPackEntry) != 0) {
+		LOG_WARN("Asset pack \"{}\" is corrupt", path);
+		return nullptr;
+	}
+	result->_entries = reinterpret_cast<const AssetPackEntry*>(file.GetData() + header.DirectoryOffset);
+	result->_entryCount = static_cast<size_t>(header.EntryCount);
+	result->_names = file.GetData() + header.NamesOffset;
+	for (size_t ix = 0; ix < result->_entryCount; ix++) {
+		const AssetPackEntry& entry = result->_entries[ix];
+		if (entry.Offset + entry.StoredSize > file.GetSize() ||
+			static_cast<uint64_t>(entry.NameOffset) + entry.NameLength > header.NamesSize ||
+			(entry.Compression == static_cast<uint32_t>(AssetPackCompression::None) && entry.StoredSize != entry.Size) ||
+			entry.Compression > static_cast<uint32_t>(AssetPackCompression::Zlib)) {
+			LOG_WARN("Asset pack \"{}\" has a corrupt entry at index {}", path, ix);
+			return nullptr;
+		}
+	}
+	return result;
+}
+
+std::string AssetPack::NormalizePath(const std::string& path) {
+	std::string result = std::filesystem::path(path).lexically_normal().generic_string();
+	if (result.rfind("./", 0) == 0) {
+		result.erase(0, 2);
+	}
+	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return result;
+}
+
+const AssetPackEntry* AssetPack::Find(const std::string& normalizedPath) const {
+	const uint64_t hash = MeshCache::Hash(normalizedPath.data(), normalizedPath.size());
+	const AssetPackEntry* end = _entries + _entryCount;
+	const AssetPackEntry* it = std::lower_bound(_entries, end, hash, [](const AssetPackEntry& entry, uint64_t value) {
+		return entry.PathHash < value;
+	});
+	// Different paths can share a hash, so we compare the names of everything with the same hash
+	for (; it != end && it->PathHash == hash; ++it) {
+		if (GetEntryName(*it) == normalizedPath) {
+			return it;
+		}
+	}
+	return nullptr;
+}
+
+bool AssetPack::Decompress(const AssetPackEntry& entry, std::vector<char>& result) const {
+	result.resize(static_cast<size_t>(entry.Size));
+	uLongf size = static_cast<uLongf>(entry.Size);
+	const int status = uncompress(reinterpret_cast<Bytef*>(result.data()), &size,
+		reinterpret_cast<const Bytef*>(GetStoredData(entry)), static_cast<uLong>(entry.StoredSize));
+	return status == Z_OK && size == entry.Size;
+}
+
+bool AssetPack::Write(const std::string& packPath, const std::string& rootDirectory, const AssetPackWriteOptions& options) {
+	namespace fs = std::filesystem;
+
+	// Gather up everything we're packing, sorted by path so that files that are used together (ex: the faces of a
+	// cube map) end up next to each other, and reading them is one sequential sweep through the pack
+	std::error_code error;
+	const fs::path root = fs::path(rootDirectory);
+	const fs::path packFile = fs::weakly_canonical(packPath, error);
+	std::vector<std::pair<std::string, fs::path>> files;
+	for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+		std::error_code pathError;
+		if (!it->is_regular_file() || HasPackExtension(it->path(), options.ExcludedExtensions) ||
+			fs::weakly_canonical(it->path(), pathError) == packFile) {
+			continue;
+		}
+		files.emplace_back(NormalizePath(fs::relative(it->path(), root).string()), it->path());
+	}
+	if (error) {
+		LOG_WARN("Failed to list the files in \"{}\": {}", rootDirectory, error.message());
+		return false;
+	}
+	std::sort(files.begin(), files.end());
+
+	std::ofstream stream(packPath, std::ios::binary | std::ios::trunc);
+	if (!stream) {
+		LOG_WARN("Failed to open \"{}\" for writing", packPath);
+		return false;
+	}
+	// The header gets filled in last once we know where everything is, for now we just reserve its page
+	AssetPackHeader header;
+	memset(&header, 0, sizeof(AssetPackHeader));
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(AssetPackHeader));
+	PadPackStream(stream, Alignment);
+
+	std::vector<AssetPackEntry> entries;
+	std::string names;
+	std::vector<char> compressed;
+	entries.reserve(files.size());
+	uint64_t totalSize = 0;
+	for (const auto& [name, path] : files) {
+		MemoryMappedFile source;
+		const uint64_t size = fs::file_size(path, error);
+		fs::file_time_type time;
+		if (!error) {
+			time = fs::last_write_time(path, error);
+		}
+		if (error || !source.Open(path.string())) {
+			LOG_WARN("Failed to read \"{}\", it will be left out of the pack", path.string());
+			error.clear();
+			continue;
+		}
+
+		AssetPackEntry entry;
+		memset(&entry, 0, sizeof(AssetPackEntry));
+		entry.PathHash = MeshCache::Hash(name.data(), name.size());
+		entry.Offset = static_cast<uint64_t>(stream.tellp());
+		entry.Size = size;
+		entry.SourceTime = static_cast<int64_t>(time.time_since_epoch().count());
+		entry.NameOffset = static_cast<uint32_t>(names.size());
+		entry.NameLength = static_cast<uint32_t>(name.size());
+		entry.Compression = static_cast<uint32_t>(AssetPackCompression::None);
+		names += name;
+
+		const char* data = source.GetData();
+		entry.StoredSize = size;
+		// zlib's one shot functions use 32 bit sizes on some platforms, so anything larger is stored as-is
+		if (size > 0 && size <= std::numeric_limits<uint32_t>::max() && !HasPackExtension(path, options.StoredExtensions)) {
+			uLongf compressedSize = compressBound(static_cast<uLong>(size));
+			compressed.resize(compressedSize);
+			if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &compressedSize,
+					reinterpret_cast<const Bytef*>(data), static_cast<uLong>(size), options.CompressionLevel) == Z_OK &&
+				compressedSize <= size * options.MaxCompressedRatio) {
+				entry.Compression = static_cast<uint32_t>(AssetPackCompression::Zlib);
+				entry.StoredSize = compressedSize;
+				data = compressed.data();
+			}
+		}
+		if (entry.StoredSize > 0) {
+			stream.write(data, static_cast<std::streamsize>(entry.StoredSize));
+		}
+		PadPackStream(stream, Alignment);
+		entries.push_back(entry);
+		totalSize += size;
+	}
+
+	// The directory is sorted by hash so lookups can binary search it
+	header.NamesOffset = static_cast<uint64_t>(stream.tellp());
+	header.NamesSize = names.size();
+	stream.write(names.data(), static_cast<std::streamsize>(names.size()));
+	PadPackStream(stream, alignof(AssetPackEntry));
+	std::sort(entries.begin(), entries.end(), [](const AssetPackEntry& a, const AssetPackEntry& b) { return a.PathHash < b.PathHash; });
+	header.DirectoryOffset = static_cast<uint64_t>(stream.tellp());
+	header.EntryCount = entries.size();
+	stream.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+	const uint64_t packSize = static_cast<uint64_t>(stream.tellp());
+
+	memcpy(header.Magic, "OPAK", 4);
+	header.Version = FormatVersion;
+	stream.seekp(0);
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(AssetPackHeader));
+	if (!stream) {
+		LOG_WARN("Failed to write asset pack \"{}\"", packPath);
+		return false;
+	}
+	LOG_INFO("Packed {} files from \"{}\" into \"{}\" ({:.2f} MB -> {:.2f} MB)", entries.size(), rootDirectory, packPath,
+		totalSize / (1024.0 * 1024.0), packSize / (1024.0 * 1024.0));
+	return true;
+}
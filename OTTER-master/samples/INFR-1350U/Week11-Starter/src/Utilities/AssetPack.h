@@ -0,0 +1,214 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MemoryMappedFile.h"
+
+/// <summary>
+/// How the data for an entry in an asset pack is stored
+/// </summary>
+enum class AssetPackCompression : uint32_t
+{
+	/// <summary>
+	/// Stored as-is, the data can be read straight out of the mapped pack
+	/// </summary>
+	None = 0,
+	/// <summary>
+	/// Compressed with zlib's deflate, needs to be inflated into a buffer before it can be read
+	/// </summary>
+	Zlib = 1
+};
+
+/// <summary>
+/// The header at the start of every asset pack. The file layout is:
+///     AssetPackHeader (padded out to AssetPack::Alignment)
+///     entry data, each entry starting on a multiple of AssetPack::Alignment
+///     entry names (NamesSize bytes, starting at NamesOffset, not null terminated)
+///     AssetPackEntry[EntryCount] (the central directory, starting at DirectoryOffset, sorted by PathHash)
+/// All values are stored in the native byte order of the machine that built the pack
+/// </summary>
+struct AssetPackHeader
+{
+	/// <summary>
+	/// Should always be 'OPAK', used to reject files that aren't asset packs
+	/// </summary>
+	char     Magic[4];
+	/// <summary>
+	/// The version of the format, packs with a different version are rejected
+	/// </summary>
+	uint32_t Version;
+	uint64_t EntryCount;
+	uint64_t DirectoryOffset;
+	uint64_t NamesOffset;
+	uint64_t NamesSize;
+};
+
+/// <summary>
+/// An entry in an asset pack's central directory
+/// </summary>
+struct AssetPackEntry
+{
+	/// <summary>
+	/// The MeshCache::Hash of the entry's normalized path, see AssetPack::NormalizePath
+	/// </summary>
+	uint64_t PathHash;
+	/// <summary>
+	/// The offset of the entry's data from the start of the pack, always a multiple of AssetPack::Alignment
+	/// </summary>
+	uint64_t Offset;
+	/// <summary>
+	/// The number of bytes the entry takes up in the pack
+	/// </summary>
+	uint64_t StoredSize;
+	/// <summary>
+	/// The size of the original file, in bytes
+	/// </summary>
+	uint64_t Size;
+	/// <summary>
+	/// The last write time of the original file when it was packed, so caches built from it stay valid (see MeshCache)
+	/// </summary>
+	int64_t  SourceTime;
+	/// <summary>
+	/// The offset of the entry's normalized path within the name table
+	/// </summary>
+	uint32_t NameOffset;
+	uint32_t NameLength;
+	/// <summary>
+	/// How the data is stored, see AssetPackCompression
+	/// </summary>
+	uint32_t Compression;
+	uint32_t Reserved;
+};
+
+/// <summary>
+/// Options that control how AssetPack::Write packs up a directory
+/// </summary>
+struct AssetPackWriteOptions
+{
+	/// <summary>
+	/// Files with these extensions are stored without compressing them, since they are already compressed
+	/// </summary>
+	std::vector<std::string> StoredExtensions;
+	/// <summary>
+	/// Files with these extensions are left out of the pack entirely (ex: caches and other packs)
+	/// </summary>
+	std::vector<std::string> ExcludedExtensions;
+	/// <summary>
+	/// The zlib compression level, from 1 (fastest) to 9 (smallest)
+	/// </summary>
+	int   CompressionLevel;
+	/// <summary>
+	/// Files that compress to more than this fraction of their size are stored instead, since inflating them
+	/// would cost more than reading the few bytes we saved
+	/// </summary>
+	float MaxCompressedRatio;
+
+	AssetPackWriteOptions() :
+		StoredExtensions({ ".png", ".jpg", ".jpeg", ".ktx2", ".dds", ".glb" }),
+		ExcludedExtensions({ ".pak", ".cmesh" }),
+		CompressionLevel(6),
+		MaxCompressedRatio(0.9f)
+	{ }
+};
+
+/// <summary>
+/// A single file that bundles many assets together, so that loading them is one memory mapped file instead of
+/// thousands of small reads. Entries are compressed with zlib unless compressing them doesn't help, in which
+/// case they are stored as-is and can be read without copying. Entry data is aligned to pages, so stored entries
+/// can be handed straight to anything that works with mapped memory. Packs are usually used through the
+/// VirtualFileSystem rather than directly
+/// </summary>
+class AssetPack final
+{
+public:
+	typedef std::shared_ptr<AssetPack> sptr;
+	// We'll disallow moving and copying, the entries point into our mapping
+	AssetPack(const AssetPack& other) = delete;
+	AssetPack(AssetPack&& other) = delete;
+	AssetPack& operator=(const AssetPack& other) = delete;
+	AssetPack& operator=(AssetPack&& other) = delete;
+
+	/// <summary>
+	/// The current version of the pack format
+	/// </summary>
+	static constexpr uint32_t FormatVersion = 1;
+	/// <summary>
+	/// The alignment of the header and every entry's data within the pack, in bytes
+	/// </summary>
+	static constexpr uint64_t Alignment = 4096;
+
+public:
+	AssetPack();
+	~AssetPack() = default;
+
+	/// <summary>
+	/// Maps an asset pack and checks that its directory is intact
+	/// </summary>
+	/// <param name="path">The path of the pack to open</param>
+	/// <returns>The pack, or nullptr if it could not be opened</returns>
+	static sptr Open(const std::string& path);
+
+	/// <summary>
+	/// Packs every file under a directory into a new asset pack, with paths stored relative to the directory
+	/// </summary>
+	/// <param name="packPath">The path to write the pack to, any existing file is overwritten</param>
+	/// <param name="rootDirectory">The directory to pack up</param>
+	/// <param name="options">The options for building the pack</param>
+	/// <returns>True if the pack was written, false if otherwise (the reason is logged)</returns>
+	static bool Write(const std::string& packPath, const std::string& rootDirectory, const AssetPackWriteOptions& options = AssetPackWriteOptions());
+
+	/// <summary>
+	/// Converts a path into the form it is stored in packs with, normalized with forward slashes and in lower
+	/// case, since the file systems we ship on don't care about case either
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+
+	/// <summary>
+	/// Finds the entry for a path in this pack
+	/// </summary>
+	/// <param name="normalizedPath">The path to look for, must already be normalized with NormalizePath</param>
+	/// <returns>The entry, or nullptr if the pack does not contain the path</returns>
+	const AssetPackEntry* Find(const std::string& normalizedPath) const;
+	/// <summary>
+	/// Gets the data for an entry as it is stored in the pack, this is the file's contents for stored entries
+	/// </summary>
+	const char* GetStoredData(const AssetPackEntry& entry) const { return _file.GetData() + entry.Offset; }
+	/// <summary>
+	/// Inflates a compressed entry into a buffer
+	/// </summary>
+	/// <param name="entry">The entry to inflate</param>
+	/// <param name="result">The buffer to inflate into, it is resized to the entry's size</param>
+	/// <returns>True if the data inflated to the expected size, false if the entry is corrupt</returns>
+	bool Decompress(const AssetPackEntry& entry, std::vector<char>& result) const;
+
+	/// <summary>
+	/// Gets the path of the pack on disk
+	/// </summary>
+	const std::string& GetPath() const { return _path; }
+	/// <summary>
+	/// Gets the number of entries in the pack
+	/// </summary>
+	size_t GetEntryCount() const { return _entryCount; }
+	/// <summary>
+	/// Gets an entry from the pack's directory
+	/// </summary>
+	const AssetPackEntry& GetEntry(size_t index) const { return _entries[index]; }
+	/// <summary>
+	/// Gets the normalized path of an entry
+	/// </summary>
+	std::string_view GetEntryName(const AssetPackEntry& entry) const { return std::string_view(_names + entry.NameOffset, entry.NameLength); }
+	/// <summary>
+	/// Gets the total size of the pack on disk, in bytes
+	/// </summary>
+	size_t GetSize() const { return _file.GetSize(); }
+
+private:
+	std::string           _path;
+	MemoryMappedFile      _file;
+	const AssetPackEntry* _entries;
+	size_t                _entryCount;
+	const char*           _names;
+};
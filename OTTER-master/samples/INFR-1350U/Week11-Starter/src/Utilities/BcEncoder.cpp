@@ -0,0 +1,479 @@
+#include "BcEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "ParallelFor.h"
+
+// A 4x4 block of RGBA texels, stored as floats so the fitting doesn't have to keep converting them
+typedef float BcBlock[16][4];
+
+// The weight of the second endpoint for each BC1 index (index 2 is 2/3 of the first endpoint, index 3 is 1/3)
+static constexpr float Bc1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+// The weight of the second endpoint (out of 64) for each 4 bit BC7 index
+static constexpr int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/// <summary>
+/// Reads a 4x4 block out of an RGBA8 image, repeating the edge texels for blocks that hang off the edge
+/// </summary>
+inline void LoadBcBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, BcBlock& block) {
+	for (uint32_t y = 0; y < 4; y++) {
+		const uint32_t row = std::min(blockY * 4 + y, height - 1);
+		for (uint32_t x = 0; x < 4; x++) {
+			const uint32_t column = std::min(blockX * 4 + x, width - 1);
+			const uint8_t* texel = rgba + ((size_t)row * width + column) * 4;
+			for (int c = 0; c < 4; c++) {
+				block[y * 4 + x][c] = texel[c];
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Finds the line that best fits the first N channels of a block's texels (its principal axis), and the two ends of
+/// the span the texels cover along it
+/// </summary>
+template <int N>
+inline void FitBcLine(const BcBlock& block, float start[4], float end[4]) {
+	float mean[N] = {};
+	float low[N], high[N];
+	std::fill(low, low + N, 255.0f);
+	std::fill(high, high + N, 0.0f);
+	for (int px = 0; px < 16; px++) {
+		for (int c = 0; c < N; c++) {
+			mean[c] += block[px][c] / 16.0f;
+			low[c] = std::min(low[c], block[px][c]);
+			high[c] = std::max(high[c], block[px][c]);
+		}
+	}
+
+	float covariance[N][N] = {};
+	for (int px = 0; px < 16; px++) {
+		for (int i = 0; i < N; i++) {
+			for (int j = 0; j < N; j++) {
+				covariance[i][j] += (block[px][i] - mean[i]) * (block[px][j] - mean[j]);
+			}
+		}
+	}
+
+	// Power iteration, starting from the diagonal of the bounding box since that's usually close already. If the
+	// texels run against the diagonal it can collapse to nothing, in which case the widest channel is a good start
+	float axis[N];
+	float length = 0.0f;
+	for (int c = 0; c < N; c++) {
+		axis[c] = high[c] - low[c];
+		length += axis[c] * axis[c];
+	}
+	if (length == 0.0f) {
+		// Every texel is the same
+		for (int c = 0; c < 4; c++) {
+			start[c] = end[c] = c < N ? mean[c] : 0.0f;
+		}
+		return;
+	}
+	for (int attempt = 0; attempt < 2; attempt++) {
+		bool collapsed = false;
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[N] = {};
+			float nextLength = 0.0f;
+			for (int i = 0; i < N; i++) {
+				for (int j = 0; j < N; j++) {
+					next[i] += covariance[i][j] * axis[j];
+				}
+				nextLength += next[i] * next[i];
+			}
+			if (nextLength < 1e-6f) {
+				collapsed = true;
+				break;
+			}
+			nextLength = std::sqrt(nextLength);
+			for (int c = 0; c < N; c++) {
+				axis[c] = next[c] / nextLength;
+			}
+		}
+		if (!collapsed) {
+			break;
+		}
+		int widest = 0;
+		for (int c = 1; c < N; c++) {
+			if (high[c] - low[c] > high[widest] - low[widest]) {
+				widest = c;
+			}
+		}
+		std::fill(axis, axis + N, 0.0f);
+		axis[widest] = 1.0f;
+	}
+
+	float minT = 0.0f, maxT = 0.0f;
+	for (int px = 0; px < 16; px++) {
+		float t = 0.0f;
+		for (int c = 0; c < N; c++) {
+			t += (block[px][c] - mean[c]) * axis[c];
+		}
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	for (int c = 0; c < 4; c++) {
+		start[c] = c < N ? std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f) : 0.0f;
+		end[c] = c < N ? std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f) : 0.0f;
+	}
+}
+
+/// <summary>
+/// Finds the pair of endpoints that best reproduces the first N channels of a block, given how far along the line
+/// between them each texel is (a least squares fit). Returns false if the weights can't pin the endpoints down
+/// </summary>
+template <int N>
+inline bool SolveBcEndpoints(const BcBlock& block, const float weights[16], float start[4], float end[4]) {
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[N] = {}, bx[N] = {};
+	for (int px = 0; px < 16; px++) {
+		const float b = weights[px];
+		const float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < N; c++) {
+			ax[c] += a * block[px][c];
+			bx[c] += b * block[px][c];
+		}
+	}
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f) {
+		return false;
+	}
+	for (int c = 0; c < 4; c++) {
+		start[c] = c < N ? std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f) : 0.0f;
+		end[c] = c < N ? std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f) : 0.0f;
+	}
+	return true;
+}
+
+/// <summary>
+/// Gets the squared distance between a texel and a palette entry over the first N channels
+/// </summary>
+template <int N>
+inline float GetBcError(const float texel[4], const int color[4]) {
+	float result = 0.0f;
+	for (int c = 0; c < N; c++) {
+		const float delta = texel[c] - color[c];
+		result += delta * delta;
+	}
+	return result;
+}
+
+/// <summary>
+/// Packs a colour into the 5:6:5 format that BC1 stores its endpoints in
+/// </summary>
+inline uint16_t PackBc565(const float color[4]) {
+	const uint16_t r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+	const uint16_t g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+	const uint16_t b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+	return (r << 11) | (g << 5) | b;
+}
+
+/// <summary>
+/// Expands a 5:6:5 colour back out to 8 bits per channel, the same way the GPU does
+/// </summary>
+inline void UnpackBc565(uint16_t packed, int color[4]) {
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+	color[3] = 255;
+}
+
+/// <summary>
+/// Orders a pair of BC1 endpoints for 4 colour mode, and picks the closest palette entry for every texel
+/// </summary>
+/// <returns>The total squared error of the block</returns>
+inline float ChooseBc1Indices(const BcBlock& block, uint16_t& c0, uint16_t& c1, uint8_t indices[16]) {
+	// 4 colour mode needs the first endpoint to be larger, if they're equal every texel just uses the first one
+	if (c0 < c1) {
+		std::swap(c0, c1);
+	}
+	int palette[4][4];
+	UnpackBc565(c0, palette[0]);
+	UnpackBc565(c1, palette[1]);
+	for (int c = 0; c < 4; c++) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+	const int paletteSize = c0 == c1 ? 1 : 4;
+
+	float result = 0.0f;
+	for (int px = 0; px < 16; px++) {
+		float best = GetBcError<3>(block[px], palette[0]);
+		indices[px] = 0;
+		for (int ix = 1; ix < paletteSize; ix++) {
+			const float error = GetBcError<3>(block[px], palette[ix]);
+			if (error < best) {
+				best = error;
+				indices[px] = static_cast<uint8_t>(ix);
+			}
+		}
+		result += best;
+	}
+	return result;
+}
+
+/// <summary>
+/// Compresses the RGB channels of a block into an 8 byte BC1 block
+/// </summary>
+inline void EncodeBc1Block(const BcBlock& block, uint8_t* output) {
+	float start[4], end[4];
+	FitBcLine<3>(block, start, end);
+	// Pulling the ends in a little keeps a few outliers from spreading the palette too thin for everything else
+	for (int c = 0; c < 3; c++) {
+		const float inset = (end[c] - start[c]) / 16.0f;
+		start[c] += inset;
+		end[c] -= inset;
+	}
+
+	uint16_t c0 = PackBc565(end);
+	uint16_t c1 = PackBc565(start);
+	uint8_t indices[16];
+	float error = ChooseBc1Indices(block, c0, c1, indices);
+
+	// One round of least squares on the indices we picked usually finds better endpoints
+	float weights[16];
+	for (int px = 0; px < 16; px++) {
+		weights[px] = Bc1Weights[indices[px]];
+	}
+	if (SolveBcEndpoints<3>(block, weights, start, end)) {
+		uint16_t r0 = PackBc565(start);
+		uint16_t r1 = PackBc565(end);
+		uint8_t refined[16];
+		const float refinedError = ChooseBc1Indices(block, r0, r1, refined);
+		if (refinedError < error) {
+			c0 = r0;
+			c1 = r1;
+			memcpy(indices, refined, sizeof(refined));
+		}
+	}
+
+	output[0] = static_cast<uint8_t>(c0 & 0xFF);
+	output[1] = static_cast<uint8_t>(c0 >> 8);
+	output[2] = static_cast<uint8_t>(c1 & 0xFF);
+	output[3] = static_cast<uint8_t>(c1 >> 8);
+	for (int row = 0; row < 4; row++) {
+		const uint8_t* rowIndices = indices + row * 4;
+		output[4 + row] = static_cast<uint8_t>(rowIndices[0] | (rowIndices[1] << 2) | (rowIndices[2] << 4) | (rowIndices[3] << 6));
+	}
+}
+
+/// <summary>
+/// Compresses a single channel of a block into an 8 byte BC4 block (also used for BC3's alpha and both halves of BC5)
+/// </summary>
+inline void EncodeBc4Block(const BcBlock& block, int channel, uint8_t* output) {
+	float low = 255.0f, high = 0.0f;
+	for (int px = 0; px < 16; px++) {
+		low = std::min(low, block[px][channel]);
+		high = std::max(high, block[px][channel]);
+	}
+
+	// With the first endpoint larger, the block uses 8 evenly spaced steps between them
+	const int a0 = static_cast<int>(std::lround(high));
+	const int a1 = static_cast<int>(std::lround(low));
+	int palette[8] = { a0, a1 };
+	for (int ix = 2; ix < 8; ix++) {
+		palette[ix] = ((8 - ix) * a0 + (ix - 1) * a1) / 7;
+	}
+	const int paletteSize = a0 == a1 ? 1 : 8;
+
+	uint64_t bits = 0;
+	for (int px = 0; px < 16; px++) {
+		int best = 0;
+		float bestError = std::abs(block[px][channel] - palette[0]);
+		for (int ix = 1; ix < paletteSize; ix++) {
+			const float error = std::abs(block[px][channel] - palette[ix]);
+			if (error < bestError) {
+				bestError = error;
+				best = ix;
+			}
+		}
+		bits |= static_cast<uint64_t>(best) << (px * 3);
+	}
+
+	output[0] = static_cast<uint8_t>(a0);
+	output[1] = static_cast<uint8_t>(a1);
+	for (int ix = 0; ix < 6; ix++) {
+		output[2 + ix] = static_cast<uint8_t>(bits >> (ix * 8));
+	}
+}
+
+/// <summary>
+/// Quantizes a BC7 mode 6 endpoint to 7 bits per channel plus a p-bit shared by all of its channels, picking
+/// whichever p-bit lands closer
+/// </summary>
+inline void QuantizeBc7Endpoint(const float value[4], uint8_t quantized[4], uint8_t& pBit) {
+	float bestError = -1.0f;
+	for (uint8_t p = 0; p < 2; p++) {
+		uint8_t candidate[4];
+		float error = 0.0f;
+		for (int c = 0; c < 4; c++) {
+			candidate[c] = static_cast<uint8_t>(std::clamp<long>(std::lround((value[c] - p) / 2.0f), 0, 127));
+			const float delta = ((candidate[c] << 1) | p) - value[c];
+			error += delta * delta;
+		}
+		if (bestError < 0.0f || error < bestError) {
+			bestError = error;
+			pBit = p;
+			memcpy(quantized, candidate, sizeof(candidate));
+		}
+	}
+}
+
+/// <summary>
+/// Picks the closest of the 16 palette entries between two BC7 mode 6 endpoints for every texel
+/// </summary>
+/// <returns>The total squared error of the block</returns>
+inline float ChooseBc7Indices(const BcBlock& block, const uint8_t q0[4], uint8_t p0, const uint8_t q1[4], uint8_t p1, uint8_t indices[16]) {
+	int palette[16][4];
+	for (int c = 0; c < 4; c++) {
+		const int e0 = (q0[c] << 1) | p0;
+		const int e1 = (q1[c] << 1) | p1;
+		for (int ix = 0; ix < 16; ix++) {
+			palette[ix][c] = ((64 - Bc7Weights[ix]) * e0 + Bc7Weights[ix] * e1 + 32) >> 6;
+		}
+	}
+
+	float result = 0.0f;
+	for (int px = 0; px < 16; px++) {
+		float best = GetBcError<4>(block[px], palette[0]);
+		indices[px] = 0;
+		for (int ix = 1; ix < 16; ix++) {
+			const float error = GetBcError<4>(block[px], palette[ix]);
+			if (error < best) {
+				best = error;
+				indices[px] = static_cast<uint8_t>(ix);
+			}
+		}
+		result += best;
+	}
+	return result;
+}
+
+/// <summary>
+/// Writes values into a block LSB first, the way BC7 packs its fields
+/// </summary>
+struct BcBitWriter
+{
+	uint8_t* Output;
+	uint32_t Position;
+
+	void Write(uint32_t value, uint32_t bits) {
+		for (uint32_t ix = 0; ix < bits; ix++, Position++) {
+			if ((value >> ix) & 1) {
+				Output[Position >> 3] |= static_cast<uint8_t>(1 << (Position & 7));
+			}
+		}
+	}
+};
+
+/// <summary>
+/// Compresses a block into a 16 byte BC7 block, using mode 6 (one RGBA line with 7 bit endpoints, a p-bit per
+/// endpoint and 4 bit indices)
+/// </summary>
+inline void EncodeBc7Block(const BcBlock& block, uint8_t* output) {
+	float start[4], end[4];
+	FitBcLine<4>(block, start, end);
+
+	uint8_t q0[4], q1[4], p0, p1;
+	QuantizeBc7Endpoint(start, q0, p0);
+	QuantizeBc7Endpoint(end, q1, p1);
+	uint8_t indices[16];
+	float error = ChooseBc7Indices(block, q0, p0, q1, p1, indices);
+
+	float weights[16];
+	for (int px = 0; px < 16; px++) {
+		weights[px] = Bc7Weights[indices[px]] / 64.0f;
+	}
+	if (SolveBcEndpoints<4>(block, weights, start, end)) {
+		uint8_t r0[4], r1[4], rp0, rp1;
+		QuantizeBc7Endpoint(start, r0, rp0);
+		QuantizeBc7Endpoint(end, r1, rp1);
+		uint8_t refined[16];
+		const float refinedError = ChooseBc7Indices(block, r0, rp0, r1, rp1, refined);
+		if (refinedError < error) {
+			memcpy(q0, r0, sizeof(q0));
+			memcpy(q1, r1, sizeof(q1));
+			p0 = rp0;
+			p1 = rp1;
+			memcpy(indices, refined, sizeof(refined));
+		}
+	}
+
+	// The first texel's index is stored with only 3 bits, so its top bit has to be 0. Swapping the endpoints flips it
+	if (indices[0] & 8) {
+		for (int c = 0; c < 4; c++) {
+			std::swap(q0[c], q1[c]);
+		}
+		std::swap(p0, p1);
+		for (int px = 0; px < 16; px++) {
+			indices[px] = 15 - indices[px];
+		}
+	}
+
+	memset(output, 0, 16);
+	BcBitWriter writer = { output, 0 };
+	writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++) {
+		writer.Write(q0[c], 7);
+		writer.Write(q1[c], 7);
+	}
+	writer.Write(p0, 1);
+	writer.Write(p1, 1);
+	writer.Write(indices[0], 3);
+	for (int px = 1; px < 16; px++) {
+		writer.Write(indices[px], 4);
+	}
+}
+
+void BcEncoder::Encode(const uint8_t* rgba, uint32_t width, uint32_t height, InternalFormat format, uint8_t* output, uint32_t threadCount) {
+	const size_t blockSize = GetCompressedBlockSize(format);
+	LOG_ASSERT(blockSize != 0, "Format {} is not block compressed!", format);
+	LOG_ASSERT(width > 0 && height > 0, "Cannot compress an empty image!");
+
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	size_t threads = threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	threads = std::min(threads, (size_t)blocksX * blocksY / MinBlocksPerThread + 1);
+
+	// Every block is independent, so each thread just takes a range of block rows
+	ParallelFor(threads, [&](size_t chunk) {
+		const uint32_t endRow = static_cast<uint32_t>(blocksY * (chunk + 1) / threads);
+		BcBlock block;
+		for (uint32_t blockY = static_cast<uint32_t>(blocksY * chunk / threads); blockY < endRow; blockY++) {
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+				LoadBcBlock(rgba, width, height, blockX, blockY, block);
+				uint8_t* result = output + ((size_t)blockY * blocksX + blockX) * blockSize;
+				switch (format) {
+					case InternalFormat::BC1:
+						EncodeBc1Block(block, result);
+						break;
+					case InternalFormat::BC3:
+						EncodeBc4Block(block, 3, result);
+						EncodeBc1Block(block, result + 8);
+						break;
+					case InternalFormat::BC4:
+						EncodeBc4Block(block, 0, result);
+						break;
+					case InternalFormat::BC5:
+						EncodeBc4Block(block, 0, result);
+						EncodeBc4Block(block, 1, result + 8);
+						break;
+					case InternalFormat::BC7:
+						EncodeBc7Block(block, result);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+	});
+}
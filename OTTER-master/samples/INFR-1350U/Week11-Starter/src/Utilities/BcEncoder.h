@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+#include "Graphics/TextureEnums.h"
+
+/// <summary>
+/// A CPU encoder for the block compressed texture formats (BC1, BC3, BC4, BC5 and BC7). This is meant for cooking
+/// textures offline (see TextureCooker), it favours being simple and predictable over squeezing out every last bit
+/// of quality. Endpoints are found along the principal axis of each block's colours and refined with a least
+/// squares fit, and BC7 only uses mode 6 (a single RGBA line with 16 steps), which suits most of our textures
+/// </summary>
+class BcEncoder
+{
+public:
+	/// <summary>
+	/// The fewest blocks each thread should get, smaller images use fewer threads
+	/// </summary>
+	static constexpr size_t MinBlocksPerThread = 1024;
+
+	/// <summary>
+	/// Compresses an image into one of the block compressed formats. Images that aren't a multiple of 4 texels
+	/// across are padded out by repeating their edges
+	/// </summary>
+	/// <param name="rgba">The image to compress, as tightly packed RGBA8 texels. Formats with fewer channels ignore the rest</param>
+	/// <param name="width">The width of the image, in texels</param>
+	/// <param name="height">The height of the image, in texels</param>
+	/// <param name="format">The format to compress to, must be one of BC1, BC3, BC4, BC5 or BC7</param>
+	/// <param name="output">The buffer to write the blocks to, must be GetTextureLevelSize(format, width, height) bytes</param>
+	/// <param name="threadCount">The number of threads to use, 0 will use one per hardware thread</param>
+	static void Encode(const uint8_t* rgba, uint32_t width, uint32_t height, InternalFormat format, uint8_t* output, uint32_t threadCount = 0);
+
+protected:
+	BcEncoder() = default;
+	~BcEncoder() = default;
+};
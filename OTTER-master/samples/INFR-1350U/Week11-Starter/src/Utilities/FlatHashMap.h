@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// An insert-only hash map that stores all of its entries in one flat array and resolves collisions with
+/// linear probing. Compared to std::unordered_map there is no allocation per entry and lookups touch
+/// neighbouring memory, which makes it a lot faster for building large lookup tables such as vertex
+/// de-duplication maps. If you know roughly how many entries you will add, call Reserve first.
+///
+/// Note that entries can't be erased, and pointers returned by Find/TryEmplace are only valid until the
+/// next insertion (the table may grow)
+/// </summary>
+/// <typeparam name="TKey">The type of key, must be default constructible, copyable and comparable with ==</typeparam>
+/// <typeparam name="TValue">The type of value, must be default constructible and copyable</typeparam>
+/// <typeparam name="THash">The hash function for keys, the output gets re-mixed so std::hash is fine</typeparam>
+template <typename TKey, typename TValue, typename THash = std::hash<TKey>>
+class FlatHashMap
+{
+public:
+	/// <summary>
+	/// Creates a new empty map, no memory is allocated until the first insert or Reserve
+	/// </summary>
+	FlatHashMap() :
+		_entries(),
+		_occupied(),
+		_size(0),
+		_mask(0),
+		_shift(64),
+		_hasher() { }
+	~FlatHashMap() = default;
+
+	/// <summary>
+	/// The fraction of slots that can be filled before the table grows, linear probing slows down quickly past this
+	/// </summary>
+	static constexpr double MaxLoadFactor = 0.5;
+
+	/// <summary>
+	/// Makes sure the map can hold at least count entries without growing
+	/// </summary>
+	/// <param name="count">The number of entries to make room for</param>
+	void Reserve(size_t count) {
+		size_t capacity = 16;
+		while (capacity * MaxLoadFactor < count) {
+			capacity *= 2;
+		}
+		if (capacity > _entries.size()) {
+			_Rehash(capacity);
+		}
+	}
+
+	/// <summary>
+	/// Inserts the key with the given value if the key is not in the map yet
+	/// </summary>
+	/// <param name="key">The key to look up or insert</param>
+	/// <param name="value">The value to store if the key is new</param>
+	/// <returns>A pointer to the value stored for the key, and true if the key was inserted</returns>
+	std::pair<TValue*, bool> TryEmplace(const TKey& key, const TValue& value) {
+		if (_size + 1 > _entries.size() * MaxLoadFactor) {
+			_Rehash(_entries.empty() ? 16 : _entries.size() * 2);
+		}
+
+		// The occupied flags are kept in their own array, so probing past empty slots doesn't pull entries into the cache
+		size_t slot = _GetSlot(key);
+		while (_occupied[slot]) {
+			if (_entries[slot].first == key) {
+				return { &_entries[slot].second, false };
+			}
+			slot = (slot + 1) & _mask;
+		}
+
+		_occupied[slot] = 1;
+		_entries[slot].first = key;
+		_entries[slot].second = value;
+		_size++;
+		return { &_entries[slot].second, true };
+	}
+
+	/// <summary>
+	/// Finds the value stored for a key
+	/// </summary>
+	/// <param name="key">The key to search for</param>
+	/// <returns>A pointer to the value, or nullptr if the key is not in the map</returns>
+	TValue* Find(const TKey& key) {
+		if (_size == 0) {
+			return nullptr;
+		}
+		size_t slot = _GetSlot(key);
+		while (_occupied[slot]) {
+			if (_entries[slot].first == key) {
+				return &_entries[slot].second;
+			}
+			slot = (slot + 1) & _mask;
+		}
+		return nullptr;
+	}
+	const TValue* Find(const TKey& key) const {
+		return const_cast<FlatHashMap*>(this)->Find(key);
+	}
+
+	/// <summary>
+	/// Removes all entries from the map, but keeps the memory around for re-use
+	/// </summary>
+	void Clear() {
+		std::fill(_occupied.begin(), _occupied.end(), uint8_t(0));
+		_size = 0;
+	}
+
+	/// <summary>
+	/// Returns the number of entries in the map
+	/// </summary>
+	size_t Size() const { return _size; }
+	/// <summary>
+	/// Returns the number of slots in the table
+	/// </summary>
+	size_t Capacity() const { return _entries.size(); }
+
+protected:
+	std::vector<std::pair<TKey, TValue>> _entries;
+	std::vector<uint8_t> _occupied;
+	size_t _size;
+	size_t _mask;
+	int    _shift;
+	THash  _hasher;
+
+	/// <summary>
+	/// Gets the first slot to probe for a key, we use fibonacci hashing on top of the user's hash so that
+	/// weak hashes (ex: std::hash on integers is usually the identity) still spread out over the table
+	/// </summary>
+	size_t _GetSlot(const TKey& key) const {
+		const uint64_t hash = static_cast<uint64_t>(_hasher(key));
+		return static_cast<size_t>((hash * 11400714819323198485ull) >> _shift);
+	}
+
+	void _Rehash(size_t capacity) {
+		std::vector<std::pair<TKey, TValue>> entries(capacity);
+		std::vector<uint8_t> occupied(capacity, 0);
+		entries.swap(_entries);
+		occupied.swap(_occupied);
+
+		_mask = capacity - 1;
+		_shift = 64;
+		for (size_t bits = capacity; bits > 1; bits >>= 1) {
+			_shift--;
+		}
+
+		for (size_t ix = 0; ix < entries.size(); ix++) {
+			if (occupied[ix]) {
+				size_t slot = _GetSlot(entries[ix].first);
+				while (_occupied[slot]) {
+					slot = (slot + 1) & _mask;
+				}
+				_occupied[slot] = 1;
+				_entries[slot] = std::move(entries[ix]);
+			}
+		}
+	}
+};
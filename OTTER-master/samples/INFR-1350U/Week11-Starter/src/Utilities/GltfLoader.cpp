@@ -0,0 +1,749 @@
+#include "GltfLoader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <GLM/gtc/type_ptr.hpp>
+#include <GLM/gtx/matrix_decompose.hpp>
+#include <json.hpp>
+#include <tiny_gltf.h>
+
+#include "Logging.h"
+#include "Gameplay/GameObjectTag.h"
+#include "Gameplay/RendererComponent.h"
+#include "Gameplay/Transform.h"
+#include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DData.h"
+#include "Utilities/MemoryMappedFile.h"
+#include "Utilities/TextureArrayPacker.h"
+
+/// <summary>
+/// Maps the glTF vertex attributes we support onto the inputs of our vertex shaders
+/// </summary>
+struct GltfAttributeSlot
+{
+	const char* Name;
+	GLuint      Slot;
+	AttribUsage Usage;
+};
+static const GltfAttributeSlot GLTF_ATTRIBUTE_SLOTS[] = {
+	{ "POSITION",   0, AttribUsage::Position },
+	{ "COLOR_0",    1, AttribUsage::Color },
+	{ "NORMAL",     2, AttribUsage::Normal },
+	{ "TEXCOORD_0", 3, AttribUsage::Texture }
+};
+
+/// <summary>
+/// Views that are not uploaded don't have an offset in the packed buffers
+/// </summary>
+static constexpr size_t NO_OFFSET = std::numeric_limits<size_t>::max();
+
+/// <summary>
+/// The GPU buffers that hold the packed vertex and index views of one glTF buffer
+/// </summary>
+struct GltfBufferUpload
+{
+	VertexBuffer::sptr Vertices;
+	IndexBuffer::sptr  Indices;
+};
+
+/// <summary>
+/// All the state shared between the steps of an import
+/// </summary>
+struct GltfImportContext
+{
+	const tinygltf::Model&  Model;
+	const GltfLoadOptions&  Options;
+	GltfImportStats&        Stats;
+	GameScene::sptr         Scene;
+
+	// The data for each glTF buffer. For GLB files the embedded buffer points straight into the mapped file
+	std::vector<const unsigned char*> BufferData;
+	std::vector<size_t>               BufferSizes;
+	// The mapped GLB file, or nullptr if we're loading a .gltf
+	const MemoryMappedFile*           File;
+	// Images stored in a GLB's binary chunk, keyed by image index. tinygltf only ever sees a placeholder for these
+	std::unordered_map<int, std::pair<const unsigned char*, size_t>> EmbeddedImages;
+
+	// The images that were uploaded while tinygltf parsed the file, keyed by image index
+	std::unordered_map<int, Texture2D::sptr> Images;
+
+	// Where each buffer view landed in its buffer's packed vertex and index data
+	std::vector<size_t>           VertexOffsets;
+	std::vector<size_t>           IndexOffsets;
+	std::vector<GltfBufferUpload> Uploads;
+
+	// Whether we can draw each primitive, per mesh and primitive
+	std::vector<std::vector<bool>>   Drawable;
+	// Sequential indices for primitives that don't have any, offsets are per mesh and primitive
+	std::vector<uint32_t>            GeneratedIndices;
+	std::vector<std::vector<size_t>> GeneratedOffsets;
+	IndexBuffer::sptr                GeneratedBuffer;
+
+	// The base color of every material, index 0 is the default material
+	VertexBuffer::sptr BaseColors;
+
+	std::vector<ShaderMaterial::sptr>                 Materials;
+	ShaderMaterial::sptr                              DefaultMaterial;
+	std::vector<Texture2D::sptr>                      Textures;
+	Texture2D::sptr                                   White;
+	std::vector<std::vector<VertexArrayObject::sptr>> Primitives;
+
+	GltfImportContext(const tinygltf::Model& model, const GltfLoadOptions& options, GltfImportStats& stats, const GameScene::sptr& scene) :
+		Model(model), Options(options), Stats(stats), Scene(scene), File(nullptr) { }
+};
+
+inline size_t AlignGltfOffset(size_t value) {
+	return (value + 3) & ~static_cast<size_t>(3);
+}
+
+/// <summary>
+/// Tells the OS it can drop part of the mapped file from memory, if we're loading from one
+/// </summary>
+void ReleaseGltfBytes(const GltfImportContext& context, const unsigned char* data, size_t size) {
+	const char* start = reinterpret_cast<const char*>(data);
+	if (context.File != nullptr && start >= context.File->GetData() && start < context.File->GetEnd()) {
+		context.File->Release(start - context.File->GetData(), size);
+	}
+}
+
+/// <summary>
+/// Decodes and uploads images as tinygltf finds them (see TinyGLTF::SetImageLoader), so neither tinygltf nor we
+/// keep a copy of the pixels around. The sampler settings get applied later, once the textures have been parsed
+/// </summary>
+bool DecodeGltfImage(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn,
+	int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData)
+{
+	GltfImportContext* context = static_cast<GltfImportContext*>(userData);
+	if (!context->Options.LoadTextures) {
+		return true;
+	}
+
+	// Images in a GLB's binary chunk are decoded straight out of the mapped file
+	size_t byteCount = static_cast<size_t>(size);
+	auto embedded = context->EmbeddedImages.find(imageIndex);
+	if (embedded != context->EmbeddedImages.end()) {
+		bytes = embedded->second.first;
+		byteCount = embedded->second.second;
+	}
+
+	const std::string name = !image->name.empty() ? image->name : !image->uri.empty() ? image->uri : "image " + std::to_string(imageIndex);
+	Texture2DData::sptr data = Texture2DData::LoadFromMemory(bytes, byteCount, name);
+	ReleaseGltfBytes(*context, bytes, byteCount);
+	// A broken image shouldn't stop the level from loading, the material will just end up white
+	if (data == nullptr) {
+		if (warn != nullptr) {
+			*warn += "Failed to decode image \"" + name + "\"\n";
+		}
+		return true;
+	}
+	// glTF puts the origin of its texture coordinates in the top left
+	data->FlipVertically();
+
+	image->width = data->GetWidth();
+	image->height = data->GetHeight();
+	Texture2D::sptr texture = Texture2D::Create();
+	texture->LoadData(data);
+	context->Images[imageIndex] = texture;
+	context->Stats.Textures++;
+	return true;
+}
+
+/// <summary>
+/// Gets the size in bytes of a single element of an accessor (ex: 12 for a float vec3)
+/// </summary>
+inline size_t GetGltfElementSize(const tinygltf::Accessor& accessor) {
+	return static_cast<size_t>(tinygltf::GetComponentSizeInBytes(accessor.componentType)) * tinygltf::GetNumComponentsInType(accessor.type);
+}
+
+/// <summary>
+/// Checks that an accessor has a buffer view, and that all of its elements fit inside of it
+/// </summary>
+bool IsGltfAccessorInRange(const GltfImportContext& context, const tinygltf::Accessor& accessor) {
+	const tinygltf::Model& model = context.Model;
+	if (accessor.bufferView < 0 || accessor.bufferView >= (int)model.bufferViews.size() || accessor.sparse.isSparse) {
+		return false;
+	}
+	const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+	if (view.buffer < 0 || view.buffer >= (int)model.buffers.size() || view.byteOffset + view.byteLength > context.BufferSizes[view.buffer]) {
+		return false;
+	}
+	const int stride = accessor.ByteStride(view);
+	if (stride <= 0 || accessor.count == 0) {
+		return false;
+	}
+	return accessor.byteOffset + (accessor.count - 1) * stride + GetGltfElementSize(accessor) <= view.byteLength;
+}
+
+/// <summary>
+/// Checks whether we can draw a primitive, and warns if we can't
+/// </summary>
+bool IsGltfPrimitiveSupported(const GltfImportContext& context, const tinygltf::Primitive& primitive, const std::string& meshName) {
+	const tinygltf::Model& model = context.Model;
+	if (primitive.mode != -1 && primitive.mode != TINYGLTF_MODE_TRIANGLES) {
+		LOG_WARN("Skipping primitive in mesh \"{}\", only triangle lists are supported", meshName);
+		return false;
+	}
+	for (const GltfAttributeSlot& slot : GLTF_ATTRIBUTE_SLOTS) {
+		auto it = primitive.attributes.find(slot.Name);
+		if (it == primitive.attributes.end()) {
+			if (slot.Usage == AttribUsage::Position) {
+				LOG_WARN("Skipping primitive in mesh \"{}\", it has no positions", meshName);
+				return false;
+			}
+			continue;
+		}
+		if (it->second < 0 || it->second >= (int)model.accessors.size() || !IsGltfAccessorInRange(context, model.accessors[it->second])) {
+			LOG_WARN("Skipping primitive in mesh \"{}\", attribute {} is outside of its buffer", meshName, slot.Name);
+			return false;
+		}
+	}
+	if (primitive.indices >= 0) {
+		if (primitive.indices >= (int)model.accessors.size() || !IsGltfAccessorInRange(context, model.accessors[primitive.indices])) {
+			LOG_WARN("Skipping primitive in mesh \"{}\", the indices are outside of their buffer", meshName);
+			return false;
+		}
+		const int type = model.accessors[primitive.indices].componentType;
+		if (type != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && type != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT && type != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
+			LOG_WARN("Skipping primitive in mesh \"{}\", indices must be unsigned integers", meshName);
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Copies the views that were assigned to a GPU buffer straight out of the glTF buffer, the GPU buffer must already be allocated.
+/// For GLB files this reads from the mapped file, and lets each view's pages go once it's uploaded
+/// </summary>
+void UploadGltfViews(GltfImportContext& context, IBuffer& target, const std::vector<size_t>& offsets, int bufferIndex, size_t size) {
+	const tinygltf::Model& model = context.Model;
+	const unsigned char* source = context.BufferData[bufferIndex];
+	for (size_t ix = 0; ix < model.bufferViews.size(); ix++) {
+		const tinygltf::BufferView& view = model.bufferViews[ix];
+		if (view.buffer == bufferIndex && offsets[ix] != NO_OFFSET) {
+			target.UpdateData(source + view.byteOffset, offsets[ix], view.byteLength);
+			ReleaseGltfBytes(context, source + view.byteOffset, view.byteLength);
+		}
+	}
+	context.Stats.BufferUploads++;
+	context.Stats.UploadBytes += size;
+}
+
+/// <summary>
+/// Works out which buffer views hold vertex or index data, packs them together per glTF buffer, and uploads each buffer
+/// </summary>
+void UploadGltfBuffers(GltfImportContext& context) {
+	const tinygltf::Model& model = context.Model;
+	context.VertexOffsets.assign(model.bufferViews.size(), NO_OFFSET);
+	context.IndexOffsets.assign(model.bufferViews.size(), NO_OFFSET);
+	context.Drawable.resize(model.meshes.size());
+	context.GeneratedOffsets.resize(model.meshes.size());
+
+	// Mark the views that our primitives actually use, so we don't upload things like images or skinning data
+	for (size_t meshIx = 0; meshIx < model.meshes.size(); meshIx++) {
+		const tinygltf::Mesh& mesh = model.meshes[meshIx];
+		context.Drawable[meshIx].assign(mesh.primitives.size(), false);
+		context.GeneratedOffsets[meshIx].assign(mesh.primitives.size(), NO_OFFSET);
+		for (size_t primIx = 0; primIx < mesh.primitives.size(); primIx++) {
+			const tinygltf::Primitive& primitive = mesh.primitives[primIx];
+			if (!IsGltfPrimitiveSupported(context, primitive, mesh.name)) {
+				continue;
+			}
+			context.Drawable[meshIx][primIx] = true;
+			for (const GltfAttributeSlot& slot : GLTF_ATTRIBUTE_SLOTS) {
+				auto it = primitive.attributes.find(slot.Name);
+				if (it != primitive.attributes.end()) {
+					context.VertexOffsets[model.accessors[it->second].bufferView] = 0;
+				}
+			}
+			if (primitive.indices >= 0) {
+				context.IndexOffsets[model.accessors[primitive.indices].bufferView] = 0;
+			} else {
+				// Every primitive is drawn with indices, so non-indexed ones get a sequential list
+				const size_t vertexCount = model.accessors[primitive.attributes.at("POSITION")].count;
+				context.GeneratedOffsets[meshIx][primIx] = context.GeneratedIndices.size();
+				for (size_t ix = 0; ix < vertexCount; ix++) {
+					context.GeneratedIndices.push_back(static_cast<uint32_t>(ix));
+				}
+			}
+		}
+	}
+
+	context.Uploads.resize(model.buffers.size());
+	for (int bufferIx = 0; bufferIx < (int)model.buffers.size(); bufferIx++) {
+		size_t vertexSize = 0;
+		size_t indexSize = 0;
+		for (size_t viewIx = 0; viewIx < model.bufferViews.size(); viewIx++) {
+			const tinygltf::BufferView& view = model.bufferViews[viewIx];
+			if (view.buffer != bufferIx) {
+				continue;
+			}
+			// Vertex attributes need to be 4 byte aligned, so we keep every view on a 4 byte boundary
+			if (context.VertexOffsets[viewIx] != NO_OFFSET) {
+				context.VertexOffsets[viewIx] = AlignGltfOffset(vertexSize);
+				vertexSize = context.VertexOffsets[viewIx] + view.byteLength;
+			}
+			if (context.IndexOffsets[viewIx] != NO_OFFSET) {
+				context.IndexOffsets[viewIx] = AlignGltfOffset(indexSize);
+				indexSize = context.IndexOffsets[viewIx] + view.byteLength;
+			}
+		}
+
+		// The buffers hold raw bytes, the VAOs describe how to read them with their attribute offsets and strides
+		if (vertexSize > 0) {
+			context.Uploads[bufferIx].Vertices = VertexBuffer::Create();
+			context.Uploads[bufferIx].Vertices->LoadData(nullptr, 1, vertexSize);
+			UploadGltfViews(context, *context.Uploads[bufferIx].Vertices, context.VertexOffsets, bufferIx, vertexSize);
+		}
+		if (indexSize > 0) {
+			context.Uploads[bufferIx].Indices = IndexBuffer::Create();
+			context.Uploads[bufferIx].Indices->LoadData(nullptr, 1, indexSize, GL_UNSIGNED_BYTE);
+			UploadGltfViews(context, *context.Uploads[bufferIx].Indices, context.IndexOffsets, bufferIx, indexSize);
+		}
+	}
+
+	if (!context.GeneratedIndices.empty()) {
+		context.GeneratedBuffer = IndexBuffer::Create();
+		context.GeneratedBuffer->LoadData(context.GeneratedIndices.data(), context.GeneratedIndices.size());
+		context.Stats.BufferUploads++;
+		context.Stats.UploadBytes += context.GeneratedIndices.size() * sizeof(uint32_t);
+	}
+}
+
+/// <summary>
+/// Gets the texture for a glTF texture slot, applying its sampler the first time it's used. Textures that share an
+/// image share the OpenGL texture as well, so they'll all end up with the first texture's sampler
+/// </summary>
+Texture2D::sptr GetGltfTexture(GltfImportContext& context, int textureIndex) {
+	const tinygltf::Model& model = context.Model;
+	if (textureIndex < 0 || textureIndex >= (int)model.textures.size()) {
+		return context.White;
+	}
+	if (context.Textures[textureIndex] != nullptr) {
+		return context.Textures[textureIndex];
+	}
+
+	const tinygltf::Texture& texture = model.textures[textureIndex];
+	auto it = context.Images.find(texture.source);
+	if (it == context.Images.end()) {
+		context.Textures[textureIndex] = context.White;
+		return context.White;
+	}
+
+	// glTF uses the OpenGL enums for its samplers, so they map straight onto ours
+	Texture2D::sptr result = it->second;
+	if (texture.sampler >= 0 && texture.sampler < (int)model.samplers.size()) {
+		const tinygltf::Sampler& sampler = model.samplers[texture.sampler];
+		result->SetWrapS((WrapMode)sampler.wrapS);
+		result->SetWrapT((WrapMode)sampler.wrapT);
+		if (sampler.minFilter != -1) {
+			result->SetMinFilter((MinFilter)sampler.minFilter);
+		}
+		if (sampler.magFilter != -1) {
+			result->SetMagFilter((MagFilter)sampler.magFilter);
+		}
+	}
+	context.Textures[textureIndex] = result;
+	return result;
+}
+
+/// <summary>
+/// Creates a material for one of the glTF material slots, our shaders don't do PBR so we approximate it
+/// </summary>
+ShaderMaterial::sptr CreateGltfMaterial(GltfImportContext& context, const tinygltf::Material& material) {
+	const tinygltf::PbrMetallicRoughness& pbr = material.pbrMetallicRoughness;
+	Texture2D::sptr diffuse = GetGltfTexture(context, pbr.baseColorTexture.index);
+
+	// Rougher surfaces get wider, dimmer highlights, this is the usual Blinn-Phong exponent for a GGX roughness
+	const float roughness = std::max(static_cast<float>(pbr.roughnessFactor), 0.01f);
+	const float shininess = glm::clamp(2.0f / (roughness * roughness * roughness * roughness) - 2.0f, 1.0f, 256.0f);
+
+	ShaderMaterial::sptr result = ShaderMaterial::Create();
+	result->Shader = context.Options.Shader;
+	result->DebugName = material.name;
+	result->Set("s_Diffuse2", diffuse);
+	result->Set("s_Specular", context.White);
+	result->Set("u_Shininess", shininess);
+	result->Set("u_TextureMix", 0.0f);
+	context.Stats.Materials++;
+	return result;
+}
+
+/// <summary>
+/// Creates the materials for every material slot, and uploads their base colors
+/// </summary>
+void CreateGltfMaterials(GltfImportContext& context) {
+	const tinygltf::Model& model = context.Model;
+
+	Texture2DDescription desc = Texture2DDescription();
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.Format = InternalFormat::RGB8;
+	context.White = Texture2D::Create(desc);
+	context.White->Clear();
+
+	context.Textures.resize(model.textures.size());
+	std::vector<glm::vec3> baseColors;
+	baseColors.push_back(glm::vec3(1.0f));
+	for (const tinygltf::Material& material : model.materials) {
+		context.Materials.push_back(CreateGltfMaterial(context, material));
+		const std::vector<double>& factor = material.pbrMetallicRoughness.baseColorFactor;
+		baseColors.push_back(factor.size() >= 3 ? glm::vec3(factor[0], factor[1], factor[2]) : glm::vec3(1.0f));
+	}
+	context.DefaultMaterial = CreateGltfMaterial(context, tinygltf::Material());
+
+	// Our textured shader reads s_Diffuse from a texture array, so the base color textures get packed, and materials
+	// whose images match only differ by a layer
+	std::vector<Texture2D::sptr> diffuse;
+	diffuse.reserve(model.materials.size() + 1);
+	for (const tinygltf::Material& material : model.materials) {
+		diffuse.push_back(GetGltfTexture(context, material.pbrMetallicRoughness.baseColorTexture.index));
+	}
+	diffuse.push_back(context.White);
+	TextureArraySet::sptr arrays = TextureArrayPacker::Pack(diffuse);
+	for (size_t ix = 0; ix < context.Materials.size(); ix++) {
+		context.Materials[ix]->Set("s_Diffuse", arrays->Slots[ix]);
+	}
+	context.DefaultMaterial->Set("s_Diffuse", arrays->Slots.back());
+
+	context.BaseColors = VertexBuffer::Create();
+	context.BaseColors->LoadData(baseColors.data(), 1, baseColors.size() * sizeof(glm::vec3));
+	context.Stats.BufferUploads++;
+	context.Stats.UploadBytes += baseColors.size() * sizeof(glm::vec3);
+}
+
+/// <summary>
+/// Creates a VAO that reads a primitive's attributes and indices out of the shared buffers
+/// </summary>
+VertexArrayObject::sptr CreateGltfPrimitive(GltfImportContext& context, size_t meshIx, size_t primIx) {
+	const tinygltf::Model& model = context.Model;
+	const tinygltf::Primitive& primitive = model.meshes[meshIx].primitives[primIx];
+
+	// Attributes are grouped by the buffer they come from, since each buffer has its own GPU buffer
+	std::vector<std::vector<BufferAttribute>> attributes(model.buffers.size());
+	bool hasColor = false;
+	for (const GltfAttributeSlot& slot : GLTF_ATTRIBUTE_SLOTS) {
+		auto it = primitive.attributes.find(slot.Name);
+		if (it == primitive.attributes.end()) {
+			continue;
+		}
+		const tinygltf::Accessor& accessor = model.accessors[it->second];
+		const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+		attributes[view.buffer].push_back(BufferAttribute(slot.Slot, tinygltf::GetNumComponentsInType(accessor.type), accessor.componentType,
+			accessor.normalized, accessor.ByteStride(view), context.VertexOffsets[accessor.bufferView] + accessor.byteOffset, slot.Usage));
+		hasColor |= slot.Usage == AttribUsage::Color;
+	}
+
+	VertexArrayObject::sptr result = VertexArrayObject::Create();
+	for (size_t bufferIx = 0; bufferIx < attributes.size(); bufferIx++) {
+		if (!attributes[bufferIx].empty()) {
+			result->AddVertexBuffer(context.Uploads[bufferIx].Vertices, attributes[bufferIx]);
+		}
+	}
+
+	// Our shaders multiply the vertex color into the result, primitives without colors get their material's base color
+	// instead. With a divisor set, every vertex of a non-instanced draw reads the same value
+	if (!hasColor) {
+		const size_t colorIx = primitive.material >= 0 && primitive.material < (int)model.materials.size() ? primitive.material + 1 : 0;
+		result->AddVertexBuffer(context.BaseColors, {
+			BufferAttribute(1, 3, GL_FLOAT, false, sizeof(glm::vec3), colorIx * sizeof(glm::vec3), AttribUsage::Color, 1)
+		});
+	}
+
+	if (primitive.indices >= 0) {
+		const tinygltf::Accessor& accessor = model.accessors[primitive.indices];
+		const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+		result->SetIndexBuffer(context.Uploads[view.buffer].Indices, context.IndexOffsets[accessor.bufferView] + accessor.byteOffset,
+			static_cast<GLsizei>(accessor.count), accessor.componentType);
+	} else {
+		const size_t vertexCount = model.accessors[primitive.attributes.at("POSITION")].count;
+		result->SetIndexBuffer(context.GeneratedBuffer, context.GeneratedOffsets[meshIx][primIx] * sizeof(uint32_t),
+			static_cast<GLsizei>(vertexCount), GL_UNSIGNED_INT);
+	}
+
+	// glTF requires POSITION accessors to have their min and max, so we don't have to read the vertices for the bounds
+	auto positions = primitive.attributes.find("POSITION");
+	const tinygltf::Accessor* bounds = positions != primitive.attributes.end() ? &model.accessors[positions->second] : nullptr;
+	if (bounds != nullptr && bounds->minValues.size() >= 3 && bounds->maxValues.size() >= 3) {
+		const glm::vec3 min = glm::vec3(bounds->minValues[0], bounds->minValues[1], bounds->minValues[2]);
+		const glm::vec3 max = glm::vec3(bounds->maxValues[0], bounds->maxValues[1], bounds->maxValues[2]);
+		result->SetBounds((min + max) * 0.5f, glm::length(max - min) * 0.5f);
+	}
+
+	if (!model.meshes[meshIx].name.empty()) {
+		result->SetDebugName(model.meshes[meshIx].name);
+	}
+	context.Stats.Primitives++;
+	return result;
+}
+
+/// <summary>
+/// Creates the VAOs for every primitive, they get shared between all of the nodes that use the same mesh
+/// </summary>
+void CreateGltfPrimitives(GltfImportContext& context) {
+	const tinygltf::Model& model = context.Model;
+	context.Primitives.resize(model.meshes.size());
+	for (size_t meshIx = 0; meshIx < model.meshes.size(); meshIx++) {
+		const tinygltf::Mesh& mesh = model.meshes[meshIx];
+		context.Primitives[meshIx].resize(mesh.primitives.size());
+		for (size_t primIx = 0; primIx < mesh.primitives.size(); primIx++) {
+			// UploadGltfBuffers already warned about the primitives we can't draw
+			if (context.Drawable[meshIx][primIx]) {
+				context.Primitives[meshIx][primIx] = CreateGltfPrimitive(context, meshIx, primIx);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Copies a node's transform into an entity, nodes either have a matrix or separate translation, rotation and scale
+/// </summary>
+void SetGltfNodeTransform(Transform& transform, const tinygltf::Node& node) {
+	if (node.matrix.size() == 16) {
+		const glm::mat4 matrix = glm::mat4(glm::make_mat4(node.matrix.data()));
+		glm::vec3 scale, translation, skew;
+		glm::quat rotation;
+		glm::vec4 perspective;
+		glm::decompose(matrix, scale, rotation, translation, skew, perspective);
+		transform.SetLocalPosition(translation);
+		transform.SetLocalRotation(rotation);
+		transform.SetLocalScale(scale);
+		return;
+	}
+	if (node.translation.size() == 3) {
+		transform.SetLocalPosition(glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
+	}
+	// glTF stores quaternions as XYZW, GLM's constructor takes WXYZ
+	if (node.rotation.size() == 4) {
+		transform.SetLocalRotation(glm::quat((float)node.rotation[3], (float)node.rotation[0], (float)node.rotation[1], (float)node.rotation[2]));
+	}
+	if (node.scale.size() == 3) {
+		transform.SetLocalScale(glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+	}
+}
+
+/// <summary>
+/// Creates the entity for a node and its children
+/// </summary>
+void CreateGltfNode(GltfImportContext& context, int nodeIndex, GameObject parent, std::vector<bool>& visited) {
+	const tinygltf::Model& model = context.Model;
+	if (nodeIndex < 0 || nodeIndex >= (int)model.nodes.size() || visited[nodeIndex]) {
+		LOG_WARN("Skipping node {}, it does not exist or is used more than once", nodeIndex);
+		return;
+	}
+	visited[nodeIndex] = true;
+	const tinygltf::Node& node = model.nodes[nodeIndex];
+
+	GameObject object = context.Scene->CreateEntity(node.name.empty() ? "node " + std::to_string(nodeIndex) : node.name);
+	Transform& transform = object.get<Transform>();
+	SetGltfNodeTransform(transform, node);
+	transform.SetParent(parent);
+	context.Stats.Nodes++;
+
+	if (node.mesh >= 0 && node.mesh < (int)model.meshes.size()) {
+		const std::vector<VertexArrayObject::sptr>& primitives = context.Primitives[node.mesh];
+		const tinygltf::Mesh& mesh = model.meshes[node.mesh];
+		for (size_t primIx = 0; primIx < primitives.size(); primIx++) {
+			if (primitives[primIx] == nullptr) {
+				continue;
+			}
+			const int materialIx = mesh.primitives[primIx].material;
+			const ShaderMaterial::sptr& material = materialIx >= 0 && materialIx < (int)context.Materials.size() ? context.Materials[materialIx] : context.DefaultMaterial;
+
+			// Our renderer only draws one mesh per entity, so extra primitives go on child entities
+			GameObject target = object;
+			if (primitives.size() > 1) {
+				target = context.Scene->CreateEntity(object.get<GameObjectTag>().Name + "/" + std::to_string(primIx));
+				target.get<Transform>().SetParent(object);
+			}
+			target.emplace<RendererComponent>().SetMesh(primitives[primIx]).SetMaterial(material);
+		}
+	}
+
+	for (int child : node.children) {
+		CreateGltfNode(context, child, object, visited);
+	}
+}
+
+/// <summary>
+/// The chunk types in a GLB file, see https://www.khronos.org/registry/glTF/specs/2.0/glTF-2.0.html#binary-gltf-layout
+/// </summary>
+static constexpr uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+static constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+static constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+inline uint32_t ReadGlbWord(const char* data) {
+	uint32_t result;
+	memcpy(&result, data, sizeof(uint32_t));
+	return result;
+}
+
+/// <summary>
+/// Parses a memory mapped GLB file without copying its binary chunk. tinygltf would copy the whole chunk into its
+/// buffer (on top of reading the whole file into memory), so we hand it the JSON with the embedded buffer and any
+/// images stored in it swapped for tiny placeholders, and point the context at the mapped data instead
+/// </summary>
+bool LoadGltfBinary(GltfImportContext& context, tinygltf::TinyGLTF& loader, tinygltf::Model& model, const MemoryMappedFile& file,
+	const std::string& baseDir, std::string& err, std::string& warn)
+{
+	const char* data = file.GetData();
+	const size_t size = file.GetSize();
+	if (size < 20 || ReadGlbWord(data) != GLB_MAGIC || ReadGlbWord(data + 4) != 2) {
+		err = "Not a glTF 2.0 binary file";
+		return false;
+	}
+	const size_t length = std::min(static_cast<size_t>(ReadGlbWord(data + 8)), size);
+	const size_t jsonLength = ReadGlbWord(data + 12);
+	if (ReadGlbWord(data + 16) != GLB_CHUNK_JSON || 20 + jsonLength > length) {
+		err = "The first chunk must be JSON, and must fit in the file";
+		return false;
+	}
+
+	// The binary chunk is optional, and always comes right after the JSON
+	const unsigned char* binData = nullptr;
+	size_t binLength = 0;
+	const size_t binHeader = 20 + jsonLength;
+	if (binHeader + 8 <= length && ReadGlbWord(data + binHeader + 4) == GLB_CHUNK_BIN) {
+		binData = reinterpret_cast<const unsigned char*>(data + binHeader + 8);
+		binLength = std::min(static_cast<size_t>(ReadGlbWord(data + binHeader)), length - binHeader - 8);
+	}
+
+	nlohmann::json document = nlohmann::json::parse(data + 20, data + 20 + jsonLength, nullptr, false);
+	if (document.is_discarded() || !document.is_object()) {
+		err = "Failed to parse the JSON chunk";
+		return false;
+	}
+
+	// Only the first buffer may live in the binary chunk, and it's the one without a uri
+	int embeddedBuffer = -1;
+	size_t embeddedLength = 0;
+	auto buffers = document.find("buffers");
+	if (buffers != document.end() && buffers->is_array() && !buffers->empty() && (*buffers)[0].is_object() && !(*buffers)[0].contains("uri")) {
+		nlohmann::json& buffer = (*buffers)[0];
+		embeddedLength = buffer.value("byteLength", static_cast<size_t>(0));
+		if (binData == nullptr || embeddedLength > binLength) {
+			err = "The binary chunk is missing or smaller than the buffer stored in it";
+			return false;
+		}
+		embeddedBuffer = 0;
+		buffer["uri"] = "data:application/octet-stream;base64,AA==";
+		buffer["byteLength"] = 1;
+	}
+
+	// Images in the binary chunk get decoded straight out of the mapped file, see DecodeGltfImage
+	auto images = document.find("images");
+	auto views = document.find("bufferViews");
+	const bool hasImages = embeddedBuffer >= 0 && images != document.end() && images->is_array() && views != document.end() && views->is_array();
+	for (size_t ix = 0; hasImages && ix < images->size(); ix++) {
+		nlohmann::json& image = (*images)[ix];
+		if (!image.is_object() || !image.contains("bufferView") || !image["bufferView"].is_number_unsigned()) {
+			continue;
+		}
+		const size_t viewIx = image["bufferView"].get<size_t>();
+		if (viewIx >= views->size() || !(*views)[viewIx].is_object() || (*views)[viewIx].value("buffer", -1) != embeddedBuffer) {
+			continue;
+		}
+		const size_t offset = (*views)[viewIx].value("byteOffset", static_cast<size_t>(0));
+		const size_t byteLength = (*views)[viewIx].value("byteLength", static_cast<size_t>(0));
+		if (offset + byteLength > embeddedLength) {
+			err = "Image " + std::to_string(ix) + " is outside of the binary chunk";
+			return false;
+		}
+		context.EmbeddedImages[static_cast<int>(ix)] = std::make_pair(binData + offset, byteLength);
+		image.erase("bufferView");
+		image.erase("mimeType");
+		image["uri"] = "data:image/png;base64,AA==";
+	}
+
+	const std::string json = document.dump();
+	if (!loader.LoadASCIIFromString(&model, &err, &warn, json.c_str(), static_cast<unsigned int>(json.size()), baseDir)) {
+		return false;
+	}
+	if (embeddedBuffer >= 0) {
+		context.BufferData.resize(model.buffers.size(), nullptr);
+		context.BufferSizes.resize(model.buffers.size(), 0);
+		context.BufferData[embeddedBuffer] = binData;
+		context.BufferSizes[embeddedBuffer] = embeddedLength;
+	}
+	return true;
+}
+
+GameObject GltfLoader::LoadScene(const GameScene::sptr& scene, const std::string& filename, const GltfLoadOptions& options, GltfImportStats* stats) {
+	if (options.Shader == nullptr) {
+		throw std::runtime_error("A shader is required to create materials for glTF files");
+	}
+
+	GltfImportStats localStats;
+	tinygltf::Model model;
+	GltfImportContext context(model, options, stats != nullptr ? *stats : localStats, scene);
+
+	tinygltf::TinyGLTF loader;
+	loader.SetImageLoader(DecodeGltfImage, &context);
+	std::string err, warn;
+	const std::filesystem::path path(filename);
+	MemoryMappedFile file;
+	bool loaded;
+	// GLB files are memory mapped, so the binary chunk is never copied, only the views we use get paged in while we upload them
+	if (path.extension() == ".glb") {
+		if (!file.Open(filename)) {
+			throw std::runtime_error("Failed to open glTF file \"" + filename + "\"");
+		}
+		context.File = &file;
+		loaded = LoadGltfBinary(context, loader, model, file, path.parent_path().string(), err, warn);
+	} else {
+		loaded = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+	}
+	if (!warn.empty()) {
+		LOG_WARN("glTF warnings for \"{}\": {}", filename, warn);
+	}
+	if (!loaded) {
+		throw std::runtime_error("Failed to load glTF file \"" + filename + "\": " + err);
+	}
+
+	// Buffers we didn't map use tinygltf's copy of the data
+	context.BufferData.resize(model.buffers.size(), nullptr);
+	context.BufferSizes.resize(model.buffers.size(), 0);
+	for (size_t ix = 0; ix < model.buffers.size(); ix++) {
+		if (context.BufferData[ix] == nullptr) {
+			context.BufferData[ix] = model.buffers[ix].data.data();
+			context.BufferSizes[ix] = model.buffers[ix].data.size();
+		}
+	}
+
+	UploadGltfBuffers(context);
+	CreateGltfMaterials(context);
+	CreateGltfPrimitives(context);
+
+	GameObject root = scene->CreateEntity(path.stem().string());
+	std::vector<bool> visited(model.nodes.size(), false);
+	if (!model.scenes.empty()) {
+		const int sceneIx = model.defaultScene >= 0 && model.defaultScene < (int)model.scenes.size() ? model.defaultScene : 0;
+		for (int node : model.scenes[sceneIx].nodes) {
+			CreateGltfNode(context, node, root, visited);
+		}
+	} else {
+		// Files without scenes just get every node that isn't a child of another
+		std::vector<bool> isChild(model.nodes.size(), false);
+		for (const tinygltf::Node& node : model.nodes) {
+			for (int child : node.children) {
+				if (child >= 0 && child < (int)model.nodes.size()) {
+					isChild[child] = true;
+				}
+			}
+		}
+		for (int ix = 0; ix < (int)model.nodes.size(); ix++) {
+			if (!isChild[ix]) {
+				CreateGltfNode(context, ix, root, visited);
+			}
+		}
+	}
+
+	LOG_INFO("Imported \"{}\": {} nodes, {} primitives, {} materials, {} textures, {} buffer uploads ({} bytes)", filename,
+		context.Stats.Nodes, context.Stats.Primitives, context.Stats.Materials, context.Stats.Textures, context.Stats.BufferUploads, context.Stats.UploadBytes);
+	return root;
+}
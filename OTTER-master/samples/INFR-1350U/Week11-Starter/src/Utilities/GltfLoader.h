@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+
+#include "Gameplay/Scene.h"
+#include "Gameplay/ShaderMaterial.h"
+#include "Graphics/Shader.h"
+
+/// <summary>
+/// Options that control how a glTF scene gets imported
+/// </summary>
+struct GltfLoadOptions
+{
+	/// <summary>
+	/// The shader to give the materials that get created from the file's material slots, this is required
+	/// </summary>
+	Shader::sptr Shader;
+	/// <summary>
+	/// True to decode and upload the images used by the materials, false to give every material a white
+	/// texture (useful for quickly previewing a level's layout)
+	/// </summary>
+	bool         LoadTextures;
+
+	GltfLoadOptions() :
+		Shader(nullptr),
+		LoadTextures(true)
+	{ }
+};
+
+/// <summary>
+/// Counters describing what a glTF import created
+/// </summary>
+struct GltfImportStats
+{
+	/// <summary>
+	/// The number of entities that were created for the file's nodes, not including the root
+	/// </summary>
+	size_t Nodes;
+	/// <summary>
+	/// The number of primitives (VAOs) that were created, primitives are shared between nodes that use the same mesh
+	/// </summary>
+	size_t Primitives;
+	/// <summary>
+	/// The number of GPU buffers that were created and filled
+	/// </summary>
+	size_t BufferUploads;
+	/// <summary>
+	/// The total number of bytes uploaded to those buffers
+	/// </summary>
+	size_t UploadBytes;
+	/// <summary>
+	/// The number of materials that were created
+	/// </summary>
+	size_t Materials;
+	/// <summary>
+	/// The number of textures that were decoded and uploaded
+	/// </summary>
+	size_t Textures;
+
+	GltfImportStats() :
+		Nodes(0),
+		Primitives(0),
+		BufferUploads(0),
+		UploadBytes(0),
+		Materials(0),
+		Textures(0)
+	{ }
+};
+
+/// <summary>
+/// Imports whole glTF 2.0 scenes (.gltf or .glb) into a GameScene. Rather than uploading every primitive on its own,
+/// the vertex and index data of each glTF buffer is uploaded once, and every primitive gets a VAO that points at its
+/// range of the shared buffers. A level with hundreds of nodes only needs a handful of buffer uploads this way
+/// </summary>
+class GltfLoader
+{
+public:
+	/// <summary>
+	/// Loads a glTF file and instantiates its default scene. Every node becomes an entity parented to a new root
+	/// entity, and nodes with meshes get a RendererComponent (or one child entity per primitive if their mesh has
+	/// several). glTF is Y-up, transform the root entity to fit it into a Z-up scene
+	/// </summary>
+	/// <param name="scene">The scene to create the entities in</param>
+	/// <param name="filename">The path of the file to load, .glb files are loaded as binary glTF</param>
+	/// <param name="options">The options to use when importing the file</param>
+	/// <param name="stats">If not null, will be filled with counts of what the import created</param>
+	/// <returns>The root entity that all of the file's nodes are parented to</returns>
+	static GameObject LoadScene(const GameScene::sptr& scene, const std::string& filename, const GltfLoadOptions& options, GltfImportStats* stats = nullptr);
+
+protected:
+	GltfLoader() = default;
+	~GltfLoader() = default;
+};
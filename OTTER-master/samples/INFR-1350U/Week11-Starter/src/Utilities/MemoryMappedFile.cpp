@@ -0,0 +1,139 @@
+#include "MemoryMappedFile.h"
+
+#include <algorithm>
+
+#ifdef WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile() :
+	_data(nullptr),
+	_size(0),
+	_isOpen(false),
+	#ifdef WINDOWS
+	_fileHandle(nullptr),
+	_mappingHandle(nullptr)
+	#else
+	_fileDescriptor(-1)
+	#endif
+{ }
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path) :
+	MemoryMappedFile()
+{
+	Open(path);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+	Close();
+}
+
+bool MemoryMappedFile::Open(const std::string& path) {
+	Close();
+
+	#ifdef WINDOWS
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		return false;
+	}
+	_fileHandle = file;
+	_size = static_cast<size_t>(size.QuadPart);
+
+	// Windows will refuse to map an empty file, so we just leave the data pointer as null
+	if (_size > 0) {
+		_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mappingHandle == nullptr) {
+			Close();
+			return false;
+		}
+		_data = static_cast<const char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (_data == nullptr) {
+			Close();
+			return false;
+		}
+	}
+	#else
+	_fileDescriptor = open(path.c_str(), O_RDONLY);
+	if (_fileDescriptor == -1) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(_fileDescriptor, &info) != 0) {
+		Close();
+		return false;
+	}
+	_size = static_cast<size_t>(info.st_size);
+
+	// mmap will refuse to map an empty file, so we just leave the data pointer as null
+	if (_size > 0) {
+		void* mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+		if (mapping == MAP_FAILED) {
+			Close();
+			return false;
+		}
+		// We'll be reading front to back, let the kernel know it can read ahead aggressively
+		madvise(mapping, _size, MADV_SEQUENTIAL);
+		_data = static_cast<const char*>(mapping);
+	}
+	#endif
+
+	_isOpen = true;
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	#ifdef WINDOWS
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != nullptr) {
+		CloseHandle(_mappingHandle);
+		_mappingHandle = nullptr;
+	}
+	if (_fileHandle != nullptr) {
+		CloseHandle(_fileHandle);
+		_fileHandle = nullptr;
+	}
+	#else
+	if (_data != nullptr) {
+		munmap(const_cast<char*>(_data), _size);
+	}
+	if (_fileDescriptor != -1) {
+		close(_fileDescriptor);
+		_fileDescriptor = -1;
+	}
+	#endif
+
+	_data = nullptr;
+	_size = 0;
+	_isOpen = false;
+}
+
+void MemoryMappedFile::Release(size_t offset, size_t size) const {
+	if (_data == nullptr || offset >= _size || size == 0) {
+		return;
+	}
+	size = std::min(size, _size - offset);
+
+	#ifdef WINDOWS
+	// Unlocking pages that were never locked removes them from the working set, which is exactly what we want
+	VirtualUnlock(const_cast<char*>(_data + offset), size);
+	#else
+	// madvise needs a page aligned address, dropping the rest of the first page is harmless since it's a read only mapping
+	static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t start = offset - (offset % pageSize);
+	madvise(const_cast<char*>(_data + start), size + (offset - start), MADV_DONTNEED);
+	#endif
+}
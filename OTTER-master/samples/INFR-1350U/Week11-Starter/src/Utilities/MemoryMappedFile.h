@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// A read-only view of a file on disk, mapped directly into our address space. This lets us parse
+/// large files without copying them into a buffer first, the OS will page the data in as we touch it
+/// </summary>
+class MemoryMappedFile final
+{
+public:
+	// We'll disallow moving and copying, since we want to manually control when the mapping is released
+	MemoryMappedFile(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile(MemoryMappedFile&& other) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile& operator=(MemoryMappedFile&& other) = delete;
+
+	/// <summary>
+	/// Creates a new memory mapped file that is not yet bound to anything
+	/// </summary>
+	MemoryMappedFile();
+	/// <summary>
+	/// Creates a new memory mapped file and attempts to open the given path, check IsOpen for the result
+	/// </summary>
+	/// <param name="path">The path of the file to map</param>
+	explicit MemoryMappedFile(const std::string& path);
+	~MemoryMappedFile();
+
+	/// <summary>
+	/// Maps the given file into memory, closing any file that was previously mapped
+	/// </summary>
+	/// <param name="path">The path of the file to map</param>
+	/// <returns>True if the file was opened and mapped, false if otherwise</returns>
+	bool Open(const std::string& path);
+	/// <summary>
+	/// Releases the mapping and closes the underlying file handle
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if this object currently has a file mapped (note that empty files are open, but have a null data pointer)
+	/// </summary>
+	bool IsOpen() const { return _isOpen; }
+	/// <summary>
+	/// Gets a pointer to the first byte of the file, valid until Close is called or this object is destroyed
+	/// </summary>
+	const char* GetData() const { return _data; }
+	/// <summary>
+	/// Gets a pointer to one past the last byte of the file
+	/// </summary>
+	const char* GetEnd() const { return _data + _size; }
+	/// <summary>
+	/// Gets the size of the mapped file, in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+	/// <summary>
+	/// Lets the OS know we're done with part of the file, so it can drop those pages from our working set. The data stays
+	/// valid, it will just be read back in from disk if it gets touched again. Useful for keeping memory use down when
+	/// streaming through large files
+	/// </summary>
+	/// <param name="offset">The offset of the first byte we're done with</param>
+	/// <param name="size">The number of bytes we're done with</param>
+	void Release(size_t offset, size_t size) const;
+
+private:
+	const char* _data;
+	size_t      _size;
+	bool        _isOpen;
+
+	#ifdef WINDOWS
+	void* _fileHandle;
+	void* _mappingHandle;
+	#else
+	int   _fileDescriptor;
+	#endif
+};
@@ -0,0 +1,113 @@
+#include "MemoryStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#endif
+
+// These are only ever added to, and are read while other threads may be allocating, so relaxed ordering is enough
+static std::atomic<size_t> AllocationCount(0);
+static std::atomic<size_t> AllocatedBytes(0);
+// Only written when a benchmark starts or stops, so checking it leaves the cache line shared between threads
+static std::atomic<bool> CountingAllocations(false);
+
+/// <summary>
+/// Counts an allocation if counting is on and hands it off to malloc, this is what every replaced operator new calls
+/// </summary>
+inline void* CountedAlloc(size_t size) noexcept {
+	if (CountingAllocations.load(std::memory_order_relaxed)) {
+		AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+	// malloc(0) may return nullptr, but operator new has to return a unique pointer
+	return malloc(size > 0 ? size : 1);
+}
+
+void* operator new(size_t size) {
+	void* result = CountedAlloc(size);
+	if (result == nullptr) {
+		throw std::bad_alloc();
+	}
+	return result;
+}
+void* operator new[](size_t size) {
+	void* result = CountedAlloc(size);
+	if (result == nullptr) {
+		throw std::bad_alloc();
+	}
+	return result;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+void MemoryStats::SetCountingAllocations(bool enabled) {
+	CountingAllocations.store(enabled, std::memory_order_relaxed);
+}
+
+bool MemoryStats::IsCountingAllocations() {
+	return CountingAllocations.load(std::memory_order_relaxed);
+}
+
+size_t MemoryStats::GetAllocationCount() {
+	return AllocationCount.load(std::memory_order_relaxed);
+}
+
+size_t MemoryStats::GetAllocatedBytes() {
+	return AllocatedBytes.load(std::memory_order_relaxed);
+}
+
+size_t MemoryStats::GetPeakResidentBytes() {
+	#ifdef WINDOWS
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+	#else
+	// VmHWM can be reset (unlike getrusage's maximum), so we prefer it when /proc is around
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.rfind("VmHWM:", 0) == 0) {
+			return static_cast<size_t>(std::strtoull(line.c_str() + 6, nullptr, 10)) * 1024;
+		}
+	}
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+	}
+	return 0;
+	#endif
+}
+
+bool MemoryStats::ResetPeakResidentBytes() {
+	#ifdef WINDOWS
+	return false;
+	#else
+	// Writing 5 to clear_refs resets VmHWM to the current resident set size (Linux 4.0 and later)
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	if (!clearRefs) {
+		return false;
+	}
+	clearRefs << "5";
+	clearRefs.flush();
+	return static_cast<bool>(clearRefs);
+	#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+
+/// <summary>
+/// Process wide memory counters, used by the benchmarks to see how much loaders allocate. Allocations are counted
+/// by replacing the global operator new, so only C++ allocations are seen (ex: STBI's malloc'd pixel buffers are
+/// not counted, but they still show up in the resident set size). Counting is off until a benchmark turns it on,
+/// so normal play doesn't pay for the shared counters on every allocation
+/// </summary>
+class MemoryStats
+{
+public:
+	/// <summary>
+	/// Turns allocation counting on or off, the counts are kept while it is off
+	/// </summary>
+	static void SetCountingAllocations(bool enabled);
+	static bool IsCountingAllocations();
+
+	/// <summary>
+	/// Gets the number of calls to operator new (and new[]) made while counting was on
+	/// </summary>
+	static size_t GetAllocationCount();
+	/// <summary>
+	/// Gets the total number of bytes requested from operator new (and new[]) while counting was on
+	/// </summary>
+	static size_t GetAllocatedBytes();
+
+	/// <summary>
+	/// Gets the largest resident set size (the physical memory used by the process) seen so far, in bytes
+	/// </summary>
+	static size_t GetPeakResidentBytes();
+	/// <summary>
+	/// Resets the peak resident set size to the current resident set size, so the next GetPeakResidentBytes only
+	/// covers what happened since. Only Linux supports this
+	/// </summary>
+	/// <returns>True if the peak was reset, false if the platform can't reset it</returns>
+	static bool ResetPeakResidentBytes();
+
+protected:
+	MemoryStats() = default;
+	~MemoryStats() = default;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 #include "Graphics/VertexArrayObject.h"
 
@@ -8,7 +9,8 @@ class MeshBuilder
 public:
 	MeshBuilder() :
 		_vertices(std::vector<VertType>()),
-		_indices(std::vector<uint32_t>()) {}
+		_indices(std::vector<uint32_t>()),
+		_vertexTransform(glm::mat4(1.0f)) {}
 	~MeshBuilder() = default;
 
 	/// <summary>
@@ -43,7 +45,8 @@ public:
 	/// <param name="c">The index of the third vertex</param>
 	void AddIndexTri(uint32_t a, uint32_t b, uint32_t c)
 	{
-		ReserveIndexSpace(3);
+		// Note: we don't reserve here, reserving an exact size on every call defeats the vector's
+		// geometric growth and turns building large meshes into a quadratic copy
 		_indices.push_back(a);
 		_indices.push_back(b);
 		_indices.push_back(c);
@@ -55,7 +58,7 @@ public:
 	/// </summary>
 	/// <param name="extendAmount">The number of vertices to reserve space for</param>
 	void ReserveVertexSpace(size_t extendAmount) {
-		_vertices.reserve(_vertices.size() + extendAmount);
+		_Grow(_vertices, extendAmount);
 	}
 	/// <summary>
 	/// Resizes the internal vector to allocate space for new indices, can improve
@@ -63,7 +66,7 @@ public:
 	/// </summary>
 	/// <param name="extendAmount">The number of indices to reserve space for</param>
 	void ReserveIndexSpace(size_t extendAmount) {
-		_indices.reserve(_indices.size() + extendAmount);
+		_Grow(_indices, extendAmount);
 	}
 
 	/// <summary>
@@ -81,16 +84,34 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
-	VertexArrayObject::sptr Bake() {
+	/// <summary>
+	/// Sets the transform that takes the stored vertex positions into model space, see VertexArrayObject::SetVertexTransform
+	/// </summary>
+	void SetVertexTransform(const glm::mat4& transform) { _vertexTransform = transform; }
+	/// <summary>
+	/// Gets the transform that takes the stored vertex positions into model space
+	/// </summary>
+	const glm::mat4& GetVertexTransform() const { return _vertexTransform; }
+
+	VertexArrayObject::sptr Bake() const {
 		VertexBuffer::sptr vbo = VertexBuffer::Create();
 		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
 
+		// Most of our meshes have less than 65536 vertices, so they can get away with 16 bit indices
 		IndexBuffer::sptr ebo = IndexBuffer::Create();
-		ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		ebo->LoadCompactData(GetIndexDataPtr(), _indices.size(), _vertices.size());
 
 		VertexArrayObject::sptr result = VertexArrayObject::Create();
 		result->AddVertexBuffer(vbo, VertType::V_DECL);
 		result->SetIndexBuffer(ebo);
+		result->SetVertexTransform(_vertexTransform);
+
+		// The bounds let renderers without levels of detail or meshlets know how large they are on screen
+		glm::vec3 center;
+		float radius;
+		if (VertexArrayObject::CalculateBounds(GetVertexDataPtr(), _vertices.size(), VertType::V_DECL, _vertexTransform, center, radius)) {
+			result->SetBounds(center, radius);
+		}
 
 		return result;
 	}
@@ -112,7 +133,26 @@ public:
 	
 protected:
 	friend class MeshFactory;
+	friend class ObjLoader;
+	friend class MeshOptimizer;
+	friend class VertexPacking;
+	friend class MeshletBuilder;
+	friend class TangentGenerator;
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
+	glm::mat4             _vertexTransform;
+
+	/// <summary>
+	/// Makes room for extendAmount more elements. reserve() allocates exactly what we ask for, so calling it
+	/// for every small primitive we append would re-allocate (and copy) the whole vector each time, instead we
+	/// grow at least geometrically like push_back does
+	/// </summary>
+	template <typename T>
+	static void _Grow(std::vector<T>& vec, size_t extendAmount) {
+		const size_t required = vec.size() + extendAmount;
+		if (required > vec.capacity()) {
+			vec.reserve(std::max(required, vec.capacity() * 2));
+		}
+	}
 };
@@ -0,0 +1,427 @@
+#include "MeshCache.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <system_error>
+
+#include "Logging.h"
+#include "MemoryMappedFile.h"
+#include "VirtualFileSystem.h"
+
+// The vertex and index blobs are aligned to this many bytes within the file
+static constexpr uint64_t CookedBlobAlignment = 16;
+
+/// <summary>
+/// Rounds value up to the next multiple of CookedBlobAlignment
+/// </summary>
+inline uint64_t AlignCookedOffset(uint64_t value) {
+	return (value + CookedBlobAlignment - 1) & ~(CookedBlobAlignment - 1);
+}
+
+/// <summary>
+/// Gets the size and last write time of a file, returning false if the file could not be found
+/// </summary>
+bool GetSourceStamp(const std::string& path, uint64_t& size, int64_t& time) {
+	// Sources may live in an asset pack, which remembers the stamps of the files it was built from
+	return VirtualFileSystem::Stat(path, size, time);
+}
+
+/// <summary>
+/// Hashes the entire contents of a file, returning false if the file could not be read
+/// </summary>
+bool HashSourceFile(const std::string& path, uint64_t& hash) {
+	VfsFile file(path);
+	if (!file.IsOpen()) {
+		return false;
+	}
+	hash = MeshCache::Hash(file.GetData(), file.GetSize());
+	return true;
+}
+
+/// <summary>
+/// Checks that count elements of elementSize bytes starting at offset are within a file, without multiplying them
+/// out first, since a corrupt count could overflow that and pass
+/// </summary>
+inline bool CookedRangeFits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize) {
+	if (offset > fileSize) {
+		return false;
+	}
+	return elementSize == 0 ? count == 0 : count <= (fileSize - offset) / elementSize;
+}
+
+std::string MeshCache::GetCookedPath(const std::string& sourcePath, uint64_t optionsHash) {
+	return fmt::format("{}.{:016x}{}", sourcePath, optionsHash, Extension);
+}
+
+/// <summary>
+/// Gets a temporary path to write a cooked file to before it is swapped in. Cooks can run on several loader threads
+/// at once, so every writer gets its own file instead of truncating one that another thread is part way through
+/// </summary>
+std::string GetCookedTempPath(const std::string& cookedPath) {
+	static std::atomic<uint32_t> nextTempId(0);
+	return cookedPath + "." + std::to_string(nextTempId.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+}
+
+/// <summary>
+/// Opens the cooked version of a source file and makes sure it is up to date and intact
+/// </summary>
+/// <param name="sourcePath">The path of the source file</param>
+/// <param name="optionsHash">The hash of the options the caller wants the mesh loaded with</param>
+/// <param name="file">The file to open the cooked mesh into</param>
+/// <param name="header">Will be filled with the cooked mesh's header</param>
+/// <param name="sourceTime">Will be set to the source's write time if the header's time needs to be updated, or 0</param>
+/// <returns>True if the cooked file can be used</returns>
+bool OpenCookedFile(const std::string& sourcePath, uint64_t optionsHash, MemoryMappedFile& file, CookedMeshHeader& header, int64_t& sourceTime) {
+	uint64_t sourceSize;
+	if (!GetSourceStamp(sourcePath, sourceSize, sourceTime)) {
+		return false;
+	}
+
+	const std::string cookedPath = MeshCache::GetCookedPath(sourcePath, optionsHash);
+	if (!file.Open(cookedPath) || file.GetSize() < sizeof(CookedMeshHeader)) {
+		return false;
+	}
+
+	// Make sure the header is for the right file and options, and that everything it points to is within the file
+	memcpy(&header, file.GetData(), sizeof(CookedMeshHeader));
+	if (memcmp(header.Magic, "CMSH", 4) != 0 ||
+		header.Version != MeshCache::FormatVersion ||
+		header.OptionsHash != optionsHash ||
+		header.SourceSize != sourceSize) {
+		return false;
+	}
+	const uint64_t fileSize = file.GetSize();
+	bool valid = header.AttributeCount > 0 && header.VertexStride > 0 &&
+		CookedRangeFits(sizeof(CookedMeshHeader), header.AttributeCount, sizeof(CookedMeshAttribute), fileSize) &&
+		CookedRangeFits(header.VertexDataOffset, header.VertexCount, header.VertexStride, fileSize) &&
+		CookedRangeFits(header.IndexDataOffset, header.IndexCount, header.IndexElementSize, fileSize) &&
+		(header.MeshletCount == 0 || CookedRangeFits(header.MeshletDataOffset, header.MeshletCount, sizeof(Meshlet), fileSize));
+	// Every block fits in the file, so working out where they end can't overflow anymore. They also can't overlap
+	if (valid) {
+		const uint64_t attribEnd = sizeof(CookedMeshHeader) + header.AttributeCount * sizeof(CookedMeshAttribute);
+		const uint64_t vertexEnd = header.VertexDataOffset + header.VertexCount * header.VertexStride;
+		const uint64_t indexEnd  = header.IndexDataOffset + header.IndexCount * header.IndexElementSize;
+		valid = attribEnd <= header.VertexDataOffset && vertexEnd <= header.IndexDataOffset &&
+			(header.MeshletCount == 0 || indexEnd <= header.MeshletDataOffset);
+	}
+	if (!valid) {
+		LOG_WARN("Cooked mesh \"{}\" is corrupt, it will be re-cooked", cookedPath);
+		return false;
+	}
+
+	// If only the write time has changed (ex: the file was checked out again), fall back to comparing the contents
+	if (header.SourceTime != sourceTime) {
+		uint64_t sourceHash;
+		if (!HashSourceFile(sourcePath, sourceHash) || sourceHash != header.SourceHash) {
+			return false;
+		}
+	} else {
+		sourceTime = 0;
+	}
+	return true;
+}
+
+/// <summary>
+/// Reads the attribute layout out of an opened cooked file
+/// </summary>
+std::vector<BufferAttribute> ReadCookedAttributes(const MemoryMappedFile& file, const CookedMeshHeader& header) {
+	std::vector<BufferAttribute> attributes;
+	attributes.reserve(header.AttributeCount);
+	const CookedMeshAttribute* cookedAttribs = reinterpret_cast<const CookedMeshAttribute*>(file.GetData() + sizeof(CookedMeshHeader));
+	for (uint32_t ix = 0; ix < header.AttributeCount; ix++) {
+		const CookedMeshAttribute& attrib = cookedAttribs[ix];
+		attributes.emplace_back(attrib.Slot, attrib.Size, attrib.Type, attrib.Normalized != 0, attrib.Stride, attrib.Offset, static_cast<AttribUsage>(attrib.Usage));
+	}
+	return attributes;
+}
+
+/// <summary>
+/// Swaps a fully written temp file in as a cooked file, removing the temp file if that fails
+/// </summary>
+bool ReplaceCookedFile(const std::string& tempPath, const std::string& cookedPath, std::error_code& error) {
+	std::filesystem::rename(tempPath, cookedPath, error);
+	if (error) {
+		std::error_code removeError;
+		std::filesystem::remove(tempPath, removeError);
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// Stores the new write time of the source in a cooked file, so we don't need to hash the source again next time.
+/// Other loads may have the file mapped, so instead of patching the header in place we write a copy with the new
+/// header and swap it in like Store does. The file is closed before the swap
+/// </summary>
+void UpdateCookedTime(const std::string& sourcePath, MemoryMappedFile& file, CookedMeshHeader header, int64_t sourceTime) {
+	header.SourceTime = sourceTime;
+	const std::string cookedPath = MeshCache::GetCookedPath(sourcePath, header.OptionsHash);
+	const std::string tempPath = GetCookedTempPath(cookedPath);
+	bool written;
+	{
+		std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(CookedMeshHeader));
+		stream.write(file.GetData() + sizeof(CookedMeshHeader), file.GetSize() - sizeof(CookedMeshHeader));
+		written = static_cast<bool>(stream);
+	}
+	file.Close();
+
+	// This is only an optimization, if it fails (ex: another load still has the file open) we'll try again next time
+	std::error_code error;
+	if (!written) {
+		std::filesystem::remove(tempPath, error);
+	} else {
+		ReplaceCookedFile(tempPath, cookedPath, error);
+	}
+}
+
+VertexArrayObject::sptr MeshCache::TryLoad(const std::string& sourcePath, uint64_t optionsHash) {
+	MemoryMappedFile file;
+	CookedMeshHeader header;
+	int64_t newTime;
+	if (!OpenCookedFile(sourcePath, optionsHash, file, header, newTime)) {
+		return nullptr;
+	}
+	std::vector<BufferAttribute> attributes = ReadCookedAttributes(file, header);
+
+	// The blobs go straight from the mapped file into the GL buffers, without being copied or parsed
+	VertexBuffer::sptr vbo = VertexBuffer::Create();
+	vbo->LoadData(file.GetData() + header.VertexDataOffset, header.VertexStride, header.VertexCount);
+
+	IndexBuffer::sptr ebo = IndexBuffer::Create();
+	ebo->LoadData(file.GetData() + header.IndexDataOffset, header.IndexElementSize, header.IndexCount, header.IndexType);
+
+	VertexArrayObject::sptr result = VertexArrayObject::Create();
+	result->AddVertexBuffer(vbo, attributes);
+	result->SetIndexBuffer(ebo);
+
+	glm::mat4 vertexTransform;
+	memcpy(&vertexTransform[0][0], header.VertexTransform, sizeof(header.VertexTransform));
+	result->SetVertexTransform(vertexTransform);
+
+	glm::vec3 center;
+	float radius;
+	if (VertexArrayObject::CalculateBounds(file.GetData() + header.VertexDataOffset, header.VertexCount, attributes, vertexTransform, center, radius)) {
+		result->SetBounds(center, radius);
+	}
+
+	if (newTime != 0) {
+		UpdateCookedTime(sourcePath, file, header, newTime);
+	}
+
+	return result;
+}
+
+bool MeshCache::TryRead(const std::string& sourcePath, uint64_t optionsHash, CookedMesh& result) {
+	MemoryMappedFile file;
+	CookedMeshHeader header;
+	int64_t newTime;
+	if (!OpenCookedFile(sourcePath, optionsHash, file, header, newTime)) {
+		return false;
+	}
+
+	result.Attributes = ReadCookedAttributes(file, header);
+	result.VertexStride = header.VertexStride;
+	result.VertexCount = header.VertexCount;
+	result.Vertices.assign(file.GetData() + header.VertexDataOffset, file.GetData() + header.VertexDataOffset + header.VertexStride * header.VertexCount);
+	result.IndexElementSize = header.IndexElementSize;
+	result.IndexCount = header.IndexCount;
+	result.IndexType = header.IndexType;
+	result.Indices.assign(file.GetData() + header.IndexDataOffset, file.GetData() + header.IndexDataOffset + header.IndexElementSize * header.IndexCount);
+	memcpy(&result.VertexTransform[0][0], header.VertexTransform, sizeof(header.VertexTransform));
+
+	result.Meshlets.resize(header.MeshletCount);
+	if (header.MeshletCount > 0) {
+		memcpy(result.Meshlets.data(), file.GetData() + header.MeshletDataOffset, header.MeshletCount * sizeof(Meshlet));
+		// Make sure none of the meshlets would draw past the end of the index buffer
+		for (const Meshlet& meshlet : result.Meshlets) {
+			if (static_cast<uint64_t>(meshlet.IndexOffset) + meshlet.IndexCount > header.IndexCount) {
+				LOG_WARN("Cooked mesh \"{}\" has invalid meshlets, it will be re-cooked", GetCookedPath(sourcePath, optionsHash));
+				return false;
+			}
+		}
+	}
+
+	if (newTime != 0) {
+		UpdateCookedTime(sourcePath, file, header, newTime);
+	}
+	return true;
+}
+
+bool MeshCache::TryMap(const std::string& sourcePath, uint64_t optionsHash, CookedMeshView& result) {
+	std::shared_ptr<MemoryMappedFile> file = std::make_shared<MemoryMappedFile>();
+	CookedMeshHeader header;
+	int64_t newTime;
+	if (!OpenCookedFile(sourcePath, optionsHash, *file, header, newTime)) {
+		return false;
+	}
+	// Storing the new write time swaps in a new copy of the file and closes this one, so we map the file again afterwards
+	if (newTime != 0) {
+		UpdateCookedTime(sourcePath, *file, header, newTime);
+		if (!OpenCookedFile(sourcePath, optionsHash, *file, header, newTime)) {
+			return false;
+		}
+	}
+
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(file->GetData());
+	result.File = file;
+	result.Mesh = nullptr;
+	result.Attributes = ReadCookedAttributes(*file, header);
+	result.Vertices = data + header.VertexDataOffset;
+	result.VertexStride = header.VertexStride;
+	result.VertexCount = header.VertexCount;
+	result.Indices = data + header.IndexDataOffset;
+	result.IndexElementSize = header.IndexElementSize;
+	result.IndexCount = header.IndexCount;
+	result.IndexType = header.IndexType;
+	memcpy(&result.VertexTransform[0][0], header.VertexTransform, sizeof(header.VertexTransform));
+	return true;
+}
+
+CookedMeshView CookedMeshView::FromMesh(const std::shared_ptr<const CookedMesh>& mesh) {
+	CookedMeshView result;
+	result.Mesh = mesh;
+	result.Attributes = mesh->Attributes;
+	result.Vertices = mesh->Vertices.data();
+	result.VertexStride = mesh->VertexStride;
+	result.VertexCount = mesh->VertexCount;
+	result.Indices = mesh->Indices.data();
+	result.IndexElementSize = mesh->IndexElementSize;
+	result.IndexCount = mesh->IndexCount;
+	result.IndexType = mesh->IndexType;
+	result.VertexTransform = mesh->VertexTransform;
+	return result;
+}
+
+void CookedMeshView::Release(const uint8_t* data, size_t size) const {
+	if (File != nullptr) {
+		File->Release(data - reinterpret_cast<const uint8_t*>(File->GetData()), size);
+	}
+}
+
+VertexArrayObject::sptr CookedMesh::Bake() const {
+	VertexBuffer::sptr vbo = VertexBuffer::Create();
+	vbo->LoadData(Vertices.data(), VertexStride, VertexCount);
+
+	IndexBuffer::sptr ebo = IndexBuffer::Create();
+	ebo->LoadData(Indices.data(), IndexElementSize, IndexCount, IndexType);
+
+	VertexArrayObject::sptr result = VertexArrayObject::Create();
+	result->AddVertexBuffer(vbo, Attributes);
+	result->SetIndexBuffer(ebo);
+	result->SetVertexTransform(VertexTransform);
+
+	glm::vec3 center;
+	float radius;
+	if (VertexArrayObject::CalculateBounds(Vertices.data(), VertexCount, Attributes, VertexTransform, center, radius)) {
+		result->SetBounds(center, radius);
+	}
+	return result;
+}
+
+MeshletSet::sptr CookedMesh::BakeMeshlets() const {
+	MeshletSet::sptr result = MeshletSet::Create();
+	if (Meshlets.empty()) {
+		// A single meshlet that can't be culled, so meshes that were cooked without meshlets still draw
+		Meshlet whole;
+		whole.Center = glm::vec3(0.0f);
+		whole.Radius = std::numeric_limits<float>::max();
+		whole.ConeAxis = glm::vec3(0.0f);
+		whole.ConeCutoff = 1.0f;
+		whole.IndexOffset = 0;
+		whole.IndexCount = static_cast<uint32_t>(IndexCount);
+		result->SetMesh(Bake(), { whole });
+	} else {
+		result->SetMesh(Bake(), Meshlets);
+	}
+	return result;
+}
+
+bool MeshCache::Store(const std::string& sourcePath, uint64_t optionsHash, const std::vector<BufferAttribute>& attributes,
+	const void* vertices, size_t vertexStride, size_t vertexCount,
+	const void* indices, size_t indexElementSize, size_t indexCount, GLenum indexType,
+	const glm::mat4& vertexTransform, const Meshlet* meshlets, size_t meshletCount)
+{
+	// Sources that come from a pack have no folder on disk to cook into, and packs are deployments where nothing
+	// should be written anyways, so these are just loaded from the source every time
+	if (VirtualFileSystem::IsPacked(sourcePath)) {
+		return false;
+	}
+
+	CookedMeshHeader header;
+	memset(&header, 0, sizeof(CookedMeshHeader));
+	memcpy(header.Magic, "CMSH", 4);
+	header.Version = FormatVersion;
+	header.OptionsHash = optionsHash;
+	if (!GetSourceStamp(sourcePath, header.SourceSize, header.SourceTime) || !HashSourceFile(sourcePath, header.SourceHash)) {
+		LOG_WARN("Could not read \"{}\" to cook it", sourcePath);
+		return false;
+	}
+	header.VertexCount = vertexCount;
+	header.IndexCount = indexCount;
+	header.VertexStride = static_cast<uint32_t>(vertexStride);
+	header.AttributeCount = static_cast<uint32_t>(attributes.size());
+	header.IndexType = indexType;
+	header.IndexElementSize = static_cast<uint32_t>(indexElementSize);
+	memcpy(header.VertexTransform, &vertexTransform[0][0], sizeof(header.VertexTransform));
+	header.VertexDataOffset = AlignCookedOffset(sizeof(CookedMeshHeader) + attributes.size() * sizeof(CookedMeshAttribute));
+	header.IndexDataOffset = AlignCookedOffset(header.VertexDataOffset + vertexStride * vertexCount);
+	header.MeshletCount = meshletCount;
+	header.MeshletDataOffset = meshletCount > 0 ? AlignCookedOffset(header.IndexDataOffset + indexElementSize * indexCount) : 0;
+
+	std::vector<CookedMeshAttribute> cookedAttribs(attributes.size());
+	for (size_t ix = 0; ix < attributes.size(); ix++) {
+		const BufferAttribute& attrib = attributes[ix];
+		cookedAttribs[ix] = {
+			attrib.Slot, static_cast<uint32_t>(attrib.Size), attrib.Type, attrib.Normalized ? 1u : 0u,
+			static_cast<uint32_t>(attrib.Stride), static_cast<uint32_t>(attrib.Offset), static_cast<uint32_t>(attrib.Usage), 0u
+		};
+	}
+
+	// We write to a temporary file and then swap it in, so a crash part way through never leaves a half written cache behind
+	const std::string cookedPath = GetCookedPath(sourcePath, optionsHash);
+	const std::string tempPath = GetCookedTempPath(cookedPath);
+	{
+		std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+		if (!stream) {
+			LOG_WARN("Could not open \"{}\" to write the cooked mesh", tempPath);
+			return false;
+		}
+
+		const char padding[CookedBlobAlignment] = { 0 };
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(CookedMeshHeader));
+		stream.write(reinterpret_cast<const char*>(cookedAttribs.data()), cookedAttribs.size() * sizeof(CookedMeshAttribute));
+		stream.write(padding, header.VertexDataOffset - (sizeof(CookedMeshHeader) + cookedAttribs.size() * sizeof(CookedMeshAttribute)));
+		stream.write(reinterpret_cast<const char*>(vertices), vertexStride * vertexCount);
+		stream.write(padding, header.IndexDataOffset - (header.VertexDataOffset + vertexStride * vertexCount));
+		stream.write(reinterpret_cast<const char*>(indices), indexElementSize * indexCount);
+		if (meshletCount > 0) {
+			stream.write(padding, header.MeshletDataOffset - (header.IndexDataOffset + indexElementSize * indexCount));
+			stream.write(reinterpret_cast<const char*>(meshlets), meshletCount * sizeof(Meshlet));
+		}
+		if (!stream) {
+			LOG_WARN("Failed to write cooked mesh \"{}\"", tempPath);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	if (!ReplaceCookedFile(tempPath, cookedPath, error)) {
+		LOG_WARN("Could not replace cooked mesh \"{}\": {}", cookedPath, error.message());
+		return false;
+	}
+	return true;
+}
+
+uint64_t MeshCache::Hash(const void* data, size_t size, uint64_t seed) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+	for (size_t ix = 0; ix < size; ix++) {
+		hash ^= bytes[ix];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
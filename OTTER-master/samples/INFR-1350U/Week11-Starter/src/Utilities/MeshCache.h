@@ -0,0 +1,306 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshletSet.h"
+#include "MeshBuilder.h"
+#include "MemoryMappedFile.h"
+
+/// <summary>
+/// The header at the start of every cooked mesh file. The file layout is:
+///     CookedMeshHeader
+///     CookedMeshAttribute[AttributeCount]
+///     vertex data (VertexStride * VertexCount bytes, starting at VertexDataOffset)
+///     index data (IndexElementSize * IndexCount bytes, starting at IndexDataOffset)
+///     Meshlet[MeshletCount] (starting at MeshletDataOffset, only if the mesh was split into meshlets)
+/// All values are stored in the native byte order of the machine that cooked the file
+/// </summary>
+struct CookedMeshHeader
+{
+	/// <summary>
+	/// Should always be 'CMSH', used to reject files that aren't cooked meshes
+	/// </summary>
+	char     Magic[4];
+	/// <summary>
+	/// The version of the format, bumped whenever the layout changes so stale caches get re-cooked
+	/// </summary>
+	uint32_t Version;
+	/// <summary>
+	/// The size of the source file, in bytes
+	/// </summary>
+	uint64_t SourceSize;
+	/// <summary>
+	/// The last write time of the source file when this was cooked
+	/// </summary>
+	int64_t  SourceTime;
+	/// <summary>
+	/// A hash of the source file's contents, used if the write time changes but the contents do not
+	/// </summary>
+	uint64_t SourceHash;
+	/// <summary>
+	/// A hash of the options that were used to load the source, since these can change the output
+	/// </summary>
+	uint64_t OptionsHash;
+	uint64_t VertexCount;
+	uint64_t IndexCount;
+	uint64_t VertexDataOffset;
+	uint64_t IndexDataOffset;
+	uint32_t VertexStride;
+	uint32_t AttributeCount;
+	/// <summary>
+	/// The GL type of the indices (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
+	/// </summary>
+	uint32_t IndexType;
+	uint32_t IndexElementSize;
+	/// <summary>
+	/// The transform from stored vertex positions to model space (column major), see VertexArrayObject::SetVertexTransform
+	/// </summary>
+	float    VertexTransform[16];
+	/// <summary>
+	/// The number of meshlets the indices are grouped into, 0 if the mesh was not split into meshlets
+	/// </summary>
+	uint64_t MeshletCount;
+	uint64_t MeshletDataOffset;
+};
+
+/// <summary>
+/// The on-disk version of a BufferAttribute, with fixed size members
+/// </summary>
+struct CookedMeshAttribute
+{
+	uint32_t Slot;
+	uint32_t Size;
+	uint32_t Type;
+	uint32_t Normalized;
+	uint32_t Stride;
+	uint32_t Offset;
+	uint32_t Usage;
+	uint32_t Reserved;
+};
+
+/// <summary>
+/// A mesh that has been loaded into memory in the same layout as a cooked file, but not uploaded to the
+/// GPU yet. This lets us do all of the loading work on another thread and only the upload on the main thread
+/// </summary>
+struct CookedMesh
+{
+	std::vector<BufferAttribute> Attributes;
+	std::vector<uint8_t> Vertices;
+	size_t               VertexStride;
+	size_t               VertexCount;
+	std::vector<uint8_t> Indices;
+	size_t               IndexElementSize;
+	size_t               IndexCount;
+	/// <summary>
+	/// The GL type of the indices (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)
+	/// </summary>
+	GLenum               IndexType;
+	glm::mat4            VertexTransform;
+	/// <summary>
+	/// The meshlets that the indices are grouped into, empty if the mesh was not split into meshlets
+	/// </summary>
+	std::vector<Meshlet> Meshlets;
+
+	CookedMesh() :
+		Attributes(), Vertices(), VertexStride(0), VertexCount(0),
+		Indices(), IndexElementSize(0), IndexCount(0), IndexType(GL_NONE),
+		VertexTransform(glm::mat4(1.0f)), Meshlets()
+	{ }
+
+	/// <summary>
+	/// Gets the number of bytes that will be uploaded to the GPU when this mesh is baked
+	/// </summary>
+	size_t GetUploadSize() const { return Vertices.size() + Indices.size(); }
+	/// <summary>
+	/// Uploads the mesh to the GPU, must be called from the thread that owns the GL context
+	/// </summary>
+	VertexArrayObject::sptr Bake() const;
+	/// <summary>
+	/// Uploads the mesh to the GPU and wraps it in a meshlet set, must be called from the thread that owns the
+	/// GL context. Meshes without meshlets get a single meshlet covering the whole mesh
+	/// </summary>
+	MeshletSet::sptr BakeMeshlets() const;
+};
+
+/// <summary>
+/// A read-only view of a cooked mesh's vertex and index data, which is either mapped straight from a cooked file
+/// (see MeshCache::TryMap) or points into a CookedMesh in memory. The view keeps whatever it points into alive, so
+/// it can be handed between threads and the data is only ever touched when it is uploaded
+/// </summary>
+struct CookedMeshView
+{
+	/// <summary>
+	/// The mapped cooked file, or nullptr if the view points into a CookedMesh
+	/// </summary>
+	std::shared_ptr<MemoryMappedFile> File;
+	/// <summary>
+	/// The mesh in memory, or nullptr if the view points into a mapped file
+	/// </summary>
+	std::shared_ptr<const CookedMesh> Mesh;
+	std::vector<BufferAttribute> Attributes;
+	const uint8_t* Vertices;
+	size_t         VertexStride;
+	size_t         VertexCount;
+	const uint8_t* Indices;
+	size_t         IndexElementSize;
+	size_t         IndexCount;
+	GLenum         IndexType;
+	glm::mat4      VertexTransform;
+
+	CookedMeshView() :
+		File(nullptr), Mesh(nullptr), Attributes(),
+		Vertices(nullptr), VertexStride(0), VertexCount(0),
+		Indices(nullptr), IndexElementSize(0), IndexCount(0), IndexType(GL_NONE),
+		VertexTransform(glm::mat4(1.0f))
+	{ }
+
+	/// <summary>
+	/// Creates a view of a mesh that was loaded into memory
+	/// </summary>
+	static CookedMeshView FromMesh(const std::shared_ptr<const CookedMesh>& mesh);
+
+	/// <summary>
+	/// Lets the OS drop part of the data from memory once it has been uploaded, this only does something for
+	/// mapped files. The data is still valid afterwards, it will just be read from disk again if needed
+	/// </summary>
+	/// <param name="data">A pointer into the vertex or index data</param>
+	/// <param name="size">The number of bytes we are done with</param>
+	void Release(const uint8_t* data, size_t size) const;
+};
+
+/// <summary>
+/// Stores meshes in a binary form that can be memory mapped and handed directly to OpenGL, so that
+/// we only need to parse source files like OBJs the first time they are loaded. Cooked files are
+/// written next to the source file, with one file for each set of load options so that loading the same
+/// source in different ways doesn't keep re-cooking it (ex: models/monkey.obj.<options hash>.cmesh).
+/// They are invalidated when the source file's size, write time and content hash change
+/// </summary>
+class MeshCache
+{
+public:
+	/// <summary>
+	/// The current version of the cooked format
+	/// </summary>
+	static constexpr uint32_t FormatVersion = 3;
+	/// <summary>
+	/// The extension appended to the source path and options hash to get the cooked path
+	/// </summary>
+	static constexpr const char* Extension = ".cmesh";
+
+	/// <summary>
+	/// Gets the path that the cooked version of the given source file is stored at
+	/// </summary>
+	/// <param name="sourcePath">The path of the source file (ex: models/monkey.obj)</param>
+	/// <param name="optionsHash">A hash of the options used to load the source file</param>
+	static std::string GetCookedPath(const std::string& sourcePath, uint64_t optionsHash);
+
+	/// <summary>
+	/// Attempts to load the cooked version of a source file, if it exists and is up to date
+	/// </summary>
+	/// <param name="sourcePath">The path of the source file (ex: models/monkey.obj)</param>
+	/// <param name="optionsHash">A hash of the options used to load the source file</param>
+	/// <returns>The mesh, or nullptr if there is no valid cooked mesh for the source</returns>
+	static VertexArrayObject::sptr TryLoad(const std::string& sourcePath, uint64_t optionsHash);
+	/// <summary>
+	/// Attempts to read the cooked version of a source file into memory without uploading it, this is safe
+	/// to call from any thread
+	/// </summary>
+	/// <param name="sourcePath">The path of the source file (ex: models/monkey.obj)</param>
+	/// <param name="optionsHash">A hash of the options used to load the source file</param>
+	/// <param name="result">The mesh to store the cooked data in</param>
+	/// <returns>True if there was a valid cooked mesh for the source, false if otherwise</returns>
+	static bool TryRead(const std::string& sourcePath, uint64_t optionsHash, CookedMesh& result);
+
+	/// <summary>
+	/// Attempts to map the cooked version of a source file without reading it into memory, the pages are only
+	/// loaded as the data is touched. This is safe to call from any thread
+	/// </summary>
+	/// <param name="sourcePath">The path of the source file (ex: models/monkey.obj)</param>
+	/// <param name="optionsHash">A hash of the options used to load the source file</param>
+	/// <param name="result">The view to point at the mapped data</param>
+	/// <returns>True if there was a valid cooked mesh for the source, false if otherwise</returns>
+	static bool TryMap(const std::string& sourcePath, uint64_t optionsHash, CookedMeshView& result);
+
+	/// <summary>
+	/// Converts a mesh builder into the cooked layout in memory, narrowing the indices to 16 bits if they fit
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the mesh, must have a V_DECL</typeparam>
+	/// <param name="mesh">The mesh to convert</param>
+	/// <param name="result">The cooked mesh to store the result in</param>
+	template <typename VertType>
+	static void Cook(const MeshBuilder<VertType>& mesh, CookedMesh& result) {
+		result.Attributes = VertType::V_DECL;
+		result.VertexStride = sizeof(VertType);
+		result.VertexCount = mesh.GetVertexCount();
+		const uint8_t* vertices = reinterpret_cast<const uint8_t*>(mesh.GetVertexDataPtr());
+		result.Vertices.assign(vertices, vertices + sizeof(VertType) * mesh.GetVertexCount());
+		result.IndexCount = mesh.GetIndexCount();
+		if (mesh.GetVertexCount() <= 0x10000) {
+			std::vector<uint16_t> indices(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+			result.Indices.assign(reinterpret_cast<const uint8_t*>(indices.data()), reinterpret_cast<const uint8_t*>(indices.data() + indices.size()));
+			result.IndexElementSize = sizeof(uint16_t);
+			result.IndexType = GL_UNSIGNED_SHORT;
+		} else {
+			const uint8_t* indices = reinterpret_cast<const uint8_t*>(mesh.GetIndexDataPtr());
+			result.Indices.assign(indices, indices + sizeof(uint32_t) * mesh.GetIndexCount());
+			result.IndexElementSize = sizeof(uint32_t);
+			result.IndexType = GL_UNSIGNED_INT;
+		}
+		result.VertexTransform = mesh.GetVertexTransform();
+	}
+
+	/// <summary>
+	/// Cooks a mesh that was loaded from a source file and writes it next to the source. Failures are
+	/// logged but not thrown, since the cache is an optimization and we still have the source mesh. Sources that
+	/// are read from a mounted asset pack are never cooked
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the mesh, must have a V_DECL</typeparam>
+	/// <param name="sourcePath">The path of the source file that the mesh was loaded from</param>
+	/// <param name="optionsHash">A hash of the options used to load the source file</param>
+	/// <param name="mesh">The mesh to store</param>
+	/// <returns>True if the cooked file was written, false if otherwise</returns>
+	template <typename VertType>
+	static bool Store(const std::string& sourcePath, uint64_t optionsHash, const MeshBuilder<VertType>& mesh) {
+		// Cook the indices as 16 bit if they fit, so loads don't need to narrow them again
+		if (mesh.GetVertexCount() <= 0x10000) {
+			std::vector<uint16_t> indices(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+			return Store(sourcePath, optionsHash, VertType::V_DECL,
+				mesh.GetVertexDataPtr(), sizeof(VertType), mesh.GetVertexCount(),
+				indices.data(), sizeof(uint16_t), indices.size(), GL_UNSIGNED_SHORT, mesh.GetVertexTransform());
+		}
+		return Store(sourcePath, optionsHash, VertType::V_DECL,
+			mesh.GetVertexDataPtr(), sizeof(VertType), mesh.GetVertexCount(),
+			mesh.GetIndexDataPtr(), sizeof(uint32_t), mesh.GetIndexCount(), GL_UNSIGNED_INT, mesh.GetVertexTransform());
+	}
+	/// <summary>
+	/// Writes a mesh that is already in the cooked layout (including any meshlets) next to its source file
+	/// </summary>
+	static bool Store(const std::string& sourcePath, uint64_t optionsHash, const CookedMesh& mesh) {
+		return Store(sourcePath, optionsHash, mesh.Attributes,
+			mesh.Vertices.data(), mesh.VertexStride, mesh.VertexCount,
+			mesh.Indices.data(), mesh.IndexElementSize, mesh.IndexCount, mesh.IndexType, mesh.VertexTransform,
+			mesh.Meshlets.data(), mesh.Meshlets.size());
+	}
+	/// <summary>
+	/// Cooks raw vertex and index data that was loaded from a source file and writes it next to the source
+	/// </summary>
+	static bool Store(const std::string& sourcePath, uint64_t optionsHash, const std::vector<BufferAttribute>& attributes,
+		const void* vertices, size_t vertexStride, size_t vertexCount,
+		const void* indices, size_t indexElementSize, size_t indexCount, GLenum indexType,
+		const glm::mat4& vertexTransform = glm::mat4(1.0f), const Meshlet* meshlets = nullptr, size_t meshletCount = 0);
+
+	/// <summary>
+	/// Computes a 64 bit FNV-1a hash of a block of memory
+	/// </summary>
+	/// <param name="data">The data to hash</param>
+	/// <param name="size">The size of the data, in bytes</param>
+	/// <param name="seed">The hash to continue from, lets you combine multiple blocks into one hash</param>
+	static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+protected:
+	MeshCache() = default;
+	~MeshCache() = default;
+};
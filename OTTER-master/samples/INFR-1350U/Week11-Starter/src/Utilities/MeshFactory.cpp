@@ -200,7 +200,7 @@ void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm:
 
 	uint32_t offset = verts.size();
 	uint32_t initialIndex = data._indices.size();
-	verts.reserve(verts.size() + numverts);
+	data.ReserveVertexSpace(numverts);
 
 	float stackAngle, sliceAngle;
 	float x, y, z, xy;
@@ -239,7 +239,7 @@ void MeshFactory::AddUvSphere(MeshBuilder<VertexPosNormTexCol>& data, const glm:
 	}
 	
 	int numIndices = (slices - 1) * slices * 6;
-	data._indices.reserve(data._indices.size() + numIndices);
+	data.ReserveIndexSpace(numIndices);
 
 	// Body loop
 	int k1, k2;
@@ -0,0 +1,330 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <GLM/glm.hpp>
+
+// Tuning values for the vertex cache optimization, from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static constexpr int   ForsythCacheSize         = 32;
+static constexpr float ForsythCacheDecayPower   = 1.5f;
+static constexpr float ForsythLastTriScore      = 0.75f;
+static constexpr float ForsythValenceBoostScale = 2.0f;
+static constexpr float ForsythValenceBoostPower = 0.5f;
+
+/// <summary>
+/// Scores a vertex based on where it is in the cache and how many triangles still need it, higher
+/// scores mean the vertex is a better choice to draw next
+/// </summary>
+inline float ForsythVertexScore(int cachePosition, uint32_t remainingValence) {
+	if (remainingValence == 0) {
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		// Vertices used by the last triangle get a fixed score, so we don't favour going back and forth over one edge
+		if (cachePosition < 3) {
+			score = ForsythLastTriScore;
+		} else {
+			const float scaler = 1.0f / (ForsythCacheSize - 3);
+			score = std::pow(1.0f - (cachePosition - 3) * scaler, ForsythCacheDecayPower);
+		}
+	}
+
+	// Boost vertices with only a few triangles left, so we finish them off and don't leave lone triangles behind
+	score += ForsythValenceBoostScale * std::pow(static_cast<float>(remainingValence), -ForsythValenceBoostPower);
+	return score;
+}
+
+/// <summary>
+/// A FIFO cache simulation, used to measure cache efficiency and to find good places to split the mesh into clusters
+/// </summary>
+class FifoCacheSimulator
+{
+public:
+	FifoCacheSimulator(size_t vertexCount, size_t cacheSize) :
+		_timestamps(vertexCount, 0),
+		_time(cacheSize + 1),
+		_cacheSize(cacheSize)
+	{ }
+
+	/// <summary>
+	/// Processes a single vertex, returning 1 if it was a cache miss and 0 if it was a hit
+	/// </summary>
+	uint32_t Touch(uint32_t vertex) {
+		// A vertex is in the cache if it was added within the last cacheSize misses
+		if (_time - _timestamps[vertex] > _cacheSize) {
+			_timestamps[vertex] = _time++;
+			return 1;
+		}
+		return 0;
+	}
+
+	/// <summary>
+	/// Empties the cache, so all following vertices will miss until they are re-added
+	/// </summary>
+	void Reset() {
+		_time += _cacheSize + 1;
+	}
+
+private:
+	std::vector<size_t> _timestamps;
+	size_t _time;
+	size_t _cacheSize;
+};
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+	FifoCacheSimulator cache(vertexCount, cacheSize);
+	size_t transformed = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		transformed += cache.Touch(indices[ix]);
+	}
+
+	// ATVR is relative to the vertices that are actually used, so we don't penalize meshes with unused vertices
+	std::vector<uint8_t> used(vertexCount, 0);
+	size_t usedCount = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		usedCount += used[indices[ix]] == 0 ? 1 : 0;
+		used[indices[ix]] = 1;
+	}
+
+	VertexCacheStats result;
+	result.Transformed = transformed;
+	result.ACMR = indexCount >= 3 ? transformed / static_cast<float>(indexCount / 3) : 0.0f;
+	result.ATVR = usedCount > 0 ? transformed / static_cast<float>(usedCount) : 0.0f;
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0) {
+		return;
+	}
+
+	// Build a list of the triangles that use each vertex, laid out as one flat array with an offset per vertex
+	std::vector<uint32_t> valence(vertexCount, 0);
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		valence[indices[ix]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] = adjacencyOffsets[ix] + valence[ix];
+	}
+	std::vector<uint32_t> adjacency(triCount * 3);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+	}
+
+	// remaining[v] tracks how many of the vertex's triangles have not been drawn yet, these always occupy the
+	// first remaining[v] slots of the vertex's adjacency list
+	std::vector<uint32_t> remaining(valence);
+	std::vector<int>      cachePosition(vertexCount, -1);
+	std::vector<float>    vertexScore(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		vertexScore[ix] = ForsythVertexScore(-1, remaining[ix]);
+	}
+
+	std::vector<float>   triScore(triCount);
+	std::vector<uint8_t> triAdded(triCount, 0);
+	uint32_t bestTri = 0;
+	for (size_t ix = 0; ix < triCount; ix++) {
+		triScore[ix] = vertexScore[indices[ix * 3]] + vertexScore[indices[ix * 3 + 1]] + vertexScore[indices[ix * 3 + 2]];
+		if (triScore[ix] > triScore[bestTri]) {
+			bestTri = static_cast<uint32_t>(ix);
+		}
+	}
+
+	std::vector<uint32_t> output(triCount * 3);
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(ForsythCacheSize + 3);
+	newCache.reserve(ForsythCacheSize + 3);
+	size_t searchCursor = 0;
+
+	for (size_t outTri = 0; outTri < triCount; outTri++) {
+		// If none of the triangles touching the cache are left, we fall back to the next triangle in the original order
+		if (bestTri == ~0u) {
+			while (triAdded[searchCursor]) {
+				searchCursor++;
+			}
+			bestTri = static_cast<uint32_t>(searchCursor);
+		}
+
+		const uint32_t* tri = indices + bestTri * 3;
+		output[outTri * 3 + 0] = tri[0];
+		output[outTri * 3 + 1] = tri[1];
+		output[outTri * 3 + 2] = tri[2];
+		triAdded[bestTri] = 1;
+
+		// Remove the triangle from its vertices' lists of remaining triangles
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t vertex = tri[corner];
+			uint32_t* list = adjacency.data() + adjacencyOffsets[vertex];
+			for (uint32_t ix = 0; ix < remaining[vertex]; ix++) {
+				if (list[ix] == bestTri) {
+					std::swap(list[ix], list[remaining[vertex] - 1]);
+					remaining[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// The triangle's vertices move to the front of the LRU cache, everything else shifts back
+		newCache.clear();
+		newCache.push_back(tri[0]);
+		newCache.push_back(tri[1]);
+		newCache.push_back(tri[2]);
+		for (uint32_t vertex : cache) {
+			if (vertex != tri[0] && vertex != tri[1] && vertex != tri[2]) {
+				newCache.push_back(vertex);
+			}
+		}
+
+		// Re-score all the vertices that moved, including the ones that fell out of the cache
+		for (size_t ix = 0; ix < newCache.size(); ix++) {
+			const uint32_t vertex = newCache[ix];
+			cachePosition[vertex] = ix < ForsythCacheSize ? static_cast<int>(ix) : -1;
+			vertexScore[vertex] = ForsythVertexScore(cachePosition[vertex], remaining[vertex]);
+		}
+
+		// Re-score the triangles touching the cache, the best of these is what we draw next
+		bestTri = ~0u;
+		float bestScore = -1.0f;
+		for (size_t ix = 0; ix < newCache.size(); ix++) {
+			const uint32_t vertex = newCache[ix];
+			const uint32_t* list = adjacency.data() + adjacencyOffsets[vertex];
+			for (uint32_t adj = 0; adj < remaining[vertex]; adj++) {
+				const uint32_t triIx = list[adj];
+				const uint32_t* adjTri = indices + triIx * 3;
+				triScore[triIx] = vertexScore[adjTri[0]] + vertexScore[adjTri[1]] + vertexScore[adjTri[2]];
+				if (triScore[triIx] > bestScore) {
+					bestScore = triScore[triIx];
+					bestTri = triIx;
+				}
+			}
+		}
+
+		if (newCache.size() > ForsythCacheSize) {
+			newCache.resize(ForsythCacheSize);
+		}
+		cache.swap(newCache);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount, float threshold) {
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0) {
+		return;
+	}
+
+	auto getPosition = [&](uint32_t vertex) {
+		const float* pos = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+		return glm::vec3(pos[0], pos[1], pos[2]);
+	};
+
+	// Hard boundaries are where the cache optimized order had to start over (every vertex of the triangle
+	// missed), we can split there without losing anything
+	std::vector<uint32_t> hardClusters;
+	{
+		FifoCacheSimulator cache(vertexCount, SimulatedCacheSize);
+		for (size_t ix = 0; ix < triCount; ix++) {
+			const uint32_t misses = cache.Touch(indices[ix * 3]) + cache.Touch(indices[ix * 3 + 1]) + cache.Touch(indices[ix * 3 + 2]);
+			if (ix == 0 || misses == 3) {
+				hardClusters.push_back(static_cast<uint32_t>(ix));
+			}
+		}
+		hardClusters.push_back(static_cast<uint32_t>(triCount));
+	}
+
+	// Soft boundaries split the hard clusters further, wherever the part we've walked so far is already
+	// within the threshold of the cluster's overall cache efficiency
+	std::vector<uint32_t> clusters;
+	{
+		FifoCacheSimulator cache(vertexCount, SimulatedCacheSize);
+		for (size_t cluster = 0; cluster + 1 < hardClusters.size(); cluster++) {
+			const uint32_t start = hardClusters[cluster];
+			const uint32_t end = hardClusters[cluster + 1];
+
+			cache.Reset();
+			uint32_t clusterMisses = 0;
+			for (uint32_t ix = start; ix < end; ix++) {
+				clusterMisses += cache.Touch(indices[ix * 3]) + cache.Touch(indices[ix * 3 + 1]) + cache.Touch(indices[ix * 3 + 2]);
+			}
+			const float target = threshold * clusterMisses / static_cast<float>(end - start);
+
+			cache.Reset();
+			uint32_t subStart = start;
+			uint32_t misses = 0;
+			clusters.push_back(start);
+			for (uint32_t ix = start; ix < end; ix++) {
+				misses += cache.Touch(indices[ix * 3]) + cache.Touch(indices[ix * 3 + 1]) + cache.Touch(indices[ix * 3 + 2]);
+				if (ix + 1 < end && misses / static_cast<float>(ix + 1 - subStart) <= target) {
+					clusters.push_back(ix + 1);
+					subStart = ix + 1;
+					misses = 0;
+					cache.Reset();
+				}
+			}
+		}
+		clusters.push_back(static_cast<uint32_t>(triCount));
+	}
+
+	// Work out the area weighted center of the mesh, and the center and average normal of each cluster
+	const size_t clusterCount = clusters.size() - 1;
+	std::vector<glm::vec3> clusterCenters(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+	for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+		float clusterArea = 0.0f;
+		for (uint32_t ix = clusters[cluster]; ix < clusters[cluster + 1]; ix++) {
+			const glm::vec3 a = getPosition(indices[ix * 3]);
+			const glm::vec3 b = getPosition(indices[ix * 3 + 1]);
+			const glm::vec3 c = getPosition(indices[ix * 3 + 2]);
+			const glm::vec3 normal = glm::cross(b - a, c - a);
+			const float area = glm::length(normal);
+			const glm::vec3 center = (a + b + c) / 3.0f;
+
+			clusterCenters[cluster] += center * area;
+			clusterNormals[cluster] += normal;
+			clusterArea += area;
+		}
+		meshCenter += clusterCenters[cluster];
+		meshArea += clusterArea;
+		clusterCenters[cluster] = clusterArea > 0.0f ? clusterCenters[cluster] / clusterArea : getPosition(indices[clusters[cluster] * 3]);
+	}
+	meshCenter = meshArea > 0.0f ? meshCenter / meshArea : glm::vec3(0.0f);
+
+	// Clusters that are further out along their normal are more likely to occlude others, so we draw them first
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<uint32_t> order(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+		const float length = glm::length(clusterNormals[cluster]);
+		const glm::vec3 normal = length > 0.0f ? clusterNormals[cluster] / length : glm::vec3(0.0f);
+		sortKeys[cluster] = glm::dot(clusterCenters[cluster] - meshCenter, normal);
+		order[cluster] = static_cast<uint32_t>(cluster);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output;
+	output.reserve(triCount * 3);
+	for (uint32_t cluster : order) {
+		output.insert(output.end(), indices + clusters[cluster] * 3, indices + clusters[cluster + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+size_t MeshOptimizer::OptimizeVertexFetchRemap(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap) {
+	remap.assign(vertexCount, UnusedVertex);
+	uint32_t next = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t& mapped = remap[indices[ix]];
+		if (mapped == UnusedVertex) {
+			mapped = next++;
+		}
+		indices[ix] = mapped;
+	}
+	return next;
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "MeshBuilder.h"
+
+/// <summary>
+/// Results from simulating a GPU's post-transform vertex cache over an index buffer
+/// </summary>
+struct VertexCacheStats
+{
+	/// <summary>
+	/// The number of vertices that had to be transformed (cache misses)
+	/// </summary>
+	size_t Transformed;
+	/// <summary>
+	/// Average cache miss ratio, the number of transformed vertices per triangle. Lower is better,
+	/// 0.5 is the best you can do for a large regular grid and 3.0 is the worst
+	/// </summary>
+	float  ACMR;
+	/// <summary>
+	/// Average transform to vertex ratio, the number of transformed vertices per unique vertex.
+	/// Lower is better, 1.0 is ideal (every vertex is transformed once)
+	/// </summary>
+	float  ATVR;
+};
+
+/// <summary>
+/// The statistics for a mesh before and after it was optimized
+/// </summary>
+struct MeshOptimizerStats
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+};
+
+/// <summary>
+/// Options that control which passes the mesh optimizer runs
+/// </summary>
+struct MeshOptimizerOptions
+{
+	/// <summary>
+	/// Reorders triangles so that vertices are reused while they are still in the post-transform cache
+	/// </summary>
+	bool  OptimizeVertexCache;
+	/// <summary>
+	/// Reorders clusters of triangles so that outward facing surfaces are drawn first, reducing overdraw.
+	/// Requires the vertex type to have a 3 component float position
+	/// </summary>
+	bool  OptimizeOverdraw;
+	/// <summary>
+	/// How much the cache efficiency can be sacrificed to reduce overdraw, 1.05 allows the ACMR to get 5% worse
+	/// </summary>
+	float OverdrawThreshold;
+	/// <summary>
+	/// Reorders the vertex buffer so that vertices are stored in the order they are first used,
+	/// and removes any vertices that are not used by any triangle
+	/// </summary>
+	bool  OptimizeVertexFetch;
+
+	MeshOptimizerOptions() :
+		OptimizeVertexCache(true),
+		OptimizeOverdraw(true),
+		OverdrawThreshold(1.05f),
+		OptimizeVertexFetch(true)
+	{ }
+};
+
+/// <summary>
+/// Reorders the triangles and vertices of indexed meshes so they render faster on the GPU, without
+/// changing what gets rendered. The passes should be run in the order vertex cache, overdraw, vertex
+/// fetch, which is what Optimize does for you
+/// </summary>
+class MeshOptimizer
+{
+public:
+	/// <summary>
+	/// The size of the FIFO cache that we simulate when reporting stats. This is a conservative
+	/// estimate, most modern GPUs behave like a larger cache
+	/// </summary>
+	static constexpr size_t SimulatedCacheSize = 16;
+
+	/// <summary>
+	/// Runs all the optimization passes that are enabled in options on the given mesh
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex stored in the mesh, must have a V_DECL</typeparam>
+	/// <param name="mesh">The mesh to optimize in-place</param>
+	/// <param name="options">The passes to run</param>
+	/// <returns>The vertex cache statistics for the mesh before and after optimization</returns>
+	template <typename VertType>
+	static MeshOptimizerStats Optimize(MeshBuilder<VertType>& mesh, const MeshOptimizerOptions& options = MeshOptimizerOptions()) {
+		MeshOptimizerStats result;
+		result.Before = AnalyzeVertexCache(mesh._indices.data(), mesh._indices.size(), mesh._vertices.size());
+
+		if (options.OptimizeVertexCache) {
+			OptimizeVertexCache(mesh._indices.data(), mesh._indices.size(), mesh._vertices.size());
+		}
+		if (options.OptimizeOverdraw) {
+			// We need to find the positions within the vertex, if there's no float position we just skip this pass
+			for (const BufferAttribute& attrib : VertType::V_DECL) {
+				if (attrib.Usage == AttribUsage::Position && attrib.Type == GL_FLOAT && attrib.Size >= 3) {
+					const float* positions = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(mesh._vertices.data()) + attrib.Offset);
+					OptimizeOverdraw(mesh._indices.data(), mesh._indices.size(), positions, sizeof(VertType), mesh._vertices.size(), options.OverdrawThreshold);
+					break;
+				}
+			}
+		}
+		if (options.OptimizeVertexFetch) {
+			std::vector<uint32_t> remap;
+			const size_t vertexCount = OptimizeVertexFetchRemap(mesh._indices.data(), mesh._indices.size(), mesh._vertices.size(), remap);
+
+			std::vector<VertType> vertices(vertexCount);
+			for (size_t ix = 0; ix < mesh._vertices.size(); ix++) {
+				if (remap[ix] != UnusedVertex) {
+					vertices[remap[ix]] = mesh._vertices[ix];
+				}
+			}
+			mesh._vertices.swap(vertices);
+		}
+
+		result.After = AnalyzeVertexCache(mesh._indices.data(), mesh._indices.size(), mesh._vertices.size());
+		return result;
+	}
+
+	/// <summary>
+	/// Simulates a FIFO post-transform cache over the given triangle list
+	/// </summary>
+	/// <param name="indices">The triangle list to analyze</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	/// <param name="cacheSize">The number of vertices the simulated cache can hold</param>
+	static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = SimulatedCacheSize);
+
+	/// <summary>
+	/// Reorders a triangle list to improve post-transform cache hits, using Tom Forsyth's linear-speed
+	/// vertex cache optimization algorithm
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder in-place</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/// <summary>
+	/// Reorders clusters of triangles so that those facing away from the mesh's center are drawn first,
+	/// letting early-Z reject more of the fragments behind them. Should be run after OptimizeVertexCache,
+	/// clusters are only split where it does not cost more than threshold in cache efficiency (based on
+	/// Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder in-place</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="positions">A pointer to the position of the first vertex</param>
+	/// <param name="positionStride">The number of bytes between each vertex position</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	/// <param name="threshold">How much worse the ACMR is allowed to get, 1.05 allows it to get 5% worse</param>
+	static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount, float threshold);
+
+	/// <summary>
+	/// Generates a remap table that orders vertices by when they are first used, and rewrites the indices to match
+	/// </summary>
+	/// <param name="indices">The triangle list to rewrite in-place</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	/// <param name="remap">Will be filled with the new index for each old vertex, or UnusedVertex if it is not referenced</param>
+	/// <returns>The number of vertices that are referenced by the triangles</returns>
+	static size_t OptimizeVertexFetchRemap(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap);
+
+	/// <summary>
+	/// Marks a vertex in a remap table that is not used by any triangle
+	/// </summary>
+	static constexpr uint32_t UnusedVertex = ~0u;
+
+protected:
+	MeshOptimizer() = default;
+	~MeshOptimizer() = default;
+};
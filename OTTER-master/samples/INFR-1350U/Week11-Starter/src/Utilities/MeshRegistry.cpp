@@ -0,0 +1,221 @@
+#include "MeshRegistry.h"
+
+#include <filesystem>
+#include <system_error>
+
+#include "Logging.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+
+std::mutex MeshRegistry::_lock;
+std::unordered_map<std::string, std::weak_ptr<VertexArrayObject>> MeshRegistry::_meshes;
+std::unordered_map<std::string, std::weak_ptr<MeshLodSet>> MeshRegistry::_lodSets;
+size_t MeshRegistry::_hits = 0;
+size_t MeshRegistry::_misses = 0;
+
+VertexArrayObject::sptr MeshRegistry::LoadObj(const std::string& filename, const ObjLoadOptions& options) {
+	const std::string key = _MakeKey(filename, options.GetOutputHash());
+
+	// Note that we hold the lock while loading, so two threads asking for the same mesh don't both load it
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _meshes.find(key);
+	if (it != _meshes.end()) {
+		VertexArrayObject::sptr result = it->second.lock();
+		if (result != nullptr) {
+			_hits++;
+			return result;
+		}
+	}
+
+	_misses++;
+	VertexArrayObject::sptr result = ObjLoader::LoadFromFile(filename, options);
+	result->SetDebugName(filename);
+	_meshes[key] = result;
+	return result;
+}
+
+MeshLodSet::sptr MeshRegistry::LoadObjLods(const std::string& filename, const MeshLodOptions& lodOptions, const ObjLoadOptions& options) {
+	const std::string key = _MakeKey(filename, GetLodOptionsHash(lodOptions, options));
+
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _lodSets.find(key);
+	if (it != _lodSets.end()) {
+		MeshLodSet::sptr result = it->second.lock();
+		if (result != nullptr) {
+			_hits++;
+			return result;
+		}
+	}
+
+	_misses++;
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	ObjLoader::LoadMeshData(filename, mesh, options);
+	// We optimize the full detail mesh before simplifying, so the shared vertex buffer is in a cache friendly order
+	if (options.Optimize) {
+		MeshOptimizer::Optimize(mesh);
+	}
+	// The levels are always generated from the full precision mesh, and then we upload the format that was asked for
+	MeshLodSet::sptr result;
+	switch (options.Format) {
+		case VertexFormat::Packed:
+		{
+			MeshBuilder<VertexPackedPosNormTexCol> packed;
+			VertexPacking::Pack(mesh, packed);
+			result = MeshSimplifier::BakeLods(packed, mesh, lodOptions);
+			break;
+		}
+		case VertexFormat::Quantized:
+		{
+			MeshBuilder<VertexQuantizedPosNormTexCol> quantized;
+			VertexPacking::Quantize(mesh, quantized);
+			result = MeshSimplifier::BakeLods(quantized, mesh, lodOptions);
+			break;
+		}
+		case VertexFormat::QTangent:
+		{
+			MeshBuilder<VertexPackedPosQTangentTexCol> qtangents;
+			VertexPacking::PackQTangents(mesh, qtangents, options.ThreadCount);
+			result = MeshSimplifier::BakeLods(qtangents, mesh, lodOptions);
+			break;
+		}
+		default:
+			result = MeshSimplifier::BakeLods(mesh, lodOptions);
+			break;
+	}
+	for (size_t ix = 0; ix < result->GetLevelCount(); ix++) {
+		result->GetLevel(ix).Mesh->SetDebugName(filename + " LOD" + std::to_string(ix));
+	}
+	LOG_INFO("Generated {} levels of detail for {}, {} -> {} triangles", result->GetLevelCount(), filename,
+		result->GetLevel(0).TriangleCount, result->GetLevel(result->GetLevelCount() - 1).TriangleCount);
+	_lodSets[key] = result;
+	return result;
+}
+
+VertexArrayObject::sptr MeshRegistry::FindObj(const std::string& filename, const ObjLoadOptions& options) {
+	const std::string key = _MakeKey(filename, options.GetOutputHash());
+
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _meshes.find(key);
+	if (it == _meshes.end()) {
+		return nullptr;
+	}
+	VertexArrayObject::sptr result = it->second.lock();
+	if (result != nullptr) {
+		_hits++;
+	}
+	return result;
+}
+
+void MeshRegistry::RegisterObj(const std::string& filename, const ObjLoadOptions& options, const VertexArrayObject::sptr& mesh) {
+	const std::string key = _MakeKey(filename, options.GetOutputHash());
+
+	std::lock_guard<std::mutex> guard(_lock);
+	_misses++;
+	_meshes[key] = mesh;
+}
+
+MeshLodSet::sptr MeshRegistry::FindObjLods(const std::string& filename, const MeshLodOptions& lodOptions, const ObjLoadOptions& options) {
+	const std::string key = _MakeKey(filename, GetLodOptionsHash(lodOptions, options));
+
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _lodSets.find(key);
+	if (it == _lodSets.end()) {
+		return nullptr;
+	}
+	MeshLodSet::sptr result = it->second.lock();
+	if (result != nullptr) {
+		_hits++;
+	}
+	return result;
+}
+
+void MeshRegistry::RegisterObjLods(const std::string& filename, const MeshLodOptions& lodOptions, const ObjLoadOptions& options, const MeshLodSet::sptr& lods) {
+	const std::string key = _MakeKey(filename, GetLodOptionsHash(lodOptions, options));
+
+	std::lock_guard<std::mutex> guard(_lock);
+	_misses++;
+	_lodSets[key] = lods;
+}
+
+uint64_t MeshRegistry::GetLodOptionsHash(const MeshLodOptions& lodOptions, const ObjLoadOptions& options) {
+	// Mix the LOD options into the key, so different chains for the same file don't get mixed up
+	uint64_t hash = options.GetOutputHash();
+	hash = MeshCache::Hash(&lodOptions.LevelCount, sizeof(lodOptions.LevelCount), hash);
+	hash = MeshCache::Hash(&lodOptions.TriangleRatio, sizeof(lodOptions.TriangleRatio), hash);
+	hash = MeshCache::Hash(&lodOptions.MaxError, sizeof(lodOptions.MaxError), hash);
+	hash = MeshCache::Hash(&lodOptions.FirstScreenSize, sizeof(lodOptions.FirstScreenSize), hash);
+	return hash;
+}
+
+size_t MeshRegistry::GetRefCount(const std::string& filename, const ObjLoadOptions& options) {
+	const std::string key = _MakeKey(filename, options.GetOutputHash());
+
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _meshes.find(key);
+	return it != _meshes.end() ? static_cast<size_t>(it->second.use_count()) : 0;
+}
+
+MeshRegistryStats MeshRegistry::GetStats() {
+	std::lock_guard<std::mutex> guard(_lock);
+	MeshRegistryStats result;
+	result.Hits = _hits;
+	result.Misses = _misses;
+	result.ResidentMeshes = 0;
+	result.References = 0;
+	for (const auto& [key, mesh] : _meshes) {
+		const long count = mesh.use_count();
+		result.ResidentMeshes += count > 0 ? 1 : 0;
+		result.References += static_cast<size_t>(count);
+	}
+	for (const auto& [key, lods] : _lodSets) {
+		const long count = lods.use_count();
+		result.ResidentMeshes += count > 0 ? 1 : 0;
+		result.References += static_cast<size_t>(count);
+	}
+	return result;
+}
+
+void MeshRegistry::ResetStats() {
+	std::lock_guard<std::mutex> guard(_lock);
+	_hits = 0;
+	_misses = 0;
+}
+
+size_t MeshRegistry::CollectGarbage() {
+	std::lock_guard<std::mutex> guard(_lock);
+	size_t removed = 0;
+	for (auto it = _meshes.begin(); it != _meshes.end();) {
+		if (it->second.expired()) {
+			it = _meshes.erase(it);
+			removed++;
+		} else {
+			++it;
+		}
+	}
+	for (auto it = _lodSets.begin(); it != _lodSets.end();) {
+		if (it->second.expired()) {
+			it = _lodSets.erase(it);
+			removed++;
+		} else {
+			++it;
+		}
+	}
+	return removed;
+}
+
+void MeshRegistry::Clear() {
+	std::lock_guard<std::mutex> guard(_lock);
+	_meshes.clear();
+	_lodSets.clear();
+}
+
+std::string MeshRegistry::_MakeKey(const std::string& filename, uint64_t optionsHash) {
+	// We use the canonical path so that things like "models/../models/a.obj" and "models/a.obj" share an entry,
+	// falling back to the path as given if the file can't be found (the load will report the error)
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(filename, error);
+	std::string result = error ? filename : path.generic_string();
+	result += '|';
+	result += std::to_string(optionsHash);
+	return result;
+}
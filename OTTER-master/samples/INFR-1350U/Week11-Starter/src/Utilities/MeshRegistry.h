@@ -0,0 +1,135 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshLodSet.h"
+#include "ObjLoader.h"
+#include "MeshSimplifier.h"
+
+/// <summary>
+/// Statistics about how effective the mesh registry has been
+/// </summary>
+struct MeshRegistryStats
+{
+	/// <summary>
+	/// The number of loads that returned a mesh that was already resident
+	/// </summary>
+	size_t Hits;
+	/// <summary>
+	/// The number of loads that had to load the mesh from disk
+	/// </summary>
+	size_t Misses;
+	/// <summary>
+	/// The number of unique meshes that are currently resident on the GPU
+	/// </summary>
+	size_t ResidentMeshes;
+	/// <summary>
+	/// The total number of references to resident meshes
+	/// </summary>
+	size_t References;
+};
+
+/// <summary>
+/// Keeps track of all the meshes that have been loaded from disk, so that loading the same file with the
+/// same options multiple times only parses it and creates GPU buffers once, and everyone shares the same VAO.
+/// AssetLoader::LoadObj and AssetLoader::LoadObjLods go through the registry as well.
+///
+/// The registry does not keep meshes alive by itself, a mesh stays resident on the GPU for as long as
+/// something holds on to its VAO, and will be loaded again if it is requested after being released
+/// </summary>
+class MeshRegistry
+{
+public:
+	/// <summary>
+	/// Loads an OBJ file, or returns the already loaded mesh if the file was loaded before with options
+	/// that produce the same mesh
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="options">The options to load the file with, if it is not already loaded</param>
+	/// <returns>A VAO that is shared with everyone else who has loaded the mesh</returns>
+	static VertexArrayObject::sptr LoadObj(const std::string& filename, const ObjLoadOptions& options = ObjLoadOptions());
+
+	/// <summary>
+	/// Loads an OBJ file and generates levels of detail for it, or returns the already loaded set if the file was
+	/// loaded before with the same options. Note that LOD sets are not shared with meshes loaded through LoadObj,
+	/// and are generated each time they are loaded (they do not go through the cooked mesh cache)
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="lodOptions">The options for generating the levels of detail</param>
+	/// <param name="options">The options to load the file with, if it is not already loaded</param>
+	/// <returns>A LOD set that is shared with everyone else who has loaded the mesh</returns>
+	static MeshLodSet::sptr LoadObjLods(const std::string& filename, const MeshLodOptions& lodOptions = MeshLodOptions(), const ObjLoadOptions& options = ObjLoadOptions());
+
+	/// <summary>
+	/// Gets the mesh for an OBJ file if it is resident, without loading it if it is not. Counts as a hit if it is found
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file</param>
+	/// <param name="options">The options that the file was loaded with</param>
+	/// <returns>The shared mesh, or nullptr if the mesh is not resident</returns>
+	static VertexArrayObject::sptr FindObj(const std::string& filename, const ObjLoadOptions& options = ObjLoadOptions());
+	/// <summary>
+	/// Adds a mesh that was loaded elsewhere (ex: by the AssetLoader) to the registry, so later loads of the same
+	/// file share it. Counts as a miss, since the file had to be loaded
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file that the mesh was loaded from</param>
+	/// <param name="options">The options that the file was loaded with</param>
+	/// <param name="mesh">The mesh to share</param>
+	static void RegisterObj(const std::string& filename, const ObjLoadOptions& options, const VertexArrayObject::sptr& mesh);
+	/// <summary>
+	/// Gets the LOD set for an OBJ file if it is resident, without generating it if it is not. Counts as a hit if it is found
+	/// </summary>
+	static MeshLodSet::sptr FindObjLods(const std::string& filename, const MeshLodOptions& lodOptions = MeshLodOptions(), const ObjLoadOptions& options = ObjLoadOptions());
+	/// <summary>
+	/// Adds a LOD set that was generated elsewhere (ex: by the AssetLoader) to the registry. Counts as a miss
+	/// </summary>
+	static void RegisterObjLods(const std::string& filename, const MeshLodOptions& lodOptions, const ObjLoadOptions& options, const MeshLodSet::sptr& lods);
+
+	/// <summary>
+	/// Gets a hash of the load and LOD options, which together decide the LOD set that gets generated for a file
+	/// </summary>
+	static uint64_t GetLodOptionsHash(const MeshLodOptions& lodOptions, const ObjLoadOptions& options);
+
+	/// <summary>
+	/// Gets the number of references to a mesh, or 0 if it is not resident
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file</param>
+	/// <param name="options">The options that the file was loaded with</param>
+	static size_t GetRefCount(const std::string& filename, const ObjLoadOptions& options = ObjLoadOptions());
+
+	/// <summary>
+	/// Gets the current statistics for the registry
+	/// </summary>
+	static MeshRegistryStats GetStats();
+	/// <summary>
+	/// Resets the hit and miss counts back to zero
+	/// </summary>
+	static void ResetStats();
+
+	/// <summary>
+	/// Removes entries for meshes that are no longer referenced by anything
+	/// </summary>
+	/// <returns>The number of entries that were removed</returns>
+	static size_t CollectGarbage();
+	/// <summary>
+	/// Forgets about all meshes, meshes that are still referenced elsewhere will stay alive but will no longer be shared
+	/// </summary>
+	static void Clear();
+
+protected:
+	MeshRegistry() = default;
+	~MeshRegistry() = default;
+
+	/// <summary>
+	/// Builds the key for a mesh from the canonical version of its path and the hash of its options
+	/// </summary>
+	static std::string _MakeKey(const std::string& filename, uint64_t optionsHash);
+
+	static std::mutex _lock;
+	static std::unordered_map<std::string, std::weak_ptr<VertexArrayObject>> _meshes;
+	static std::unordered_map<std::string, std::weak_ptr<MeshLodSet>> _lodSets;
+	static size_t _hits;
+	static size_t _misses;
+};
@@ -0,0 +1,449 @@
+#include "MeshSimplifier.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <GLM/glm.hpp>
+
+#include "FlatHashMap.h"
+#include "MeshOptimizer.h"
+
+// Weights for the extra error we add when a collapse changes a vertex's attributes, relative to the
+// positional error. These keep the simplifier from smearing hard edges and texture seams first
+static constexpr double SimplifierNormalWeight  = 0.0025;
+static constexpr double SimplifierTextureWeight = 0.01;
+// How much more we care about moving border edges than interior ones, this keeps holes and the edges of
+// open meshes (like planes) from shrinking
+static constexpr double SimplifierBorderWeight  = 10.0;
+
+/// <summary>
+/// A symmetric 4x4 matrix that measures the sum of squared distances from a point to a set of planes
+/// </summary>
+struct Quadric
+{
+	double A00, A11, A22;
+	double A01, A02, A12;
+	double B0, B1, B2;
+	double C;
+	// The total area of the planes, used to turn the sum into an average distance
+	double Weight;
+
+	Quadric() :
+		A00(0.0), A11(0.0), A22(0.0), A01(0.0), A02(0.0), A12(0.0), B0(0.0), B1(0.0), B2(0.0), C(0.0), Weight(0.0)
+	{ }
+
+	/// <summary>
+	/// Creates the quadric for the plane with the given normal and distance, scaled by weight
+	/// </summary>
+	static Quadric FromPlane(const glm::dvec3& normal, double distance, double weight) {
+		Quadric result;
+		result.A00 = weight * normal.x * normal.x;
+		result.A11 = weight * normal.y * normal.y;
+		result.A22 = weight * normal.z * normal.z;
+		result.A01 = weight * normal.x * normal.y;
+		result.A02 = weight * normal.x * normal.z;
+		result.A12 = weight * normal.y * normal.z;
+		result.B0 = weight * normal.x * distance;
+		result.B1 = weight * normal.y * distance;
+		result.B2 = weight * normal.z * distance;
+		result.C = weight * distance * distance;
+		result.Weight = weight;
+		return result;
+	}
+
+	Quadric& operator+=(const Quadric& other) {
+		A00 += other.A00; A11 += other.A11; A22 += other.A22;
+		A01 += other.A01; A02 += other.A02; A12 += other.A12;
+		B0 += other.B0; B1 += other.B1; B2 += other.B2;
+		C += other.C;
+		Weight += other.Weight;
+		return *this;
+	}
+
+	/// <summary>
+	/// Gets the weighted sum of squared distances from the point to all the planes in the quadric
+	/// </summary>
+	double Evaluate(const glm::dvec3& p) const {
+		const double rx = A00 * p.x + A01 * p.y + A02 * p.z + B0;
+		const double ry = A01 * p.x + A11 * p.y + A12 * p.z + B1;
+		const double rz = A02 * p.x + A12 * p.y + A22 * p.z + B2;
+		const double result = rx * p.x + ry * p.y + rz * p.z + B0 * p.x + B1 * p.y + B2 * p.z + C;
+		return std::abs(result);
+	}
+};
+
+/// <summary>
+/// A potential edge collapse, moving the From vertex onto the To vertex
+/// </summary>
+struct Collapse
+{
+	uint32_t From;
+	uint32_t To;
+	double   Cost;
+};
+
+/// <summary>
+/// Gets a float attribute from a vertex buffer
+/// </summary>
+inline const float* GetAttribute(const uint8_t* vertices, size_t stride, uint32_t vertex, int offset) {
+	return reinterpret_cast<const float*>(vertices + stride * vertex + offset);
+}
+
+size_t MeshSimplifier::Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const void* vertices, size_t vertexStride, size_t vertexCount, const MeshSimplifierLayout& layout,
+	size_t targetIndexCount, float targetError, float* resultError) {
+	const uint8_t* vertexData = static_cast<const uint8_t*>(vertices);
+	if (resultError != nullptr) {
+		*resultError = 0.0f;
+	}
+	if (layout.PositionOffset < 0) {
+		throw std::runtime_error("Cannot simplify a mesh without a 3 component float position");
+	}
+
+	std::vector<uint32_t> result(indices, indices + indexCount);
+	if (indexCount <= targetIndexCount || vertexCount == 0) {
+		memmove(destination, result.data(), result.size() * sizeof(uint32_t));
+		return result.size();
+	}
+
+	// We work with positions that are normalized to the mesh's bounding sphere, so that the error is
+	// relative to the size of the mesh and the target error means the same thing for any model
+	glm::vec3 center;
+	float radius;
+	CalculateBounds(vertices, vertexStride, vertexCount, layout, center, radius);
+	const double scale = radius > 0.0f ? 1.0 / radius : 1.0;
+
+	// Vertices that share a position are welded together, we simplify the welded mesh and carry the
+	// attribute vertices (wedges) along with it. Each vertex points to the first vertex at its position,
+	// and the vertices at each position are linked together in a ring
+	std::vector<uint32_t> weld(vertexCount);
+	std::vector<uint32_t> wedgeNext(vertexCount);
+	std::vector<glm::dvec3> positions(vertexCount);
+	{
+		FlatHashMap<PositionKey, uint32_t, PositionKeyHash> welded;
+		welded.Reserve(vertexCount);
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			const float* position = GetAttribute(vertexData, vertexStride, ix, layout.PositionOffset);
+			PositionKey key;
+			memcpy(&key.X, &position[0], sizeof(float));
+			memcpy(&key.Y, &position[1], sizeof(float));
+			memcpy(&key.Z, &position[2], sizeof(float));
+			auto [first, inserted] = welded.TryEmplace(key, ix);
+			weld[ix] = *first;
+			if (inserted) {
+				wedgeNext[ix] = ix;
+			} else {
+				wedgeNext[ix] = wedgeNext[*first];
+				wedgeNext[*first] = ix;
+			}
+			positions[ix] = (glm::dvec3(position[0], position[1], position[2]) - glm::dvec3(center)) * scale;
+		}
+	}
+
+	// Build the error quadrics for each welded vertex from the planes of the triangles around it
+	std::vector<Quadric> quadrics(vertexCount);
+	FlatHashMap<uint64_t, uint32_t> edgeCounts;
+	edgeCounts.Reserve(indexCount);
+	for (size_t ix = 0; ix < indexCount; ix += 3) {
+		const uint32_t w[3] = { weld[result[ix]], weld[result[ix + 1]], weld[result[ix + 2]] };
+		const glm::dvec3 normal = glm::cross(positions[w[1]] - positions[w[0]], positions[w[2]] - positions[w[0]]);
+		const double area = glm::length(normal);
+		if (area > 0.0) {
+			const glm::dvec3 n = normal / area;
+			const Quadric quadric = Quadric::FromPlane(n, -glm::dot(n, positions[w[0]]), area * 0.5);
+			for (int corner = 0; corner < 3; corner++) {
+				quadrics[w[corner]] += quadric;
+			}
+		}
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t a = std::min(w[corner], w[(corner + 1) % 3]);
+			const uint32_t b = std::max(w[corner], w[(corner + 1) % 3]);
+			(*edgeCounts.TryEmplace((static_cast<uint64_t>(a) << 32) | b, 0).first)++;
+		}
+	}
+
+	// Edges that only belong to one triangle are on the border of the mesh, we add a plane that runs through
+	// the edge and is perpendicular to the triangle so that moving the border away from itself costs something
+	for (size_t ix = 0; ix < indexCount; ix += 3) {
+		const uint32_t w[3] = { weld[result[ix]], weld[result[ix + 1]], weld[result[ix + 2]] };
+		const glm::dvec3 normal = glm::cross(positions[w[1]] - positions[w[0]], positions[w[2]] - positions[w[0]]);
+		if (glm::length(normal) == 0.0) {
+			continue;
+		}
+		for (int corner = 0; corner < 3; corner++) {
+			const uint32_t a = w[corner];
+			const uint32_t b = w[(corner + 1) % 3];
+			const uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+			if (*edgeCounts.Find(key) != 1) {
+				continue;
+			}
+			const glm::dvec3 edge = positions[b] - positions[a];
+			const double length = glm::length(edge);
+			if (length == 0.0) {
+				continue;
+			}
+			const glm::dvec3 n = glm::normalize(glm::cross(edge, normal));
+			const Quadric quadric = Quadric::FromPlane(n, -glm::dot(n, positions[a]), length * length * SimplifierBorderWeight);
+			quadrics[a] += quadric;
+			quadrics[b] += quadric;
+		}
+	}
+
+	// Gets the extra cost of moving a vertex's attributes onto another vertex
+	auto attributeCost = [&](uint32_t from, uint32_t to) {
+		double cost = 0.0;
+		if (layout.NormalOffset >= 0) {
+			const float* a = GetAttribute(vertexData, vertexStride, from, layout.NormalOffset);
+			const float* b = GetAttribute(vertexData, vertexStride, to, layout.NormalOffset);
+			const glm::dvec3 delta(a[0] - b[0], a[1] - b[1], a[2] - b[2]);
+			cost += glm::dot(delta, delta) * SimplifierNormalWeight;
+		}
+		if (layout.TextureOffset >= 0) {
+			const float* a = GetAttribute(vertexData, vertexStride, from, layout.TextureOffset);
+			const float* b = GetAttribute(vertexData, vertexStride, to, layout.TextureOffset);
+			const glm::dvec2 delta(a[0] - b[0], a[1] - b[1]);
+			cost += glm::dot(delta, delta) * SimplifierTextureWeight;
+		}
+		return cost;
+	};
+
+	const size_t targetTriangles = targetIndexCount / 3;
+	const double maxCost = static_cast<double>(targetError) * targetError;
+	double largestCost = 0.0;
+
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> locked(vertexCount);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<std::pair<uint32_t, uint32_t>> wedgeMap;
+
+	// We make passes over the mesh, each one collapses the cheapest edges that don't touch each other. This is
+	// a lot simpler than keeping a priority queue up to date, and gives almost the same results
+	while (result.size() / 3 > targetTriangles) {
+		const size_t triangleCount = result.size() / 3;
+
+		// Find the triangles around each welded vertex
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result) {
+			adjacencyOffsets[weld[index] + 1]++;
+		}
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			adjacencyOffsets[ix + 1] += adjacencyOffsets[ix];
+		}
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t ix = 0; ix < result.size(); ix++) {
+				adjacency[fill[weld[result[ix]]]++] = static_cast<uint32_t>(ix / 3);
+			}
+		}
+
+		// Score every edge in both directions
+		collapses.clear();
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				const uint32_t a = result[ix + corner];
+				const uint32_t b = result[ix + (corner + 1) % 3];
+				const uint32_t wa = weld[a];
+				const uint32_t wb = weld[b];
+				if (wa == wb) {
+					continue;
+				}
+				Quadric sum = quadrics[wa];
+				sum += quadrics[wb];
+				const double weight = sum.Weight > 0.0 ? sum.Weight : 1.0;
+				collapses.push_back({ wa, wb, sum.Evaluate(positions[wb]) / weight + attributeCost(a, b) });
+				collapses.push_back({ wb, wa, sum.Evaluate(positions[wa]) / weight + attributeCost(b, a) });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.Cost < b.Cost;
+		});
+
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			remap[ix] = static_cast<uint32_t>(ix);
+		}
+		std::fill(locked.begin(), locked.end(), uint8_t(0));
+
+		const size_t needed = triangleCount - targetTriangles;
+		size_t removed = 0;
+		size_t collapsed = 0;
+		for (const Collapse& collapse : collapses) {
+			if (removed >= needed || collapse.Cost > maxCost) {
+				break;
+			}
+			// Collapses in the same pass can't share any triangles, otherwise the flip checks would be out of date
+			if (locked[collapse.From] || locked[collapse.To]) {
+				continue;
+			}
+
+			// Go through the triangles around the vertex we're removing. Triangles that also contain the target
+			// get removed, we use them to work out which wedge each of our wedges turns into. The others
+			// get stretched over to the target, and we make sure none of them would flip over
+			bool valid = true;
+			size_t removing = 0;
+			wedgeMap.clear();
+			for (uint32_t adj = adjacencyOffsets[collapse.From]; adj < adjacencyOffsets[collapse.From + 1] && valid; adj++) {
+				const uint32_t* tri = &result[adjacency[adj] * 3];
+				int fromCorner = -1;
+				int toCorner = -1;
+				for (int corner = 0; corner < 3; corner++) {
+					if (weld[tri[corner]] == collapse.From) {
+						fromCorner = corner;
+					} else if (weld[tri[corner]] == collapse.To) {
+						toCorner = corner;
+					}
+				}
+
+				if (toCorner >= 0) {
+					removing++;
+					bool found = false;
+					for (const auto& [from, to] : wedgeMap) {
+						if (from == tri[fromCorner]) {
+							found = true;
+							valid &= to == tri[toCorner];
+						}
+					}
+					if (!found) {
+						wedgeMap.push_back({ tri[fromCorner], tri[toCorner] });
+					}
+				} else {
+					const glm::dvec3& p0 = positions[weld[tri[0]]];
+					const glm::dvec3& p1 = positions[weld[tri[1]]];
+					const glm::dvec3& p2 = positions[weld[tri[2]]];
+					const glm::dvec3 before = glm::cross(p1 - p0, p2 - p0);
+					glm::dvec3 moved[3] = { p0, p1, p2 };
+					moved[fromCorner] = positions[collapse.To];
+					const glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+					valid &= glm::dot(before, after) > 0.0;
+				}
+			}
+			if (!valid || removing == 0) {
+				continue;
+			}
+
+			// Wedges that don't share a triangle with the target (ex: the other faces around a hard edge) get moved
+			// onto whichever of the target's wedges has the closest attributes, and pay for the difference
+			double penalty = 0.0;
+			for (uint32_t adj = adjacencyOffsets[collapse.From]; adj < adjacencyOffsets[collapse.From + 1]; adj++) {
+				const uint32_t* tri = &result[adjacency[adj] * 3];
+				for (int corner = 0; corner < 3; corner++) {
+					const uint32_t wedge = tri[corner];
+					if (weld[wedge] != collapse.From ||
+						std::any_of(wedgeMap.begin(), wedgeMap.end(), [&](const auto& pair) { return pair.first == wedge; })) {
+						continue;
+					}
+					uint32_t closest = collapse.To;
+					double closestCost = attributeCost(wedge, closest);
+					for (uint32_t other = wedgeNext[collapse.To]; other != collapse.To; other = wedgeNext[other]) {
+						const double cost = attributeCost(wedge, other);
+						if (cost < closestCost) {
+							closest = other;
+							closestCost = cost;
+						}
+					}
+					wedgeMap.push_back({ wedge, closest });
+					penalty += closestCost;
+				}
+			}
+			if (collapse.Cost + penalty > maxCost) {
+				continue;
+			}
+
+			for (const auto& [from, to] : wedgeMap) {
+				remap[from] = to;
+			}
+			quadrics[collapse.To] += quadrics[collapse.From];
+			for (uint32_t adj = adjacencyOffsets[collapse.From]; adj < adjacencyOffsets[collapse.From + 1]; adj++) {
+				const uint32_t* tri = &result[adjacency[adj] * 3];
+				locked[weld[tri[0]]] = 1;
+				locked[weld[tri[1]]] = 1;
+				locked[weld[tri[2]]] = 1;
+			}
+			largestCost = std::max(largestCost, collapse.Cost + penalty);
+			removed += removing;
+			collapsed++;
+		}
+
+		if (collapsed == 0) {
+			break;
+		}
+
+		// Apply the collapses, and drop any triangles that have collapsed down to a line
+		size_t write = 0;
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			const uint32_t a = remap[result[ix]];
+			const uint32_t b = remap[result[ix + 1]];
+			const uint32_t c = remap[result[ix + 2]];
+			if (weld[a] != weld[b] && weld[b] != weld[c] && weld[a] != weld[c]) {
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+
+	if (resultError != nullptr) {
+		*resultError = static_cast<float>(std::sqrt(largestCost));
+	}
+	memcpy(destination, result.data(), result.size() * sizeof(uint32_t));
+	return result.size();
+}
+
+void MeshSimplifier::GenerateLods(const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexStride, size_t vertexCount,
+	const MeshSimplifierLayout& layout, const MeshLodOptions& options,
+	std::vector<std::vector<uint32_t>>& outIndices, std::vector<float>& outErrors) {
+	outIndices.clear();
+	outErrors.clear();
+	outIndices.emplace_back(indices, indices + indexCount);
+	outErrors.push_back(0.0f);
+
+	for (size_t level = 1; level < options.LevelCount; level++) {
+		const std::vector<uint32_t>& source = outIndices.back();
+		const size_t target = static_cast<size_t>(source.size() / 3 * options.TriangleRatio) * 3;
+
+		std::vector<uint32_t> simplified(source.size());
+		float error = 0.0f;
+		const size_t count = Simplify(simplified.data(), source.data(), source.size(), vertices, vertexStride, vertexCount, layout, target, options.MaxError, &error);
+
+		// If we couldn't get rid of a meaningful number of triangles, another level isn't worth the memory
+		if (count == 0 || count > source.size() * 0.9) {
+			break;
+		}
+		simplified.resize(count);
+
+		// Simplifying scrambles the triangle order, so we need to optimize the new level for the vertex cache again
+		MeshOptimizer::OptimizeVertexCache(simplified.data(), simplified.size(), vertexCount);
+		outIndices.push_back(std::move(simplified));
+		outErrors.push_back(std::max(error, outErrors.back()));
+	}
+}
+
+void MeshSimplifier::CalculateBounds(const void* vertices, size_t vertexStride, size_t vertexCount, const MeshSimplifierLayout& layout, glm::vec3& outCenter, float& outRadius) {
+	const uint8_t* vertexData = static_cast<const uint8_t*>(vertices);
+	outCenter = glm::vec3(0.0f);
+	outRadius = 0.0f;
+	if (vertexCount == 0 || layout.PositionOffset < 0) {
+		return;
+	}
+
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+	for (uint32_t ix = 0; ix < vertexCount; ix++) {
+		const float* position = GetAttribute(vertexData, vertexStride, ix, layout.PositionOffset);
+		const glm::vec3 p(position[0], position[1], position[2]);
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	outCenter = (min + max) * 0.5f;
+
+	float radiusSq = 0.0f;
+	for (uint32_t ix = 0; ix < vertexCount; ix++) {
+		const float* position = GetAttribute(vertexData, vertexStride, ix, layout.PositionOffset);
+		const glm::vec3 delta = glm::vec3(position[0], position[1], position[2]) - outCenter;
+		radiusSq = std::max(radiusSq, glm::dot(delta, delta));
+	}
+	outRadius = std::sqrt(radiusSq);
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "MeshBuilder.h"
+#include "Graphics/MeshLodSet.h"
+
+/// <summary>
+/// Describes where the attributes the simplifier cares about are stored within a vertex, offsets are in
+/// bytes from the start of the vertex, or -1 if the vertex does not have that attribute
+/// </summary>
+struct MeshSimplifierLayout
+{
+	/// <summary>
+	/// The offset of the 3 component float position, this one is required
+	/// </summary>
+	int PositionOffset;
+	/// <summary>
+	/// The offset of the 3 component float normal
+	/// </summary>
+	int NormalOffset;
+	/// <summary>
+	/// The offset of the 2 component float texture coordinate
+	/// </summary>
+	int TextureOffset;
+
+	MeshSimplifierLayout() :
+		PositionOffset(-1),
+		NormalOffset(-1),
+		TextureOffset(-1)
+	{ }
+
+	/// <summary>
+	/// Finds the attribute offsets for a vertex type from its V_DECL
+	/// </summary>
+	template <typename VertType>
+	static MeshSimplifierLayout FromDecl() {
+		MeshSimplifierLayout result;
+		for (const BufferAttribute& attrib : VertType::V_DECL) {
+			if (attrib.Type != GL_FLOAT) {
+				continue;
+			}
+			if (attrib.Usage == AttribUsage::Position && attrib.Size >= 3 && result.PositionOffset < 0) {
+				result.PositionOffset = static_cast<int>(attrib.Offset);
+			} else if (attrib.Usage == AttribUsage::Normal && attrib.Size >= 3 && result.NormalOffset < 0) {
+				result.NormalOffset = static_cast<int>(attrib.Offset);
+			} else if (attrib.Usage == AttribUsage::Texture && attrib.Size >= 2 && result.TextureOffset < 0) {
+				result.TextureOffset = static_cast<int>(attrib.Offset);
+			}
+		}
+		return result;
+	}
+};
+
+/// <summary>
+/// The exact bit pattern of a position, used to weld together vertices that only differ by their attributes
+/// </summary>
+struct PositionKey
+{
+	uint32_t X, Y, Z;
+
+	bool operator==(const PositionKey& other) const {
+		return X == other.X && Y == other.Y && Z == other.Z;
+	}
+};
+struct PositionKeyHash
+{
+	size_t operator()(const PositionKey& key) const {
+		uint64_t hash = 14695981039346656037ull;
+		hash = (hash ^ key.X) * 1099511628211ull;
+		hash = (hash ^ key.Y) * 1099511628211ull;
+		hash = (hash ^ key.Z) * 1099511628211ull;
+		return static_cast<size_t>(hash);
+	}
+};
+
+/// <summary>
+/// Options that control how a chain of levels of detail is generated
+/// </summary>
+struct MeshLodOptions
+{
+	/// <summary>
+	/// The maximum number of levels to generate, including the full detail mesh
+	/// </summary>
+	size_t LevelCount;
+	/// <summary>
+	/// The fraction of triangles to keep for each level, relative to the level before it
+	/// </summary>
+	float  TriangleRatio;
+	/// <summary>
+	/// The largest error a level can have, relative to the radius of the mesh. Levels that can't reach their
+	/// triangle target without going past this are made as small as the error allows instead
+	/// </summary>
+	float  MaxError;
+	/// <summary>
+	/// The projected size (fraction of the viewport height) below which we switch to level 1. Each level
+	/// after that kicks in at half the size of the level before it, since it has roughly half the triangles
+	/// </summary>
+	float  FirstScreenSize;
+
+	MeshLodOptions() :
+		LevelCount(4),
+		TriangleRatio(0.5f),
+		MaxError(0.05f),
+		FirstScreenSize(0.25f)
+	{ }
+};
+
+/// <summary>
+/// Reduces the number of triangles in an indexed mesh using quadric error metrics (Garland and Heckbert,
+/// "Surface Simplification Using Quadric Error Metrics"). The simplifier only ever collapses vertices onto
+/// other existing vertices, so the simplified index buffers can all share the original vertex buffer
+/// </summary>
+class MeshSimplifier
+{
+public:
+	/// <summary>
+	/// Simplifies a triangle list, trying to reach the target index count without going over the target error
+	/// </summary>
+	/// <param name="destination">The buffer to store the result in, must have room for indexCount indices (can be the same as indices)</param>
+	/// <param name="indices">The triangle list to simplify</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertices">A pointer to the first vertex in the mesh</param>
+	/// <param name="vertexStride">The size of each vertex in bytes</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	/// <param name="layout">Where the positions, normals and texture coordinates are stored in each vertex</param>
+	/// <param name="targetIndexCount">The number of indices we'd like to end up with</param>
+	/// <param name="targetError">The maximum error allowed, relative to the radius of the mesh</param>
+	/// <param name="resultError">If not null, will be set to the largest error of any collapse that was made</param>
+	/// <returns>The number of indices written to destination</returns>
+	static size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+		const void* vertices, size_t vertexStride, size_t vertexCount, const MeshSimplifierLayout& layout,
+		size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	/// <summary>
+	/// Generates a chain of index buffers, one per level of detail. Each level is simplified from the one before
+	/// it and then optimized for the vertex cache. Level 0 is always a copy of the input indices
+	/// </summary>
+	/// <param name="mesh">The mesh to generate levels for</param>
+	/// <param name="options">The options for generating the levels</param>
+	/// <param name="outIndices">Will be filled with the index buffer for each level</param>
+	/// <param name="outErrors">Will be filled with the error for each level</param>
+	template <typename VertType>
+	static void GenerateLods(const MeshBuilder<VertType>& mesh, const MeshLodOptions& options,
+		std::vector<std::vector<uint32_t>>& outIndices, std::vector<float>& outErrors) {
+		GenerateLods(mesh.GetIndexDataPtr(), mesh.GetIndexCount(), mesh.GetVertexDataPtr(), sizeof(VertType), mesh.GetVertexCount(),
+			MeshSimplifierLayout::FromDecl<VertType>(), options, outIndices, outErrors);
+	}
+	static void GenerateLods(const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexStride, size_t vertexCount,
+		const MeshSimplifierLayout& layout, const MeshLodOptions& options,
+		std::vector<std::vector<uint32_t>>& outIndices, std::vector<float>& outErrors);
+
+	/// <summary>
+	/// Generates the levels of detail for a mesh and uploads them to the GPU. The vertices are uploaded once
+	/// and shared between all the levels, each level only gets its own index buffer
+	/// </summary>
+	/// <param name="mesh">The mesh to generate levels for</param>
+	/// <param name="options">The options for generating the levels</param>
+	/// <returns>A new LOD set containing the levels</returns>
+	template <typename VertType>
+	static MeshLodSet::sptr BakeLods(const MeshBuilder<VertType>& mesh, const MeshLodOptions& options = MeshLodOptions()) {
+		return BakeLods(mesh, mesh, options);
+	}
+	/// <summary>
+	/// Generates the levels of detail from one mesh, but uploads the vertices of another. This lets us simplify
+	/// using full precision positions and attributes, and then render with a packed copy of the same vertices
+	/// </summary>
+	/// <param name="mesh">The mesh to upload, must have the same vertices in the same order as source</param>
+	/// <param name="source">The mesh to generate levels for</param>
+	/// <param name="options">The options for generating the levels</param>
+	/// <returns>A new LOD set containing the levels</returns>
+	template <typename VertType, typename SourceType>
+	static MeshLodSet::sptr BakeLods(const MeshBuilder<VertType>& mesh, const MeshBuilder<SourceType>& source, const MeshLodOptions& options) {
+		std::vector<std::vector<uint32_t>> levels;
+		std::vector<float> errors;
+		GenerateLods(source, options, levels, errors);
+
+		glm::vec3 center;
+		float radius;
+		CalculateBounds(source.GetVertexDataPtr(), sizeof(SourceType), source.GetVertexCount(), MeshSimplifierLayout::FromDecl<SourceType>(), center, radius);
+		return UploadLods(mesh, levels, errors, center, radius, options);
+	}
+
+	/// <summary>
+	/// Uploads levels that were already generated with GenerateLods. This is split out from BakeLods so that
+	/// the simplification can happen on a worker thread, and only the upload on the thread that owns the context
+	/// </summary>
+	/// <param name="mesh">The mesh to upload the vertices of</param>
+	/// <param name="levels">The index buffers for each level</param>
+	/// <param name="errors">The error for each level</param>
+	/// <param name="center">The center of the mesh's bounding sphere</param>
+	/// <param name="radius">The radius of the mesh's bounding sphere</param>
+	/// <param name="options">The options the levels were generated with</param>
+	/// <returns>A new LOD set containing the levels</returns>
+	template <typename VertType>
+	static MeshLodSet::sptr UploadLods(const MeshBuilder<VertType>& mesh, const std::vector<std::vector<uint32_t>>& levels,
+		const std::vector<float>& errors, const glm::vec3& center, float radius, const MeshLodOptions& options) {
+		MeshLodSet::sptr result = MeshLodSet::Create();
+
+		VertexBuffer::sptr vbo = VertexBuffer::Create();
+		vbo->LoadData(mesh.GetVertexDataPtr(), mesh.GetVertexCount());
+
+		float screenSize = options.FirstScreenSize;
+		for (size_t ix = 0; ix < levels.size(); ix++) {
+			IndexBuffer::sptr ebo = IndexBuffer::Create();
+			ebo->LoadCompactData(levels[ix].data(), levels[ix].size(), mesh.GetVertexCount());
+
+			VertexArrayObject::sptr vao = VertexArrayObject::Create();
+			vao->AddVertexBuffer(vbo, VertType::V_DECL);
+			vao->SetIndexBuffer(ebo);
+			vao->SetVertexTransform(mesh.GetVertexTransform());
+
+			// The full detail mesh can be used at any size
+			if (ix == 0) {
+				result->AddLevel(vao, levels[ix].size() / 3, std::numeric_limits<float>::max(), errors[ix]);
+			} else {
+				result->AddLevel(vao, levels[ix].size() / 3, screenSize, errors[ix]);
+				screenSize *= 0.5f;
+			}
+		}
+
+		result->SetBounds(center, radius);
+		return result;
+	}
+
+	/// <summary>
+	/// Calculates a bounding sphere for a set of vertices, centered on their bounding box
+	/// </summary>
+	static void CalculateBounds(const void* vertices, size_t vertexStride, size_t vertexCount, const MeshSimplifierLayout& layout, glm::vec3& outCenter, float& outRadius);
+
+protected:
+	MeshSimplifier() = default;
+	~MeshSimplifier() = default;
+};
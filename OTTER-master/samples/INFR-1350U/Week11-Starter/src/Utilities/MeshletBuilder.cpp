@@ -0,0 +1,251 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <GLM/glm.hpp>
+
+#include "FlatHashMap.h"
+#include "Logging.h"
+
+// Meshlets whose normals are spread further than this from the cone axis (cos of ~84 degrees) can face the
+// camera from almost anywhere, so we don't bother testing their cones at all
+static constexpr float MeshletMinConeDot = 0.1f;
+
+/// <summary>
+/// Reads the position of a vertex out of an interleaved vertex buffer
+/// </summary>
+inline glm::vec3 ReadMeshletPosition(const uint8_t* vertices, size_t vertexStride, const MeshSimplifierLayout& layout, uint32_t index) {
+	glm::vec3 result;
+	memcpy(&result, vertices + vertexStride * index + layout.PositionOffset, sizeof(glm::vec3));
+	return result;
+}
+
+/// <summary>
+/// Calculates the bounding sphere and normal cone of a meshlet from its triangles
+/// </summary>
+void CalculateMeshletBounds(Meshlet& meshlet, const std::vector<uint32_t>& triangles, const uint32_t* indices,
+	const uint8_t* vertices, size_t vertexStride, const MeshSimplifierLayout& layout, const std::vector<glm::vec3>& normals)
+{
+	// The sphere is centered on the bounding box, like MeshSimplifier::CalculateBounds
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+	glm::vec3 normalSum = glm::vec3(0.0f);
+	for (uint32_t tri : triangles) {
+		for (int ix = 0; ix < 3; ix++) {
+			const glm::vec3 pos = ReadMeshletPosition(vertices, vertexStride, layout, indices[tri * 3 + ix]);
+			min = glm::min(min, pos);
+			max = glm::max(max, pos);
+		}
+		normalSum += normals[tri];
+	}
+	meshlet.Center = (min + max) * 0.5f;
+	float radiusSq = 0.0f;
+	for (uint32_t tri : triangles) {
+		for (int ix = 0; ix < 3; ix++) {
+			const glm::vec3 offset = ReadMeshletPosition(vertices, vertexStride, layout, indices[tri * 3 + ix]) - meshlet.Center;
+			radiusSq = std::max(radiusSq, glm::dot(offset, offset));
+		}
+	}
+	meshlet.Radius = std::sqrt(radiusSq);
+
+	// The cone axis is the average normal, and the cutoff comes from the normal that is furthest from it
+	meshlet.ConeAxis = glm::vec3(0.0f);
+	meshlet.ConeCutoff = 1.0f;
+	const float axisLength = glm::length(normalSum);
+	if (axisLength <= 0.0f) {
+		return;
+	}
+	const glm::vec3 axis = normalSum / axisLength;
+	float minDot = 1.0f;
+	for (uint32_t tri : triangles) {
+		// Degenerate triangles have no normal, and can never be seen anyways
+		if (normals[tri] != glm::vec3(0.0f)) {
+			minDot = std::min(minDot, glm::dot(normals[tri], axis));
+		}
+	}
+	if (minDot > MeshletMinConeDot) {
+		meshlet.ConeAxis = axis;
+		meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+void MeshletBuilder::Build(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const void* vertices, size_t vertexStride, size_t vertexCount, const MeshSimplifierLayout& layout,
+	const MeshletOptions& options, std::vector<Meshlet>& outMeshlets)
+{
+	LOG_ASSERT(layout.PositionOffset >= 0, "Meshlets need a 3 component float position!");
+	LOG_ASSERT(indexCount % 3 == 0, "Meshlets can only be built from triangle lists!");
+
+	outMeshlets.clear();
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0) {
+		return;
+	}
+	const size_t maxTriangles = std::max(options.MaxTriangles, 1u);
+	const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+
+	// The destination may be the same buffer as the indices, so we work from a copy
+	const std::vector<uint32_t> source(indices, indices + indexCount);
+
+	// The centroids and unit normals of every triangle, used to score which triangle to add to a meshlet next
+	std::vector<glm::vec3> centroids(triCount);
+	std::vector<glm::vec3> normals(triCount);
+	for (size_t tri = 0; tri < triCount; tri++) {
+		const glm::vec3 a = ReadMeshletPosition(vertexBytes, vertexStride, layout, source[tri * 3 + 0]);
+		const glm::vec3 b = ReadMeshletPosition(vertexBytes, vertexStride, layout, source[tri * 3 + 1]);
+		const glm::vec3 c = ReadMeshletPosition(vertexBytes, vertexStride, layout, source[tri * 3 + 2]);
+		centroids[tri] = (a + b + c) / 3.0f;
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const float length = glm::length(normal);
+		normals[tri] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+	}
+
+	// Vertices that only differ by their attributes (ex: along UV seams or hard edges) still connect their
+	// triangles, so adjacency is tracked between welded positions rather than between indices
+	std::vector<uint32_t> weld(vertexCount);
+	{
+		FlatHashMap<PositionKey, uint32_t, PositionKeyHash> welded;
+		welded.Reserve(vertexCount);
+		for (uint32_t ix = 0; ix < vertexCount; ix++) {
+			PositionKey key;
+			memcpy(&key, vertexBytes + vertexStride * ix + layout.PositionOffset, sizeof(PositionKey));
+			weld[ix] = *welded.TryEmplace(key, ix).first;
+		}
+	}
+	std::vector<uint32_t> welded(indexCount);
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		welded[ix] = weld[source[ix]];
+	}
+
+	// The triangles that use each welded vertex, stored as one flat list with an offset per vertex
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t index : welded) {
+		adjacencyOffsets[index + 1]++;
+	}
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] += adjacencyOffsets[ix];
+	}
+	std::vector<uint32_t> adjacency(indexCount);
+	{
+		std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t ix = 0; ix < indexCount; ix++) {
+			adjacency[cursor[welded[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+	}
+
+	// Stamps store the ID of the meshlet that last touched a vertex or triangle, so we never need to clear them
+	constexpr uint32_t NoMeshlet = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> vertexStamps(vertexCount, NoMeshlet);
+	std::vector<uint32_t> candidateStamps(triCount, NoMeshlet);
+	std::vector<bool>     emitted(triCount, false);
+
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> triangles;
+	candidates.reserve(maxTriangles * 8);
+	triangles.reserve(maxTriangles);
+
+	size_t written = 0;
+	size_t nextUnused = 0;
+	uint32_t seed = NoMeshlet;
+	while (written < triCount) {
+		const uint32_t id = static_cast<uint32_t>(outMeshlets.size());
+		candidates.clear();
+		triangles.clear();
+		glm::vec3 centroidSum = glm::vec3(0.0f);
+		glm::vec3 normalSum = glm::vec3(0.0f);
+
+		// Adds a triangle to the meshlet, and makes every unused triangle that shares a vertex with it a candidate
+		auto addTriangle = [&](uint32_t tri) {
+			emitted[tri] = true;
+			triangles.push_back(tri);
+			centroidSum += centroids[tri];
+			normalSum += normals[tri];
+			for (int ix = 0; ix < 3; ix++) {
+				const uint32_t vertex = welded[tri * 3 + ix];
+				if (vertexStamps[vertex] == id) {
+					continue;
+				}
+				vertexStamps[vertex] = id;
+				for (uint32_t adj = adjacencyOffsets[vertex]; adj < adjacencyOffsets[vertex + 1]; adj++) {
+					const uint32_t other = adjacency[adj];
+					if (!emitted[other] && candidateStamps[other] != id) {
+						candidateStamps[other] = id;
+						candidates.push_back(other);
+					}
+				}
+			}
+		};
+
+		// Start from next to the last meshlet if we can, otherwise from the first triangle we haven't used yet
+		if (seed == NoMeshlet) {
+			while (emitted[nextUnused]) {
+				nextUnused++;
+			}
+			seed = static_cast<uint32_t>(nextUnused);
+		}
+		addTriangle(seed);
+
+		// Grow the meshlet one triangle at a time. We prefer triangles that add the fewest new vertices (keeping the
+		// meshlet a connected patch), then the ones closest to the meshlet whose normals agree with it the most
+		while (triangles.size() < maxTriangles && !candidates.empty()) {
+			const glm::vec3 center = centroidSum / static_cast<float>(triangles.size());
+			const float axisLength = glm::length(normalSum);
+			const glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+
+			size_t best = 0;
+			int bestNewVerts = 4;
+			float bestCost = std::numeric_limits<float>::max();
+			for (size_t ix = 0; ix < candidates.size(); ix++) {
+				const uint32_t tri = candidates[ix];
+				int newVerts = 0;
+				for (int jx = 0; jx < 3; jx++) {
+					newVerts += vertexStamps[welded[tri * 3 + jx]] != id ? 1 : 0;
+				}
+				if (newVerts > bestNewVerts) {
+					continue;
+				}
+				const float spread = 1.0f - glm::dot(normals[tri], axis);
+				const float cost = glm::length(centroids[tri] - center) * (1.0f + options.ConeWeight * spread);
+				if (newVerts < bestNewVerts || cost < bestCost) {
+					best = ix;
+					bestNewVerts = newVerts;
+					bestCost = cost;
+				}
+			}
+
+			const uint32_t tri = candidates[best];
+			candidates[best] = candidates.back();
+			candidates.pop_back();
+			addTriangle(tri);
+		}
+
+		// Write the meshlet out
+		Meshlet meshlet;
+		meshlet.IndexOffset = static_cast<uint32_t>(written * 3);
+		meshlet.IndexCount = static_cast<uint32_t>(triangles.size() * 3);
+		CalculateMeshletBounds(meshlet, triangles, source.data(), vertexBytes, vertexStride, layout, normals);
+		for (uint32_t tri : triangles) {
+			destination[written * 3 + 0] = source[tri * 3 + 0];
+			destination[written * 3 + 1] = source[tri * 3 + 1];
+			destination[written * 3 + 2] = source[tri * 3 + 2];
+			written++;
+		}
+		outMeshlets.push_back(meshlet);
+
+		// The next meshlet starts from the leftover candidate closest to this one, so neighbouring meshlets end
+		// up next to each other in the index buffer (and visible runs of them can be merged into one draw)
+		seed = NoMeshlet;
+		const glm::vec3 center = centroidSum / static_cast<float>(triangles.size());
+		float bestDistance = std::numeric_limits<float>::max();
+		for (uint32_t tri : candidates) {
+			const glm::vec3 offset = centroids[tri] - center;
+			const float distance = glm::dot(offset, offset);
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				seed = tri;
+			}
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "MeshBuilder.h"
+#include "MeshSimplifier.h"
+#include "Graphics/MeshletSet.h"
+
+/// <summary>
+/// Options that control how meshes are split into meshlets
+/// </summary>
+struct MeshletOptions
+{
+	/// <summary>
+	/// The largest number of triangles in a meshlet. Smaller meshlets cull more precisely, but cost more to test
+	/// and draw, 64 to 128 is a good range
+	/// </summary>
+	uint32_t MaxTriangles;
+	/// <summary>
+	/// How much we care about keeping the normals in a meshlet close together (for backface culling) versus keeping
+	/// the meshlet compact (for frustum culling). 0 only looks at distance
+	/// </summary>
+	float    ConeWeight;
+
+	MeshletOptions() :
+		MaxTriangles(128),
+		ConeWeight(0.5f)
+	{ }
+};
+
+/// <summary>
+/// Splits indexed meshes into meshlets, small clusters of neighbouring triangles that each get a bounding sphere
+/// and a normal cone so they can be culled on their own (see MeshletSet). The triangles are reordered so that
+/// every meshlet is a contiguous range of the index buffer, the vertices are left untouched
+/// </summary>
+class MeshletBuilder
+{
+public:
+	/// <summary>
+	/// Groups the triangles of a mesh into meshlets
+	/// </summary>
+	/// <param name="destination">The buffer to store the reordered indices in, must have room for indexCount indices (can be the same as indices)</param>
+	/// <param name="indices">The triangle list to split up</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertices">A pointer to the first vertex in the mesh</param>
+	/// <param name="vertexStride">The size of each vertex in bytes</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	/// <param name="layout">Where the positions are stored in each vertex, only the position is used</param>
+	/// <param name="options">The options for building the meshlets</param>
+	/// <param name="outMeshlets">Will be filled with the meshlets, in the order they appear in destination</param>
+	static void Build(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+		const void* vertices, size_t vertexStride, size_t vertexCount, const MeshSimplifierLayout& layout,
+		const MeshletOptions& options, std::vector<Meshlet>& outMeshlets);
+
+	/// <summary>
+	/// Reorders the triangles of a mesh into meshlets in-place. Run this after MeshOptimizer, since the vertex
+	/// cache pass would scatter the meshlets again
+	/// </summary>
+	/// <param name="mesh">The mesh to split up</param>
+	/// <param name="options">The options for building the meshlets</param>
+	/// <param name="outMeshlets">Will be filled with the meshlets</param>
+	template <typename VertType>
+	static void Build(MeshBuilder<VertType>& mesh, const MeshletOptions& options, std::vector<Meshlet>& outMeshlets) {
+		Build(mesh._indices.data(), mesh._indices.data(), mesh._indices.size(),
+			mesh._vertices.data(), sizeof(VertType), mesh._vertices.size(),
+			MeshSimplifierLayout::FromDecl<VertType>(), options, outMeshlets);
+	}
+
+	/// <summary>
+	/// Uploads a mesh that was already split with Build, and wraps it in a meshlet set
+	/// </summary>
+	/// <param name="mesh">The mesh to upload</param>
+	/// <param name="meshlets">The meshlets that Build generated for the mesh</param>
+	/// <returns>A new meshlet set for the mesh</returns>
+	template <typename VertType>
+	static MeshletSet::sptr Bake(const MeshBuilder<VertType>& mesh, const std::vector<Meshlet>& meshlets) {
+		MeshletSet::sptr result = MeshletSet::Create();
+		result->SetMesh(mesh.Bake(), meshlets);
+		return result;
+	}
+
+protected:
+	MeshletBuilder() = default;
+	~MeshletBuilder() = default;
+};
@@ -0,0 +1,223 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <thread>
+
+#include "Logging.h"
+#include "ParallelFor.h"
+
+// The Kaiser filter's radius (in texels of the smaller level) and shape, these are what most texture tools default to
+static constexpr float KaiserWidth = 3.0f;
+static constexpr float KaiserAlpha = 4.0f;
+static constexpr float MipPi = 3.14159265358979f;
+
+/// <summary>
+/// Lookup tables for converting between 8 bit sRGB and linear values
+/// </summary>
+struct SrgbTables
+{
+	float   ToLinear[256];
+	// Indexed by a linear value scaled up to 0-4095, which is fine enough that every sRGB value can be reached
+	uint8_t FromLinear[4096];
+
+	SrgbTables() {
+		for (int ix = 0; ix < 256; ix++) {
+			const float value = ix / 255.0f;
+			ToLinear[ix] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int ix = 0; ix < 4096; ix++) {
+			const float value = ix / 4095.0f;
+			const float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+			FromLinear[ix] = static_cast<uint8_t>(std::lround(std::clamp(srgb, 0.0f, 1.0f) * 255.0f));
+		}
+	}
+};
+
+/// <summary>
+/// Gets the sRGB tables, they get built the first time they are needed
+/// </summary>
+inline const SrgbTables& GetSrgbTables() {
+	static const SrgbTables tables;
+	return tables;
+}
+
+/// <summary>
+/// The zeroth order modified Bessel function of the first kind, which the Kaiser window is built from
+/// </summary>
+inline float BesselI0(float x) {
+	float result = 1.0f;
+	float term = 1.0f;
+	for (int k = 1; k < 25; k++) {
+		const float factor = x / (2.0f * k);
+		term *= factor * factor;
+		result += term;
+		if (term < result * 1e-7f) {
+			break;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Gets the weight of a source texel that is x texels (of the smaller level) away from the centre of the result texel
+/// </summary>
+inline float EvaluateMipFilter(float x, bool kaiser) {
+	if (!kaiser) {
+		return std::abs(x) <= 0.5f ? 1.0f : 0.0f;
+	}
+	if (std::abs(x) >= KaiserWidth) {
+		return 0.0f;
+	}
+	const float sinc = x == 0.0f ? 1.0f : std::sin(MipPi * x) / (MipPi * x);
+	const float t = x / KaiserWidth;
+	return sinc * BesselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(KaiserAlpha);
+}
+
+/// <summary>
+/// The source texels (and their weights) that make up each result texel along one axis
+/// </summary>
+struct MipFilterTaps
+{
+	// The number of taps for every result texel
+	uint32_t              Count;
+	std::vector<uint32_t> Indices;
+	std::vector<float>    Weights;
+};
+
+/// <summary>
+/// Works out which source texels each result texel is filtered from, clamping the taps that fall off the edge
+/// </summary>
+inline void BuildMipFilterTaps(uint32_t sourceSize, uint32_t resultSize, bool kaiser, MipFilterTaps& taps) {
+	const float scale = static_cast<float>(sourceSize) / resultSize;
+	const float radius = (kaiser ? KaiserWidth : 0.5f) * scale;
+	taps.Count = static_cast<uint32_t>(std::ceil(radius * 2.0f)) + 1;
+	taps.Indices.resize((size_t)taps.Count * resultSize);
+	taps.Weights.resize((size_t)taps.Count * resultSize);
+	for (uint32_t ix = 0; ix < resultSize; ix++) {
+		const float center = (ix + 0.5f) * scale;
+		const int first = static_cast<int>(std::floor(center - radius));
+		float sum = 0.0f;
+		for (uint32_t tap = 0; tap < taps.Count; tap++) {
+			const int source = first + static_cast<int>(tap);
+			const float weight = EvaluateMipFilter((source + 0.5f - center) / scale, kaiser);
+			taps.Indices[ix * taps.Count + tap] = static_cast<uint32_t>(std::clamp(source, 0, static_cast<int>(sourceSize) - 1));
+			taps.Weights[ix * taps.Count + tap] = weight;
+			sum += weight;
+		}
+		for (uint32_t tap = 0; tap < taps.Count; tap++) {
+			taps.Weights[ix * taps.Count + tap] /= sum;
+		}
+	}
+}
+
+/// <summary>
+/// Gets the number of threads to filter a level with
+/// </summary>
+inline size_t GetMipThreadCount(uint32_t threadCount, size_t rows) {
+	const size_t threads = threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	return std::min(threads, rows / MipGenerator::MinRowsPerThread + 1);
+}
+
+MipGenerationOptions MipGenerator::GetDefaultOptions(const std::string& path) {
+	std::string name = std::filesystem::path(path).filename().string();
+	std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+	MipGenerationOptions result;
+	result.GammaCorrect = name.find("normal") == std::string::npos;
+	return result;
+}
+
+std::vector<Texture2DLevel> MipGenerator::GetLevelLayout(uint32_t width, uint32_t height, size_t texelSize) {
+	std::vector<Texture2DLevel> result;
+	result.reserve(GetMipLevelCount(width, height));
+	size_t offset = 0;
+	for (uint32_t level = 0; level < GetMipLevelCount(width, height); level++) {
+		const uint32_t levelWidth = std::max(width >> level, 1u);
+		const uint32_t levelHeight = std::max(height >> level, 1u);
+		const size_t size = (size_t)levelWidth * levelHeight * texelSize;
+		result.push_back({ levelWidth, levelHeight, offset, size });
+		offset += size;
+	}
+	return result;
+}
+
+void MipGenerator::Generate(uint8_t* data, const std::vector<Texture2DLevel>& levels, int channels, const MipGenerationOptions& options) {
+	LOG_ASSERT(channels >= 1 && channels <= 4, "Images need between 1 and 4 channels, got {}", channels);
+	if (levels.size() < 2) {
+		return;
+	}
+
+	// Only the colour channels get gamma corrected, alpha (and the channels of 1 or 2 channel images) is always data
+	const SrgbTables& tables = GetSrgbTables();
+	const int gammaChannels = options.GammaCorrect && channels >= 3 ? 3 : 0;
+
+	// The working copy of the level we're filtering from
+	std::vector<float> current((size_t)levels[0].Width * levels[0].Height * channels);
+	for (size_t ix = 0; ix < current.size(); ix++) {
+		const uint8_t value = data[levels[0].Offset + ix];
+		current[ix] = (int)(ix % channels) < gammaChannels ? tables.ToLinear[value] : value / 255.0f;
+	}
+
+	std::vector<float> horizontal;
+	std::vector<float> next;
+	MipFilterTaps tapsX, tapsY;
+	for (size_t level = 1; level < levels.size(); level++) {
+		const Texture2DLevel& source = levels[level - 1];
+		const Texture2DLevel& result = levels[level];
+		BuildMipFilterTaps(source.Width, result.Width, options.UseKaiser, tapsX);
+		BuildMipFilterTaps(source.Height, result.Height, options.UseKaiser, tapsY);
+		const size_t sourceStride = (size_t)source.Width * channels;
+		const size_t resultStride = (size_t)result.Width * channels;
+		horizontal.assign(resultStride * source.Height, 0.0f);
+		next.assign(resultStride * result.Height, 0.0f);
+
+		// Filter every source row down to the new width
+		const size_t rowThreads = GetMipThreadCount(options.ThreadCount, source.Height);
+		ParallelFor(rowThreads, [&](size_t chunk) {
+			const size_t end = source.Height * (chunk + 1) / rowThreads;
+			for (size_t y = source.Height * chunk / rowThreads; y < end; y++) {
+				const float* sourceRow = current.data() + y * sourceStride;
+				float* resultRow = horizontal.data() + y * resultStride;
+				for (uint32_t x = 0; x < result.Width; x++) {
+					for (uint32_t tap = 0; tap < tapsX.Count; tap++) {
+						const float weight = tapsX.Weights[x * tapsX.Count + tap];
+						const float* texel = sourceRow + (size_t)tapsX.Indices[x * tapsX.Count + tap] * channels;
+						for (int c = 0; c < channels; c++) {
+							resultRow[x * channels + c] += weight * texel[c];
+						}
+					}
+				}
+			}
+		});
+
+		// Then blend whole rows together for the new height, and write the result out
+		uint8_t* output = data + result.Offset;
+		const size_t columnThreads = GetMipThreadCount(options.ThreadCount, result.Height);
+		ParallelFor(columnThreads, [&](size_t chunk) {
+			const size_t end = result.Height * (chunk + 1) / columnThreads;
+			for (size_t y = result.Height * chunk / columnThreads; y < end; y++) {
+				float* resultRow = next.data() + y * resultStride;
+				for (uint32_t tap = 0; tap < tapsY.Count; tap++) {
+					const float weight = tapsY.Weights[y * tapsY.Count + tap];
+					const float* sourceRow = horizontal.data() + (size_t)tapsY.Indices[y * tapsY.Count + tap] * resultStride;
+					for (size_t ix = 0; ix < resultStride; ix++) {
+						resultRow[ix] += weight * sourceRow[ix];
+					}
+				}
+				// The Kaiser filter's negative lobes can overshoot, so we clamp before storing
+				for (size_t ix = 0; ix < resultStride; ix++) {
+					const float value = std::clamp(resultRow[ix], 0.0f, 1.0f);
+					resultRow[ix] = value;
+					output[y * resultStride + ix] = (int)(ix % channels) < gammaChannels ?
+						tables.FromLinear[static_cast<int>(value * 4095.0f + 0.5f)] :
+						static_cast<uint8_t>(value * 255.0f + 0.5f);
+				}
+			}
+		});
+
+		current.swap(next);
+	}
+}
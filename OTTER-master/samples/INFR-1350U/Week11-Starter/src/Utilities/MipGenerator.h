@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Graphics/Texture2DData.h"
+
+/// <summary>
+/// Options that control how MipGenerator filters each level down to the next
+/// </summary>
+struct MipGenerationOptions
+{
+	/// <summary>
+	/// True to filter the RGB channels of 3 and 4 channel images in linear space, since they store sRGB colours.
+	/// Should be false for images that store data instead of colours (ex: normal maps), see MipGenerator::GetDefaultOptions
+	/// </summary>
+	bool     GammaCorrect;
+	/// <summary>
+	/// True to use a Kaiser windowed sinc filter, which keeps distant surfaces sharper. False uses a 2x2 box filter,
+	/// which is faster but blurrier
+	/// </summary>
+	bool     UseKaiser;
+	/// <summary>
+	/// The number of threads to filter each level with, 0 will use one per hardware thread
+	/// </summary>
+	uint32_t ThreadCount;
+
+	MipGenerationOptions() :
+		GammaCorrect(true),
+		UseKaiser(true),
+		ThreadCount(0)
+	{ }
+};
+
+/// <summary>
+/// Builds mip chains for 8 bit images on the CPU, so they can be stored with cooked textures or uploaded level by
+/// level instead of relying on glGenerateTextureMipmap (which uses a plain box filter in gamma space on most drivers).
+/// Each level is filtered from the one above it, using a linear floating point copy so that rounding doesn't build
+/// up over the chain. The filter is separable, and the vertical pass blends whole rows at a time so the compiler can
+/// vectorize it
+/// </summary>
+class MipGenerator
+{
+public:
+	/// <summary>
+	/// The fewest output rows each thread should get, smaller levels use fewer threads
+	/// </summary>
+	static constexpr size_t MinRowsPerThread = 32;
+
+	/// <summary>
+	/// Gets the options to use for an image file. Images that look like normal maps from their name (ex:
+	/// "Stone_001_Normal.png") are filtered without gamma correction
+	/// </summary>
+	/// <param name="path">The path of the image</param>
+	static MipGenerationOptions GetDefaultOptions(const std::string& path);
+
+	/// <summary>
+	/// Lays out the full mip chain of an uncompressed image back to back, largest level first
+	/// </summary>
+	/// <param name="width">The width of the top level, in texels</param>
+	/// <param name="height">The height of the top level, in texels</param>
+	/// <param name="texelSize">The size of a single texel, in bytes</param>
+	static std::vector<Texture2DLevel> GetLevelLayout(uint32_t width, uint32_t height, size_t texelSize);
+
+	/// <summary>
+	/// Fills in every level below the first of an 8 bit image
+	/// </summary>
+	/// <param name="data">The buffer holding the chain, with the top level already filled in</param>
+	/// <param name="levels">Where each level is in the buffer, see GetLevelLayout</param>
+	/// <param name="channels">The number of 8 bit channels in each texel, from 1 to 4</param>
+	/// <param name="options">The options for filtering the levels</param>
+	static void Generate(uint8_t* data, const std::vector<Texture2DLevel>& levels, int channels, const MipGenerationOptions& options = MipGenerationOptions());
+
+protected:
+	MipGenerator() = default;
+	~MipGenerator() = default;
+};
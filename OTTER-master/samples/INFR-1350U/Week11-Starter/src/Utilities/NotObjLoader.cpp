@@ -1,112 +1,168 @@
 #include "NotObjLoader.h"
 
 #include <string>
-#include <sstream>
-#include <fstream>
-#include <iostream>
+#include <unordered_map>
 
-#include "StringUtils.h"
+#include "Logging.h"
+#include "TextTokenizer.h"
+#include "VirtualFileSystem.h"
+
+/// <summary>
+/// Bump this whenever the loader starts producing different meshes, so that stale cooked files get rebuilt
+/// </summary>
+constexpr uint32_t NotObjOutputVersion = 1;
+
+typedef MeshBuilder<VertexPosNormTexCol> NotObjMesh;
+
+/// <summary>
+/// Reads 3 floats from the current line, missing components are left as is
+/// </summary>
+inline void ReadNotObjVec3(TextTokenizer& tok, glm::vec3& result) {
+	tok.ReadFloat(result.x);
+	tok.ReadFloat(result.y);
+	tok.ReadFloat(result.z);
+}
+
+/// <summary>
+/// Reads the optional color at the end of a primitive line, either RGB or RGBA. Missing values default to 1
+/// </summary>
+inline glm::vec4 ReadNotObjColor(TextTokenizer& tok) {
+	glm::vec4 color = glm::vec4(1.0f);
+	if (tok.ReadFloat(color.r)) {
+		tok.ReadFloat(color.g);
+		tok.ReadFloat(color.b);
+		tok.ReadFloat(color.a);
+	}
+	return color;
+}
+
+/// <summary>
+/// Copies a unit sphere that was generated around the origin into the mesh, moving it to the given center and
+/// stretching it by the given radii. MeshFactory calculates sphere positions as center + (normal * radii) with the
+/// normals not depending on either, so the result is identical to generating the sphere in place
+/// </summary>
+void AppendNotObjSphere(NotObjMesh& mesh, const NotObjMesh& shape, const glm::vec3& center, const glm::vec3& radii, const glm::vec4& col) {
+	const uint32_t offset = static_cast<uint32_t>(mesh.GetVertexCount());
+	mesh.ReserveVertexSpace(shape.GetVertexCount());
+	mesh.ReserveIndexSpace(shape.GetIndexCount());
+
+	const VertexPosNormTexCol* vertices = shape.GetVertexDataPtr();
+	for (size_t ix = 0; ix < shape.GetVertexCount(); ix++) {
+		const VertexPosNormTexCol& vert = vertices[ix];
+		mesh.AddVertex(center + (vert.Normal * radii), vert.Normal, vert.UV, col);
+	}
+	const uint32_t* indices = shape.GetIndexDataPtr();
+	for (size_t ix = 0; ix < shape.GetIndexCount(); ix++) {
+		mesh.AddIndex(offset + indices[ix]);
+	}
+}
+
+uint64_t NotObjLoadOptions::GetOutputHash() const {
+	// ReusePrimitives produces the same mesh either way, so only the format version matters
+	return MeshCache::Hash(&NotObjOutputVersion, sizeof(uint32_t));
+}
 
 VertexArrayObject::sptr NotObjLoader::LoadFromFile(const std::string& filename)
 {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	return LoadFromFile(filename, NotObjLoadOptions());
+}
+
+VertexArrayObject::sptr NotObjLoader::LoadFromFile(const std::string& filename, const NotObjLoadOptions& options)
+{
+	// If we've already baked this file, we can skip parsing and generating the primitives entirely
+	if (options.UseCache) {
+		VertexArrayObject::sptr cooked = MeshCache::TryLoad(filename, options.GetOutputHash());
+		if (cooked != nullptr) {
+			return cooked;
+		}
+	}
+
+	NotObjMesh mesh;
+	LoadMeshData(filename, mesh, options);
+
+	if (options.UseCache) {
+		MeshCache::Store(filename, options.GetOutputHash(), mesh);
+	}
+	return mesh.Bake();
+}
+
+void NotObjLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const NotObjLoadOptions& options)
+{
+	VfsFile file(filename);
 
 	// If our file fails to open, we will throw an error
-	if (!file) {
+	if (!file.IsOpen()) {
 		throw std::runtime_error("Failed to open file");
 	}
 
-	MeshBuilder<VertexPosNormTexCol> mesh;
-	std::string line;
-	
-	// Iterate as long as there is content to read
-	while (std::getline(file, line)) {
-		trim(line);
-		if (line.substr(0, 1) == "#")
-		{
-			// Comment, no-op
+	// Spheres are the only primitives that are expensive to generate, so we generate each shape once at unit
+	// size around the origin, keyed by (mode << 32 | tessellation), and copy it for every sphere that uses it
+	std::unordered_map<uint64_t, NotObjMesh> sphereShapes;
+
+	TextTokenizer tok(file.GetData(), file.GetEnd());
+	while (!tok.IsEOF()) {
+		const std::string_view command = tok.ReadToken();
+
+		if (command.empty() || command[0] == '#') {
+			// Blank line or comment, no-op
 		}
-		else if (line.substr(0, 5) == "cube ") // We can do equality check this way since the left side is a string and not a char*
-		{
-			std::istringstream ss = std::istringstream(line.substr(5));
-			glm::vec3 pos;
-			ss >> pos.x >> pos.y >> pos.z;
-			
-			glm::vec3 scale;
-			ss >> scale.x >> scale.y >> scale.z;
-			
-			glm::vec3 eulerDeg;
-			ss >> eulerDeg.x >> eulerDeg.y >> eulerDeg.z;
-			
-			glm::vec4 color = glm::vec4(1.0f);
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.r >> color.g >> color.b;
-			}
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.a;
-			}
+		else if (command == "cube") {
+			glm::vec3 pos = glm::vec3(0.0f), scale = glm::vec3(0.0f), eulerDeg = glm::vec3(0.0f);
+			ReadNotObjVec3(tok, pos);
+			ReadNotObjVec3(tok, scale);
+			ReadNotObjVec3(tok, eulerDeg);
+			const glm::vec4 color = ReadNotObjColor(tok);
 
 			MeshFactory::AddCube(mesh, pos, scale, eulerDeg, color);
-			
 		}
-		else if (line.substr(0, 6) == "plane ")
-		{
-			std::istringstream ss = std::istringstream(line.substr(6));
-			glm::vec3 pos;
-			ss >> pos.x >> pos.y >> pos.z;
-			glm::vec3 normal;
-			ss >> normal.x >> normal.y >> normal.z;
-			glm::vec3 tangent;
-			ss >> tangent.x >> tangent.y >> tangent.z;
-			glm::vec2 size;
-			ss >> size.x >> size.y;
-			glm::vec4 color = glm::vec4(1.0f);
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.r >> color.g >> color.b;
-			}
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.a;
-			}
-			
+		else if (command == "plane") {
+			glm::vec3 pos = glm::vec3(0.0f), normal = glm::vec3(0.0f), tangent = glm::vec3(0.0f);
+			glm::vec2 size = glm::vec2(0.0f);
+			ReadNotObjVec3(tok, pos);
+			ReadNotObjVec3(tok, normal);
+			ReadNotObjVec3(tok, tangent);
+			tok.ReadFloat(size.x);
+			tok.ReadFloat(size.y);
+			const glm::vec4 color = ReadNotObjColor(tok);
+
 			MeshFactory::AddPlane(mesh, pos, normal, tangent, size, color);
 		}
-		else if (line.substr(0, 7) == "sphere ")
-		{
-			std::istringstream ss = std::istringstream(line.substr(7));
-
-			std::string mode;
-			ss >> mode;
-
-			int tesselation = 0;
-			ss >> tesselation;
+		else if (command == "sphere") {
+			const std::string_view mode = tok.ReadToken();
+			int32_t tessellation = 0;
+			tok.ReadInt(tessellation);
 
-			glm::vec3 pos;
-			ss >> pos.x >> pos.y >> pos.z;
+			glm::vec3 pos = glm::vec3(0.0f), radii = glm::vec3(0.0f);
+			ReadNotObjVec3(tok, pos);
+			ReadNotObjVec3(tok, radii);
+			const glm::vec4 color = ReadNotObjColor(tok);
 
-			glm::vec3 radii;
-			ss >> radii.x >> radii.y >> radii.z;
-			
-			glm::vec4 color = glm::vec4(1.0f);
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.r >> color.g >> color.b;
+			const bool isIco = mode == "ico";
+			if (!isIco && mode != "uv") {
+				LOG_WARN("Unknown sphere mode \"{}\" in \"{}\", skipping", std::string(mode), filename);
 			}
-			if (ss.rdbuf()->in_avail() > 0) {
-				ss >> color.a;
+			else if (!options.ReusePrimitives) {
+				if (isIco) {
+					MeshFactory::AddIcoSphere(mesh, pos, radii, tessellation, color);
+				} else {
+					MeshFactory::AddUvSphere(mesh, pos, radii, tessellation, color);
+				}
 			}
-						
-			if (mode == "ico") {
-				MeshFactory::AddIcoSphere(mesh, pos, radii, tesselation, color);
-			} else if (mode == "uv") {
-				MeshFactory::AddUvSphere(mesh, pos, radii, tesselation, color);
+			else {
+				const uint64_t key = (static_cast<uint64_t>(isIco) << 32) | static_cast<uint32_t>(tessellation);
+				auto it = sphereShapes.find(key);
+				if (it == sphereShapes.end()) {
+					it = sphereShapes.emplace(key, NotObjMesh()).first;
+					if (isIco) {
+						MeshFactory::AddIcoSphere(it->second, glm::vec3(0.0f), glm::vec3(1.0f), tessellation, glm::vec4(1.0f));
+					} else {
+						MeshFactory::AddUvSphere(it->second, glm::vec3(0.0f), glm::vec3(1.0f), tessellation, glm::vec4(1.0f));
+					}
+				}
+				AppendNotObjSphere(mesh, it->second, pos, radii, color);
 			}
 		}
-	}
-
-	// Note: with actual OBJ files you're going to run into the issue where faces are composited of different indices
-	// You'll need to keep track of these and create vertex entries for each vertex in the face
-	// If you want to get fancy, you can track which vertices you've already added
 
-	return mesh.Bake();
+		tok.SkipLine();
+	}
 }
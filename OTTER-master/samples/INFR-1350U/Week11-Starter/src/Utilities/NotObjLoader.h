@@ -1,12 +1,56 @@
 #pragma once
 #include "MeshFactory.h"
+#include "MeshCache.h"
 
+/// <summary>
+/// Options that control how a NotObj scene description gets loaded
+/// </summary>
+struct NotObjLoadOptions
+{
+	/// <summary>
+	/// True to use the cooked mesh cache (see MeshCache), the first load writes the baked mesh next to the
+	/// source file, and later loads upload that directly instead of parsing and generating the primitives
+	/// </summary>
+	bool UseCache;
+	/// <summary>
+	/// True to generate each sphere shape (mode and tessellation) once and stamp out copies of it for every
+	/// sphere that uses it, false to run every sphere through MeshFactory. Both produce the same mesh
+	/// </summary>
+	bool ReusePrimitives;
+
+	NotObjLoadOptions() :
+		UseCache(true),
+		ReusePrimitives(true)
+	{ }
+
+	/// <summary>
+	/// Gets a hash of the options that affect the mesh that gets produced
+	/// </summary>
+	uint64_t GetOutputHash() const;
+};
+
+/// <summary>
+/// Loads NotObj scene descriptions, which are text files with one procedural primitive per line:
+///    cube   px py pz  sx sy sz  ex ey ez  [r g b [a]]
+///    plane  px py pz  nx ny nz  tx ty tz  w h  [r g b [a]]
+///    sphere ico|uv tessellation  px py pz  rx ry rz  [r g b [a]]
+/// Lines starting with # are comments
+/// </summary>
 class NotObjLoader
 {
 public:
 	static VertexArrayObject::sptr LoadFromFile(const std::string& filename);
+	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const NotObjLoadOptions& options);
+
+	/// <summary>
+	/// Parses a NotObj file and generates its primitives into a mesh builder without touching OpenGL
+	/// </summary>
+	/// <param name="filename">The path of the file to load</param>
+	/// <param name="mesh">The mesh builder to append the primitives to</param>
+	/// <param name="options">The options to use when generating the primitives</param>
+	static void LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const NotObjLoadOptions& options = NotObjLoadOptions());
 
 protected:
 	NotObjLoader() = default;
 	~NotObjLoader() = default;
-};
\ No newline at end of file
+};
@@ -4,36 +4,64 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <cstring>
+#include <algorithm>
+#include <thread>
 
+#include "Logging.h"
+#include "FlatHashMap.h"
 #include "StringUtils.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "ParallelFor.h"
+#include "TangentGenerator.h"
+#include "TextTokenizer.h"
+#include "VirtualFileSystem.h"
 
-VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor)
-{	
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+/// <summary>
+/// The key we use to de-duplicate vertices, made up of the absolute 1-based attribute indices (0 for a missing attribute)
+/// </summary>
+struct ObjVertexKey
+{
+	int32_t VertIx, UvIx, NormIx;
+
+	bool operator ==(const ObjVertexKey& other) const {
+		return VertIx == other.VertIx && UvIx == other.UvIx && NormIx == other.NormIx;
+	}
+};
 
-	// If our file fails to open, we will throw an error
-	if (!file) {
-		throw std::runtime_error("Failed to open file");
+/// <summary>
+/// Hashes all three indices of an ObjVertexKey, the map mixes the result further so this can stay cheap
+/// </summary>
+struct ObjVertexKeyHash
+{
+	size_t operator ()(const ObjVertexKey& key) const {
+		uint64_t hash = static_cast<uint32_t>(key.VertIx);
+		hash = (hash * 0x100000001B3ull) ^ static_cast<uint32_t>(key.UvIx);
+		hash = (hash * 0x100000001B3ull) ^ static_cast<uint32_t>(key.NormIx);
+		return static_cast<size_t>(hash ^ (hash >> 29));
 	}
+};
 
+typedef FlatHashMap<ObjVertexKey, uint32_t, ObjVertexKeyHash> ObjVertexMap;
+
+/// <summary>
+/// The original std::ifstream based parser, kept around as a fallback for when memory mapping is turned off
+/// </summary>
+void ParseObjStream(std::istream& file, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor)
+{
 	// Stores attributes
 	std::vector<glm::vec3> positions;
 	std::vector<glm::vec3> normals;
 	std::vector<glm::vec2> textureCoords;
 
-	// We'll use bitmask keys and a map to avoid duplicate vertices
-	std::unordered_map<uint64_t, uint32_t> indexMap;
-
-	// We'll leverage the mesh builder class
-	MeshBuilder<VertexPosNormTexCol> mesh;
+	// We key the map on the full index triple to avoid duplicate vertices, so there is no limit on the attribute counts
+	ObjVertexMap indexMap;
 
 	// Temporaries for loading data
 	glm::vec3 temp;
 	glm::ivec3 vertexIndices;
-	
+
 	std::string line;
 	// Iterate as long as there is content to read
 	while (file.peek() != EOF) {
@@ -60,7 +88,7 @@ VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, con
 			// Read the entire line, trim it, and stuff it into a string stream
 			std::string line;
 			std::getline(file, line);
-			trim(line);			
+			trim(line);
 			std::stringstream stream = std::stringstream(line);
 
 			// We'll store the edges in case we added a quad
@@ -77,18 +105,13 @@ VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, con
 					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() - 1 + vertexIndices.x; }
 					if (vertexIndices.y < 0) { vertexIndices.y = textureCoords.size() - 1 + vertexIndices.y; }
 					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() - 1 + vertexIndices.z; }
-					// We can construct a key using a bitmask of the attribute indices
-					// This let's us quickly look up a combination of attributes to see if it's already been added
-					// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
-					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
-					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
-
-					// Find the index associated with the combination of attributes
-					auto it = indexMap.find(key);
+					// Look up the combination of attributes to see if it's already been added
+					const ObjVertexKey key = { vertexIndices.x, vertexIndices.y, vertexIndices.z };
+					const uint32_t* existing = indexMap.Find(key);
 
 					// If it exists, we push the index to our indices
-					if (it != indexMap.end()) {
-						edges[ix] = it->second;
+					if (existing != nullptr) {
+						edges[ix] = *existing;
 					}
 					else {
 						// Construct a new vertex using the indices for the vertex
@@ -101,7 +124,7 @@ VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, con
 						// Add to the mesh, get index of the added vertex
 						uint32_t index = mesh.AddVertex(vertex);
 						// Cache the index based on our key
-						indexMap[key] = index;
+						indexMap.TryEmplace(key, index);
 						// Add index to mesh, and add to edges list for if we are using quads
 						edges[ix] = index;
 					}
@@ -120,10 +143,565 @@ VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, con
 			}
 		}
 	}
+}
+
+/// <summary>
+/// Stores how many of each record type are in an OBJ file, so we can size our buffers before parsing
+/// </summary>
+struct ObjRecordCounts
+{
+	size_t Positions = 0;
+	size_t Normals = 0;
+	size_t TextureCoords = 0;
+	size_t Faces = 0;
+};
+
+/// <summary>
+/// Does a quick pass over the file, only looking at the first two characters of each line
+/// </summary>
+ObjRecordCounts CountObjRecords(const char* begin, const char* end) {
+	ObjRecordCounts result;
+	const char* line = begin;
+	while (line < end) {
+		const char* next = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+		next = next != nullptr ? next + 1 : end;
+		if (next - line > 2) {
+			if (line[0] == 'v') {
+				switch (line[1]) {
+					case ' ':
+					case '\t': result.Positions++; break;
+					case 'n':  result.Normals++; break;
+					case 't':  result.TextureCoords++; break;
+					default: break;
+				}
+			} else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t')) {
+				result.Faces++;
+			}
+		}
+		line = next;
+	}
+	return result;
+}
+
+/// <summary>
+/// Converts a possibly relative (negative) OBJ index into an absolute 1-based index, where 0 means the attribute is missing
+/// </summary>
+inline int32_t ResolveObjIndex(int32_t index, size_t attributeCount) {
+	return index < 0 ? static_cast<int32_t>(attributeCount) + index + 1 : index;
+}
+
+/// <summary>
+/// Reads a single face corner in any of the v, v/vt, v//vn or v/vt/vn forms, missing attributes are returned as 0
+/// </summary>
+/// <returns>True if a corner was read, false if there are no more corners on this line</returns>
+inline bool ReadObjCorner(TextTokenizer& tokenizer, int32_t& vertIx, int32_t& uvIx, int32_t& normIx) {
+	if (!tokenizer.ReadInt(vertIx)) {
+		return false;
+	}
+	uvIx = 0;
+	normIx = 0;
+	if (tokenizer.TryConsume('/')) {
+		if (!tokenizer.TryConsume('/')) {
+			tokenizer.ReadInt(uvIx);
+			if (tokenizer.TryConsume('/')) {
+				tokenizer.ReadInt(normIx);
+			}
+		} else {
+			tokenizer.ReadInt(normIx);
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Parses an OBJ file that is already in memory, without creating any per-line strings or streams
+/// </summary>
+void ParseObjMapped(const char* begin, const char* end, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor)
+{
+	// Size all our buffers ahead of time so we're not re-allocating as we parse
+	const ObjRecordCounts counts = CountObjRecords(begin, end);
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> textureCoords;
+	positions.reserve(counts.Positions);
+	normals.reserve(counts.Normals);
+	textureCoords.reserve(counts.TextureCoords);
+
+	// The number of unique vertices is at least as large as the largest attribute list, so that's a good starting point
+	const size_t expectedVerts = std::max({ counts.Positions, counts.Normals, counts.TextureCoords });
+	mesh.ReserveVertexSpace(expectedVerts);
+	mesh.ReserveIndexSpace(counts.Faces * 3);
+
+	// We'll key a flat hash map on the attribute indices to avoid duplicate vertices
+	ObjVertexMap indexMap;
+	indexMap.Reserve(expectedVerts);
+
+	TextTokenizer tokenizer(begin, end);
+	while (!tokenizer.IsEOF()) {
+		const std::string_view command = tokenizer.ReadToken();
+
+		// Load in vertex positions
+		if (command == "v") {
+			glm::vec3 position = glm::vec3(0.0f);
+			tokenizer.ReadFloat(position.x);
+			tokenizer.ReadFloat(position.y);
+			tokenizer.ReadFloat(position.z);
+			positions.push_back(position);
+		}
+		// Load in vertex normals
+		else if (command == "vn") {
+			glm::vec3 normal = glm::vec3(0.0f);
+			tokenizer.ReadFloat(normal.x);
+			tokenizer.ReadFloat(normal.y);
+			tokenizer.ReadFloat(normal.z);
+			normals.push_back(normal);
+		}
+		// Load in UV coordinates
+		else if (command == "vt") {
+			glm::vec2 uv = glm::vec2(0.0f);
+			tokenizer.ReadFloat(uv.x);
+			tokenizer.ReadFloat(uv.y);
+			textureCoords.push_back(uv);
+		}
+		// Load in face lines, these can be any of v, v/vt, v//vn or v/vt/vn
+		else if (command == "f") {
+			uint32_t first = 0, previous = 0;
+			int count = 0;
+			int32_t vertIx, uvIx, normIx;
+			while (ReadObjCorner(tokenizer, vertIx, uvIx, normIx)) {
+				// The OBJ format can have negative values, which are a reference from the last added attributes
+				vertIx = ResolveObjIndex(vertIx, positions.size());
+				uvIx   = ResolveObjIndex(uvIx, textureCoords.size());
+				normIx = ResolveObjIndex(normIx, normals.size());
+				if (vertIx < 1 || vertIx > (int32_t)positions.size() ||
+					uvIx < 0 || uvIx > (int32_t)textureCoords.size() ||
+					normIx < 0 || normIx > (int32_t)normals.size()) {
+					throw std::runtime_error("Face references an attribute that does not exist");
+				}
+
+				// Look up the combination of attributes, adding a new vertex if we haven't seen it before
+				const auto result = indexMap.TryEmplace({ vertIx, uvIx, normIx }, static_cast<uint32_t>(mesh.GetVertexCount()));
+				const uint32_t index = *result.first;
+				if (result.second) {
+					mesh.AddVertex(
+						positions[vertIx - 1],
+						normIx != 0 ? normals[normIx - 1] : glm::vec3(0.0f, 0.0f, 1.0f),
+						uvIx != 0 ? textureCoords[uvIx - 1] : glm::vec2(0.0f),
+						inColor);
+				}
+
+				// Triangulate as a fan around the first vertex, this matches the old quad handling
+				// and lets us handle n-gons as well
+				if (count == 0) {
+					first = index;
+				} else if (count >= 2) {
+					mesh.AddIndexTri(first, previous, index);
+				}
+				previous = index;
+				count++;
+			}
+		}
+
+		// Anything else (comments, groups, materials) gets ignored
+		tokenizer.SkipLine();
+	}
+}
+
+/// <summary>
+/// A single face corner as it was read from a chunk. Negative (relative) indices are resolved against the
+/// chunk's own attribute lists while parsing, and flagged in RelativeMask so that they can be offset by the
+/// number of attributes in the preceding chunks once those are known
+/// </summary>
+struct ObjChunkCorner
+{
+	int32_t VertIx, UvIx, NormIx;
+	uint8_t RelativeMask; // bit 0 = position, bit 1 = uv, bit 2 = normal
+};
+
+/// <summary>
+/// Stores everything that one worker thread produces for a line-aligned chunk of an OBJ file
+/// </summary>
+struct ObjChunk
+{
+	const char* Begin = nullptr;
+	const char* End   = nullptr;
+
+	// Filled in by the parse pass
+	std::vector<glm::vec3>      Positions;
+	std::vector<glm::vec3>      Normals;
+	std::vector<glm::vec2>      TextureCoords;
+	std::vector<ObjChunkCorner> Corners;
+	std::vector<uint32_t>       FaceSizes;
+	size_t                      TriangleCount = 0;
+
+	// Prefix sums over the preceding chunks
+	size_t PositionOffset = 0, NormalOffset = 0, UvOffset = 0, TriangleOffset = 0;
+
+	// Filled in by the local de-duplication pass, unique vertices in order of first occurrence within this chunk
+	std::vector<ObjVertexKey> UniqueKeys;
+	std::vector<uint32_t>     CornerIds;
+
+	// Filled in by the merge pass, maps UniqueKeys to final vertex indices, and flags the vertices this chunk creates
+	std::vector<uint32_t>   Remap;
+	std::vector<uint8_t>    IsOwner;
+};
+
+/// <summary>
+/// Splits the buffer into at most count chunks, with every chunk ending on a line break
+/// </summary>
+std::vector<ObjChunk> SplitObjChunks(const char* begin, const char* end, size_t count) {
+	std::vector<ObjChunk> result;
+	const size_t chunkSize = static_cast<size_t>(end - begin) / count + 1;
+	const char* start = begin;
+	while (start < end) {
+		const char* stop = start + std::min(chunkSize, static_cast<size_t>(end - start));
+		if (stop < end) {
+			const char* lineEnd = static_cast<const char*>(memchr(stop, '\n', static_cast<size_t>(end - stop)));
+			stop = lineEnd != nullptr ? lineEnd + 1 : end;
+		}
+		ObjChunk& chunk = result.emplace_back();
+		chunk.Begin = start;
+		chunk.End = stop;
+		start = stop;
+	}
+	return result;
+}
+
+/// <summary>
+/// Parses all the records in a chunk, without de-duplicating anything
+/// </summary>
+void ParseObjChunk(ObjChunk& chunk) {
+	const ObjRecordCounts counts = CountObjRecords(chunk.Begin, chunk.End);
+	chunk.Positions.reserve(counts.Positions);
+	chunk.Normals.reserve(counts.Normals);
+	chunk.TextureCoords.reserve(counts.TextureCoords);
+	chunk.Corners.reserve(counts.Faces * 3);
+	chunk.FaceSizes.reserve(counts.Faces);
+
+	TextTokenizer tokenizer(chunk.Begin, chunk.End);
+	while (!tokenizer.IsEOF()) {
+		const std::string_view command = tokenizer.ReadToken();
+
+		if (command == "v") {
+			glm::vec3 position = glm::vec3(0.0f);
+			tokenizer.ReadFloat(position.x);
+			tokenizer.ReadFloat(position.y);
+			tokenizer.ReadFloat(position.z);
+			chunk.Positions.push_back(position);
+		}
+		else if (command == "vn") {
+			glm::vec3 normal = glm::vec3(0.0f);
+			tokenizer.ReadFloat(normal.x);
+			tokenizer.ReadFloat(normal.y);
+			tokenizer.ReadFloat(normal.z);
+			chunk.Normals.push_back(normal);
+		}
+		else if (command == "vt") {
+			glm::vec2 uv = glm::vec2(0.0f);
+			tokenizer.ReadFloat(uv.x);
+			tokenizer.ReadFloat(uv.y);
+			chunk.TextureCoords.push_back(uv);
+		}
+		else if (command == "f") {
+			uint32_t count = 0;
+			ObjChunkCorner corner;
+			while (ReadObjCorner(tokenizer, corner.VertIx, corner.UvIx, corner.NormIx)) {
+				corner.RelativeMask = (corner.VertIx < 0 ? 1 : 0) | (corner.UvIx < 0 ? 2 : 0) | (corner.NormIx < 0 ? 4 : 0);
+				corner.VertIx = ResolveObjIndex(corner.VertIx, chunk.Positions.size());
+				corner.UvIx   = ResolveObjIndex(corner.UvIx, chunk.TextureCoords.size());
+				corner.NormIx = ResolveObjIndex(corner.NormIx, chunk.Normals.size());
+				chunk.Corners.push_back(corner);
+				count++;
+			}
+			chunk.FaceSizes.push_back(count);
+			chunk.TriangleCount += count > 2 ? count - 2 : 0;
+		}
+
+		tokenizer.SkipLine();
+	}
+}
+
+/// <summary>
+/// Converts the chunk's corners to absolute indices and de-duplicates them within the chunk, recording the
+/// unique vertices in the order they first appear
+/// </summary>
+void DedupObjChunk(ObjChunk& chunk, size_t totalPositions, size_t totalUvs, size_t totalNormals) {
+	ObjVertexMap localMap;
+	localMap.Reserve(std::max({ chunk.Positions.size(), chunk.Normals.size(), chunk.TextureCoords.size() }));
+	chunk.CornerIds.reserve(chunk.Corners.size());
+
+	for (const ObjChunkCorner& corner : chunk.Corners) {
+		const int32_t vertIx = corner.VertIx + ((corner.RelativeMask & 1) ? static_cast<int32_t>(chunk.PositionOffset) : 0);
+		const int32_t uvIx   = corner.UvIx   + ((corner.RelativeMask & 2) ? static_cast<int32_t>(chunk.UvOffset) : 0);
+		const int32_t normIx = corner.NormIx + ((corner.RelativeMask & 4) ? static_cast<int32_t>(chunk.NormalOffset) : 0);
+		if (vertIx < 1 || vertIx > (int32_t)totalPositions ||
+			uvIx < 0 || uvIx > (int32_t)totalUvs ||
+			normIx < 0 || normIx > (int32_t)totalNormals) {
+			throw std::runtime_error("Face references an attribute that does not exist");
+		}
+
+		const ObjVertexKey key = { vertIx, uvIx, normIx };
+		const auto result = localMap.TryEmplace(key, static_cast<uint32_t>(chunk.UniqueKeys.size()));
+		if (result.second) {
+			chunk.UniqueKeys.push_back(key);
+		}
+		chunk.CornerIds.push_back(*result.first);
+	}
+}
+
+void ObjLoader::_ParseChunked(const char* begin, const char* end, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount)
+{
+	std::vector<ObjChunk> chunks = SplitObjChunks(begin, end, threadCount);
+
+	// Pass 1 (parallel): parse each chunk into its own attribute and corner lists
+	ParallelFor(chunks.size(), [&](size_t ix) { ParseObjChunk(chunks[ix]); });
+
+	// Prefix sums, so every chunk knows where its attributes and triangles land in the final buffers
+	size_t positionCount = 0, normalCount = 0, uvCount = 0, triangleCount = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.PositionOffset = positionCount;
+		chunk.NormalOffset   = normalCount;
+		chunk.UvOffset       = uvCount;
+		chunk.TriangleOffset = triangleCount;
+		positionCount += chunk.Positions.size();
+		normalCount   += chunk.Normals.size();
+		uvCount       += chunk.TextureCoords.size();
+		triangleCount += chunk.TriangleCount;
+	}
+
+	// Pass 2 (parallel): resolve indices and de-duplicate within each chunk
+	ParallelFor(chunks.size(), [&](size_t ix) { DedupObjChunk(chunks[ix], positionCount, uvCount, normalCount); });
+
+	// Merge (serial): walking the chunks in file order, and each chunk's unique vertices in order of first occurrence,
+	// visits every vertex in exactly the order the single threaded loader would first see it. This means we hand out
+	// the same indices as the single threaded loader, but only need to touch each chunk's unique vertices
+	const uint32_t baseVertex = static_cast<uint32_t>(mesh._vertices.size());
+	uint32_t nextVertex = baseVertex;
+	ObjVertexMap indexMap;
+	indexMap.Reserve(std::max({ positionCount, normalCount, uvCount }));
+	for (ObjChunk& chunk : chunks) {
+		chunk.Remap.resize(chunk.UniqueKeys.size());
+		chunk.IsOwner.resize(chunk.UniqueKeys.size());
+		for (size_t ix = 0; ix < chunk.UniqueKeys.size(); ix++) {
+			const auto result = indexMap.TryEmplace(chunk.UniqueKeys[ix], nextVertex);
+			chunk.Remap[ix] = *result.first;
+			chunk.IsOwner[ix] = result.second;
+			nextVertex += result.second ? 1 : 0;
+		}
+	}
+
+	// Pass 3 (parallel): every chunk writes out the vertices it owns and its triangles, directly into the mesh
+	const size_t baseIndex = mesh._indices.size();
+	mesh._vertices.resize(nextVertex);
+	mesh._indices.resize(baseIndex + triangleCount * 3);
+	ParallelFor(chunks.size(), [&](size_t chunkIx) {
+		const ObjChunk& chunk = chunks[chunkIx];
+
+		// Attributes may be referenced across chunk boundaries, so look them up in whichever chunk holds them
+		auto findChunk = [&](size_t globalIx, size_t ObjChunk::* offset) -> const ObjChunk& {
+			auto it = std::upper_bound(chunks.begin(), chunks.end(), globalIx, [&](size_t value, const ObjChunk& c) { return value < c.*offset; });
+			return *(it - 1);
+		};
+		for (size_t ix = 0; ix < chunk.UniqueKeys.size(); ix++) {
+			if (!chunk.IsOwner[ix]) {
+				continue;
+			}
+			const ObjVertexKey& key = chunk.UniqueKeys[ix];
+			VertexPosNormTexCol& vertex = mesh._vertices[chunk.Remap[ix]];
+
+			const size_t vertIx = key.VertIx - 1;
+			const ObjChunk& posChunk = findChunk(vertIx, &ObjChunk::PositionOffset);
+			vertex.Position = posChunk.Positions[vertIx - posChunk.PositionOffset];
+			if (key.UvIx != 0) {
+				const size_t uvIx = key.UvIx - 1;
+				const ObjChunk& uvChunk = findChunk(uvIx, &ObjChunk::UvOffset);
+				vertex.UV = uvChunk.TextureCoords[uvIx - uvChunk.UvOffset];
+			} else {
+				vertex.UV = glm::vec2(0.0f);
+			}
+			if (key.NormIx != 0) {
+				const size_t normIx = key.NormIx - 1;
+				const ObjChunk& normChunk = findChunk(normIx, &ObjChunk::NormalOffset);
+				vertex.Normal = normChunk.Normals[normIx - normChunk.NormalOffset];
+			} else {
+				vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			}
+			vertex.Color = inColor;
+		}
+
+		// Triangulate as a fan around the first vertex, same as the single threaded path
+		uint32_t* out = mesh._indices.data() + baseIndex + chunk.TriangleOffset * 3;
+		size_t cornerIx = 0;
+		for (uint32_t faceSize : chunk.FaceSizes) {
+			for (uint32_t ix = 2; ix < faceSize; ix++) {
+				*out++ = chunk.Remap[chunk.CornerIds[cornerIx]];
+				*out++ = chunk.Remap[chunk.CornerIds[cornerIx + ix - 1]];
+				*out++ = chunk.Remap[chunk.CornerIds[cornerIx + ix]];
+			}
+			cornerIx += faceSize;
+		}
+	});
+}
+
+VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor)
+{
+	ObjLoadOptions options;
+	options.Color = inColor;
+	return LoadFromFile(filename, options);
+}
+
+uint64_t ObjLoadOptions::GetOutputHash() const {
+	uint64_t result = MeshCache::Hash(&Color, sizeof(glm::vec4));
+	result = MeshCache::Hash(&Optimize, sizeof(bool), result);
+	result = MeshCache::Hash(&Format, sizeof(VertexFormat), result);
+	if (BuildMeshlets) {
+		result = MeshCache::Hash(&BuildMeshlets, sizeof(bool), result);
+		result = MeshCache::Hash(&Meshlets.MaxTriangles, sizeof(Meshlets.MaxTriangles), result);
+		result = MeshCache::Hash(&Meshlets.ConeWeight, sizeof(Meshlets.ConeWeight), result);
+	}
+	return result;
+}
+
+VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const ObjLoadOptions& options)
+{
+	// If we've already cooked this file with the same options, we can skip parsing entirely
+	if (options.UseCache) {
+		VertexArrayObject::sptr cooked = MeshCache::TryLoad(filename, options.GetOutputHash());
+		if (cooked != nullptr) {
+			return cooked;
+		}
+	}
 
-	// Note: with actual OBJ files you're going to run into the issue where faces are composited of different indices
-	// You'll need to keep track of these and create vertex entries for each vertex in the face
-	// If you want to get fancy, you can track which vertices you've already added
+	// Meshlets are only stored in the cooked layout, so we build them through that and upload the whole mesh
+	if (options.BuildMeshlets) {
+		CookedMesh cooked;
+		LoadCooked(filename, options, cooked);
+		return cooked.Bake();
+	}
+
+	// We'll leverage the mesh builder class
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	LoadMeshData(filename, mesh, options);
+
+	if (options.Optimize) {
+		const MeshOptimizerStats stats = MeshOptimizer::Optimize(mesh);
+		LOG_INFO("Optimized \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+			filename, stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR);
+	}
+
+	switch (options.Format) {
+		case VertexFormat::Packed:
+		{
+			MeshBuilder<VertexPackedPosNormTexCol> packed;
+			VertexPacking::Pack(mesh, packed);
+			return _StoreAndBake(filename, options, packed);
+		}
+		case VertexFormat::Quantized:
+		{
+			MeshBuilder<VertexQuantizedPosNormTexCol> quantized;
+			VertexPacking::Quantize(mesh, quantized);
+			return _StoreAndBake(filename, options, quantized);
+		}
+		case VertexFormat::QTangent:
+		{
+			MeshBuilder<VertexPackedPosQTangentTexCol> qtangents;
+			VertexPacking::PackQTangents(mesh, qtangents, options.ThreadCount);
+			return _StoreAndBake(filename, options, qtangents);
+		}
+		default:
+			return _StoreAndBake(filename, options, mesh);
+	}
+}
+
+void ObjLoader::LoadCooked(const std::string& filename, const ObjLoadOptions& options, CookedMesh& result)
+{
+	if (options.UseCache && MeshCache::TryRead(filename, options.GetOutputHash(), result)) {
+		return;
+	}
+
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	LoadMeshData(filename, mesh, options);
+
+	if (options.Optimize) {
+		const MeshOptimizerStats stats = MeshOptimizer::Optimize(mesh);
+		LOG_INFO("Optimized \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+			filename, stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR);
+	}
+
+	// The meshlets are built from the full precision positions, packing keeps the triangle order so they still line up
+	result.Meshlets.clear();
+	if (options.BuildMeshlets) {
+		MeshletBuilder::Build(mesh, options.Meshlets, result.Meshlets);
+		LOG_INFO("Split \"{}\" into {} meshlets", filename, result.Meshlets.size());
+	}
+
+	switch (options.Format) {
+		case VertexFormat::Packed:
+		{
+			MeshBuilder<VertexPackedPosNormTexCol> packed;
+			VertexPacking::Pack(mesh, packed);
+			_StoreAndCook(filename, options, packed, result);
+			break;
+		}
+		case VertexFormat::Quantized:
+		{
+			MeshBuilder<VertexQuantizedPosNormTexCol> quantized;
+			VertexPacking::Quantize(mesh, quantized);
+			_StoreAndCook(filename, options, quantized, result);
+			break;
+		}
+		case VertexFormat::QTangent:
+		{
+			MeshBuilder<VertexPackedPosQTangentTexCol> qtangents;
+			VertexPacking::PackQTangents(mesh, qtangents, options.ThreadCount);
+			_StoreAndCook(filename, options, qtangents, result);
+			break;
+		}
+		default:
+			_StoreAndCook(filename, options, mesh, result);
+			break;
+	}
+}
+
+void ObjLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const ObjLoadOptions& options)
+{
+	if (options.UseMemoryMap) {
+		VfsFile file(filename);
+
+		// If our file fails to open, we will throw an error
+		if (!file.IsOpen()) {
+			throw std::runtime_error("Failed to open file");
+		}
 
-	return mesh.Bake();
+		// Small files aren't worth spinning up threads for, so we limit ourselves to one thread per MinBytesPerThread
+		size_t threadCount = options.ThreadCount > 0 ? options.ThreadCount : std::max(std::thread::hardware_concurrency(), 1u);
+		threadCount = std::min(threadCount, file.GetSize() / ObjLoadOptions::MinBytesPerThread + 1);
+
+		if (threadCount > 1) {
+			_ParseChunked(file.GetData(), file.GetEnd(), mesh, options.Color, threadCount);
+		} else {
+			ParseObjMapped(file.GetData(), file.GetEnd(), mesh, options.Color);
+		}
+	} else {
+		// Open our file in binary mode
+		std::ifstream file;
+		file.open(filename, std::ios::binary);
+
+		// If our file fails to open, we will throw an error
+		if (!file) {
+			throw std::runtime_error("Failed to open file");
+		}
+
+		ParseObjStream(file, mesh, options.Color);
+	}
+
+	// Mirrored UVs need a tangent frame of each handedness, so the vertices along those seams get split before
+	// anything downstream (optimizing, meshlets, LODs) sees the mesh
+	if (options.Format == VertexFormat::QTangent) {
+		const size_t added = TangentGenerator::SplitMirroredVertices(mesh);
+		if (added > 0) {
+			LOG_INFO("Split {} vertices along mirrored UV seams in \"{}\"", added, filename);
+		}
+	}
 }
@@ -1,12 +1,126 @@
 #pragma once
 #include "MeshFactory.h"
+#include "MeshCache.h"
+#include "VertexPacking.h"
+#include "MeshletBuilder.h"
+
+/// <summary>
+/// Options that control how an OBJ file gets loaded
+/// </summary>
+struct ObjLoadOptions
+{
+	/// <summary>
+	/// The color to assign to every vertex in the mesh
+	/// </summary>
+	glm::vec4 Color;
+	/// <summary>
+	/// True to open the file through the VirtualFileSystem and parse it in-place (fast path), false to use
+	/// the older std::ifstream based parser, which only reads loose files
+	/// </summary>
+	bool      UseMemoryMap;
+	/// <summary>
+	/// The number of threads to parse with when using the memory mapped path, 0 will use one per hardware
+	/// thread. Files are split into line-aligned chunks, and the result is identical to a single threaded load.
+	/// Tangent generation for the QTangent format uses the same number of threads
+	/// </summary>
+	uint32_t  ThreadCount;
+	/// <summary>
+	/// True to use the cooked mesh cache (see MeshCache), the first load writes a cooked copy of the
+	/// mesh next to the OBJ file, and later loads upload that directly instead of parsing the OBJ
+	/// </summary>
+	bool      UseCache;
+	/// <summary>
+	/// True to run the mesh through MeshOptimizer before it gets baked (and cooked), so it renders
+	/// faster on the GPU. This only applies to LoadFromFile, LoadMeshData leaves the mesh in file order
+	/// </summary>
+	bool      Optimize;
+	/// <summary>
+	/// The vertex format that LoadFromFile bakes the mesh into, the compact formats use half or less of
+	/// the memory and vertex bandwidth of the full float format, but need a shader that decodes octahedral
+	/// normals (see vertex_shader.glsl). LoadMeshData always produces the full format, but splits the vertices on
+	/// mirrored UV seams when the QTangent format is selected
+	/// </summary>
+	VertexFormat Format;
+	/// <summary>
+	/// True to split the mesh into meshlets after it is optimized (see MeshletBuilder), the meshlets are stored
+	/// in the cooked mesh, use AssetLoader::LoadObjMeshlets to get a MeshletSet that can cull them
+	/// </summary>
+	bool           BuildMeshlets;
+	/// <summary>
+	/// The options for building the meshlets, if BuildMeshlets is set
+	/// </summary>
+	MeshletOptions Meshlets;
+
+	/// <summary>
+	/// The minimum amount of the file each thread should get, smaller files will use fewer threads
+	/// </summary>
+	static constexpr size_t MinBytesPerThread = 256 * 1024;
+
+	ObjLoadOptions() :
+		Color(glm::vec4(1.0f)),
+		UseMemoryMap(true),
+		ThreadCount(1),
+		UseCache(true),
+		Optimize(true),
+		Format(VertexFormat::Full),
+		BuildMeshlets(false),
+		Meshlets(MeshletOptions())
+	{ }
+
+	/// <summary>
+	/// Gets a hash of the options that affect the mesh that gets produced (ex: the color, but not the thread count)
+	/// </summary>
+	uint64_t GetOutputHash() const;
+};
 
 class ObjLoader
 {
 public:
 	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f));
+	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const ObjLoadOptions& options);
+
+	/// <summary>
+	/// Parses an OBJ file into a mesh builder without touching OpenGL, useful if you want to modify the
+	/// mesh before baking it, or if you are loading on a thread without a GL context
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="mesh">The mesh builder to append the vertices and indices to</param>
+	/// <param name="options">The options to use when parsing the file</param>
+	static void LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const ObjLoadOptions& options = ObjLoadOptions());
+	/// <summary>
+	/// Does everything LoadFromFile does except for the upload, leaving the final mesh in memory. This does not
+	/// touch OpenGL, so it can be used from worker threads, call CookedMesh::Bake on the main thread to upload it
+	/// </summary>
+	/// <param name="filename">The path of the OBJ file to load</param>
+	/// <param name="options">The options to load the file with</param>
+	/// <param name="result">The cooked mesh to store the result in</param>
+	static void LoadCooked(const std::string& filename, const ObjLoadOptions& options, CookedMesh& result);
 
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
-};
\ No newline at end of file
+
+	/// <summary>
+	/// Writes a finished mesh to the cooked mesh cache (if enabled in options) and uploads it to the GPU
+	/// </summary>
+	template <typename VertType>
+	static VertexArrayObject::sptr _StoreAndBake(const std::string& filename, const ObjLoadOptions& options, MeshBuilder<VertType>& mesh) {
+		if (options.UseCache) {
+			MeshCache::Store(filename, options.GetOutputHash(), mesh);
+		}
+		return mesh.Bake();
+	}
+
+	/// <summary>
+	/// Converts a finished mesh into the cooked layout and writes it to the cooked mesh cache (if enabled in options)
+	/// </summary>
+	template <typename VertType>
+	static void _StoreAndCook(const std::string& filename, const ObjLoadOptions& options, MeshBuilder<VertType>& mesh, CookedMesh& result) {
+		MeshCache::Cook(mesh, result);
+		if (options.UseCache) {
+			MeshCache::Store(filename, options.GetOutputHash(), result);
+		}
+	}
+
+	static void _ParseChunked(const char* begin, const char* end, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount);
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <exception>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Invokes func(ix) for every ix in [0, count), with each invocation running on its own thread (the
+/// calling thread handles index 0). Blocks until all invocations have finished. If any invocation
+/// throws, the exception from the lowest index is re-thrown on the calling thread
+/// </summary>
+/// <typeparam name="Func">A callable with the signature void(size_t)</typeparam>
+/// <param name="count">The number of invocations to make, usually the number of chunks of work</param>
+/// <param name="func">The function to invoke</param>
+template <typename Func>
+void ParallelFor(size_t count, const Func& func) {
+	if (count == 0) {
+		return;
+	}
+
+	std::vector<std::exception_ptr> errors(count);
+	auto invoke = [&](size_t ix) {
+		try {
+			func(ix);
+		} catch (...) {
+			errors[ix] = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(count - 1);
+	for (size_t ix = 1; ix < count; ix++) {
+		threads.emplace_back(invoke, ix);
+	}
+	invoke(0);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	for (const std::exception_ptr& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
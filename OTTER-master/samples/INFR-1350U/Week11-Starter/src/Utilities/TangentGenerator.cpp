@@ -0,0 +1,180 @@
+#include "TangentGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include "Logging.h"
+#include "ParallelFor.h"
+
+/// <summary>
+/// Reads a float vector attribute out of an interleaved vertex buffer
+/// </summary>
+template <typename Vec>
+inline Vec ReadTangentAttribute(const uint8_t* vertices, size_t vertexStride, int offset, uint32_t index) {
+	Vec result;
+	memcpy(&result, vertices + vertexStride * index + offset, sizeof(Vec));
+	return result;
+}
+
+/// <summary>
+/// Gets twice the signed area of a triangle in UV space, this is negative for triangles with mirrored UVs
+/// </summary>
+inline float GetUvWinding(const uint8_t* vertices, size_t vertexStride, const MeshSimplifierLayout& layout, const uint32_t* triangle) {
+	const glm::vec2 a = ReadTangentAttribute<glm::vec2>(vertices, vertexStride, layout.TextureOffset, triangle[0]);
+	const glm::vec2 b = ReadTangentAttribute<glm::vec2>(vertices, vertexStride, layout.TextureOffset, triangle[1]);
+	const glm::vec2 c = ReadTangentAttribute<glm::vec2>(vertices, vertexStride, layout.TextureOffset, triangle[2]);
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/// <summary>
+/// Projects a vector onto the plane of a unit normal and normalizes it, returns false if nothing is left of it
+/// </summary>
+inline bool ProjectOntoTangentPlane(const glm::vec3& normal, glm::vec3& value) {
+	value -= normal * glm::dot(normal, value);
+	const float length = glm::length(value);
+	if (length <= std::numeric_limits<float>::epsilon()) {
+		return false;
+	}
+	value /= length;
+	return true;
+}
+
+void TangentGenerator::Generate(const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexStride, size_t vertexCount,
+	const MeshSimplifierLayout& layout, std::vector<glm::vec4>& outTangents, uint32_t threadCount)
+{
+	LOG_ASSERT(layout.PositionOffset >= 0 && layout.NormalOffset >= 0 && layout.TextureOffset >= 0, "Tangents need float positions, normals and UVs!");
+	LOG_ASSERT(indexCount % 3 == 0, "Tangents can only be generated for triangle lists!");
+
+	outTangents.assign(vertexCount, glm::vec4(0.0f));
+	const size_t triCount = indexCount / 3;
+	const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+
+	size_t threads = threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	threads = std::min(threads, triCount / MinTrianglesPerThread + 1);
+
+	// The UV derivative of every triangle (its tangent before it gets projected onto each vertex's normal), with the
+	// UV winding in w. Triangles with no UV area get a zero tangent, and don't contribute to their vertices
+	std::vector<glm::vec4> faceTangents(triCount);
+	ParallelFor(threads, [&](size_t chunk) {
+		const size_t end = triCount * (chunk + 1) / threads;
+		for (size_t tri = triCount * chunk / threads; tri < end; tri++) {
+			const uint32_t* triangle = indices + tri * 3;
+			const glm::vec3 p0 = ReadTangentAttribute<glm::vec3>(vertexBytes, vertexStride, layout.PositionOffset, triangle[0]);
+			const glm::vec3 d21 = ReadTangentAttribute<glm::vec3>(vertexBytes, vertexStride, layout.PositionOffset, triangle[1]) - p0;
+			const glm::vec3 d31 = ReadTangentAttribute<glm::vec3>(vertexBytes, vertexStride, layout.PositionOffset, triangle[2]) - p0;
+			const glm::vec2 t0 = ReadTangentAttribute<glm::vec2>(vertexBytes, vertexStride, layout.TextureOffset, triangle[0]);
+			const glm::vec2 t21 = ReadTangentAttribute<glm::vec2>(vertexBytes, vertexStride, layout.TextureOffset, triangle[1]) - t0;
+			const glm::vec2 t31 = ReadTangentAttribute<glm::vec2>(vertexBytes, vertexStride, layout.TextureOffset, triangle[2]) - t0;
+
+			// Dividing by the signed UV area would flip the tangent of mirrored triangles, so we only take its sign
+			const float area = t21.x * t31.y - t21.y * t31.x;
+			const float sign = area < 0.0f ? -1.0f : 1.0f;
+			const glm::vec3 tangent = t31.y * d21 - t21.y * d31;
+			const float length = glm::length(tangent);
+			faceTangents[tri] = area != 0.0f && length > 0.0f ? glm::vec4(tangent * (sign / length), sign) : glm::vec4(0.0f, 0.0f, 0.0f, sign);
+		}
+	});
+
+	// The corners that use each vertex, stored as one flat list with an offset per vertex (like MeshletBuilder)
+	std::vector<uint32_t> cornerOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		cornerOffsets[indices[ix] + 1]++;
+	}
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		cornerOffsets[ix + 1] += cornerOffsets[ix];
+	}
+	std::vector<uint32_t> corners(indexCount);
+	{
+		std::vector<uint32_t> cursor(cornerOffsets.begin(), cornerOffsets.end() - 1);
+		for (size_t ix = 0; ix < indexCount; ix++) {
+			corners[cursor[indices[ix]]++] = static_cast<uint32_t>(ix);
+		}
+	}
+
+	// Every vertex gathers from its own corners, so the result doesn't depend on how the work gets split up
+	ParallelFor(threads, [&](size_t chunk) {
+		const size_t end = vertexCount * (chunk + 1) / threads;
+		for (size_t vertex = vertexCount * chunk / threads; vertex < end; vertex++) {
+			const uint32_t index = static_cast<uint32_t>(vertex);
+			glm::vec3 normal = ReadTangentAttribute<glm::vec3>(vertexBytes, vertexStride, layout.NormalOffset, index);
+			const float normalLength = glm::length(normal);
+			normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+			const glm::vec3 position = ReadTangentAttribute<glm::vec3>(vertexBytes, vertexStride, layout.PositionOffset, index);
+
+			glm::vec3 sum = glm::vec3(0.0f);
+			float winding = 0.0f;
+			for (uint32_t adj = cornerOffsets[vertex]; adj < cornerOffsets[vertex + 1]; adj++) {
+				const uint32_t corner = corners[adj];
+				const uint32_t tri = corner / 3;
+				glm::vec3 tangent = glm::vec3(faceTangents[tri]);
+				if (tangent == glm::vec3(0.0f) || !ProjectOntoTangentPlane(normal, tangent)) {
+					continue;
+				}
+				winding += faceTangents[tri].w;
+
+				// Each triangle is weighted by its angle at this corner, measured in the plane of the vertex normal
+				const uint32_t* triangle = indices + tri * 3;
+				glm::vec3 edgeA = ReadTangentAttribute<glm::vec3>(vertexBytes, vertexStride, layout.PositionOffset, triangle[(corner + 1) % 3]) - position;
+				glm::vec3 edgeB = ReadTangentAttribute<glm::vec3>(vertexBytes, vertexStride, layout.PositionOffset, triangle[(corner + 2) % 3]) - position;
+				if (!ProjectOntoTangentPlane(normal, edgeA) || !ProjectOntoTangentPlane(normal, edgeB)) {
+					continue;
+				}
+				sum += tangent * std::acos(glm::clamp(glm::dot(edgeA, edgeB), -1.0f, 1.0f));
+			}
+
+			// Vertices that only touch degenerate triangles still need a valid frame, any tangent will do
+			if (!ProjectOntoTangentPlane(normal, sum)) {
+				sum = glm::normalize(glm::cross(std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f), normal));
+			}
+			outTangents[vertex] = glm::vec4(sum, winding < 0.0f ? -1.0f : 1.0f);
+		}
+	});
+}
+
+void TangentGenerator::_SplitMirroredIndices(uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexStride, size_t vertexCount,
+	const MeshSimplifierLayout& layout, std::vector<uint32_t>& outSources)
+{
+	LOG_ASSERT(layout.TextureOffset >= 0, "Tangents need float UVs!");
+	LOG_ASSERT(indexCount % 3 == 0, "Tangents can only be generated for triangle lists!");
+
+	outSources.clear();
+	const size_t triCount = indexCount / 3;
+	const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+
+	// Bit 0 is set for vertices used by regular triangles, and bit 1 for vertices used by mirrored ones. Triangles
+	// with no UV area can use either frame, so they don't count
+	constexpr uint8_t Regular = 1;
+	constexpr uint8_t Mirrored = 2;
+	std::vector<uint8_t> windings(triCount);
+	std::vector<uint8_t> usedBy(vertexCount, 0);
+	for (size_t tri = 0; tri < triCount; tri++) {
+		const float area = GetUvWinding(vertexBytes, vertexStride, layout, indices + tri * 3);
+		windings[tri] = area > 0.0f ? Regular : (area < 0.0f ? Mirrored : 0);
+		for (int ix = 0; ix < 3; ix++) {
+			usedBy[indices[tri * 3 + ix]] |= windings[tri];
+		}
+	}
+
+	// The regular triangles keep the original vertex, and the mirrored ones share a single copy of it
+	constexpr uint32_t NoVertex = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> copies(vertexCount, NoVertex);
+	for (size_t tri = 0; tri < triCount; tri++) {
+		if (windings[tri] != Mirrored) {
+			continue;
+		}
+		for (int ix = 0; ix < 3; ix++) {
+			uint32_t& index = indices[tri * 3 + ix];
+			if (usedBy[index] != (Regular | Mirrored)) {
+				continue;
+			}
+			if (copies[index] == NoVertex) {
+				copies[index] = static_cast<uint32_t>(vertexCount + outSources.size());
+				outSources.push_back(index);
+			}
+			index = copies[index];
+		}
+	}
+}
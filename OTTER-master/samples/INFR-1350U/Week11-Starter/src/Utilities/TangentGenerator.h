@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "MeshBuilder.h"
+#include "MeshSimplifier.h"
+
+/// <summary>
+/// Generates per-vertex tangent frames for normal mapping, following the same conventions as MikkTSpace (the
+/// tangent space Blender, Substance and most bakers use): every triangle's UV derivative is projected onto the
+/// vertex normal and weighted by the triangle's angle at the vertex, and the bitangent is rebuilt in the shader as
+/// sign * cross(normal, tangent). Normal maps baked against MikkTSpace will line up with the result
+/// </summary>
+class TangentGenerator
+{
+public:
+	/// <summary>
+	/// The fewest triangles each thread should get, smaller meshes use fewer threads
+	/// </summary>
+	static constexpr size_t MinTrianglesPerThread = 16 * 1024;
+
+	/// <summary>
+	/// Calculates the tangent of every vertex in an indexed triangle list. Every vertex should be used by triangles
+	/// with the same UV winding, run SplitMirroredVertices first to make sure of that
+	/// </summary>
+	/// <param name="indices">The triangle list</param>
+	/// <param name="indexCount">The number of indices in the list</param>
+	/// <param name="vertices">A pointer to the first vertex in the mesh</param>
+	/// <param name="vertexStride">The size of each vertex in bytes</param>
+	/// <param name="vertexCount">The number of vertices in the mesh</param>
+	/// <param name="layout">Where the position, normal and UV are stored in each vertex, all 3 are required</param>
+	/// <param name="outTangents">Will be filled with a tangent for each vertex, the w component is the bitangent sign (1 or -1)</param>
+	/// <param name="threadCount">The number of threads to use, 0 will use one per hardware thread</param>
+	static void Generate(const uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexStride, size_t vertexCount,
+		const MeshSimplifierLayout& layout, std::vector<glm::vec4>& outTangents, uint32_t threadCount = 0);
+
+	/// <summary>
+	/// Calculates the tangent of every vertex in a mesh
+	/// </summary>
+	/// <param name="mesh">The mesh to generate tangents for</param>
+	/// <param name="outTangents">Will be filled with a tangent for each vertex, the w component is the bitangent sign (1 or -1)</param>
+	/// <param name="threadCount">The number of threads to use, 0 will use one per hardware thread</param>
+	template <typename VertType>
+	static void Generate(const MeshBuilder<VertType>& mesh, std::vector<glm::vec4>& outTangents, uint32_t threadCount = 0) {
+		Generate(mesh._indices.data(), mesh._indices.size(), mesh._vertices.data(), sizeof(VertType), mesh._vertices.size(),
+			MeshSimplifierLayout::FromDecl<VertType>(), outTangents, threadCount);
+	}
+
+	/// <summary>
+	/// Duplicates any vertex that is shared between triangles with opposite UV winding (ex: along the seam of a
+	/// mirrored texture), since those need tangent frames with opposite handedness. The duplicates are appended
+	/// to the end of the vertex buffer, and the indices of the mirrored triangles are pointed at them
+	/// </summary>
+	/// <param name="mesh">The mesh to split up</param>
+	/// <returns>The number of vertices that were added</returns>
+	template <typename VertType>
+	static size_t SplitMirroredVertices(MeshBuilder<VertType>& mesh) {
+		std::vector<uint32_t> sources;
+		_SplitMirroredIndices(mesh._indices.data(), mesh._indices.size(), mesh._vertices.data(), sizeof(VertType), mesh._vertices.size(),
+			MeshSimplifierLayout::FromDecl<VertType>(), sources);
+		mesh._vertices.reserve(mesh._vertices.size() + sources.size());
+		for (uint32_t source : sources) {
+			const VertType copy = mesh._vertices[source];
+			mesh._vertices.push_back(copy);
+		}
+		return sources.size();
+	}
+
+protected:
+	TangentGenerator() = default;
+	~TangentGenerator() = default;
+
+	/// <summary>
+	/// Finds the vertices that are shared by triangles with opposite UV winding, and re-points the indices of the
+	/// negatively wound triangles to new vertices (numbered from vertexCount up)
+	/// </summary>
+	/// <param name="outSources">Will be filled with the vertex that each new vertex should be a copy of</param>
+	static void _SplitMirroredIndices(uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexStride, size_t vertexCount,
+		const MeshSimplifierLayout& layout, std::vector<uint32_t>& outSources);
+};
@@ -0,0 +1,124 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+/// <summary>
+/// A small forward-only tokenizer for text that is already in memory (ex: a MemoryMappedFile). Nothing in
+/// here allocates, tokens are handed out as views into the source buffer and numbers are parsed in-place
+/// with std::from_chars. Whitespace handling is line-aware, so most parsers will look something like:
+///    while (!tok.IsEOF()) { auto cmd = tok.ReadToken(); ...; tok.SkipLine(); }
+/// </summary>
+class TextTokenizer
+{
+public:
+	TextTokenizer(const char* begin, const char* end) :
+		_current(begin), _end(end) { }
+	TextTokenizer(std::string_view text) :
+		_current(text.data()), _end(text.data() + text.size()) { }
+
+	/// <summary>
+	/// Returns true if we have consumed the entire buffer
+	/// </summary>
+	bool IsEOF() const { return _current >= _end; }
+	/// <summary>
+	/// Returns true if the next character is a line break (or we are at the end of the buffer)
+	/// </summary>
+	bool IsEOL() const { return _current >= _end || *_current == '\n' || *_current == '\r'; }
+	/// <summary>
+	/// Gets the current read position within the source buffer
+	/// </summary>
+	const char* GetPosition() const { return _current; }
+	/// <summary>
+	/// Peeks at the next character without consuming it, returns '\0' at the end of the buffer
+	/// </summary>
+	char Peek() const { return _current < _end ? *_current : '\0'; }
+
+	/// <summary>
+	/// Skips over spaces and tabs, stopping at the next token or line break
+	/// </summary>
+	void SkipWhitespace() {
+		while (_current < _end && (*_current == ' ' || *_current == '\t')) {
+			_current++;
+		}
+	}
+	/// <summary>
+	/// Skips to the first character of the next line
+	/// </summary>
+	void SkipLine() {
+		while (_current < _end && *_current != '\n') {
+			_current++;
+		}
+		if (_current < _end) {
+			_current++;
+		}
+	}
+
+	/// <summary>
+	/// Reads the next whitespace separated token on the current line, will be empty if the line has no more tokens
+	/// </summary>
+	std::string_view ReadToken() {
+		SkipWhitespace();
+		const char* start = _current;
+		while (_current < _end && !_IsSeparator(*_current)) {
+			_current++;
+		}
+		return std::string_view(start, static_cast<size_t>(_current - start));
+	}
+
+	/// <summary>
+	/// Consumes the given character if it is the next one in the buffer
+	/// </summary>
+	/// <param name="c">The character to look for</param>
+	/// <returns>True if the character was consumed, false if otherwise</returns>
+	bool TryConsume(char c) {
+		if (_current < _end && *_current == c) {
+			_current++;
+			return true;
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Reads a floating point number from the current line, skipping any leading whitespace. On failure, the
+	/// read position is left unchanged
+	/// </summary>
+	/// <param name="result">Receives the parsed value</param>
+	/// <returns>True if a number was read, false if otherwise</returns>
+	bool ReadFloat(float& result) {
+		return _ReadNumber(result);
+	}
+	/// <summary>
+	/// Reads a signed integer from the current line, skipping any leading whitespace. On failure, the
+	/// read position is left unchanged
+	/// </summary>
+	/// <param name="result">Receives the parsed value</param>
+	/// <returns>True if a number was read, false if otherwise</returns>
+	bool ReadInt(int32_t& result) {
+		return _ReadNumber(result);
+	}
+
+private:
+	const char* _current;
+	const char* _end;
+
+	static bool _IsSeparator(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	template <typename T>
+	bool _ReadNumber(T& result) {
+		SkipWhitespace();
+		const char* start = _current;
+		// from_chars does not accept a leading plus sign, but plenty of exporters write them
+		if (start < _end && *start == '+') {
+			start++;
+		}
+		std::from_chars_result parsed = std::from_chars(start, _end, result);
+		if (parsed.ec != std::errc()) {
+			return false;
+		}
+		_current = parsed.ptr;
+		return true;
+	}
+};
@@ -0,0 +1,103 @@
+#include "TextureArrayPacker.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Logging.h"
+
+/// <summary>
+/// Checks if two textures can go in the same array. Samplers belong to the array rather than a layer, so the
+/// sampler settings need to match as well as the storage
+/// </summary>
+inline bool CanShareArray(const Texture2D& a, const Texture2D& b) {
+	const Texture2DDescription& l = a.GetDescription();
+	const Texture2DDescription& r = b.GetDescription();
+	return
+		l.Width == r.Width && l.Height == r.Height && l.Format == r.Format &&
+		a.GetLevelCount() == b.GetLevelCount() &&
+		l.HorizontalWrap == r.HorizontalWrap && l.VerticalWrap == r.VerticalWrap &&
+		l.MinificationFilter == r.MinificationFilter && l.MagnificationFilter == r.MagnificationFilter &&
+		l.MaxAnisotropic == r.MaxAnisotropic;
+}
+
+size_t TextureArraySet::GetResidentBytes() const {
+	size_t result = 0;
+	for (const Texture2DArray::sptr& array : Arrays) {
+		result += array->GetResidentBytes();
+	}
+	return result;
+}
+
+TextureArraySet::sptr TextureArrayPacker::Pack(const std::vector<Texture2D::sptr>& textures, const TextureArrayPackOptions& options) {
+	const uint32_t maxLayers = options.MaxLayers > 0 ?
+		std::min<uint32_t>(options.MaxLayers, ITexture::GetLimits().MAX_ARRAY_TEXTURE_LAYERS) :
+		ITexture::GetLimits().MAX_ARRAY_TEXTURE_LAYERS;
+
+	// Sort the unique textures into groups first, so we know how many layers each array needs before creating it
+	std::vector<std::vector<Texture2D::sptr>> groups;
+	std::unordered_map<const Texture2D*, std::pair<size_t, uint32_t>> placement;
+	for (const Texture2D::sptr& texture : textures) {
+		if (texture == nullptr || placement.count(texture.get()) > 0) {
+			continue;
+		}
+		auto it = std::find_if(groups.begin(), groups.end(), [&](const std::vector<Texture2D::sptr>& group) {
+			return group.size() < maxLayers && CanShareArray(*group.front(), *texture);
+		});
+		if (it == groups.end()) {
+			it = groups.insert(groups.end(), std::vector<Texture2D::sptr>());
+		}
+		placement[texture.get()] = { static_cast<size_t>(it - groups.begin()), static_cast<uint32_t>(it->size()) };
+		it->push_back(texture);
+	}
+
+	TextureArraySet::sptr result = std::make_shared<TextureArraySet>();
+	result->Arrays.reserve(groups.size());
+	for (const std::vector<Texture2D::sptr>& group : groups) {
+		const Texture2DDescription& source = group.front()->GetDescription();
+		Texture2DArrayDescription desc;
+		desc.Width = source.Width;
+		desc.Height = source.Height;
+		desc.Layers = static_cast<uint32_t>(group.size());
+		desc.LevelCount = group.front()->GetLevelCount();
+		desc.Format = source.Format;
+		desc.HorizontalWrap = source.HorizontalWrap;
+		desc.VerticalWrap = source.VerticalWrap;
+		desc.MinificationFilter = source.MinificationFilter;
+		desc.MagnificationFilter = source.MagnificationFilter;
+		desc.MaxAnisotropic = source.MaxAnisotropic;
+
+		Texture2DArray::sptr array = Texture2DArray::Create(desc);
+		for (uint32_t layer = 0; layer < desc.Layers; layer++) {
+			array->CopyLayer(layer, group[layer]);
+		}
+		result->Arrays.push_back(array);
+	}
+
+	result->Slots.reserve(textures.size());
+	for (const Texture2D::sptr& texture : textures) {
+		if (texture == nullptr) {
+			result->Slots.push_back(TextureArraySlot());
+			continue;
+		}
+		const std::pair<size_t, uint32_t>& place = placement[texture.get()];
+		result->Slots.push_back(TextureArraySlot(result->Arrays[place.first], place.second));
+	}
+
+	LOG_INFO("Packed {} textures into {} texture arrays ({:.2f} MB)", placement.size(), result->Arrays.size(), result->GetResidentBytes() / (1024.0f * 1024.0f));
+	return result;
+}
+
+TextureArraySet::sptr TextureArrayPacker::CreatePlaceholder(size_t count, const glm::vec4& color) {
+	Texture2DArrayDescription desc;
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.Layers = 1;
+	desc.Format = InternalFormat::RGBA8;
+	Texture2DArray::sptr array = Texture2DArray::Create(desc);
+	array->Clear(color);
+
+	TextureArraySet::sptr result = std::make_shared<TextureArraySet>();
+	result->Arrays.push_back(array);
+	result->Slots.assign(count, TextureArraySlot(array, 0));
+	return result;
+}
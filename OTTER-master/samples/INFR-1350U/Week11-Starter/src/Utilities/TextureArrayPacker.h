@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DArray.h"
+
+/// <summary>
+/// Options that control how TextureArrayPacker groups textures into arrays
+/// </summary>
+struct TextureArrayPackOptions
+{
+	/// <summary>
+	/// The most layers to put in a single array, larger groups are split across several arrays. 0 will use the
+	/// GPU's limit (see ITexture::Limits::MAX_ARRAY_TEXTURE_LAYERS)
+	/// </summary>
+	uint32_t MaxLayers;
+
+	TextureArrayPackOptions() :
+		MaxLayers(0)
+	{ }
+};
+
+/// <summary>
+/// The result of packing a list of textures into arrays
+/// </summary>
+struct TextureArraySet
+{
+	typedef std::shared_ptr<TextureArraySet> sptr;
+
+	/// <summary>
+	/// Where each texture ended up, in the same order as the textures that were packed
+	/// </summary>
+	std::vector<TextureArraySlot>     Slots;
+	/// <summary>
+	/// Every array that was created, in the order of the first texture that went into each
+	/// </summary>
+	std::vector<Texture2DArray::sptr> Arrays;
+
+	/// <summary>
+	/// Gets the number of bytes of GPU memory used by all of the arrays
+	/// </summary>
+	size_t GetResidentBytes() const;
+};
+
+/// <summary>
+/// Packs textures that share a size, format, level count and sampler settings into GL_TEXTURE_2D_ARRAY textures,
+/// so that materials which only differ by their images can use the same binding and a layer index instead (see
+/// ShaderMaterial::Set). The images are copied on the GPU, so the textures need to be resident already, which is
+/// why this is usually done through AssetLoader::LoadTextureArrays. Textures that don't match anything else still
+/// get an array of their own, so that shaders only need a single path
+/// </summary>
+class TextureArrayPacker
+{
+public:
+	/// <summary>
+	/// Packs a list of textures into as few arrays as possible. Listing the same texture more than once gives each
+	/// entry the same slot. Must be called from the main thread
+	/// </summary>
+	/// <param name="textures">The textures to pack</param>
+	/// <param name="options">The options for grouping the textures</param>
+	/// <returns>The arrays, and the slot for each texture in the same order as textures</returns>
+	static TextureArraySet::sptr Pack(const std::vector<Texture2D::sptr>& textures, const TextureArrayPackOptions& options = TextureArrayPackOptions());
+
+	/// <summary>
+	/// Makes a set that points every one of count slots at the same 1x1 layer of a single colour, for materials
+	/// to use while the real set is loading
+	/// </summary>
+	/// <param name="count">The number of slots to make</param>
+	/// <param name="color">The colour of the layer</param>
+	static TextureArraySet::sptr CreatePlaceholder(size_t count, const glm::vec4& color = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+
+protected:
+	TextureArrayPacker() = default;
+	~TextureArrayPacker() = default;
+};
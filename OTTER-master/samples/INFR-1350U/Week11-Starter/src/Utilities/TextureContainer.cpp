@@ -0,0 +1,372 @@
+#include "TextureContainer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "Logging.h"
+
+// See https://docs.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+struct DdsPixelFormat
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t FourCC;
+	uint32_t RgbBitCount;
+	uint32_t Masks[4];
+};
+
+struct DdsHeader
+{
+	uint32_t       Size;
+	uint32_t       Flags;
+	uint32_t       Height;
+	uint32_t       Width;
+	uint32_t       PitchOrLinearSize;
+	uint32_t       Depth;
+	uint32_t       MipMapCount;
+	uint32_t       Reserved1[11];
+	DdsPixelFormat PixelFormat;
+	uint32_t       Caps;
+	uint32_t       Caps2;
+	uint32_t       Caps3;
+	uint32_t       Caps4;
+	uint32_t       Reserved2;
+};
+
+struct DdsHeaderDx10
+{
+	uint32_t DxgiFormat;
+	uint32_t ResourceDimension;
+	uint32_t MiscFlag;
+	uint32_t ArraySize;
+	uint32_t MiscFlags2;
+};
+
+// See https://github.khronos.org/KTX-Specification/, the level index follows right after the header
+struct Ktx2Header
+{
+	uint8_t  Identifier[12];
+	uint32_t VkFormat;
+	uint32_t TypeSize;
+	uint32_t PixelWidth;
+	uint32_t PixelHeight;
+	uint32_t PixelDepth;
+	uint32_t LayerCount;
+	uint32_t FaceCount;
+	uint32_t LevelCount;
+	uint32_t SupercompressionScheme;
+	uint32_t DfdByteOffset;
+	uint32_t DfdByteLength;
+	uint32_t KvdByteOffset;
+	uint32_t KvdByteLength;
+	uint64_t SgdByteOffset;
+	uint64_t SgdByteLength;
+};
+
+struct Ktx2LevelIndex
+{
+	uint64_t ByteOffset;
+	uint64_t ByteLength;
+	uint64_t UncompressedByteLength;
+};
+
+static_assert(sizeof(DdsHeader) == 124, "DDS header must match the file layout");
+static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must match the file layout");
+
+static constexpr uint8_t DdsMagic[4] = { 'D', 'D', 'S', ' ' };
+static constexpr uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// The DDS flags and caps we read or write
+static constexpr uint32_t DdsFlagsRequired = 0x1 | 0x2 | 0x4 | 0x1000; // CAPS | HEIGHT | WIDTH | PIXELFORMAT
+static constexpr uint32_t DdsFlagMipMapCount = 0x20000;
+static constexpr uint32_t DdsFlagLinearSize = 0x80000;
+static constexpr uint32_t DdsPixelFormatFourCC = 0x4;
+static constexpr uint32_t DdsCapsComplex = 0x8;
+static constexpr uint32_t DdsCapsTexture = 0x1000;
+static constexpr uint32_t DdsCapsMipMap = 0x400000;
+static constexpr uint32_t DdsCaps2CubeMap = 0x200;
+static constexpr uint32_t DdsCaps2Volume = 0x200000;
+static constexpr uint32_t DdsDimensionTexture2D = 3;
+static constexpr uint32_t DdsMiscTextureCube = 0x4;
+
+/// <summary>
+/// Builds a FourCC code the same way the DDS headers store them
+/// </summary>
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+	return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+}
+
+/// <summary>
+/// Maps a DDS FourCC code to our internal format, or Unknown if we don't support it
+/// </summary>
+inline InternalFormat FormatFromFourCC(uint32_t fourCC) {
+	switch (fourCC) {
+		// DXT1 can have a 1 bit alpha, but we don't use it for anything so it gets dropped
+		case MakeFourCC('D', 'X', 'T', '1'): return InternalFormat::BC1;
+		case MakeFourCC('D', 'X', 'T', '5'): return InternalFormat::BC3;
+		case MakeFourCC('A', 'T', 'I', '1'):
+		case MakeFourCC('B', 'C', '4', 'U'): return InternalFormat::BC4;
+		case MakeFourCC('A', 'T', 'I', '2'):
+		case MakeFourCC('B', 'C', '5', 'U'): return InternalFormat::BC5;
+		default: return InternalFormat::Unknown;
+	}
+}
+
+// The DXGI_FORMAT values for the formats we support
+static constexpr uint32_t DxgiBC1 = 71;
+static constexpr uint32_t DxgiBC3 = 77;
+static constexpr uint32_t DxgiBC4 = 80;
+static constexpr uint32_t DxgiBC5 = 83;
+static constexpr uint32_t DxgiBC7 = 98;
+
+/// <summary>
+/// Maps a DXGI_FORMAT to our internal format, or Unknown if we don't support it
+/// </summary>
+inline InternalFormat FormatFromDxgi(uint32_t format) {
+	switch (format) {
+		case DxgiBC1: return InternalFormat::BC1;
+		case DxgiBC3: return InternalFormat::BC3;
+		case DxgiBC4: return InternalFormat::BC4;
+		case DxgiBC5: return InternalFormat::BC5;
+		case DxgiBC7: return InternalFormat::BC7;
+		default: return InternalFormat::Unknown;
+	}
+}
+
+/// <summary>
+/// Maps one of our internal formats to a DXGI_FORMAT, or 0 (DXGI_FORMAT_UNKNOWN) if it can't be stored in a DDS file
+/// </summary>
+inline uint32_t FormatToDxgi(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::BC1: return DxgiBC1;
+		case InternalFormat::BC3: return DxgiBC3;
+		case InternalFormat::BC4: return DxgiBC4;
+		case InternalFormat::BC5: return DxgiBC5;
+		case InternalFormat::BC7: return DxgiBC7;
+		default: return 0;
+	}
+}
+
+/// <summary>
+/// Maps a Vulkan VkFormat (what KTX2 uses) to our internal format, or Unknown if we don't support it
+/// </summary>
+inline InternalFormat FormatFromVulkan(uint32_t format) {
+	switch (format) {
+		case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+		case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+			return InternalFormat::BC1;
+		case 137: return InternalFormat::BC3; // VK_FORMAT_BC3_UNORM_BLOCK
+		case 139: return InternalFormat::BC4; // VK_FORMAT_BC4_UNORM_BLOCK
+		case 141: return InternalFormat::BC5; // VK_FORMAT_BC5_UNORM_BLOCK
+		case 145: return InternalFormat::BC7; // VK_FORMAT_BC7_UNORM_BLOCK
+		default: return InternalFormat::Unknown;
+	}
+}
+
+bool TextureContainer::IsContainer(const void* data, size_t size) {
+	return (size >= sizeof(DdsMagic) && memcmp(data, DdsMagic, sizeof(DdsMagic)) == 0) ||
+		(size >= sizeof(Ktx2Identifier) && memcmp(data, Ktx2Identifier, sizeof(Ktx2Identifier)) == 0);
+}
+
+bool TextureContainer::ReadLayout(const void* data, size_t size, const std::string& debugName, InternalFormat& format, std::vector<Texture2DLevel>& levels) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	if (size >= sizeof(DdsMagic) && memcmp(bytes, DdsMagic, sizeof(DdsMagic)) == 0) {
+		return _ReadDds(bytes, size, debugName, format, levels);
+	}
+	else if (size >= sizeof(Ktx2Identifier) && memcmp(bytes, Ktx2Identifier, sizeof(Ktx2Identifier)) == 0) {
+		return _ReadKtx2(bytes, size, debugName, format, levels);
+	}
+	else {
+		LOG_WARN("Image \"{}\" is not a DDS or KTX2 file", debugName);
+		return false;
+	}
+}
+
+Texture2DData::sptr TextureContainer::Read(const void* data, size_t size, const std::string& debugName, uint32_t firstLevel, uint32_t levelCount) {
+	InternalFormat format;
+	std::vector<Texture2DLevel> levels;
+	if (!ReadLayout(data, size, debugName, format, levels)) {
+		return nullptr;
+	}
+	if (firstLevel >= levels.size()) {
+		LOG_WARN("Image \"{}\" only has {} levels, can't read from level {}", debugName, levels.size(), firstLevel);
+		return nullptr;
+	}
+
+	// Only the span of the file that covers the levels we want gets copied, so reading the small end of a chain
+	// doesn't touch the large levels at all
+	levelCount = std::min(levelCount, static_cast<uint32_t>(levels.size()) - firstLevel);
+	levels = std::vector<Texture2DLevel>(levels.begin() + firstLevel, levels.begin() + firstLevel + levelCount);
+	size_t start = std::numeric_limits<size_t>::max();
+	size_t end = 0;
+	for (const Texture2DLevel& level : levels) {
+		start = std::min(start, level.Offset);
+		end = std::max(end, level.Offset + level.Size);
+	}
+	for (Texture2DLevel& level : levels) {
+		level.Offset -= start;
+	}
+	Texture2DData::sptr result = Texture2DData::CreateCompressed(format, levels, static_cast<const uint8_t*>(data) + start, end - start);
+	result->DebugName = debugName;
+	return result;
+}
+
+bool TextureContainer::_ReadDds(const uint8_t* data, size_t size, const std::string& debugName, InternalFormat& format, std::vector<Texture2DLevel>& levels) {
+	DdsHeader header;
+	if (size < sizeof(DdsMagic) + sizeof(DdsHeader)) {
+		LOG_WARN("DDS file \"{}\" is truncated", debugName);
+		return false;
+	}
+	memcpy(&header, data + sizeof(DdsMagic), sizeof(DdsHeader));
+	size_t offset = sizeof(DdsMagic) + sizeof(DdsHeader);
+	if (header.Size != sizeof(DdsHeader) || (header.Flags & DdsFlagsRequired) != DdsFlagsRequired || header.Width == 0 || header.Height == 0) {
+		LOG_WARN("DDS file \"{}\" has a malformed header", debugName);
+		return false;
+	}
+	if ((header.Caps2 & (DdsCaps2CubeMap | DdsCaps2Volume)) != 0) {
+		LOG_WARN("DDS file \"{}\" is a cube map or volume, only 2D textures are supported", debugName);
+		return false;
+	}
+	if ((header.PixelFormat.Flags & DdsPixelFormatFourCC) == 0) {
+		LOG_WARN("DDS file \"{}\" is not block compressed", debugName);
+		return false;
+	}
+
+	// Formats that came after DXT5 (ex: BC7) are described by an extra header
+	if (header.PixelFormat.FourCC == MakeFourCC('D', 'X', '1', '0')) {
+		DdsHeaderDx10 dx10;
+		if (size < offset + sizeof(DdsHeaderDx10)) {
+			LOG_WARN("DDS file \"{}\" is truncated", debugName);
+			return false;
+		}
+		memcpy(&dx10, data + offset, sizeof(DdsHeaderDx10));
+		offset += sizeof(DdsHeaderDx10);
+		if (dx10.ResourceDimension != DdsDimensionTexture2D || dx10.ArraySize > 1 || (dx10.MiscFlag & DdsMiscTextureCube) != 0) {
+			LOG_WARN("DDS file \"{}\" is not a single 2D texture", debugName);
+			return false;
+		}
+		format = FormatFromDxgi(dx10.DxgiFormat);
+	} else {
+		format = FormatFromFourCC(header.PixelFormat.FourCC);
+	}
+	if (format == InternalFormat::Unknown) {
+		LOG_WARN("DDS file \"{}\" uses a format we don't support, only BC1, BC3, BC4, BC5 and BC7 can be loaded", debugName);
+		return false;
+	}
+
+	// The levels are stored back to back, largest first
+	const uint32_t levelCount = (header.Flags & DdsFlagMipMapCount) != 0 ? std::max(header.MipMapCount, 1u) : 1;
+	if (levelCount > GetMipLevelCount(header.Width, header.Height)) {
+		LOG_WARN("DDS file \"{}\" has more mip levels than its size allows", debugName);
+		return false;
+	}
+	levels.resize(levelCount);
+	size_t levelOffset = offset;
+	for (uint32_t ix = 0; ix < levelCount; ix++) {
+		Texture2DLevel& level = levels[ix];
+		level.Width = std::max(header.Width >> ix, 1u);
+		level.Height = std::max(header.Height >> ix, 1u);
+		level.Offset = levelOffset;
+		level.Size = GetTextureLevelSize(format, level.Width, level.Height);
+		levelOffset += level.Size;
+	}
+	if (size < levelOffset) {
+		LOG_WARN("DDS file \"{}\" is truncated", debugName);
+		return false;
+	}
+	return true;
+}
+
+bool TextureContainer::_ReadKtx2(const uint8_t* data, size_t size, const std::string& debugName, InternalFormat& format, std::vector<Texture2DLevel>& levels) {
+	Ktx2Header header;
+	if (size < sizeof(Ktx2Header)) {
+		LOG_WARN("KTX2 file \"{}\" is truncated", debugName);
+		return false;
+	}
+	memcpy(&header, data, sizeof(Ktx2Header));
+	if (header.PixelWidth == 0 || header.PixelHeight == 0 || header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1) {
+		LOG_WARN("KTX2 file \"{}\" is not a single 2D texture", debugName);
+		return false;
+	}
+	if (header.SupercompressionScheme != 0) {
+		LOG_WARN("KTX2 file \"{}\" is supercompressed, which is not supported", debugName);
+		return false;
+	}
+	format = FormatFromVulkan(header.VkFormat);
+	if (format == InternalFormat::Unknown) {
+		LOG_WARN("KTX2 file \"{}\" uses a format we don't support, only BC1, BC3, BC4, BC5 and BC7 can be loaded", debugName);
+		return false;
+	}
+
+	// A level count of 0 asks the loader to generate the mips, which we can't do for compressed data
+	const uint32_t levelCount = std::max(header.LevelCount, 1u);
+	if (levelCount > GetMipLevelCount(header.PixelWidth, header.PixelHeight) || size < sizeof(Ktx2Header) + levelCount * sizeof(Ktx2LevelIndex)) {
+		LOG_WARN("KTX2 file \"{}\" has a malformed level index", debugName);
+		return false;
+	}
+
+	// KTX2 stores the smallest level first, with padding between the levels, so each level gets its offset from the index
+	std::vector<Ktx2LevelIndex> index(levelCount);
+	memcpy(index.data(), data + sizeof(Ktx2Header), levelCount * sizeof(Ktx2LevelIndex));
+	levels.resize(levelCount);
+	for (uint32_t ix = 0; ix < levelCount; ix++) {
+		Texture2DLevel& level = levels[ix];
+		level.Width = std::max(header.PixelWidth >> ix, 1u);
+		level.Height = std::max(header.PixelHeight >> ix, 1u);
+		level.Size = GetTextureLevelSize(format, level.Width, level.Height);
+		if (index[ix].ByteLength != level.Size || index[ix].ByteOffset > size || size - index[ix].ByteOffset < level.Size) {
+			LOG_WARN("KTX2 file \"{}\" has a malformed level index", debugName);
+			return false;
+		}
+		level.Offset = static_cast<size_t>(index[ix].ByteOffset);
+	}
+	return true;
+}
+
+bool TextureContainer::WriteDds(const std::string& path, const Texture2DData::sptr& data) {
+	LOG_ASSERT(data != nullptr && data->IsCompressed(), "Only compressed texture data can be written to a DDS file!");
+	const uint32_t dxgiFormat = FormatToDxgi(data->GetRecommendedFormat());
+	LOG_ASSERT(dxgiFormat != 0, "Format {} cannot be stored in a DDS file!", data->GetRecommendedFormat());
+
+	DdsHeader header;
+	memset(&header, 0, sizeof(DdsHeader));
+	header.Size = sizeof(DdsHeader);
+	header.Flags = DdsFlagsRequired | DdsFlagMipMapCount | DdsFlagLinearSize;
+	header.Width = data->GetWidth();
+	header.Height = data->GetHeight();
+	header.PitchOrLinearSize = static_cast<uint32_t>(data->GetLevel(0).Size);
+	header.MipMapCount = data->GetLevelCount();
+	header.PixelFormat.Size = sizeof(DdsPixelFormat);
+	header.PixelFormat.Flags = DdsPixelFormatFourCC;
+	header.PixelFormat.FourCC = MakeFourCC('D', 'X', '1', '0');
+	header.Caps = DdsCapsTexture | (data->GetLevelCount() > 1 ? DdsCapsComplex | DdsCapsMipMap : 0);
+
+	DdsHeaderDx10 dx10;
+	dx10.DxgiFormat = dxgiFormat;
+	dx10.ResourceDimension = DdsDimensionTexture2D;
+	dx10.MiscFlag = 0;
+	dx10.ArraySize = 1;
+	dx10.MiscFlags2 = 0;
+
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	if (!stream.is_open()) {
+		LOG_WARN("Failed to open \"{}\" for writing", path);
+		return false;
+	}
+	stream.write(reinterpret_cast<const char*>(DdsMagic), sizeof(DdsMagic));
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(DdsHeader));
+	stream.write(reinterpret_cast<const char*>(&dx10), sizeof(DdsHeaderDx10));
+	const char* bytes = static_cast<const char*>(data->GetDataPtr());
+	for (uint32_t ix = 0; ix < data->GetLevelCount(); ix++) {
+		const Texture2DLevel& level = data->GetLevel(ix);
+		stream.write(bytes + level.Offset, level.Size);
+	}
+	if (!stream.good()) {
+		LOG_WARN("Failed to write \"{}\"", path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Graphics/Texture2DData.h"
+
+/// <summary>
+/// Reads and writes the container formats that block compressed textures are shipped in. DDS (with either a
+/// FourCC or a DX10 header) and KTX2 (without supercompression) can be read, and DDS files can be written.
+/// Only single 2D images are supported, cube maps and arrays are rejected.
+///
+/// Block compressed data can't be flipped without re-encoding it, so the rows are uploaded in the order they are
+/// stored. To match Texture2DData::LoadFromFile, the first row should be the bottom of the image, the TextureCooker
+/// writes its files this way. Files exported top row first by other tools will show up upside down
+/// </summary>
+class TextureContainer
+{
+public:
+	/// <summary>
+	/// Checks if a file's contents start with the signature of a container we can read
+	/// </summary>
+	/// <param name="data">A pointer to the start of the file</param>
+	/// <param name="size">The size of the file, in bytes</param>
+	static bool IsContainer(const void* data, size_t size);
+
+	/// <summary>
+	/// Reads the format and the size and location of every level of a DDS or KTX2 file, without copying any of
+	/// the image data
+	/// </summary>
+	/// <param name="data">A pointer to the start of the file</param>
+	/// <param name="size">The size of the file, in bytes</param>
+	/// <param name="debugName">The name to give the image in debug messages</param>
+	/// <param name="format">Receives the block compressed format of the file</param>
+	/// <param name="levels">Receives every level in the file, largest first, with offsets from the start of the file</param>
+	/// <returns>True if the file could be read, false if it is malformed or uses a format we don't support</returns>
+	static bool ReadLayout(const void* data, size_t size, const std::string& debugName, InternalFormat& format, std::vector<Texture2DLevel>& levels);
+	/// <summary>
+	/// Reads the mip chain out of a DDS or KTX2 file, or a range of it (ex: only the smallest levels, see TextureStreamer)
+	/// </summary>
+	/// <param name="data">A pointer to the start of the file</param>
+	/// <param name="size">The size of the file, in bytes</param>
+	/// <param name="debugName">The name to give the image in debug messages</param>
+	/// <param name="firstLevel">The first level to read, 0 being the largest. This becomes level 0 of the result</param>
+	/// <param name="levelCount">The most levels to read, the range is clamped to the levels in the file</param>
+	/// <returns>The compressed texture data, or nullptr if the file is malformed or uses a format we don't support</returns>
+	static Texture2DData::sptr Read(const void* data, size_t size, const std::string& debugName, uint32_t firstLevel = 0, uint32_t levelCount = UINT32_MAX);
+	/// <summary>
+	/// Writes block compressed texture data to a DDS file, using the DX10 header
+	/// </summary>
+	/// <param name="path">The path of the file to write, any existing file is overwritten</param>
+	/// <param name="data">The compressed data to write, see Texture2DData::IsCompressed</param>
+	/// <returns>True if the file was written, false if otherwise</returns>
+	static bool WriteDds(const std::string& path, const Texture2DData::sptr& data);
+
+protected:
+	TextureContainer() = default;
+	~TextureContainer() = default;
+
+	static bool _ReadDds(const uint8_t* data, size_t size, const std::string& debugName, InternalFormat& format, std::vector<Texture2DLevel>& levels);
+	static bool _ReadKtx2(const uint8_t* data, size_t size, const std::string& debugName, InternalFormat& format, std::vector<Texture2DLevel>& levels);
+};
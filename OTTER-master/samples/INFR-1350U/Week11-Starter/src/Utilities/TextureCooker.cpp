@@ -0,0 +1,161 @@
+#include "TextureCooker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+#include "Logging.h"
+#include "BcEncoder.h"
+#include "MipGenerator.h"
+#include "TextureContainer.h"
+#include "VirtualFileSystem.h"
+
+/// <summary>
+/// Checks if a file is one of the image types that we cook
+/// </summary>
+inline bool IsCookableImage(const std::filesystem::path& path) {
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+}
+
+std::string TextureCooker::GetCookedPath(const std::string& sourcePath) {
+	return sourcePath + Extension;
+}
+
+std::string TextureCooker::FindCooked(const std::string& sourcePath) {
+	const std::string cookedPath = GetCookedPath(sourcePath);
+	uint64_t cookedSize, sourceSize;
+	int64_t cookedTime, sourceTime;
+	if (!VirtualFileSystem::Stat(cookedPath, cookedSize, cookedTime)) {
+		return sourcePath;
+	}
+	// A build may ship only the cooked files, in which case there's nothing to compare against
+	if (!VirtualFileSystem::Stat(sourcePath, sourceSize, sourceTime) || cookedTime >= sourceTime) {
+		return cookedPath;
+	}
+	return sourcePath;
+}
+
+Texture2DData::sptr TextureCooker::Cook(const Texture2DData::sptr& source, const TextureCookOptions& options) {
+	LOG_ASSERT(!source->IsCompressed(), "Texture data is already compressed!");
+	LOG_ASSERT(source->GetPixelType() == PixelType::UByte, "Only 8 bit images can be cooked!");
+	LOG_ASSERT(source->GetFormat() != PixelFormat::BGR && source->GetFormat() != PixelFormat::BGRA, "BGR images can't be cooked!");
+	const uint32_t width = source->GetWidth();
+	const uint32_t height = source->GetHeight();
+	const int channels = GetTexelComponentCount(source->GetFormat());
+
+	// The mips are built before expanding to RGBA, so the channels of 1 and 2 channel images are treated as data
+	const uint8_t* texels = static_cast<const uint8_t*>(source->GetDataPtr());
+	std::vector<uint8_t> chain(texels, texels + source->GetDataSize());
+	std::vector<Texture2DLevel> sourceLevels;
+	for (uint32_t ix = 0; ix < (options.GenerateMipMaps ? source->GetLevelCount() : 1); ix++) {
+		sourceLevels.push_back(source->GetLevel(ix));
+	}
+	if (options.GenerateMipMaps && sourceLevels.size() == 1) {
+		sourceLevels = MipGenerator::GetLevelLayout(width, height, channels);
+		chain.resize(sourceLevels.back().Offset + sourceLevels.back().Size);
+		MipGenerationOptions mipOptions = MipGenerator::GetDefaultOptions(source->DebugName);
+		mipOptions.ThreadCount = options.ThreadCount;
+		MipGenerator::Generate(chain.data(), sourceLevels, channels, mipOptions);
+	}
+
+	bool opaque = true;
+	for (size_t ix = 0; channels == 4 && ix < (size_t)width * height; ix++) {
+		opaque &= chain[ix * 4 + 3] == 255;
+	}
+	InternalFormat format;
+	switch (channels) {
+		case 1:
+			format = InternalFormat::BC4;
+			break;
+		case 2:
+			format = InternalFormat::BC5;
+			break;
+		default:
+			format = options.HighQuality ? InternalFormat::BC7 : (opaque ? InternalFormat::BC1 : InternalFormat::BC3);
+			break;
+	}
+
+	// Lay out the compressed levels first, so we can compress straight into one buffer
+	std::vector<Texture2DLevel> levels;
+	size_t dataSize = 0;
+	for (const Texture2DLevel& level : sourceLevels) {
+		const size_t size = GetTextureLevelSize(format, level.Width, level.Height);
+		levels.push_back({ level.Width, level.Height, dataSize, size });
+		dataSize += size;
+	}
+
+	// Every level gets expanded to RGBA so the encoder only has to deal with one layout
+	std::vector<uint8_t> compressed(dataSize);
+	std::vector<uint8_t> rgba;
+	for (size_t ix = 0; ix < levels.size(); ix++) {
+		const Texture2DLevel& level = sourceLevels[ix];
+		const uint8_t* levelTexels = chain.data() + level.Offset;
+		rgba.resize((size_t)level.Width * level.Height * 4);
+		for (size_t texel = 0; texel < (size_t)level.Width * level.Height; texel++) {
+			uint8_t* result = rgba.data() + texel * 4;
+			result[0] = result[1] = result[2] = 0;
+			result[3] = 255;
+			for (int c = 0; c < channels; c++) {
+				result[c] = levelTexels[texel * channels + c];
+			}
+		}
+		BcEncoder::Encode(rgba.data(), level.Width, level.Height, format, compressed.data() + levels[ix].Offset, options.ThreadCount);
+	}
+
+	Texture2DData::sptr result = Texture2DData::CreateCompressed(format, levels, compressed.data(), compressed.size());
+	result->DebugName = source->DebugName;
+	return result;
+}
+
+bool TextureCooker::CookFile(const std::string& sourcePath, const TextureCookOptions& options) {
+	Texture2DData::sptr source = Texture2DData::LoadFromFile(sourcePath);
+	if (source == nullptr) {
+		return false;
+	}
+	if (source->IsCompressed() || source->GetPixelType() != PixelType::UByte) {
+		LOG_WARN("Image \"{}\" can't be cooked, only 8 bit uncompressed images are supported", sourcePath);
+		return false;
+	}
+
+	Texture2DData::sptr cooked = Cook(source, options);
+	const std::string cookedPath = GetCookedPath(sourcePath);
+	if (!TextureContainer::WriteDds(cookedPath, cooked)) {
+		return false;
+	}
+	LOG_INFO("Cooked \"{}\" as {} with {} levels ({:.2f} MB -> {:.2f} MB)", sourcePath, ~cooked->GetRecommendedFormat(), cooked->GetLevelCount(),
+		source->GetDataSize() / (1024.0f * 1024.0f), cooked->GetDataSize() / (1024.0f * 1024.0f));
+	return true;
+}
+
+size_t TextureCooker::CookDirectory(const std::string& rootDirectory, const TextureCookOptions& options) {
+	namespace fs = std::filesystem;
+
+	std::error_code error;
+	std::vector<std::string> sources;
+	for (fs::recursive_directory_iterator it(rootDirectory, error), end; !error && it != end; it.increment(error)) {
+		if (it->is_regular_file() && IsCookableImage(it->path())) {
+			sources.push_back(it->path().string());
+		}
+	}
+	if (error) {
+		LOG_WARN("Failed to list the files in \"{}\": {}", rootDirectory, error.message());
+	}
+	std::sort(sources.begin(), sources.end());
+
+	size_t result = 0;
+	for (const std::string& source : sources) {
+		// Files with an up to date cooked version are skipped, so cooking again only does what has changed
+		if (FindCooked(source) != source) {
+			continue;
+		}
+		if (CookFile(source, options)) {
+			result++;
+		}
+	}
+	LOG_INFO("Cooked {} of {} images under \"{}\"", result, sources.size(), rootDirectory);
+	return result;
+}
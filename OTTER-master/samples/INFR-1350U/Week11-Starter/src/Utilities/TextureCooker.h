@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "Graphics/Texture2DData.h"
+
+/// <summary>
+/// Options that control how source images get cooked into block compressed textures
+/// </summary>
+struct TextureCookOptions
+{
+	/// <summary>
+	/// True to use BC7 for colour images, which looks better than BC1 and BC3 but is twice the size of BC1
+	/// </summary>
+	bool     HighQuality;
+	/// <summary>
+	/// True to generate and store the full mip chain (see MipGenerator), since the driver can't generate mips for
+	/// compressed textures
+	/// </summary>
+	bool     GenerateMipMaps;
+	/// <summary>
+	/// The number of threads to compress each level with, 0 will use one per hardware thread
+	/// </summary>
+	uint32_t ThreadCount;
+
+	TextureCookOptions() :
+		HighQuality(false),
+		GenerateMipMaps(true),
+		ThreadCount(0)
+	{ }
+};
+
+/// <summary>
+/// Cooks PNG and JPG images into block compressed DDS files ahead of time, so the game loads them straight into
+/// GPU memory without decoding anything, at a quarter to an eighth of the size. The format is picked from the
+/// image's channels: BC4 for one channel, BC5 for two, BC1 for RGB (or RGBA with no transparency), and BC3 for
+/// RGBA, with BC7 replacing BC1 and BC3 in high quality mode.
+///
+/// Like the MeshCache, cooked files live next to their sources (ex: "textures/brick.png.dds"), and are only used
+/// in place of the source while they are at least as new as it. Run it with the --cook-textures argument (see main.cpp)
+/// </summary>
+class TextureCooker
+{
+public:
+	/// <summary>
+	/// The extension that gets added to the source path to get the path of the cooked file
+	/// </summary>
+	static constexpr const char* Extension = ".dds";
+
+	/// <summary>
+	/// Gets the path that the cooked version of a source image is stored at
+	/// </summary>
+	static std::string GetCookedPath(const std::string& sourcePath);
+	/// <summary>
+	/// Gets the path that an image should be loaded from, this is the cooked file if there is an up to date one,
+	/// or the source path if otherwise
+	/// </summary>
+	/// <param name="sourcePath">The path of the source image</param>
+	static std::string FindCooked(const std::string& sourcePath);
+
+	/// <summary>
+	/// Compresses an image and (optionally) its mip chain
+	/// </summary>
+	/// <param name="source">The uncompressed image data to compress, must have 8 bit components</param>
+	/// <param name="options">The options for cooking the image</param>
+	/// <returns>The compressed data, ready to upload or write out with TextureContainer::WriteDds</returns>
+	static Texture2DData::sptr Cook(const Texture2DData::sptr& source, const TextureCookOptions& options = TextureCookOptions());
+
+	/// <summary>
+	/// Loads an image file, cooks it, and writes the result next to it
+	/// </summary>
+	/// <param name="sourcePath">The path of the image to cook</param>
+	/// <param name="options">The options for cooking the image</param>
+	/// <returns>True if the cooked file was written, false if otherwise (the reason is logged)</returns>
+	static bool CookFile(const std::string& sourcePath, const TextureCookOptions& options = TextureCookOptions());
+	/// <summary>
+	/// Cooks every PNG and JPG image under a directory that doesn't already have an up to date cooked file
+	/// </summary>
+	/// <param name="rootDirectory">The directory to search (recursively) for images</param>
+	/// <param name="options">The options for cooking the images</param>
+	/// <returns>The number of images that were cooked</returns>
+	static size_t CookDirectory(const std::string& rootDirectory, const TextureCookOptions& options = TextureCookOptions());
+
+protected:
+	TextureCooker() = default;
+	~TextureCooker() = default;
+};
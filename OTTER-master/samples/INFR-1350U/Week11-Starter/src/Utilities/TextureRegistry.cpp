@@ -0,0 +1,164 @@
+#include "TextureRegistry.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+#include "Logging.h"
+#include "MeshCache.h"
+#include "MipGenerator.h"
+#include "TextureCooker.h"
+
+std::mutex TextureRegistry::_lock;
+std::unordered_map<std::string, TextureRegistry::Entry> TextureRegistry::_textures;
+size_t TextureRegistry::_hits = 0;
+size_t TextureRegistry::_misses = 0;
+
+uint64_t TextureLoadOptions::GetHash() const {
+	// The width and height are left out, since they come from the image rather than the options
+	const GLint settings[6] = {
+		*Description.Format,
+		*Description.HorizontalWrap,
+		*Description.VerticalWrap,
+		*Description.MinificationFilter,
+		*Description.MagnificationFilter,
+		Description.GenerateMipMaps ? 1 : 0
+	};
+	uint64_t result = MeshCache::Hash(settings, sizeof(settings));
+	result = MeshCache::Hash(&Description.MaxAnisotropic, sizeof(Description.MaxAnisotropic), result);
+	result = MeshCache::Hash(&ForceRgba, sizeof(ForceRgba), result);
+	return result;
+}
+
+Texture2D::sptr TextureRegistry::Load(const std::string& filename, const TextureLoadOptions& options) {
+	const std::string key = _MakeKey(filename, options.GetHash());
+
+	// Like the MeshRegistry, we hold the lock while loading so the same image never gets decoded twice at once
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _textures.find(key);
+	if (it != _textures.end()) {
+		Texture2D::sptr result = it->second.Texture.lock();
+		if (result != nullptr) {
+			_hits++;
+			return result;
+		}
+	}
+
+	_misses++;
+	Texture2DData::sptr data = Texture2DData::LoadFromFile(TextureCooker::FindCooked(filename), options.ForceRgba);
+	if (data == nullptr) {
+		throw std::runtime_error("Failed to load image from file");
+	}
+	if (options.Description.GenerateMipMaps && !data->IsCompressed()) {
+		data->GenerateMipMaps(MipGenerator::GetDefaultOptions(filename));
+	}
+	Texture2D::sptr result = Texture2D::Create(options.Description);
+	result->LoadData(data);
+	_textures[key] = { filename, result };
+	return result;
+}
+
+Texture2D::sptr TextureRegistry::Find(const std::string& filename, const TextureLoadOptions& options) {
+	const std::string key = _MakeKey(filename, options.GetHash());
+
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _textures.find(key);
+	if (it == _textures.end()) {
+		return nullptr;
+	}
+	Texture2D::sptr result = it->second.Texture.lock();
+	if (result != nullptr) {
+		_hits++;
+	}
+	return result;
+}
+
+void TextureRegistry::Register(const std::string& filename, const TextureLoadOptions& options, const Texture2D::sptr& texture) {
+	const std::string key = _MakeKey(filename, options.GetHash());
+
+	std::lock_guard<std::mutex> guard(_lock);
+	_misses++;
+	_textures[key] = { filename, texture };
+}
+
+size_t TextureRegistry::GetRefCount(const std::string& filename, const TextureLoadOptions& options) {
+	const std::string key = _MakeKey(filename, options.GetHash());
+
+	std::lock_guard<std::mutex> guard(_lock);
+	auto it = _textures.find(key);
+	return it != _textures.end() ? static_cast<size_t>(it->second.Texture.use_count()) : 0;
+}
+
+TextureRegistryStats TextureRegistry::GetStats() {
+	std::lock_guard<std::mutex> guard(_lock);
+	TextureRegistryStats result;
+	result.Hits = _hits;
+	result.Misses = _misses;
+	result.ResidentTextures = 0;
+	result.References = 0;
+	result.ResidentBytes = 0;
+	for (const auto& [key, entry] : _textures) {
+		Texture2D::sptr texture = entry.Texture.lock();
+		if (texture != nullptr) {
+			result.ResidentTextures++;
+			// We don't count the reference we just made
+			result.References += static_cast<size_t>(texture.use_count() - 1);
+			result.ResidentBytes += texture->GetResidentBytes();
+		}
+	}
+	return result;
+}
+
+std::vector<TextureRegistryEntry> TextureRegistry::GetResidentTextures() {
+	std::vector<TextureRegistryEntry> result;
+	{
+		std::lock_guard<std::mutex> guard(_lock);
+		result.reserve(_textures.size());
+		for (const auto& [key, entry] : _textures) {
+			Texture2D::sptr texture = entry.Texture.lock();
+			if (texture != nullptr) {
+				result.push_back({ entry.Path, texture->GetWidth(), texture->GetHeight(), texture->GetResidentBytes(), static_cast<size_t>(texture.use_count() - 1) });
+			}
+		}
+	}
+	std::sort(result.begin(), result.end(), [](const TextureRegistryEntry& a, const TextureRegistryEntry& b) {
+		return a.ResidentBytes != b.ResidentBytes ? a.ResidentBytes > b.ResidentBytes : a.Path < b.Path;
+	});
+	return result;
+}
+
+void TextureRegistry::ResetStats() {
+	std::lock_guard<std::mutex> guard(_lock);
+	_hits = 0;
+	_misses = 0;
+}
+
+size_t TextureRegistry::CollectGarbage() {
+	std::lock_guard<std::mutex> guard(_lock);
+	size_t removed = 0;
+	for (auto it = _textures.begin(); it != _textures.end();) {
+		if (it->second.Texture.expired()) {
+			it = _textures.erase(it);
+			removed++;
+		} else {
+			++it;
+		}
+	}
+	return removed;
+}
+
+void TextureRegistry::Clear() {
+	std::lock_guard<std::mutex> guard(_lock);
+	_textures.clear();
+}
+
+std::string TextureRegistry::_MakeKey(const std::string& filename, uint64_t optionsHash) {
+	// Same as the MeshRegistry, the canonical path lets different spellings of the same file share an entry
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(filename, error);
+	std::string result = error ? filename : path.generic_string();
+	result += '|';
+	result += std::to_string(optionsHash);
+	return result;
+}
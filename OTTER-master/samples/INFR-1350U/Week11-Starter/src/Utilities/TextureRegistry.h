@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/Texture2D.h"
+
+/// <summary>
+/// Options that control how an image file gets turned into a texture
+/// </summary>
+struct TextureLoadOptions
+{
+	/// <summary>
+	/// The format and sampler settings for the texture, the width and height are ignored (they come from the image)
+	/// </summary>
+	Texture2DDescription Description;
+	/// <summary>
+	/// True to always decode the image with 4 components, even if the file has fewer
+	/// </summary>
+	bool                 ForceRgba;
+
+	TextureLoadOptions() :
+		Description(Texture2DDescription()),
+		ForceRgba(false)
+	{ }
+
+	/// <summary>
+	/// Gets a hash of the options that affect the texture that gets produced
+	/// </summary>
+	uint64_t GetHash() const;
+};
+
+/// <summary>
+/// Statistics about how effective the texture registry has been
+/// </summary>
+struct TextureRegistryStats
+{
+	/// <summary>
+	/// The number of loads that returned a texture that was already resident
+	/// </summary>
+	size_t Hits;
+	/// <summary>
+	/// The number of loads that had to decode and upload the image
+	/// </summary>
+	size_t Misses;
+	/// <summary>
+	/// The number of unique textures that are currently resident on the GPU
+	/// </summary>
+	size_t ResidentTextures;
+	/// <summary>
+	/// The total number of references to resident textures
+	/// </summary>
+	size_t References;
+	/// <summary>
+	/// The GPU memory used by all the resident textures, in bytes
+	/// </summary>
+	size_t ResidentBytes;
+};
+
+/// <summary>
+/// Describes a single texture that is resident in the registry
+/// </summary>
+struct TextureRegistryEntry
+{
+	std::string Path;
+	uint32_t    Width;
+	uint32_t    Height;
+	size_t      ResidentBytes;
+	size_t      References;
+};
+
+/// <summary>
+/// Keeps track of all the textures that have been loaded from disk, so that loading the same image with the same
+/// format and sampler settings multiple times only decodes and uploads it once, and everyone shares the same texture.
+/// Texture2D::LoadFromFile and AssetLoader::LoadTexture both go through the registry.
+///
+/// Like the MeshRegistry, the registry does not keep textures alive by itself, a texture stays resident on the GPU
+/// for as long as something holds on to it, and will be loaded again if it is requested after being released
+/// </summary>
+class TextureRegistry
+{
+public:
+	/// <summary>
+	/// Loads an image file into a texture, or returns the already loaded texture if the file was loaded before with
+	/// the same options. If the image has an up to date cooked version (see TextureCooker) that gets loaded instead,
+	/// in which case the format in the options is ignored. Must be called from the main thread
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <param name="options">The options to load the image with, if it is not already loaded</param>
+	/// <returns>A texture that is shared with everyone else who has loaded the image</returns>
+	static Texture2D::sptr Load(const std::string& filename, const TextureLoadOptions& options = TextureLoadOptions());
+
+	/// <summary>
+	/// Gets the texture for an image if it is resident, without loading it if it is not. Counts as a hit if it is found
+	/// </summary>
+	/// <param name="filename">The path of the image</param>
+	/// <param name="options">The options that the image was loaded with</param>
+	/// <returns>The shared texture, or nullptr if the image is not resident</returns>
+	static Texture2D::sptr Find(const std::string& filename, const TextureLoadOptions& options = TextureLoadOptions());
+	/// <summary>
+	/// Adds a texture that was loaded elsewhere (ex: by the AssetLoader) to the registry, so later loads of the same
+	/// image share it. Counts as a miss, since the image had to be loaded
+	/// </summary>
+	/// <param name="filename">The path of the image that the texture was loaded from</param>
+	/// <param name="options">The options that the image was loaded with</param>
+	/// <param name="texture">The texture to share</param>
+	static void Register(const std::string& filename, const TextureLoadOptions& options, const Texture2D::sptr& texture);
+
+	/// <summary>
+	/// Gets the number of references to a texture, or 0 if it is not resident
+	/// </summary>
+	/// <param name="filename">The path of the image</param>
+	/// <param name="options">The options that the image was loaded with</param>
+	static size_t GetRefCount(const std::string& filename, const TextureLoadOptions& options = TextureLoadOptions());
+
+	/// <summary>
+	/// Gets the current statistics for the registry
+	/// </summary>
+	static TextureRegistryStats GetStats();
+	/// <summary>
+	/// Gets a description of every resident texture, largest first
+	/// </summary>
+	static std::vector<TextureRegistryEntry> GetResidentTextures();
+	/// <summary>
+	/// Resets the hit and miss counts back to zero
+	/// </summary>
+	static void ResetStats();
+
+	/// <summary>
+	/// Removes entries for textures that are no longer referenced by anything
+	/// </summary>
+	/// <returns>The number of entries that were removed</returns>
+	static size_t CollectGarbage();
+	/// <summary>
+	/// Forgets about all textures, textures that are still referenced elsewhere will stay alive but will no longer be shared
+	/// </summary>
+	static void Clear();
+
+protected:
+	TextureRegistry() = default;
+	~TextureRegistry() = default;
+
+	struct Entry
+	{
+		std::string               Path;
+		std::weak_ptr<Texture2D>  Texture;
+	};
+
+	/// <summary>
+	/// Builds the key for a texture from the canonical version of its path and the hash of its options
+	/// </summary>
+	static std::string _MakeKey(const std::string& filename, uint64_t optionsHash);
+
+	static std::mutex _lock;
+	static std::unordered_map<std::string, Entry> _textures;
+	static size_t _hits;
+	static size_t _misses;
+};
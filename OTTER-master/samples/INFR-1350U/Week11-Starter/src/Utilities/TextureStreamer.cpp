@@ -0,0 +1,438 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+
+#include "Logging.h"
+#include "AssetLoader.h"
+#include "MipGenerator.h"
+#include "TextureContainer.h"
+#include "TextureCooker.h"
+#include "VirtualFileSystem.h"
+
+std::unordered_map<std::string, std::shared_ptr<TextureStreamer::Entry>> TextureStreamer::_entries;
+std::unordered_map<const ITexture*, std::shared_ptr<TextureStreamer::Entry>> TextureStreamer::_byTexture;
+uint64_t TextureStreamer::_frame = 0;
+size_t TextureStreamer::_budget = 64 * 1024 * 1024;
+float TextureStreamer::_lodBias = 0.0f;
+float TextureStreamer::_fadeRate = 4.0f;
+uint32_t TextureStreamer::_keepFrames = 120;
+uint32_t TextureStreamer::_maxPendingLoads = 4;
+size_t TextureStreamer::_levelsLoaded = 0;
+size_t TextureStreamer::_levelsEvicted = 0;
+
+Texture2D::sptr TextureStreamer::Load(const std::string& filename) {
+	const std::string key = std::filesystem::path(filename).lexically_normal().generic_string();
+	auto it = _entries.find(key);
+	if (it != _entries.end()) {
+		Texture2D::sptr result = it->second->Texture.lock();
+		if (result != nullptr) {
+			return result;
+		}
+		// The new texture could end up at the old one's address, so the old entry can't be left for Update to clean up
+		_byTexture.erase(it->second->Key);
+		_entries.erase(it);
+	}
+
+	// Like the AssetLoader, the placeholder is the texture itself, so the tail gets loaded into it
+	Texture2D::sptr texture = Texture2D::Create();
+	uint8_t grey[4] = { 128, 128, 128, 255 };
+	texture->LoadData(std::make_shared<Texture2DData>(1, 1, PixelFormat::RGBA, PixelType::UByte, grey, InternalFormat::RGBA8));
+
+	std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+	entry->Path = key;
+	entry->Texture = texture;
+	entry->Key = texture.get();
+	entry->Format = InternalFormat::Unknown;
+	entry->Width = 0;
+	entry->Height = 0;
+	entry->LevelCount = 0;
+	entry->TailLevel = 0;
+	entry->ResidentLevel = 0;
+	entry->WantedLevel = 0;
+	entry->RequestedLevel = UINT32_MAX;
+	entry->LastRequested = 0;
+	entry->LastUsed = 0;
+	entry->PendingBytes = 0;
+	entry->Loading = false;
+	entry->Failed = false;
+	_entries[key] = entry;
+	_byTexture[texture.get()] = entry;
+
+	_StartLoad(entry, UINT32_MAX);
+	return texture;
+}
+
+bool TextureStreamer::IsStreamed(const ITexture::sptr& texture) {
+	return texture != nullptr && _byTexture.count(texture.get()) > 0;
+}
+
+void TextureStreamer::Request(const ITexture::sptr& texture, float screenPixels) {
+	if (texture == nullptr) {
+		return;
+	}
+	auto it = _byTexture.find(texture.get());
+	if (it == _byTexture.end() || it->second->LevelCount == 0) {
+		return;
+	}
+	Entry& entry = *it->second;
+	entry.RequestedLevel = std::min(entry.RequestedLevel, GetLevelForScreenSize(entry.Width, entry.Height, screenPixels, _lodBias));
+	entry.LastRequested = _frame;
+}
+
+void TextureStreamer::RequestLevel(const ITexture::sptr& texture, uint32_t level) {
+	if (texture == nullptr) {
+		return;
+	}
+	auto it = _byTexture.find(texture.get());
+	if (it == _byTexture.end() || it->second->LevelCount == 0) {
+		return;
+	}
+	Entry& entry = *it->second;
+	entry.RequestedLevel = std::min(entry.RequestedLevel, level);
+	entry.LastRequested = _frame;
+}
+
+uint32_t TextureStreamer::GetLevelForScreenSize(uint32_t width, uint32_t height, float screenPixels, float bias) {
+	// Every level halves the texels across the image, so the level with one texel per pixel is log2 of the ratio.
+	// Objects that cover nothing give us infinity here, and ones the camera is inside of give us negative infinity
+	const uint32_t lastLevel = GetMipLevelCount(width, height) - 1;
+	const float level = std::log2(std::max(width, height) / screenPixels) + bias;
+	if (!(level > 0.0f)) {
+		return 0;
+	}
+	return level >= static_cast<float>(lastLevel) ? lastLevel : static_cast<uint32_t>(level);
+}
+
+void TextureStreamer::Update(float deltaTime) {
+	// Forget textures that nothing holds on to anymore
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		if (it->second->Texture.expired()) {
+			_byTexture.erase(it->second->Key);
+			it = _entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto& [path, entry] : _entries) {
+		if (entry->LevelCount == 0) {
+			continue;
+		}
+		// Textures that stop being drawn hold on to what they wanted for a while, so something that goes off screen
+		// for a moment doesn't lose its levels
+		if (entry->LastRequested == _frame) {
+			entry->WantedLevel = std::min(entry->RequestedLevel, entry->TailLevel);
+		} else if (_frame - entry->LastRequested > _keepFrames) {
+			entry->WantedLevel = entry->TailLevel;
+		}
+		entry->RequestedLevel = UINT32_MAX;
+		if (entry->WantedLevel <= entry->ResidentLevel) {
+			entry->LastUsed = _frame;
+		}
+
+		Texture2D::sptr texture = entry->Texture.lock();
+		if (texture->GetMinLod() > 0.0f) {
+			texture->SetMinLod(_fadeRate > 0.0f ? std::max(texture->GetMinLod() - _fadeRate * deltaTime, 0.0f) : 0.0f);
+		}
+	}
+
+	// Lowering the budget can leave us over it. Levels that nothing wants go first, then the top level of whichever
+	// texture has the largest one, until we fit
+	size_t committed = _GetCommittedBytes();
+	if (committed > _budget) {
+		committed -= std::min(committed, _EvictUnused(committed - _budget, nullptr));
+	}
+	while (committed > _budget) {
+		Entry* largest = nullptr;
+		size_t largestBytes = 0;
+		for (auto& [path, entry] : _entries) {
+			if (!entry->Loading && entry->LevelCount > 0 && entry->ResidentLevel < entry->TailLevel) {
+				const size_t bytes = _GetLevelBytes(*entry, entry->ResidentLevel, entry->ResidentLevel + 1);
+				if (bytes > largestBytes) {
+					largest = entry.get();
+					largestBytes = bytes;
+				}
+			}
+		}
+		if (largest == nullptr) {
+			break;
+		}
+		_Evict(*largest, largest->ResidentLevel + 1);
+		committed -= std::min(committed, largestBytes);
+	}
+
+	// Start loads for the textures that are the furthest from what they want
+	size_t pending = 0;
+	std::vector<std::shared_ptr<Entry>> wanting;
+	for (auto& [path, entry] : _entries) {
+		if (entry->Loading) {
+			pending++;
+		} else if (!entry->Failed && entry->LevelCount > 0 && entry->WantedLevel < entry->ResidentLevel) {
+			wanting.push_back(entry);
+		}
+	}
+	std::sort(wanting.begin(), wanting.end(), [](const std::shared_ptr<Entry>& l, const std::shared_ptr<Entry>& r) {
+		return l->ResidentLevel - l->WantedLevel > r->ResidentLevel - r->WantedLevel;
+	});
+	for (const std::shared_ptr<Entry>& entry : wanting) {
+		if (pending >= _maxPendingLoads) {
+			break;
+		}
+		uint32_t firstLevel = entry->WantedLevel;
+		size_t bytes = _GetLevelBytes(*entry, firstLevel, entry->ResidentLevel);
+		if (committed + bytes > _budget) {
+			committed -= std::min(committed, _EvictUnused(committed + bytes - _budget, entry.get()));
+		}
+		// If there still isn't room, we load as many of the smaller levels as will fit
+		while (firstLevel < entry->ResidentLevel && committed + bytes > _budget) {
+			bytes -= _GetLevelBytes(*entry, firstLevel, firstLevel + 1);
+			firstLevel++;
+		}
+		if (firstLevel == entry->ResidentLevel) {
+			continue;
+		}
+		_StartLoad(entry, firstLevel);
+		committed += bytes;
+		pending++;
+	}
+
+	_frame++;
+}
+
+TextureStreamerStats TextureStreamer::GetStats() {
+	TextureStreamerStats result;
+	result.BudgetBytes = _budget;
+	result.ResidentBytes = 0;
+	result.WantedBytes = 0;
+	result.StreamedTextures = _entries.size();
+	result.PendingLoads = 0;
+	result.LevelsLoaded = _levelsLoaded;
+	result.LevelsEvicted = _levelsEvicted;
+	for (const auto& [path, entry] : _entries) {
+		Texture2D::sptr texture = entry->Texture.lock();
+		if (texture != nullptr) {
+			result.ResidentBytes += texture->GetResidentBytes();
+		}
+		if (entry->LevelCount > 0) {
+			result.WantedBytes += _GetLevelBytes(*entry, entry->WantedLevel, entry->LevelCount);
+		}
+		if (entry->Loading) {
+			result.PendingLoads++;
+		}
+	}
+	return result;
+}
+
+std::vector<StreamedTextureInfo> TextureStreamer::GetTextures() {
+	std::vector<StreamedTextureInfo> result;
+	result.reserve(_entries.size());
+	for (const auto& [path, entry] : _entries) {
+		Texture2D::sptr texture = entry->Texture.lock();
+		if (texture == nullptr) {
+			continue;
+		}
+		StreamedTextureInfo info;
+		info.Path = entry->Path;
+		info.Width = entry->Width;
+		info.Height = entry->Height;
+		info.LevelCount = entry->LevelCount;
+		info.ResidentLevel = entry->ResidentLevel;
+		info.WantedLevel = entry->WantedLevel;
+		info.ResidentBytes = texture->GetResidentBytes();
+		info.FullBytes = entry->LevelCount > 0 ? _GetLevelBytes(*entry, 0, entry->LevelCount) : 0;
+		info.Loading = entry->Loading;
+		result.push_back(info);
+	}
+	std::sort(result.begin(), result.end(), [](const StreamedTextureInfo& l, const StreamedTextureInfo& r) {
+		return l.FullBytes > r.FullBytes;
+	});
+	return result;
+}
+
+void TextureStreamer::Clear() {
+	_entries.clear();
+	_byTexture.clear();
+}
+
+TextureStreamer::LevelRange TextureStreamer::_ReadLevels(const std::string& filename, uint32_t firstLevel, uint32_t endLevel) {
+	LevelRange result;
+	result.Data = nullptr;
+	result.Width = 0;
+	result.Height = 0;
+	result.LevelCount = 0;
+	result.FirstLevel = 0;
+
+	const std::string debugName = std::filesystem::path(filename).filename().string();
+	VfsFile file(TextureCooker::FindCooked(filename));
+	if (!file.IsOpen()) {
+		LOG_WARN("Failed to open image \"{}\" for streaming", filename);
+		return result;
+	}
+
+	if (TextureContainer::IsContainer(file.GetData(), file.GetSize())) {
+		// Cooked files tell us where every level is, so we only copy the ones we need
+		InternalFormat format;
+		std::vector<Texture2DLevel> levels;
+		if (!TextureContainer::ReadLayout(file.GetData(), file.GetSize(), debugName, format, levels)) {
+			return result;
+		}
+		result.Width = levels[0].Width;
+		result.Height = levels[0].Height;
+		result.LevelCount = static_cast<uint32_t>(levels.size());
+		result.FirstLevel = std::min(firstLevel, _GetTailLevel(result.Width, result.Height, result.LevelCount));
+		endLevel = std::min(endLevel, result.LevelCount);
+		result.Data = TextureContainer::Read(file.GetData(), file.GetSize(), debugName, result.FirstLevel, endLevel - result.FirstLevel);
+	} else {
+		// Anything else has to be decoded in full, and have its mips built, every time a range is read from it
+		Texture2DData::sptr data = Texture2DData::LoadFromMemory(file.GetData(), file.GetSize(), debugName);
+		if (data == nullptr) {
+			return result;
+		}
+		data->GenerateMipMaps(MipGenerator::GetDefaultOptions(filename));
+		result.Width = data->GetWidth();
+		result.Height = data->GetHeight();
+		result.LevelCount = data->GetLevelCount();
+		result.FirstLevel = std::min(firstLevel, _GetTailLevel(result.Width, result.Height, result.LevelCount));
+		endLevel = std::min(endLevel, result.LevelCount);
+		result.Data = data->CopyLevels(result.FirstLevel, endLevel - result.FirstLevel);
+	}
+
+	// Like AssetLoader::LoadTexture, staging here leaves the main thread with nothing to do but issue the copy
+	if (result.Data != nullptr) {
+		result.Data->Stage();
+	}
+	return result;
+}
+
+uint32_t TextureStreamer::_GetTailLevel(uint32_t width, uint32_t height, uint32_t levelCount) {
+	uint32_t level = 0;
+	while (level + 1 < levelCount && std::max(width >> level, height >> level) > TailSize) {
+		level++;
+	}
+	return level;
+}
+
+size_t TextureStreamer::_GetLevelBytes(const Entry& entry, uint32_t firstLevel, uint32_t endLevel) {
+	size_t result = 0;
+	for (uint32_t level = firstLevel; level < endLevel && level < entry.LevelCount; level++) {
+		result += GetTextureLevelSize(entry.Format, std::max(entry.Width >> level, 1u), std::max(entry.Height >> level, 1u));
+	}
+	return result;
+}
+
+size_t TextureStreamer::_GetCommittedBytes() {
+	size_t result = 0;
+	for (const auto& [path, entry] : _entries) {
+		Texture2D::sptr texture = entry->Texture.lock();
+		if (texture != nullptr) {
+			result += texture->GetResidentBytes();
+		}
+		result += entry->PendingBytes;
+	}
+	return result;
+}
+
+void TextureStreamer::_StartLoad(const std::shared_ptr<Entry>& entry, uint32_t firstLevel) {
+	// The tail is read before we know how many levels there are, so it reads to the end of the chain
+	const uint32_t expectedTop = entry->ResidentLevel;
+	const uint32_t endLevel = entry->LevelCount == 0 ? UINT32_MAX : expectedTop;
+	entry->Loading = true;
+	entry->PendingBytes = entry->LevelCount == 0 ? 0 : _GetLevelBytes(*entry, firstLevel, endLevel);
+
+	const std::string path = entry->Path;
+	AssetLoader::Enqueue([entry, path, firstLevel, endLevel, expectedTop]() {
+		LevelRange range = _ReadLevels(path, firstLevel, endLevel);
+		const size_t bytes = range.Data != nullptr ? range.Data->GetDataSize() : 0;
+		AssetLoader::EnqueueUpload([entry, range, expectedTop]() {
+			_FinishLoad(entry, range, expectedTop);
+		}, bytes);
+	});
+}
+
+void TextureStreamer::_FinishLoad(const std::shared_ptr<Entry>& entry, const LevelRange& range, uint32_t expectedTop) {
+	entry->Loading = false;
+	entry->PendingBytes = 0;
+
+	// The texture may have been dropped, or the streamer cleared, while the levels were on their way
+	Texture2D::sptr texture = entry->Texture.lock();
+	auto it = _entries.find(entry->Path);
+	if (texture == nullptr || it == _entries.end() || it->second != entry) {
+		return;
+	}
+	if (range.Data == nullptr) {
+		LOG_WARN("Failed to stream levels of \"{}\", it will keep the levels it has", entry->Path);
+		entry->Failed = true;
+		return;
+	}
+
+	if (entry->LevelCount == 0) {
+		entry->Format = range.Data->GetRecommendedFormat();
+		entry->Width = range.Width;
+		entry->Height = range.Height;
+		entry->LevelCount = range.LevelCount;
+		entry->TailLevel = range.FirstLevel;
+		entry->WantedLevel = range.FirstLevel;
+		entry->LastUsed = _frame;
+		texture->Reallocate(entry->Format, range.Data->GetWidth(), range.Data->GetHeight(), entry->LevelCount - range.FirstLevel);
+		texture->LoadLevels(range.Data, 0);
+		entry->ResidentLevel = range.FirstLevel;
+		return;
+	}
+
+	// If levels were evicted while these were loading there would be a gap between them, so we drop these and let
+	// Update ask for them again
+	if (entry->ResidentLevel != expectedTop) {
+		return;
+	}
+	const uint32_t added = expectedTop - range.FirstLevel;
+	texture->Reallocate(entry->Format, range.Data->GetWidth(), range.Data->GetHeight(), entry->LevelCount - range.FirstLevel);
+	texture->LoadLevels(range.Data, 0);
+	entry->ResidentLevel = range.FirstLevel;
+	// The old top level is now further down the chain, so clamping to it keeps the image the same until Update fades it out
+	if (_fadeRate > 0.0f) {
+		texture->SetMinLod(texture->GetMinLod() + added);
+	}
+	_levelsLoaded += added;
+}
+
+void TextureStreamer::_Evict(Entry& entry, uint32_t newTop) {
+	Texture2D::sptr texture = entry.Texture.lock();
+	if (texture == nullptr || newTop <= entry.ResidentLevel) {
+		return;
+	}
+	const uint32_t dropped = newTop - entry.ResidentLevel;
+	texture->Reallocate(entry.Format, std::max(entry.Width >> newTop, 1u), std::max(entry.Height >> newTop, 1u), entry.LevelCount - newTop);
+	texture->SetMinLod(std::max(texture->GetMinLod() - dropped, 0.0f));
+	entry.ResidentLevel = newTop;
+	_levelsEvicted += dropped;
+}
+
+size_t TextureStreamer::_EvictUnused(size_t bytes, const Entry* skip) {
+	std::vector<Entry*> candidates;
+	for (auto& [path, entry] : _entries) {
+		if (entry.get() != skip && !entry->Loading && entry->LevelCount > 0 && entry->ResidentLevel < entry->WantedLevel) {
+			candidates.push_back(entry.get());
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Entry* l, const Entry* r) {
+		return l->LastUsed < r->LastUsed;
+	});
+
+	// Levels come off the top one at a time, so we don't throw away more than we have to
+	size_t freed = 0;
+	for (Entry* entry : candidates) {
+		if (freed >= bytes) {
+			break;
+		}
+		uint32_t newTop = entry->ResidentLevel;
+		while (newTop < entry->WantedLevel && freed < bytes) {
+			freed += _GetLevelBytes(*entry, newTop, newTop + 1);
+			newTop++;
+		}
+		_Evict(*entry, newTop);
+	}
+	return freed;
+}
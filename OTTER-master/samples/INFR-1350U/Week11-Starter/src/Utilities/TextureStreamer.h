@@ -0,0 +1,264 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/Texture2D.h"
+
+/// <summary>
+/// Statistics about the textures that the streamer is managing
+/// </summary>
+struct TextureStreamerStats
+{
+	/// <summary>
+	/// The most GPU memory that streamed textures are allowed to use, in bytes
+	/// </summary>
+	size_t BudgetBytes;
+	/// <summary>
+	/// The GPU memory used by the levels that are resident, in bytes
+	/// </summary>
+	size_t ResidentBytes;
+	/// <summary>
+	/// The GPU memory that every texture would use if it had all the levels it asked for, in bytes
+	/// </summary>
+	size_t WantedBytes;
+	/// <summary>
+	/// The number of textures being streamed
+	/// </summary>
+	size_t StreamedTextures;
+	/// <summary>
+	/// The number of loads on their way from the worker threads
+	/// </summary>
+	size_t PendingLoads;
+	/// <summary>
+	/// The total number of levels that have been loaded
+	/// </summary>
+	size_t LevelsLoaded;
+	/// <summary>
+	/// The total number of levels that have been evicted to stay under the budget
+	/// </summary>
+	size_t LevelsEvicted;
+};
+
+/// <summary>
+/// Describes the residency of a single streamed texture
+/// </summary>
+struct StreamedTextureInfo
+{
+	std::string Path;
+	// The size and level count of the full image, the level count is 0 until the tail has loaded
+	uint32_t    Width;
+	uint32_t    Height;
+	uint32_t    LevelCount;
+	// The most detailed level that is resident, and the one that the texture's users asked for
+	uint32_t    ResidentLevel;
+	uint32_t    WantedLevel;
+	size_t      ResidentBytes;
+	size_t      FullBytes;
+	bool        Loading;
+};
+
+/// <summary>
+/// Streams the mip levels of textures in and out of GPU memory based on how large the objects using them are on
+/// screen. Streamed textures start with only their tail (the levels no larger than TailSize) resident, read straight
+/// out of the cooked file if there is one (see TextureCooker), so loading a level costs a fraction of loading the
+/// whole image. Anything that draws with a texture calls Request once per frame with how many pixels it covers,
+/// and Update loads the levels that are needed through the AssetLoader's worker threads.
+///
+/// Each texture's storage only holds its resident levels (see Texture2D::Reallocate), so evicting a level gives its
+/// memory back. Levels are only evicted to make room under the budget, starting with levels nothing has asked for
+/// in the longest time. New levels are faded in with GL_TEXTURE_MIN_LOD so they don't pop.
+///
+/// Like the TextureRegistry, the streamer does not keep textures alive by itself. Everything here must be called
+/// from the main thread
+/// </summary>
+class TextureStreamer
+{
+public:
+	/// <summary>
+	/// Levels this size and smaller are loaded up front, and are never evicted
+	/// </summary>
+	static constexpr uint32_t TailSize = 64;
+
+	/// <summary>
+	/// Starts streaming an image file. The texture is a 1x1 grey placeholder until the tail has loaded, and loading
+	/// the same file again while the texture is alive returns the same texture
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <returns>The texture, which gains and loses levels as the streamer sees fit</returns>
+	static Texture2D::sptr Load(const std::string& filename);
+	/// <summary>
+	/// Gets whether a texture is being managed by the streamer
+	/// </summary>
+	static bool IsStreamed(const ITexture::sptr& texture);
+
+	/// <summary>
+	/// Asks for the level of a texture that has about one texel per pixel when it covers a given number of pixels on
+	/// screen. This assumes the texture is mapped across the object once, so tiled textures should use SetLodBias.
+	/// Textures that aren't streamed are ignored, so this can be called for every texture a material has
+	/// </summary>
+	/// <param name="texture">The texture that is being drawn</param>
+	/// <param name="screenPixels">The size of the object on screen in pixels, see RendererComponent::GetProjectedSize</param>
+	static void Request(const ITexture::sptr& texture, float screenPixels);
+	/// <summary>
+	/// Asks for a specific level of a texture to be resident. Requests last for a single frame, and the most detailed
+	/// level asked for in a frame wins
+	/// </summary>
+	/// <param name="texture">The texture that is being drawn</param>
+	/// <param name="level">The level to make resident, 0 being the full image</param>
+	static void RequestLevel(const ITexture::sptr& texture, uint32_t level);
+	/// <summary>
+	/// Gets the level of an image that has about one texel per pixel when drawn at a given size
+	/// </summary>
+	/// <param name="width">The width of the full image</param>
+	/// <param name="height">The height of the full image</param>
+	/// <param name="screenPixels">The size of the object on screen, in pixels</param>
+	/// <param name="bias">How many levels sharper (negative) or blurrier (positive) to go</param>
+	static uint32_t GetLevelForScreenSize(uint32_t width, uint32_t height, float screenPixels, float bias = 0.0f);
+
+	/// <summary>
+	/// Takes this frame's requests, evicts levels if we're over budget, starts loads for the levels that are needed
+	/// and fades in levels that were loaded. Call once per frame, after everything has made its requests
+	/// </summary>
+	/// <param name="deltaTime">The time since the last frame, in seconds</param>
+	static void Update(float deltaTime);
+
+	/// <summary>
+	/// Sets the most GPU memory that streamed textures may use. Tails always stay resident, even if they don't fit
+	/// </summary>
+	static void SetBudget(size_t bytes) { _budget = bytes; }
+	static size_t GetBudget() { return _budget; }
+	/// <summary>
+	/// Sets how many levels sharper (negative) or blurrier (positive) Request goes than one texel per pixel
+	/// </summary>
+	static void SetLodBias(float bias) { _lodBias = bias; }
+	static float GetLodBias() { return _lodBias; }
+	/// <summary>
+	/// Sets how many levels per second a newly loaded level fades in at, 0 will show new levels right away
+	/// </summary>
+	static void SetFadeRate(float levelsPerSecond) { _fadeRate = levelsPerSecond; }
+	static float GetFadeRate() { return _fadeRate; }
+	/// <summary>
+	/// Sets how many frames a texture keeps asking for its last requested level after nothing has requested it
+	/// </summary>
+	static void SetKeepFrames(uint32_t frames) { _keepFrames = frames; }
+	static uint32_t GetKeepFrames() { return _keepFrames; }
+	/// <summary>
+	/// Sets how many loads can be waiting on the worker threads at once
+	/// </summary>
+	static void SetMaxPendingLoads(uint32_t count) { _maxPendingLoads = count; }
+	static uint32_t GetMaxPendingLoads() { return _maxPendingLoads; }
+
+	/// <summary>
+	/// Gets the current statistics for the streamer
+	/// </summary>
+	static TextureStreamerStats GetStats();
+	/// <summary>
+	/// Gets a description of every streamed texture, largest first
+	/// </summary>
+	static std::vector<StreamedTextureInfo> GetTextures();
+
+	/// <summary>
+	/// Forgets about all textures, they keep whatever levels they have and loads that are still on their way are dropped
+	/// </summary>
+	static void Clear();
+
+protected:
+	TextureStreamer() = default;
+	~TextureStreamer() = default;
+
+	struct Entry
+	{
+		std::string              Path;
+		std::weak_ptr<Texture2D> Texture;
+		// The texture's address, so we can clean up _byTexture once the texture is gone
+		const ITexture*          Key;
+		InternalFormat           Format;
+		// The size and level count of the full image, the level count is 0 until the tail has loaded
+		uint32_t                 Width;
+		uint32_t                 Height;
+		uint32_t                 LevelCount;
+		// The largest level that is always resident
+		uint32_t                 TailLevel;
+		// The most detailed level that is resident, level 0 of the texture's storage
+		uint32_t                 ResidentLevel;
+		uint32_t                 WantedLevel;
+		// The most detailed level asked for since the last Update
+		uint32_t                 RequestedLevel;
+		uint64_t                 LastRequested;
+		// The last frame that every resident level was wanted, levels that went unused the longest are evicted first
+		uint64_t                 LastUsed;
+		// The bytes of the load that is on its way (0 for the tail, since we don't know its size until it's read)
+		size_t                   PendingBytes;
+		bool                     Loading;
+		bool                     Failed;
+	};
+
+	/// <summary>
+	/// The result of reading part of an image's mip chain on a worker thread
+	/// </summary>
+	struct LevelRange
+	{
+		Texture2DData::sptr Data;
+		uint32_t            Width;
+		uint32_t            Height;
+		uint32_t            LevelCount;
+		uint32_t            FirstLevel;
+	};
+
+	/// <summary>
+	/// Reads levels [firstLevel, endLevel) of an image on a worker thread. firstLevel is clamped to the tail level, so
+	/// passing UINT32_MAX reads just the tail. Cooked files only copy the levels that were asked for, anything else
+	/// has to be decoded and have its whole chain built before the levels can be picked out
+	/// </summary>
+	static LevelRange _ReadLevels(const std::string& filename, uint32_t firstLevel, uint32_t endLevel);
+	/// <summary>
+	/// Gets the largest level of an image that fits in TailSize
+	/// </summary>
+	static uint32_t _GetTailLevel(uint32_t width, uint32_t height, uint32_t levelCount);
+	/// <summary>
+	/// Gets the number of bytes that levels [firstLevel, endLevel) of an entry's image take up
+	/// </summary>
+	static size_t _GetLevelBytes(const Entry& entry, uint32_t firstLevel, uint32_t endLevel);
+	/// <summary>
+	/// Gets the bytes used by every resident level, plus every load that is on its way
+	/// </summary>
+	static size_t _GetCommittedBytes();
+
+	/// <summary>
+	/// Starts loading levels [firstLevel, entry.ResidentLevel) of an entry
+	/// </summary>
+	static void _StartLoad(const std::shared_ptr<Entry>& entry, uint32_t firstLevel);
+	/// <summary>
+	/// Uploads levels that a worker thread has read, unless the entry has changed since the load started
+	/// </summary>
+	/// <param name="entry">The entry that the levels are for</param>
+	/// <param name="range">The levels that were read</param>
+	/// <param name="expectedTop">The entry's resident level when the load started</param>
+	static void _FinishLoad(const std::shared_ptr<Entry>& entry, const LevelRange& range, uint32_t expectedTop);
+	/// <summary>
+	/// Drops the levels of an entry above newTop, keeping the rest resident
+	/// </summary>
+	static void _Evict(Entry& entry, uint32_t newTop);
+	/// <summary>
+	/// Evicts levels that nothing wants, oldest first, until at least bytes have been freed or there are none left
+	/// </summary>
+	/// <param name="bytes">The number of bytes to free</param>
+	/// <param name="skip">An entry to leave alone (ex: the one we're making room for)</param>
+	/// <returns>The number of bytes that were freed</returns>
+	static size_t _EvictUnused(size_t bytes, const Entry* skip);
+
+	static std::unordered_map<std::string, std::shared_ptr<Entry>> _entries;
+	// Lets Request find entries without going through the path
+	static std::unordered_map<const ITexture*, std::shared_ptr<Entry>> _byTexture;
+	static uint64_t _frame;
+	static size_t   _budget;
+	static float    _lodBias;
+	static float    _fadeRate;
+	static uint32_t _keepFrames;
+	static uint32_t _maxPendingLoads;
+	static size_t   _levelsLoaded;
+	static size_t   _levelsEvicted;
+};
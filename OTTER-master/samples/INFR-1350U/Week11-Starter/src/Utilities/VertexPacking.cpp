@@ -0,0 +1,161 @@
+#include "VertexPacking.h"
+
+#include <cmath>
+#include <limits>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/packing.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include "TangentGenerator.h"
+
+/// <summary>
+/// Converts a value in the -1 to 1 range to a snorm16
+/// </summary>
+inline int16_t ToSnorm16(float value) {
+	return static_cast<int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+/// <summary>
+/// Converts a value in the 0 to 1 range to a unorm16
+/// </summary>
+inline uint16_t ToUnorm16(float value) {
+	return static_cast<uint16_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+glm::i16vec2 VertexPacking::EncodeOctahedral(const glm::vec3& normal) {
+	const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (length == 0.0f) {
+		return glm::i16vec2(0);
+	}
+	glm::vec2 result = glm::vec2(normal.x, normal.y) / length;
+	// The bottom half of the octahedron gets folded out over the corners of the square
+	if (normal.z < 0.0f) {
+		result = glm::vec2(
+			(1.0f - std::abs(result.y)) * (result.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(result.x)) * (result.y >= 0.0f ? 1.0f : -1.0f));
+	}
+	return glm::i16vec2(ToSnorm16(result.x), ToSnorm16(result.y));
+}
+
+glm::vec3 VertexPacking::DecodeOctahedral(const glm::i16vec2& encoded) {
+	const glm::vec2 e = glm::max(glm::vec2(encoded) / 32767.0f, glm::vec2(-1.0f));
+	glm::vec3 result(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	const float fold = std::max(-result.z, 0.0f);
+	result.x += result.x >= 0.0f ? -fold : fold;
+	result.y += result.y >= 0.0f ? -fold : fold;
+	return glm::normalize(result);
+}
+
+glm::u16vec2 VertexPacking::PackHalf2(const glm::vec2& value) {
+	return glm::u16vec2(glm::packHalf1x16(value.x), glm::packHalf1x16(value.y));
+}
+
+glm::u8vec4 VertexPacking::PackColor(const glm::vec4& color) {
+	const glm::vec4 scaled = glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f);
+	return glm::u8vec4(scaled);
+}
+
+glm::i16vec4 VertexPacking::EncodeQTangent(const glm::vec3& normal, const glm::vec4& tangent) {
+	const float normalLength = glm::length(normal);
+	const glm::vec3 n = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+	// The frame has to be orthonormal to be stored as a rotation, so we Gram-Schmidt the tangent against the normal
+	glm::vec3 t = glm::vec3(tangent) - n * glm::dot(n, glm::vec3(tangent));
+	const float tangentLength = glm::length(t);
+	t = tangentLength > 0.0f ? t / tangentLength : glm::normalize(glm::cross(std::abs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f), n));
+	const glm::vec3 b = glm::cross(n, t);
+
+	glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(t, b, n)));
+	// q and -q are the same rotation, so the sign of w is free to hold the bitangent sign. snorm16 has no -0
+	// though, so w needs to be pushed far enough from 0 that it survives quantization
+	if (q.w < 0.0f) {
+		q = -q;
+	}
+	constexpr float bias = 1.0f / 32767.0f;
+	if (q.w < bias) {
+		const float xyzLength = glm::length(glm::vec3(q.x, q.y, q.z));
+		const float scale = std::sqrt(1.0f - bias * bias) / xyzLength;
+		q = glm::quat(bias, q.x * scale, q.y * scale, q.z * scale);
+	}
+	if (tangent.w < 0.0f) {
+		q = -q;
+	}
+	return glm::i16vec4(ToSnorm16(q.x), ToSnorm16(q.y), ToSnorm16(q.z), ToSnorm16(q.w));
+}
+
+void VertexPacking::DecodeQTangent(const glm::i16vec4& encoded, glm::vec3& outNormal, glm::vec4& outTangent) {
+	const glm::vec4 q = glm::normalize(glm::max(glm::vec4(encoded) / 32767.0f, glm::vec4(-1.0f)));
+	outTangent = glm::vec4(
+		1.0f - 2.0f * (q.y * q.y + q.z * q.z),
+		2.0f * (q.x * q.y + q.w * q.z),
+		2.0f * (q.x * q.z - q.w * q.y),
+		q.w < 0.0f ? -1.0f : 1.0f);
+	outNormal = glm::vec3(
+		2.0f * (q.x * q.z + q.w * q.y),
+		2.0f * (q.y * q.z - q.w * q.x),
+		1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+}
+
+void VertexPacking::Pack(const MeshBuilder<VertexPosNormTexCol>& source, MeshBuilder<VertexPackedPosNormTexCol>& result) {
+	result._vertices.resize(source._vertices.size());
+	for (size_t ix = 0; ix < source._vertices.size(); ix++) {
+		const VertexPosNormTexCol& in = source._vertices[ix];
+		VertexPackedPosNormTexCol& out = result._vertices[ix];
+		out.Position = in.Position;
+		out.Normal = EncodeOctahedral(in.Normal);
+		out.UV = PackHalf2(in.UV);
+		out.Color = PackColor(in.Color);
+	}
+	result._indices = source._indices;
+	result._vertexTransform = source._vertexTransform;
+}
+
+void VertexPacking::Quantize(const MeshBuilder<VertexPosNormTexCol>& source, MeshBuilder<VertexQuantizedPosNormTexCol>& result) {
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+	for (const VertexPosNormTexCol& vertex : source._vertices) {
+		min = glm::min(min, vertex.Position);
+		max = glm::max(max, vertex.Position);
+	}
+	if (source._vertices.empty()) {
+		min = max = glm::vec3(0.0f);
+	}
+	// Flat meshes (like planes) have no size on one axis, we still need a non-zero scale for the transform
+	glm::vec3 extent = max - min;
+	for (int axis = 0; axis < 3; axis++) {
+		if (extent[axis] <= 0.0f) {
+			extent[axis] = 1.0f;
+		}
+	}
+
+	result._vertices.resize(source._vertices.size());
+	for (size_t ix = 0; ix < source._vertices.size(); ix++) {
+		const VertexPosNormTexCol& in = source._vertices[ix];
+		VertexQuantizedPosNormTexCol& out = result._vertices[ix];
+		const glm::vec3 normalized = (in.Position - min) / extent;
+		out.Position = glm::u16vec4(ToUnorm16(normalized.x), ToUnorm16(normalized.y), ToUnorm16(normalized.z), 0);
+		out.Normal = EncodeOctahedral(in.Normal);
+		out.UV = PackHalf2(in.UV);
+		out.Color = PackColor(in.Color);
+	}
+	result._indices = source._indices;
+
+	// The GPU gives us the positions back in the 0-1 range, so we just need to scale them up and move them back
+	result._vertexTransform = source._vertexTransform * glm::scale(glm::translate(glm::mat4(1.0f), min), extent);
+}
+
+void VertexPacking::PackQTangents(const MeshBuilder<VertexPosNormTexCol>& source, MeshBuilder<VertexPackedPosQTangentTexCol>& result, uint32_t threadCount) {
+	std::vector<glm::vec4> tangents;
+	TangentGenerator::Generate(source, tangents, threadCount);
+
+	result._vertices.resize(source._vertices.size());
+	for (size_t ix = 0; ix < source._vertices.size(); ix++) {
+		const VertexPosNormTexCol& in = source._vertices[ix];
+		VertexPackedPosQTangentTexCol& out = result._vertices[ix];
+		out.Position = in.Position;
+		out.QTangent = EncodeQTangent(in.Normal, tangents[ix]);
+		out.UV = PackHalf2(in.UV);
+		out.Color = PackColor(in.Color);
+	}
+	result._indices = source._indices;
+	result._vertexTransform = source._vertexTransform;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include <GLM/gtc/type_precision.hpp>
+
+#include "MeshBuilder.h"
+#include "VertexTypes.h"
+
+/// <summary>
+/// The vertex formats that importers can produce
+/// </summary>
+enum class VertexFormat
+{
+	/// <summary>
+	/// VertexPosNormTexCol, 48 bytes of floats per vertex
+	/// </summary>
+	Full = 0,
+	/// <summary>
+	/// VertexPackedPosNormTexCol, float positions with packed normals, UVs and colors (24 bytes)
+	/// </summary>
+	Packed,
+	/// <summary>
+	/// VertexQuantizedPosNormTexCol, like Packed but with 16 bit positions (20 bytes). Positions are
+	/// quantized to 1/65535th of the mesh's size, which is plenty for props but not for large levels
+	/// </summary>
+	Quantized,
+	/// <summary>
+	/// VertexPackedPosQTangentTexCol, like Packed but the normal is replaced by a full tangent frame for normal
+	/// mapping (28 bytes). Needs UVs, vertices on mirrored UV seams get split at import
+	/// </summary>
+	QTangent
+};
+
+/// <summary>
+/// Helpers for converting meshes into the compact vertex formats, and for encoding the individual attributes
+/// </summary>
+class VertexPacking
+{
+public:
+	/// <summary>
+	/// Encodes a unit vector into 2 snorm16 values by projecting it onto an octahedron and unfolding it
+	/// into a square. The error is under 0.05 degrees, and it can be decoded cheaply in a shader
+	/// </summary>
+	static glm::i16vec2 EncodeOctahedral(const glm::vec3& normal);
+	/// <summary>
+	/// Decodes a vector that was encoded with EncodeOctahedral, matches OctahedralDecode in vertex_shader.glsl
+	/// </summary>
+	static glm::vec3 DecodeOctahedral(const glm::i16vec2& encoded);
+	/// <summary>
+	/// Converts a 2 component vector to half floats
+	/// </summary>
+	static glm::u16vec2 PackHalf2(const glm::vec2& value);
+	/// <summary>
+	/// Converts a color in the 0-1 range to RGBA8
+	/// </summary>
+	static glm::u8vec4 PackColor(const glm::vec4& color);
+	/// <summary>
+	/// Encodes a tangent frame into a unit quaternion stored as 4 snorm16 values. The sign of w holds the
+	/// bitangent sign, so w is kept at least 1/32767 away from 0
+	/// </summary>
+	/// <param name="normal">The vertex normal, does not need to be normalized</param>
+	/// <param name="tangent">The tangent, with the bitangent sign in w (see TangentGenerator)</param>
+	static glm::i16vec4 EncodeQTangent(const glm::vec3& normal, const glm::vec4& tangent);
+	/// <summary>
+	/// Decodes a frame that was encoded with EncodeQTangent, matches QTangentDecode in qtangent.glsl
+	/// </summary>
+	static void DecodeQTangent(const glm::i16vec4& encoded, glm::vec3& outNormal, glm::vec4& outTangent);
+
+	/// <summary>
+	/// Converts a mesh into the packed vertex format, the indices are copied as-is
+	/// </summary>
+	/// <param name="source">The mesh to convert</param>
+	/// <param name="result">The mesh to store the packed vertices in, any existing content is replaced</param>
+	static void Pack(const MeshBuilder<VertexPosNormTexCol>& source, MeshBuilder<VertexPackedPosNormTexCol>& result);
+	/// <summary>
+	/// Converts a mesh into the quantized vertex format, the indices are copied as-is. The result's vertex
+	/// transform is set up to map the quantized positions back into the source's model space
+	/// </summary>
+	/// <param name="source">The mesh to convert</param>
+	/// <param name="result">The mesh to store the quantized vertices in, any existing content is replaced</param>
+	static void Quantize(const MeshBuilder<VertexPosNormTexCol>& source, MeshBuilder<VertexQuantizedPosNormTexCol>& result);
+	/// <summary>
+	/// Generates tangents for a mesh and converts it into the QTangent vertex format, the indices are copied as-is.
+	/// Run TangentGenerator::SplitMirroredVertices on the source first if its UVs may be mirrored
+	/// </summary>
+	/// <param name="source">The mesh to convert</param>
+	/// <param name="result">The mesh to store the packed vertices in, any existing content is replaced</param>
+	/// <param name="threadCount">The number of threads to generate tangents with, 0 will use one per hardware thread</param>
+	static void PackQTangents(const MeshBuilder<VertexPosNormTexCol>& source, MeshBuilder<VertexPackedPosQTangentTexCol>& result, uint32_t threadCount = 0);
+
+protected:
+	VertexPacking() = default;
+	~VertexPacking() = default;
+};
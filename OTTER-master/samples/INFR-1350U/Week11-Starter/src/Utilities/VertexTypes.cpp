@@ -5,6 +5,9 @@ VertexPosCol* VPC = nullptr;
 VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
+VertexPackedPosNormTexCol* VPPNTC = nullptr;
+VertexQuantizedPosNormTexCol* VQPNTC = nullptr;
+VertexPackedPosQTangentTexCol* VPPQTC = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -26,4 +29,22 @@ const std::vector<BufferAttribute> VertexPosNormTexCol::V_DECL = {
 	BufferAttribute(2, 3, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->Normal, AttribUsage::Normal),
 	BufferAttribute(3, 2, GL_FLOAT, false, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->UV, AttribUsage::Texture),
 };
+const std::vector<BufferAttribute> VertexPackedPosNormTexCol::V_DECL = {
+	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, GL_UNSIGNED_BYTE, true, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->Color, AttribUsage::Color),
+	BufferAttribute(2, 2, GL_SHORT, true, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->Normal, AttribUsage::Normal),
+	BufferAttribute(3, 2, GL_HALF_FLOAT, false, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->UV, AttribUsage::Texture),
+};
+const std::vector<BufferAttribute> VertexQuantizedPosNormTexCol::V_DECL = {
+	BufferAttribute(0, 3, GL_UNSIGNED_SHORT, true, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, GL_UNSIGNED_BYTE, true, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->Color, AttribUsage::Color),
+	BufferAttribute(2, 2, GL_SHORT, true, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->Normal, AttribUsage::Normal),
+	BufferAttribute(3, 2, GL_HALF_FLOAT, false, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->UV, AttribUsage::Texture),
+};
+const std::vector<BufferAttribute> VertexPackedPosQTangentTexCol::V_DECL = {
+	BufferAttribute(0, 3, GL_FLOAT, false, sizeof(VertexPackedPosQTangentTexCol), (size_t)&VPPQTC->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, GL_UNSIGNED_BYTE, true, sizeof(VertexPackedPosQTangentTexCol), (size_t)&VPPQTC->Color, AttribUsage::Color),
+	BufferAttribute(2, 4, GL_SHORT, true, sizeof(VertexPackedPosQTangentTexCol), (size_t)&VPPQTC->QTangent, AttribUsage::Tangent),
+	BufferAttribute(3, 2, GL_HALF_FLOAT, false, sizeof(VertexPackedPosQTangentTexCol), (size_t)&VPPQTC->UV, AttribUsage::Texture),
+};
 #pragma warning(pop)
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GLM/glm.hpp>
+#include <GLM/gtc/type_precision.hpp>
 #include "Graphics/VertexArrayObject.h"
 
 struct VertexPosCol {
@@ -56,5 +57,55 @@ struct VertexPosNormTexCol {
 	VertexPosNormTexCol(float x, float y, float z, float nX, float nY, float nZ, float u, float v, float r, float g, float b, float a = 1.0f) :
 		Position({ x, y, z }), Normal({ nX, nY, nZ }), UV({ u, v }), Color({r, g, b, a}) {}
 
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// A compact version of VertexPosNormTexCol that takes 24 bytes instead of 48. The normal is octahedral
+/// encoded into 2 snorm16 values, the UV is stored as 2 half floats and the color as RGBA8. Use
+/// VertexPacking to convert meshes into this format
+/// </summary>
+struct VertexPackedPosNormTexCol {
+	glm::vec3    Position;
+	glm::i16vec2 Normal;
+	glm::u16vec2 UV;
+	glm::u8vec4  Color;
+
+	VertexPackedPosNormTexCol() : Position(glm::vec3(0.0f)), Normal(glm::i16vec2(0)), UV(glm::u16vec2(0)), Color(glm::u8vec4(0, 0, 0, 255)) {}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// A compact version of VertexPosNormTexCol that takes 20 bytes instead of 48. Same as VertexPackedPosNormTexCol,
+/// but the position is also quantized to unorm16 within the mesh's bounding box. The VAO's vertex transform
+/// maps the positions back into model space
+/// </summary>
+struct VertexQuantizedPosNormTexCol {
+	// The 4th component is padding, to keep the normal aligned to 4 bytes
+	glm::u16vec4 Position;
+	glm::i16vec2 Normal;
+	glm::u16vec2 UV;
+	glm::u8vec4  Color;
+
+	VertexQuantizedPosNormTexCol() : Position(glm::u16vec4(0)), Normal(glm::i16vec2(0)), UV(glm::u16vec2(0)), Color(glm::u8vec4(0, 0, 0, 255)) {}
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// A compact vertex with a full tangent frame for normal mapping, 28 bytes. The normal, tangent and bitangent sign
+/// are stored together as a QTangent: a unit quaternion (4 snorm16 values) whose sign also carries the
+/// handedness of the bitangent. Decode it with QTangentDecode in qtangent.glsl, and use VertexPacking::PackQTangents
+/// to convert meshes into this format
+/// </summary>
+struct VertexPackedPosQTangentTexCol {
+	glm::vec3    Position;
+	glm::i16vec4 QTangent;
+	glm::u16vec2 UV;
+	glm::u8vec4  Color;
+
+	VertexPackedPosQTangentTexCol() : Position(glm::vec3(0.0f)), QTangent(glm::i16vec4(0, 0, 0, 32767)), UV(glm::u16vec2(0)), Color(glm::u8vec4(0, 0, 0, 255)) {}
+
 	static const std::vector<BufferAttribute> V_DECL;
 };
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "VirtualFileSystem.h"
+
+#include <filesystem>
+#include <system_error>
+
+#include "Logging.h"
+
+std::mutex VirtualFileSystem::_lock;
+std::vector<AssetPack::sptr> VirtualFileSystem::_packs;
+std::atomic<size_t> VirtualFileSystem::_storedReads(0);
+std::atomic<size_t> VirtualFileSystem::_compressedReads(0);
+std::atomic<size_t> VirtualFileSystem::_looseReads(0);
+
+VfsFile::VfsFile() :
+	_pack(nullptr),
+	_mapped(),
+	_buffer(),
+	_data(nullptr),
+	_size(0),
+	_isOpen(false)
+{ }
+
+VfsFile::VfsFile(const std::string& path) :
+	VfsFile()
+{
+	Open(path);
+}
+
+bool VfsFile::Open(const std::string& path) {
+	Close();
+
+	AssetPack::sptr pack;
+	const AssetPackEntry* entry = VirtualFileSystem::_Find(path, pack);
+	if (entry != nullptr) {
+		if (entry->Compression == static_cast<uint32_t>(AssetPackCompression::None)) {
+			// Stored entries are read right out of the pack's mapping
+			_data = pack->GetStoredData(*entry);
+			VirtualFileSystem::_storedReads++;
+		} else {
+			if (!pack->Decompress(*entry, _buffer)) {
+				LOG_WARN("Failed to inflate \"{}\" from asset pack \"{}\"", path, pack->GetPath());
+				_buffer.clear();
+				return false;
+			}
+			_data = _buffer.data();
+			VirtualFileSystem::_compressedReads++;
+		}
+		_pack = pack;
+		_size = static_cast<size_t>(entry->Size);
+		_isOpen = true;
+		return true;
+	}
+
+	if (!_mapped.Open(path)) {
+		return false;
+	}
+	_data = _mapped.GetData();
+	_size = _mapped.GetSize();
+	_isOpen = true;
+	VirtualFileSystem::_looseReads++;
+	return true;
+}
+
+void VfsFile::Close() {
+	_pack = nullptr;
+	_mapped.Close();
+	_buffer.clear();
+	_buffer.shrink_to_fit();
+	_data = nullptr;
+	_size = 0;
+	_isOpen = false;
+}
+
+bool VirtualFileSystem::Mount(const std::string& packPath) {
+	AssetPack::sptr pack = AssetPack::Open(packPath);
+	if (pack == nullptr) {
+		LOG_WARN("Failed to mount asset pack \"{}\"", packPath);
+		return false;
+	}
+	LOG_INFO("Mounted asset pack \"{}\" with {} entries", packPath, pack->GetEntryCount());
+	std::lock_guard<std::mutex> guard(_lock);
+	_packs.push_back(pack);
+	return true;
+}
+
+void VirtualFileSystem::UnmountAll() {
+	std::lock_guard<std::mutex> guard(_lock);
+	_packs.clear();
+}
+
+bool VirtualFileSystem::Exists(const std::string& path) {
+	AssetPack::sptr pack;
+	if (_Find(path, pack) != nullptr) {
+		return true;
+	}
+	std::error_code error;
+	return std::filesystem::is_regular_file(path, error);
+}
+
+bool VirtualFileSystem::IsPacked(const std::string& path) {
+	AssetPack::sptr pack;
+	return _Find(path, pack) != nullptr;
+}
+
+bool VirtualFileSystem::Stat(const std::string& path, uint64_t& size, int64_t& time) {
+	AssetPack::sptr pack;
+	const AssetPackEntry* entry = _Find(path, pack);
+	if (entry != nullptr) {
+		size = entry->Size;
+		time = entry->SourceTime;
+		return true;
+	}
+
+	std::error_code error;
+	size = std::filesystem::file_size(path, error);
+	if (error) {
+		return false;
+	}
+	time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+	return !error;
+}
+
+VfsStats VirtualFileSystem::GetStats() {
+	VfsStats result;
+	{
+		std::lock_guard<std::mutex> guard(_lock);
+		result.MountedPacks = _packs.size();
+		result.PackedEntries = 0;
+		for (const AssetPack::sptr& pack : _packs) {
+			result.PackedEntries += pack->GetEntryCount();
+		}
+	}
+	result.StoredReads = _storedReads.load();
+	result.CompressedReads = _compressedReads.load();
+	result.LooseReads = _looseReads.load();
+	return result;
+}
+
+const AssetPackEntry* VirtualFileSystem::_Find(const std::string& path, AssetPack::sptr& pack) {
+	std::lock_guard<std::mutex> guard(_lock);
+	if (_packs.empty()) {
+		return nullptr;
+	}
+	const std::string normalized = AssetPack::NormalizePath(path);
+	for (auto it = _packs.rbegin(); it != _packs.rend(); ++it) {
+		const AssetPackEntry* entry = (*it)->Find(normalized);
+		if (entry != nullptr) {
+			pack = *it;
+			return entry;
+		}
+	}
+	return nullptr;
+}
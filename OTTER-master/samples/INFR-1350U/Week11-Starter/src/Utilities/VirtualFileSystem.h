@@ -0,0 +1,165 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AssetPack.h"
+#include "MemoryMappedFile.h"
+
+/// <summary>
+/// Statistics about where the virtual file system has been finding files
+/// </summary>
+struct VfsStats
+{
+	/// <summary>
+	/// The number of asset packs that are mounted
+	/// </summary>
+	size_t MountedPacks;
+	/// <summary>
+	/// The total number of entries in the mounted packs
+	/// </summary>
+	size_t PackedEntries;
+	/// <summary>
+	/// The number of files that were read out of packs without copying them
+	/// </summary>
+	size_t StoredReads;
+	/// <summary>
+	/// The number of files that were inflated out of packs
+	/// </summary>
+	size_t CompressedReads;
+	/// <summary>
+	/// The number of files that were read from disk because no pack had them
+	/// </summary>
+	size_t LooseReads;
+};
+
+/// <summary>
+/// A read-only view of a file's contents, opened through the VirtualFileSystem. This works like a MemoryMappedFile,
+/// but the data may come from a mounted asset pack (either pointing straight into the pack, or inflated into a
+/// buffer) or from a loose file on disk, so loaders can read from either without caring which
+/// </summary>
+class VfsFile final
+{
+public:
+	// We'll disallow moving and copying, since the data may point into our own buffer or mapping
+	VfsFile(const VfsFile& other) = delete;
+	VfsFile(VfsFile&& other) = delete;
+	VfsFile& operator=(const VfsFile& other) = delete;
+	VfsFile& operator=(VfsFile&& other) = delete;
+
+	/// <summary>
+	/// Creates a new file that is not yet bound to anything
+	/// </summary>
+	VfsFile();
+	/// <summary>
+	/// Creates a new file and attempts to open the given path, check IsOpen for the result
+	/// </summary>
+	/// <param name="path">The path of the file to open</param>
+	explicit VfsFile(const std::string& path);
+	~VfsFile() = default;
+
+	/// <summary>
+	/// Opens a file through the virtual file system, closing any file that was previously open
+	/// </summary>
+	/// <param name="path">The path of the file to open, relative to the working directory</param>
+	/// <returns>True if the file was found in a mounted pack or on disk, false if otherwise</returns>
+	bool Open(const std::string& path);
+	/// <summary>
+	/// Releases the file's data
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if the file was opened
+	/// </summary>
+	bool IsOpen() const { return _isOpen; }
+	/// <summary>
+	/// Returns true if the file was found in a mounted asset pack rather than on disk
+	/// </summary>
+	bool IsPacked() const { return _pack != nullptr; }
+	/// <summary>
+	/// Gets a pointer to the start of the file's contents
+	/// </summary>
+	const char* GetData() const { return _data; }
+	/// <summary>
+	/// Gets a pointer to one past the end of the file's contents
+	/// </summary>
+	const char* GetEnd() const { return _data + _size; }
+	/// <summary>
+	/// Gets the size of the file, in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+private:
+	// Keeps the pack mapped while we point into it
+	AssetPack::sptr   _pack;
+	// Used for loose files
+	MemoryMappedFile  _mapped;
+	// Used for entries that had to be inflated
+	std::vector<char> _buffer;
+	const char*       _data;
+	size_t            _size;
+	bool              _isOpen;
+};
+
+/// <summary>
+/// Lets loaders read files from mounted asset packs or from loose files on disk through the same interface. Packs
+/// are searched first (the most recently mounted first), so a deployment that ships a pack only ever maps that
+/// one file, and anything that isn't in a pack falls back to the disk. Paths are looked up relative to the working
+/// directory, so a pack built from the res folder with AssetPack::Write can be mounted from inside of it
+/// </summary>
+class VirtualFileSystem
+{
+public:
+	/// <summary>
+	/// Mounts an asset pack, so files in it can be found by VfsFile. Should be done before any loads are started
+	/// </summary>
+	/// <param name="packPath">The path of the pack to mount</param>
+	/// <returns>True if the pack was mounted, false if it could not be opened</returns>
+	static bool Mount(const std::string& packPath);
+	/// <summary>
+	/// Unmounts every pack. Files that are still open from the packs stay valid until they are closed
+	/// </summary>
+	static void UnmountAll();
+
+	/// <summary>
+	/// Checks if a file exists in a mounted pack or on disk
+	/// </summary>
+	static bool Exists(const std::string& path);
+	/// <summary>
+	/// Checks if a file will be read from a mounted pack rather than from the disk
+	/// </summary>
+	static bool IsPacked(const std::string& path);
+	/// <summary>
+	/// Gets the size and last write time of a file, for packed files this is the time of the original file when
+	/// it was packed. Returns false if the file could not be found
+	/// </summary>
+	static bool Stat(const std::string& path, uint64_t& size, int64_t& time);
+
+	/// <summary>
+	/// Gets the current statistics for the file system
+	/// </summary>
+	static VfsStats GetStats();
+
+protected:
+	VirtualFileSystem() = default;
+	~VirtualFileSystem() = default;
+
+	friend class VfsFile;
+
+	/// <summary>
+	/// Finds the newest mounted pack that contains a path
+	/// </summary>
+	/// <param name="path">The path to look for, this does not need to be normalized</param>
+	/// <param name="pack">Will be set to the pack that contains the path</param>
+	/// <returns>The entry for the path, or nullptr if no pack has it</returns>
+	static const AssetPackEntry* _Find(const std::string& path, AssetPack::sptr& pack);
+
+	static std::mutex _lock;
+	static std::vector<AssetPack::sptr> _packs;
+	static std::atomic<size_t> _storedReads;
+	static std::atomic<size_t> _compressedReads;
+	static std::atomic<size_t> _looseReads;
+};
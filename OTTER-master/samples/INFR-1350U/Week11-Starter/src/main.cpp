@@ -20,6 +20,10 @@
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
+#include "Benchmarks/AssetImportBenchmark.h"
+#include "Benchmarks/ObjLoaderBenchmark.h"
+#include "Benchmarks/TextureUploadBenchmark.h"
+#include "Benchmarks/VertexDedupBenchmark.h"
 #include "Behaviours/CameraControlBehaviour.h"
 #include "Behaviours/FollowPathBehaviour.h"
 #include "Behaviours/SimpleMoveBehaviour.h"
@@ -27,14 +31,23 @@
 #include "Gameplay/GameObjectTag.h"
 #include "Gameplay/IBehaviour.h"
 #include "Gameplay/Transform.h"
+#include "Graphics/PixelUploadRing.h"
 #include "Graphics/Texture2D.h"
 #include "Graphics/Texture2DData.h"
+#include "Graphics/UniformBuffer.h"
+#include "Utilities/AssetLoader.h"
+#include "Utilities/GltfLoader.h"
 #include "Utilities/InputHelpers.h"
 #include "Utilities/MeshBuilder.h"
 #include "Utilities/MeshFactory.h"
+#include "Utilities/MeshRegistry.h"
+#include "Utilities/TextureCooker.h"
+#include "Utilities/TextureRegistry.h"
+#include "Utilities/TextureStreamer.h"
 #include "Utilities/NotObjLoader.h"
 #include "Utilities/ObjLoader.h"
 #include "Utilities/VertexTypes.h"
+#include "Utilities/VirtualFileSystem.h"
 #include "Gameplay/Scene.h"
 #include "Gameplay/ShaderMaterial.h"
 #include "Gameplay/RendererComponent.h"
@@ -85,7 +98,7 @@ void GlfwWindowResizedCallback(GLFWwindow* window, int width, int height) {
 	});
 }
 
-bool InitGLFW() {
+bool InitGLFW(bool visible = true) {
 	if (glfwInit() == GLFW_FALSE) {
 		LOG_ERROR("Failed to initialize GLFW");
 		return false;
@@ -94,6 +107,7 @@ bool InitGLFW() {
 #ifdef _DEBUG
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
 #endif
+	glfwWindowHint(GLFW_VISIBLE, visible);
 	
 	//Create a new GLFW window
 	window = glfwCreateWindow(800, 800, "INFR1350U", nullptr, nullptr);
@@ -191,18 +205,118 @@ void RenderImGui() {
 	}
 }
 
-void RenderVAO(
+// The uniform block binding slot that the instance data for instanced draws is read from
+static constexpr GLuint InstanceBlockBinding = 0;
+// The most instances in one instanced draw, this must match MAX_INSTANCES in vertex_shader.glsl
+static constexpr size_t MaxInstances = 64;
+
+/// <summary>
+/// The per instance data for instanced draws, this must match the std140 layout of InstanceData in vertex_shader.glsl
+/// </summary>
+struct InstanceData
+{
+	glm::mat4  Model;
+	glm::mat4  NormalMatrix;
+	glm::ivec4 Layers;
+};
+
+void SetupModelUniforms(
 	const Shader::sptr& shader,
 	const VertexArrayObject::sptr& vao,
 	const glm::mat4& viewProjection,
 	const Transform& transform)
 {
-	shader->SetUniformMatrix("u_ModelViewProjection", viewProjection * transform.WorldTransform());
-	shader->SetUniformMatrix("u_Model", transform.WorldTransform()); 
+	// Meshes with quantized positions need to be scaled back into model space first, this doesn't affect the normals
+	const glm::mat4 model = transform.WorldTransform() * vao->GetVertexTransform();
+	shader->SetUniformMatrix("u_ModelViewProjection", viewProjection * model);
+	shader->SetUniformMatrix("u_Model", model); 
 	shader->SetUniformMatrix("u_NormalMatrix", transform.WorldNormalMatrix());
+	shader->SetUniform("u_OctahedralNormals", vao->GetHasOctahedralNormals() ? 1 : 0);
+	shader->SetUniform("u_QTangents", vao->GetHasQTangents() ? 1 : 0);
+}
+
+void RenderVAO(
+	const Shader::sptr& shader,
+	const VertexArrayObject::sptr& vao,
+	const glm::mat4& viewProjection,
+	const Transform& transform)
+{
+	SetupModelUniforms(shader, vao, viewProjection, transform);
 	vao->Render();
 }
 
+/// <summary>
+/// Draws a mesh once for each instance, in as few draws as the instance buffer allows. The model matrices and texture
+/// array layers come from the instance data instead of the model uniforms
+/// </summary>
+void RenderVAOInstanced(
+	const Shader::sptr& shader,
+	const VertexArrayObject::sptr& vao,
+	const UniformBuffer::sptr& instanceBuffer,
+	const std::vector<InstanceData>& instances)
+{
+	shader->SetUniform("u_OctahedralNormals", vao->GetHasOctahedralNormals() ? 1 : 0);
+	shader->SetUniform("u_QTangents", vao->GetHasQTangents() ? 1 : 0);
+	shader->SetUniform("u_Instanced", 1);
+	instanceBuffer->Bind(InstanceBlockBinding);
+	for (size_t first = 0; first < instances.size(); first += MaxInstances) {
+		const size_t count = std::min(MaxInstances, instances.size() - first);
+		instanceBuffer->UpdateData(instances.data() + first, 0, count * sizeof(InstanceData));
+		vao->RenderInstanced(static_cast<GLsizei>(count));
+	}
+	shader->SetUniform("u_Instanced", 0);
+}
+
+/// <summary>
+/// Gives an object the placeholder mesh, and swaps in the real mesh once it has finished loading in the background
+/// </summary>
+void SetMeshAsync(GameObject object, const AssetHandle<VertexArrayObject>::sptr& mesh) {
+	object.get<RendererComponent>().SetMesh(mesh->Get());
+	mesh->OnResident([object](const VertexArrayObject::sptr& vao) mutable {
+		if (object && object.has<RendererComponent>()) {
+			object.get<RendererComponent>().SetMesh(vao);
+		}
+	});
+}
+
+/// <summary>
+/// Gives an object the placeholder LOD set, and swaps in the real levels once they have finished loading in the background
+/// </summary>
+void SetLodsAsync(GameObject object, const AssetHandle<MeshLodSet>::sptr& lods) {
+	object.get<RendererComponent>().SetLods(lods->Get());
+	lods->OnResident([object](const MeshLodSet::sptr& set) mutable {
+		if (object && object.has<RendererComponent>()) {
+			object.get<RendererComponent>().SetLods(set);
+		}
+	});
+}
+
+/// <summary>
+/// Gives an object the placeholder meshlet set, and swaps in the real meshlets once they have finished loading in the background
+/// </summary>
+void SetMeshletsAsync(GameObject object, const AssetHandle<MeshletSet>::sptr& meshlets) {
+	object.get<RendererComponent>().SetMeshlets(meshlets->Get());
+	meshlets->OnResident([object](const MeshletSet::sptr& set) mutable {
+		if (object && object.has<RendererComponent>()) {
+			object.get<RendererComponent>().SetMeshlets(set);
+		}
+	});
+}
+
+/// <summary>
+/// Points a texture array sampler of each material at its slot in a set (the nth material gets the nth slot), and
+/// moves them over to the real arrays once they have finished loading in the background
+/// </summary>
+void SetTextureArraysAsync(const std::string& name, const std::vector<ShaderMaterial::sptr>& materials, const AssetHandle<TextureArraySet>::sptr& arrays) {
+	const auto setSlots = [name, materials](const TextureArraySet::sptr& set) {
+		for (size_t ix = 0; ix < materials.size() && ix < set->Slots.size(); ix++) {
+			materials[ix]->Set(name, set->Slots[ix]);
+		}
+	};
+	setSlots(arrays->Get());
+	arrays->OnResident(setSlots);
+}
+
 void SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection) {
 	shader->Bind();
 	// These are the uniforms that update only once per frame
@@ -213,9 +327,101 @@ void SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, cons
 	shader->SetUniform("u_CamPos", camPos);
 }
 
-int main() {
+int main(int argc, char** argv) {
 	Logger::Init(); // We'll borrow the logger from the toolkit, but we need to initialize it
 
+	// Benchmarks don't need a window or GL context, so we run them before we set anything up
+	// Usage: --bench-obj [directory]
+	if (argc > 1 && std::string(argv[1]) == "--bench-obj") {
+		ObjLoaderBenchmark::Run(argc > 2 ? argv[2] : "models");
+		Logger::Uninitialize();
+		return 0;
+	}
+	// Usage: --bench-dedup [directory]
+	if (argc > 1 && std::string(argv[1]) == "--bench-dedup") {
+		VertexDedupBenchmark::Run(argc > 2 ? argv[2] : "models");
+		Logger::Uninitialize();
+		return 0;
+	}
+	// Usage: --bench-obj-threads [file] [max threads]
+	if (argc > 1 && std::string(argv[1]) == "--bench-obj-threads") {
+		ObjLoaderBenchmark::RunThreadScaling(argc > 2 ? argv[2] : "models/plane.obj", argc > 3 ? std::atoi(argv[3]) : 0);
+		Logger::Uninitialize();
+		return 0;
+	}
+	// Usage: --bench-assets [directory] [output] [--upload] [--no-synthetic]
+	// This runs headless unless --upload is given, in which case we make a hidden window for the GL context
+	if (argc > 1 && std::string(argv[1]) == "--bench-assets") {
+		AssetImportBenchmarkOptions options;
+		std::vector<std::string> paths;
+		for (int ix = 2; ix < argc; ix++) {
+			const std::string arg = argv[ix];
+			if (arg == "--upload") {
+				options.Upload = true;
+			} else if (arg == "--no-synthetic") {
+				options.SyntheticScales.clear();
+			} else {
+				paths.push_back(arg);
+			}
+		}
+		if (paths.size() > 0) {
+			options.ResourceDirectory = paths[0];
+		}
+		if (options.Upload && !(InitGLFW(false) && InitGLAD())) {
+			Logger::Uninitialize();
+			return 1;
+		}
+		const bool written = AssetImportBenchmark::Run(options, paths.size() > 1 ? paths[1] : "asset_benchmark.json");
+		if (options.Upload) {
+			glfwTerminate();
+		}
+		Logger::Uninitialize();
+		return written ? 0 : 1;
+	}
+	// Usage: --bench-texture-upload [size] [iterations]
+	// Uploads need a GL context, so we make a hidden window for it
+	if (argc > 1 && std::string(argv[1]) == "--bench-texture-upload") {
+		if (!(InitGLFW(false) && InitGLAD())) {
+			Logger::Uninitialize();
+			return 1;
+		}
+		// The odd sized case is one texel smaller than the rest, so it needs at least 2 to have anything in it
+		const int size = argc > 2 ? std::max(std::atoi(argv[2]), 2) : 2048;
+		const int iterations = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 10;
+		TextureUploadBenchmark::Run(static_cast<uint32_t>(size), iterations);
+		glfwTerminate();
+		Logger::Uninitialize();
+		return 0;
+	}
+	// Usage: --cook-textures [directory] [--bc7]
+	// Run this before --pack, so the cooked textures end up in the pack
+	if (argc > 1 && std::string(argv[1]) == "--cook-textures") {
+		TextureCookOptions options;
+		std::string directory = ".";
+		for (int ix = 2; ix < argc; ix++) {
+			const std::string arg = argv[ix];
+			if (arg == "--bc7") {
+				options.HighQuality = true;
+			} else {
+				directory = arg;
+			}
+		}
+		TextureCooker::CookDirectory(directory, options);
+		Logger::Uninitialize();
+		return 0;
+	}
+	// Usage: --pack [directory] [output]
+	if (argc > 1 && std::string(argv[1]) == "--pack") {
+		const bool packed = AssetPack::Write(argc > 3 ? argv[3] : "res.pak", argc > 2 ? argv[2] : ".");
+		Logger::Uninitialize();
+		return packed ? 0 : 1;
+	}
+
+	// If our assets have been packed, everything gets read out of the pack instead of from loose files
+	if (std::filesystem::exists("res.pak")) {
+		VirtualFileSystem::Mount("res.pak");
+	}
+
 	//Initialize GLFW
 	if (!InitGLFW())
 		return 1;
@@ -237,6 +443,9 @@ int main() {
 	// Enable texturing
 	glEnable(GL_TEXTURE_2D);
 
+	// Textures loaded in the background get staged here by the loader threads, see AssetLoader::LoadTexture
+	PixelUploadRing::Init();
+
 	// Push another scope so most memory should be freed *before* we exit the app
 	{
 		#pragma region Shader and ImGui
@@ -246,6 +455,8 @@ int main() {
 		shader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
 		shader->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured.glsl", GL_FRAGMENT_SHADER);
 		shader->Link();
+		// The block binding is part of the program, so it only needs to be set once after linking
+		shader->SetUniformBlockBinding("b_Instances", InstanceBlockBinding);
 
 		glm::vec3 lightPos = glm::vec3(0.0f, 0.0f, 2.0f);
 		glm::vec3 lightCol = glm::vec3(0.9f, 0.85f, 0.5f);
@@ -387,17 +598,29 @@ int main() {
 
 		#pragma region TEXTURE LOADING
 
-		// Load some textures from files
-		Texture2D::sptr diffuse = Texture2D::LoadFromFile("images/Stone_001_Diffuse.png");
-		Texture2D::sptr bottle = Texture2D::LoadFromFile("images/BottleTex.png");
-		Texture2D::sptr table = Texture2D::LoadFromFile("images/Table.png");
-		Texture2D::sptr blackChess = Texture2D::LoadFromFile("images/blackChess.jpg");
-		Texture2D::sptr whiteChess = Texture2D::LoadFromFile("images/whiteChess.jpg");
-		Texture2D::sptr DunceSkin = Texture2D::LoadFromFile("images/SkinPNG.png");
-		Texture2D::sptr SliceOfCake = Texture2D::LoadFromFile("images/Slice of Cake.png");
-		Texture2D::sptr diffuse2 = Texture2D::LoadFromFile("images/box.bmp");
-		Texture2D::sptr specular = Texture2D::LoadFromFile("images/Stone_001_Specular.png");
-		Texture2D::sptr reflectivity = Texture2D::LoadFromFile("images/box-reflections.bmp");
+		// Load some textures from files, they all decode at once and upload in this order
+		const std::vector<AssetHandle<Texture2D>::sptr> textures = AssetLoader::LoadTextures({
+			"images/box.bmp"
+		});
+		Texture2D::sptr diffuse2 = textures[0]->Get();
+
+		// The stone specular and normal maps are streamed, they start out with only their smallest levels and load the
+		// rest once the objects using them are close enough to need them (see TextureStreamer). The stone diffuse is
+		// packed into the texture arrays below instead
+		Texture2D::sptr specular = TextureStreamer::Load("images/Stone_001_Specular.png");
+		Texture2D::sptr normalMap = TextureStreamer::Load("images/Stone_001_Normal.png");
+
+		// The diffuse textures for the textured shader get packed into texture arrays once they have loaded, so the
+		// materials below only differ by a layer where the images match, and objects using them can be instanced
+		const AssetHandle<TextureArraySet>::sptr diffuseArrays = AssetLoader::LoadTextureArrays({
+			"images/Stone_001_Diffuse.png",
+			"images/BottleTex.png",
+			"images/Table.png",
+			"images/blackChess.jpg",
+			"images/whiteChess.jpg",
+			"images/SkinPNG.png",
+			"images/Slice of Cake.png"
+		});
 
 		// Load the cube map
 		//TextureCubeMap::sptr environmentMap = TextureCubeMap::LoadFromImages("images/cubemaps/skybox/sample.jpg");
@@ -433,15 +656,15 @@ int main() {
 		// Create a material and set some properties for it
 		ShaderMaterial::sptr material0 = ShaderMaterial::Create();  
 		material0->Shader = shader;
-		material0->Set("s_Diffuse", diffuse);
 		material0->Set("s_Diffuse2", diffuse2);
 		material0->Set("s_Specular", specular);
+		material0->Set("s_NormalMap", normalMap);
+		material0->Set("u_NormalMapStrength", 1.0f);
 		material0->Set("u_Shininess", 8.0f);
 		material0->Set("u_TextureMix", 0.5f); 
 
 		ShaderMaterial::sptr material2 = ShaderMaterial::Create();//bottle material
 		material2->Shader = shader;
-		material2->Set("s_Diffuse", bottle);
 		material2->Set("s_Diffuse2", diffuse2);
 		material2->Set("s_Specular", specular);
 		material2->Set("u_Shininess", 8.0f);
@@ -449,7 +672,6 @@ int main() {
 
 		ShaderMaterial::sptr material3 = ShaderMaterial::Create();//table material
 		material3->Shader = shader;
-		material3->Set("s_Diffuse", table);
 		material3->Set("s_Diffuse2", diffuse2);
 		material3->Set("s_Specular", specular);
 		material3->Set("u_Shininess", 8.0f);
@@ -457,7 +679,6 @@ int main() {
 
 		ShaderMaterial::sptr material4 = ShaderMaterial::Create();//black material
 		material4->Shader = shader;
-		material4->Set("s_Diffuse", blackChess);
 		material4->Set("s_Diffuse2", diffuse2);
 		material4->Set("s_Specular", specular);
 		material4->Set("u_Shininess", 8.0f);
@@ -465,7 +686,6 @@ int main() {
 
 		ShaderMaterial::sptr material5 = ShaderMaterial::Create();//white material
 		material5->Shader = shader;
-		material5->Set("s_Diffuse", whiteChess);
 		material5->Set("s_Diffuse2", diffuse2);
 		material5->Set("s_Specular", specular);
 		material5->Set("u_Shininess", 8.0f);
@@ -473,7 +693,6 @@ int main() {
 
 		ShaderMaterial::sptr material6 = ShaderMaterial::Create();//dunce material
 		material6->Shader = shader;
-		material6->Set("s_Diffuse", DunceSkin);
 		material6->Set("s_Diffuse2", diffuse2);
 		material6->Set("s_Specular", specular);
 		material6->Set("u_Shininess", 8.0f);
@@ -481,53 +700,35 @@ int main() {
 
 		ShaderMaterial::sptr material7 = ShaderMaterial::Create();//cake material
 		material7->Shader = shader;
-		material7->Set("s_Diffuse", SliceOfCake);
 		material7->Set("s_Diffuse2", diffuse2);
 		material7->Set("s_Specular", specular);
 		material7->Set("u_Shininess", 8.0f);
 		material7->Set("u_TextureMix", 0.0f);
 
+		// The materials get their diffuse texture from the arrays, in the same order as the images were listed
+		SetTextureArraysAsync("s_Diffuse", { material0, material2, material3, material4, material5, material6, material7 }, diffuseArrays);
+
 		// Load a second material for our reflective material!
 		Shader::sptr reflectiveShader = Shader::Create();
 		reflectiveShader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
 		reflectiveShader->LoadShaderPartFromFile("shaders/frag_reflection.frag.glsl", GL_FRAGMENT_SHADER);
 		reflectiveShader->Link();
+		reflectiveShader->SetUniformBlockBinding("b_Instances", InstanceBlockBinding);
 
-		Shader::sptr reflective = Shader::Create();
-		reflective->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
-		reflective->LoadShaderPartFromFile("shaders/frag_blinn_phong_reflection.glsl", GL_FRAGMENT_SHADER);
-		reflective->Link();
-		
-		// 
-		ShaderMaterial::sptr material1 = ShaderMaterial::Create(); 
-		material1->Shader = reflective;
-		material1->Set("s_Diffuse", diffuse);
-		material1->Set("s_Diffuse2", diffuse2);
-		material1->Set("s_Specular", specular);
-		material1->Set("s_Reflectivity", reflectivity); 
-		material1->Set("s_Environment", environmentMap); 
-		material1->Set("u_LightPos", lightPos);
-		material1->Set("u_LightCol", lightCol);
-		material1->Set("u_AmbientLightStrength", lightAmbientPow); 
-		material1->Set("u_SpecularLightStrength", lightSpecularPow); 
-		material1->Set("u_AmbientCol", ambientCol);
-		material1->Set("u_AmbientStrength", ambientPow);
-		material1->Set("u_LightAttenuationConstant", 1.0f);
-		material1->Set("u_LightAttenuationLinear", lightLinearFalloff);
-		material1->Set("u_LightAttenuationQuadratic", lightQuadraticFalloff);
-		material1->Set("u_Shininess", 8.0f);
-		material1->Set("u_TextureMix", 0.5f);
-		material1->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(90.0f), glm::radians(90.0f), glm::vec3(0, 0, 1))));
-		
 		ShaderMaterial::sptr reflectiveMat = ShaderMaterial::Create();
 		reflectiveMat->Shader = reflectiveShader;
 		reflectiveMat->Set("s_Environment", environmentMap);
 		reflectiveMat->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(90.0f), glm::radians(90.0f), glm::vec3(1, 0, 0))));
 
+		// Our props are small, so we can store them with 16 bit positions and packed attributes (20 bytes per vertex instead of 48)
+		ObjLoadOptions propLoadOptions;
+		propLoadOptions.Format = VertexFormat::Quantized;
+
 		GameObject sceneObj = scene->CreateEntity("Table"); 
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Table.obj");
-			sceneObj.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material3);
+			// The table is streamed in slices like our large meshes would be, so that path gets exercised every run
+			sceneObj.emplace<RendererComponent>().SetMaterial(material3);
+			SetMeshAsync(sceneObj, AssetLoader::StreamObj("models/Table.obj", propLoadOptions));
 			sceneObj.get<Transform>().SetLocalPosition(0.0f, -4.0f, -4.0f);
 			sceneObj.get<Transform>().SetLocalScale(2.0f, 2.0f, 2.0f);
 			sceneObj.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -535,8 +736,8 @@ int main() {
 
 		GameObject obj2 = scene->CreateEntity("waterBottle");//left one
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/waterBottle.obj");
-			obj2.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material2);
+			obj2.emplace<RendererComponent>().SetMaterial(material2);
+			SetMeshAsync(obj2, AssetLoader::LoadObj("models/waterBottle.obj", propLoadOptions));
 			obj2.get<Transform>().SetLocalPosition(3.0f, -4.0f, 0.5f);
 			obj2.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(obj2);
@@ -544,8 +745,8 @@ int main() {
 
 		GameObject obj3 = scene->CreateEntity("chessPawn");//fallen one
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj3.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material5);
+			obj3.emplace<RendererComponent>().SetMaterial(material5);
+			SetLodsAsync(obj3, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj3.get<Transform>().SetLocalPosition(2.0f, 0.0f, 0.6f);
 			obj3.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj3.get<Transform>().SetLocalRotation(355.0f, 0.0f, 0.0f);
@@ -555,8 +756,8 @@ int main() {
 
 		GameObject obj5 = scene->CreateEntity("chessPawn2");//first upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj5.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material5);
+			obj5.emplace<RendererComponent>().SetMaterial(material5);
+			SetLodsAsync(obj5, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj5.get<Transform>().SetLocalPosition(2.0f, -0.6f, 0.5f);
 			obj5.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj5.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -565,8 +766,8 @@ int main() {
 
 		GameObject obj8 = scene->CreateEntity("chessPawn3");//second fallen
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj8.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material4);
+			obj8.emplace<RendererComponent>().SetMaterial(material4);
+			SetLodsAsync(obj8, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj8.get<Transform>().SetLocalPosition(-2.0f, 0.3f, 0.7f);
 			obj8.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj8.get<Transform>().SetLocalRotation(355.0f, 0.0f, 90.0f);
@@ -576,8 +777,8 @@ int main() {
 
 		GameObject obj9 = scene->CreateEntity("chessPawn4");//third upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj9.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material4);
+			obj9.emplace<RendererComponent>().SetMaterial(material4);
+			SetLodsAsync(obj9, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj9.get<Transform>().SetLocalPosition(-2.0f, -0.6f, 0.5f);
 			obj9.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj9.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -586,8 +787,8 @@ int main() {
 
 		GameObject obj10 = scene->CreateEntity("chessPawn5");//fourth upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj10.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material5);
+			obj10.emplace<RendererComponent>().SetMaterial(material5);
+			SetLodsAsync(obj10, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj10.get<Transform>().SetLocalPosition(2.0f, -1.6f, 0.5f);
 			obj10.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj10.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -597,8 +798,8 @@ int main() {
 
 		GameObject obj11 = scene->CreateEntity("chessPawn6");//fifth upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj11.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material4);
+			obj11.emplace<RendererComponent>().SetMaterial(material4);
+			SetLodsAsync(obj11, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj11.get<Transform>().SetLocalPosition(-2.0f, -1.6f, 0.5f);
 			obj11.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj11.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -607,8 +808,8 @@ int main() {
 
 		GameObject obj12 = scene->CreateEntity("chessPawn7");//sixth upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj12.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material5);
+			obj12.emplace<RendererComponent>().SetMaterial(material5);
+			SetLodsAsync(obj12, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj12.get<Transform>().SetLocalPosition(1.3f, -1.6f, 0.5f);
 			obj12.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj12.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -618,8 +819,8 @@ int main() {
 
 		GameObject obj13 = scene->CreateEntity("chessPawn8");//eigth upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj13.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material4);
+			obj13.emplace<RendererComponent>().SetMaterial(material4);
+			SetLodsAsync(obj13, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj13.get<Transform>().SetLocalPosition(-1.3f, -1.6f, 0.5f);
 			obj13.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj13.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -628,8 +829,8 @@ int main() {
 
 		GameObject obj14 = scene->CreateEntity("chessPawn9");//ninth upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj14.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material5);
+			obj14.emplace<RendererComponent>().SetMaterial(material5);
+			SetLodsAsync(obj14, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj14.get<Transform>().SetLocalPosition(1.3f, -0.6f, 0.5f);
 			obj14.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj14.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -639,8 +840,8 @@ int main() {
 
 		GameObject obj15 = scene->CreateEntity("chessPawn10");//tenth upright
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/ChessPawn.obj");
-			obj15.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material4);
+			obj15.emplace<RendererComponent>().SetMaterial(material4);
+			SetLodsAsync(obj15, AssetLoader::LoadObjLods("models/ChessPawn.obj", MeshLodOptions(), propLoadOptions));
 			obj15.get<Transform>().SetLocalPosition(-1.3f, -0.6f, 0.5f);
 			obj15.get<Transform>().SetLocalScale(0.15f, 0.15f, 0.15f);
 			obj15.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
@@ -649,8 +850,8 @@ int main() {
 
 		GameObject obj7 = scene->CreateEntity("waterBottle2");//right one
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/waterBottle.obj");
-			obj7.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material2);
+			obj7.emplace<RendererComponent>().SetMaterial(material2);
+			SetMeshAsync(obj7, AssetLoader::LoadObj("models/waterBottle.obj", propLoadOptions));
 			obj7.get<Transform>().SetLocalPosition(-4.0f, -4.0f, 0.5f);
 			obj7.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(obj7);
@@ -659,9 +860,8 @@ int main() {
 		GameObject obj4 = scene->CreateEntity("Rolling Water");
 		{
 			// Build a mesh
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/waterBottle.obj");
-			
-			obj4.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material2);
+			obj4.emplace<RendererComponent>().SetMaterial(material2);
+			SetMeshAsync(obj4, AssetLoader::LoadObj("models/waterBottle.obj", propLoadOptions));
 			obj4.get<Transform>().SetLocalPosition(-2.0f, 0.0f, 1.0f);
 
 			// Bind returns a smart pointer to the behaviour that was added
@@ -674,8 +874,8 @@ int main() {
 
 		GameObject obj6 = scene->CreateEntity("Jumping Dunce");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Dunce.obj");
-			obj6.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material6);
+			obj6.emplace<RendererComponent>().SetMaterial(material6);
+			SetLodsAsync(obj6, AssetLoader::LoadObjLods("models/Dunce.obj", MeshLodOptions(), propLoadOptions));
 			obj6.get<Transform>().SetLocalPosition(-7.0f, -2.0f, 3.0f);
 			obj6.get<Transform>().SetLocalScale(1.5f, 1.5f, 1.5f);
 			obj6.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
@@ -689,12 +889,36 @@ int main() {
 
 		GameObject obj16 = scene->CreateEntity("cake");//left one
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/SliceofCake.obj");
-			obj16.emplace<RendererComponent>().SetMesh(vao).SetMaterial(material7);
+			obj16.emplace<RendererComponent>().SetMaterial(material7);
+			SetMeshAsync(obj16, AssetLoader::LoadObj("models/SliceofCake.obj", propLoadOptions));
 			obj16.get<Transform>().SetLocalPosition(0.0f, -7.0f, 1.2f);
 			obj16.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(obj16);
 		}
+
+		// A small glTF scene, the two crates share one mesh and neither primitive has vertex colors, so they get
+		// their material's base color. glTF is Y-up, so the root gets turned to fit our Z-up scene
+		try {
+			GltfLoadOptions gltfOptions;
+			gltfOptions.Shader = shader;
+			GameObject crates = GltfLoader::LoadScene(scene, "models/crates.glb", gltfOptions);
+			crates.get<Transform>().SetLocalPosition(4.5f, -6.0f, 0.2f);
+			crates.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
+		} catch (const std::exception& e) {
+			LOG_WARN("{}", e.what());
+		}
+
+		GameObject ground = scene->CreateEntity("Ground");
+		{
+			// The floor is a dense grid that mostly sits off screen, so it gets split into meshlets that can be culled.
+			// It's the only normal mapped surface, so it's also the only mesh that needs tangents
+			ObjLoadOptions groundLoadOptions;
+			groundLoadOptions.Format = VertexFormat::QTangent;
+			ground.emplace<RendererComponent>().SetMaterial(material0);
+			SetMeshletsAsync(ground, AssetLoader::LoadObjMeshlets("models/plane.obj", groundLoadOptions));
+			ground.get<Transform>().SetLocalPosition(0.0f, 0.0f, -6.0f);
+			ground.get<Transform>().SetLocalScale(40.0f, 40.0f, 1.0f);
+		}
 		
 		// Create an object to be our camera
 		GameObject cameraObject = scene->CreateEntity("Camera");
@@ -711,6 +935,190 @@ int main() {
 			BehaviourBinding::Bind<CameraControlBehaviour>(cameraObject);
 		}
 
+		// Our props are loading in the background, they'll pop in over the first few frames as they get uploaded
+		int uploadBudgetMs = static_cast<int>(AssetLoader::GetUploadBudgetMs());
+		int uploadBudgetMb = static_cast<int>(AssetLoader::GetUploadBudgetBytes() / (1024 * 1024));
+		imGuiCallbacks.push_back([&]() {
+			if (ImGui::CollapsingHeader("Asset Loader"))
+			{
+				AssetLoaderStats stats = AssetLoader::GetStats();
+				ImGui::Text("Worker threads: %zu", stats.ThreadCount);
+				ImGui::Text("Queued: %zu, Loading: %zu", stats.QueuedJobs, stats.ActiveJobs);
+				ImGui::Text("Pending uploads: %zu (%.2f MB)", stats.PendingUploads, stats.PendingUploadBytes / (1024.0f * 1024.0f));
+				ImGui::Text("Last frame: %zu uploads, %.2f MB in %.3f ms", stats.FrameUploads, stats.FrameUploadBytes / (1024.0f * 1024.0f), stats.FrameUploadMs);
+				ImGui::Text("Loaded: %zu, Failed: %zu", stats.Loaded, stats.Failed);
+				PixelUploadRingStats ringStats = PixelUploadRing::GetStats();
+				ImGui::Text("Upload ring: %.2f / %.2f MB in %zu regions", ringStats.BytesInUse / (1024.0f * 1024.0f),
+					ringStats.Capacity / (1024.0f * 1024.0f), ringStats.LiveRegions);
+				ImGui::Text("Through the ring: %.2f MB, %zu misses", ringStats.UploadedBytes / (1024.0f * 1024.0f), ringStats.Misses);
+				bool changed = ImGui::SliderInt("Budget (ms)", &uploadBudgetMs, 1, 16);
+				changed |= ImGui::SliderInt("Budget (MB)", &uploadBudgetMb, 1, 64);
+				if (changed) {
+					AssetLoader::SetUploadBudget(static_cast<float>(uploadBudgetMs), static_cast<size_t>(uploadBudgetMb) * 1024 * 1024);
+				}
+			}
+		});
+
+		imGuiCallbacks.push_back([]() {
+			if (ImGui::CollapsingHeader("Asset Packs"))
+			{
+				VfsStats stats = VirtualFileSystem::GetStats();
+				ImGui::Text("Mounted packs: %zu (%zu entries)", stats.MountedPacks, stats.PackedEntries);
+				ImGui::Text("Reads: %zu stored, %zu inflated, %zu loose", stats.StoredReads, stats.CompressedReads, stats.LooseReads);
+				ImGui::TextWrapped("Run with --pack to bundle the res folder into res.pak, it will be mounted on the next launch");
+			}
+		});
+
+		imGuiCallbacks.push_back([]() {
+			if (ImGui::CollapsingHeader("Mesh Registry"))
+			{
+				MeshRegistryStats stats = MeshRegistry::GetStats();
+				ImGui::Text("Hits: %zu", stats.Hits);
+				ImGui::Text("Misses: %zu", stats.Misses);
+				ImGui::Text("Resident meshes: %zu", stats.ResidentMeshes);
+				ImGui::Text("References: %zu", stats.References);
+				if (ImGui::Button("Reset Stats")) {
+					MeshRegistry::ResetStats();
+				}
+			}
+		});
+
+		imGuiCallbacks.push_back([]() {
+			if (ImGui::CollapsingHeader("Texture Registry"))
+			{
+				TextureRegistryStats stats = TextureRegistry::GetStats();
+				ImGui::Text("Hits: %zu", stats.Hits);
+				ImGui::Text("Misses: %zu", stats.Misses);
+				ImGui::Text("Resident textures: %zu", stats.ResidentTextures);
+				ImGui::Text("References: %zu", stats.References);
+				ImGui::Text("Resident memory: %.2f MB", stats.ResidentBytes / (1024.0f * 1024.0f));
+				for (const TextureRegistryEntry& entry : TextureRegistry::GetResidentTextures()) {
+					ImGui::BulletText("%s (%ux%u, %.2f MB, %zu refs)", entry.Path.c_str(), entry.Width, entry.Height,
+						entry.ResidentBytes / (1024.0f * 1024.0f), entry.References);
+				}
+				if (ImGui::Button("Reset Stats##TextureRegistry")) {
+					TextureRegistry::ResetStats();
+				}
+			}
+		});
+
+		// Level of detail controls, the triangle counts get filled in by the render loop each frame
+		bool   lodSelectionEnabled = true;
+		int    lodForcedLevel = -1;
+		size_t lodFullTriangles = 0;
+		size_t lodDrawnTriangles = 0;
+		imGuiCallbacks.push_back([&]() {
+			if (ImGui::CollapsingHeader("Levels of Detail"))
+			{
+				ImGui::Checkbox("Automatic Selection", &lodSelectionEnabled);
+				ImGui::SliderInt("Force Level", &lodForcedLevel, -1, 3);
+				const float saved = lodFullTriangles > 0 ? 100.0f * (1.0f - (float)lodDrawnTriangles / (float)lodFullTriangles) : 0.0f;
+				ImGui::Text("Triangles: %zu / %zu (%.1f%% saved)", lodDrawnTriangles, lodFullTriangles, saved);
+				ImGui::Separator();
+				scene->Registry().view<RendererComponent, GameObjectTag>().each([](entt::entity entity, RendererComponent& renderer, GameObjectTag& tag) {
+					if (renderer.Lods != nullptr) {
+						ImGui::Text("%s: LOD %zu (%zu tris)", tag.Name.c_str(), renderer.CurrentLod, renderer.Lods->GetLevel(renderer.CurrentLod).TriangleCount);
+					}
+				});
+			}
+		});
+
+		// Meshlet culling controls, the counts get filled in by the render loop each frame
+		bool   meshletCullingEnabled = true;
+		bool   meshletFrustumCulling = true;
+		bool   meshletBackfaceCulling = true;
+		size_t meshletTotal = 0;
+		size_t meshletVisible = 0;
+		size_t meshletTotalTriangles = 0;
+		size_t meshletVisibleTriangles = 0;
+		size_t meshletDraws = 0;
+		MeshletDrawList meshletDrawList;
+		imGuiCallbacks.push_back([&]() {
+			if (ImGui::CollapsingHeader("Meshlets"))
+			{
+				ImGui::Checkbox("Enabled", &meshletCullingEnabled);
+				ImGui::Checkbox("Frustum Culling", &meshletFrustumCulling);
+				ImGui::Checkbox("Backface Culling", &meshletBackfaceCulling);
+				ImGui::Text("Meshlets: %zu / %zu in %zu draws", meshletVisible, meshletTotal, meshletDraws);
+				const float culled = meshletTotalTriangles > 0 ? 100.0f * (1.0f - (float)meshletVisibleTriangles / (float)meshletTotalTriangles) : 0.0f;
+				ImGui::Text("Triangles: %zu / %zu (%.1f%% culled)", meshletVisibleTriangles, meshletTotalTriangles, culled);
+			}
+		});
+
+		// Objects with the same mesh, whose materials only differ by their texture array layers, get merged into
+		// instanced draws. The counts get filled in by the render loop each frame
+		bool   instancingEnabled = true;
+		size_t drawCalls = 0;
+		size_t instancedDraws = 0;
+		size_t instancedObjects = 0;
+		size_t materialApplies = 0;
+		size_t layerSwitches = 0;
+		UniformBuffer::sptr instanceBuffer = UniformBuffer::Create();
+		instanceBuffer->AllocateStorage(sizeof(InstanceData), MaxInstances);
+		// Shaders with the instance block need a buffer behind it even when they aren't drawing instances
+		instanceBuffer->Bind(InstanceBlockBinding);
+		std::vector<InstanceData> instances;
+		instances.reserve(MaxInstances);
+		imGuiCallbacks.push_back([&]() {
+			if (ImGui::CollapsingHeader("Texture Arrays"))
+			{
+				const TextureArraySet::sptr& set = diffuseArrays->Get();
+				ImGui::Text("Diffuse arrays: %zu (%.2f MB)%s", set->Arrays.size(), set->GetResidentBytes() / (1024.0f * 1024.0f),
+					diffuseArrays->IsResident() ? "" : ", loading");
+				for (const Texture2DArray::sptr& array : set->Arrays) {
+					ImGui::BulletText("%ux%u %s, %u layers", array->GetWidth(), array->GetHeight(), (~array->GetFormat()).c_str(), array->GetLayerCount());
+				}
+				ImGui::Checkbox("Instanced Batching", &instancingEnabled);
+				ImGui::Text("Draw calls: %zu (%zu instanced, covering %zu objects)", drawCalls, instancedDraws, instancedObjects);
+				ImGui::Text("Material applies: %zu, layer only switches: %zu", materialApplies, layerSwitches);
+			}
+		});
+
+		// Streamed textures get the levels that match how large the objects using them are on screen, turning the
+		// density requests off asks for every level instead
+		bool textureDensityEnabled = true;
+		imGuiCallbacks.push_back([&]() {
+			if (ImGui::CollapsingHeader("Texture Streaming"))
+			{
+				TextureStreamerStats stats = TextureStreamer::GetStats();
+				int budgetMb = static_cast<int>(stats.BudgetBytes / (1024 * 1024));
+				if (ImGui::SliderInt("Budget (MB)", &budgetMb, 1, 256)) {
+					TextureStreamer::SetBudget(static_cast<size_t>(budgetMb) * 1024 * 1024);
+				}
+				float lodBias = TextureStreamer::GetLodBias();
+				if (ImGui::SliderFloat("LOD Bias", &lodBias, -2.0f, 4.0f)) {
+					TextureStreamer::SetLodBias(lodBias);
+				}
+				float fadeRate = TextureStreamer::GetFadeRate();
+				if (ImGui::SliderFloat("Fade Rate (levels/s)", &fadeRate, 0.0f, 16.0f)) {
+					TextureStreamer::SetFadeRate(fadeRate);
+				}
+				ImGui::Checkbox("Texel Density Requests", &textureDensityEnabled);
+
+				const float residentMb = stats.ResidentBytes / (1024.0f * 1024.0f);
+				const float budget = stats.BudgetBytes / (1024.0f * 1024.0f);
+				char usage[64];
+				snprintf(usage, sizeof(usage), "%.2f / %.2f MB", residentMb, budget);
+				ImGui::ProgressBar(budget > 0.0f ? residentMb / budget : 0.0f, ImVec2(-1.0f, 0.0f), usage);
+				ImGui::Text("Wanted: %.2f MB across %zu textures", stats.WantedBytes / (1024.0f * 1024.0f), stats.StreamedTextures);
+				ImGui::Text("Pending loads: %zu, levels loaded: %zu, evicted: %zu", stats.PendingLoads, stats.LevelsLoaded, stats.LevelsEvicted);
+				ImGui::Separator();
+				for (const StreamedTextureInfo& info : TextureStreamer::GetTextures()) {
+					if (info.LevelCount == 0) {
+						ImGui::BulletText("%s (loading tail)", info.Path.c_str());
+						continue;
+					}
+					ImGui::BulletText("%s (%ux%u)", info.Path.c_str(), info.Width, info.Height);
+					ImGui::Indent();
+					ImGui::Text("Level %u of %u resident (%ux%u), wants %u%s", info.ResidentLevel, info.LevelCount,
+						std::max(info.Width >> info.ResidentLevel, 1u), std::max(info.Height >> info.ResidentLevel, 1u),
+						info.WantedLevel, info.Loading ? ", loading" : "");
+					ImGui::Text("%.2f / %.2f MB", info.ResidentBytes / (1024.0f * 1024.0f), info.FullBytes / (1024.0f * 1024.0f));
+					ImGui::Unindent();
+				}
+			}
+		});
+
 		#pragma endregion 
 		//////////////////////////////////////////////////////////////////////////////////////////
 
@@ -783,6 +1191,9 @@ int main() {
 		while (!glfwWindowShouldClose(window)) {
 			glfwPollEvents();
 
+			// Upload anything that has finished loading in the background, this will swap out placeholders
+			AssetLoader::Update();
+
 			// Update the timing
 			time.CurrentFrame = glfwGetTime();
 			time.DeltaTime = static_cast<float>(time.CurrentFrame - time.LastFrame);
@@ -831,7 +1242,51 @@ int main() {
 			glm::mat4 view = glm::inverse(camTransform.LocalTransform());
 			glm::mat4 projection = cameraObject.get<Camera>().GetProjection();
 			glm::mat4 viewProjection = projection * view;
+			glm::vec3 cameraPos = glm::vec3(camTransform.LocalTransform()[3]);
+			// The meshlet cone test assumes a perspective camera, orthographic ones look along one direction everywhere
+			const bool meshletBackface = meshletBackfaceCulling && !cameraObject.get<Camera>().GetIsOrtho();
 						
+			lodFullTriangles = 0;
+			lodDrawnTriangles = 0;
+			meshletTotal = 0;
+			meshletVisible = 0;
+			meshletTotalTriangles = 0;
+			meshletVisibleTriangles = 0;
+			meshletDraws = 0;
+			drawCalls = 0;
+			instancedDraws = 0;
+			instancedObjects = 0;
+			materialApplies = 0;
+			layerSwitches = 0;
+
+			int viewportWidth, viewportHeight;
+			glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
+
+			// Pick the level of detail based on how big each object is on screen. This happens before sorting, so that
+			// objects drawing the same level of the same mesh end up next to each other and can be instanced
+			renderGroup.each([&](entt::entity e, RendererComponent& renderer, Transform& transform) {
+				if (renderer.Lods != nullptr) {
+					if (lodForcedLevel >= 0) {
+						renderer.SetLod(static_cast<size_t>(lodForcedLevel));
+					} else if (lodSelectionEnabled) {
+						renderer.SelectLod(transform.WorldTransform(), view, projection);
+					} else {
+						renderer.SetLod(0);
+					}
+					lodFullTriangles += renderer.Lods->GetLevel(0).TriangleCount;
+					lodDrawnTriangles += renderer.Lods->GetLevel(renderer.CurrentLod).TriangleCount;
+				}
+
+				// Streamed textures ask for the level that has about one texel per pixel the object covers
+				const float screenPixels = textureDensityEnabled ?
+					renderer.GetProjectedSize(transform.WorldTransform(), view, projection) * viewportHeight :
+					std::numeric_limits<float>::max();
+				for (const auto& [name, texture] : renderer.Material->Textures) {
+					TextureStreamer::Request(texture, screenPixels);
+				}
+			});
+			TextureStreamer::Update(time.DeltaTime);
+
 			// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
 			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
 			renderGroup.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
@@ -843,6 +1298,16 @@ int main() {
 				if (l.Material->Shader < r.Material->Shader) return true;
 				if (l.Material->Shader > r.Material->Shader) return false;
 
+				// Then by batch key, so materials that only differ by their texture array layers run sequentially
+				const size_t lKey = l.Material->GetBatchKey();
+				const size_t rKey = r.Material->GetBatchKey();
+				if (lKey < rKey) return true;
+				if (lKey > rKey) return false;
+
+				// Then by mesh, so objects that can be drawn as instances of one draw are next to each other
+				if (l.Mesh < r.Mesh) return true;
+				if (l.Mesh > r.Mesh) return false;
+
 				// Sort by material pointer last (so we can minimize switching between materials)
 				if (l.Material < r.Material) return true;
 				if (l.Material > r.Material) return false;
@@ -850,26 +1315,85 @@ int main() {
 				return false;
 			});
 
+			// Gather up the draws in sorted order, so we can look ahead for objects to merge into instanced draws
+			std::vector<std::pair<RendererComponent*, Transform*>> draws;
+			draws.reserve(renderGroup.size());
+			renderGroup.each([&](entt::entity e, RendererComponent& renderer, Transform& transform) {
+				draws.push_back({ &renderer, &transform });
+			});
+			// Meshlets get culled per object, so only objects that draw their whole mesh can be instanced. Meshes with
+			// per-instance attributes (ex: glTF base colours) would read the wrong element for every instance after the first
+			const auto canInstance = [&](const RendererComponent& l, const RendererComponent& r) {
+				return instancingEnabled && l.Mesh == r.Mesh && !l.Mesh->HasInstancedAttributes() &&
+					(l.Meshlets == nullptr || !meshletCullingEnabled) && (r.Meshlets == nullptr || !meshletCullingEnabled) &&
+					(l.Material == r.Material || l.Material->CanBatchWith(*r.Material));
+			};
+
 			// Start by assuming no shader or material is applied
 			Shader::sptr current = nullptr;
 			ShaderMaterial::sptr currentMat = nullptr;
 
-			// Iterate over the render group components and draw them
-			renderGroup.each( [&](entt::entity e, RendererComponent& renderer, Transform& transform) {
+			// Iterate over the draws and render them
+			for (size_t ix = 0; ix < draws.size();) {
+				RendererComponent& renderer = *draws[ix].first;
+				Transform& transform = *draws[ix].second;
+				size_t end = ix + 1;
+				while (end < draws.size() && canInstance(renderer, *draws[end].first)) {
+					end++;
+				}
+
 				// If the shader has changed, set up it's uniforms
 				if (current != renderer.Material->Shader) {
 					current = renderer.Material->Shader;
 					current->Bind();
 					SetupShaderForFrame(current, view, projection);
 				}
-				// If the material has changed, apply it
+				// If the material has changed, apply it. Materials that only differ by their layers leave everything
+				// else bound, so switching between them is a single uniform
 				if (currentMat != renderer.Material) {
+					if (currentMat != nullptr && currentMat->CanBatchWith(*renderer.Material)) {
+						renderer.Material->ApplyLayers();
+						layerSwitches++;
+					} else {
+						renderer.Material->Apply();
+						materialApplies++;
+					}
 					currentMat = renderer.Material;
-					currentMat->Apply();
 				}
-				// Render the mesh
-				RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-			});
+
+				// Render the mesh, skipping any meshlets that can't be seen
+				if (end - ix > 1) {
+					instances.clear();
+					for (size_t instance = ix; instance < end; instance++) {
+						const RendererComponent& other = *draws[instance].first;
+						const Transform& otherTransform = *draws[instance].second;
+						instances.push_back({
+							otherTransform.WorldTransform() * other.Mesh->GetVertexTransform(),
+							glm::mat4(otherTransform.WorldNormalMatrix()),
+							other.Material->GetLayers()
+						});
+					}
+					RenderVAOInstanced(renderer.Material->Shader, renderer.Mesh, instanceBuffer, instances);
+					const size_t calls = (instances.size() + MaxInstances - 1) / MaxInstances;
+					drawCalls += calls;
+					instancedDraws += calls;
+					instancedObjects += instances.size();
+				} else if (renderer.Meshlets != nullptr && meshletCullingEnabled) {
+					renderer.Meshlets->Cull(transform.WorldTransform(), viewProjection, cameraPos, meshletFrustumCulling, meshletBackface, meshletDrawList);
+					meshletTotal += renderer.Meshlets->GetMeshletCount();
+					meshletVisible += meshletDrawList.VisibleMeshlets;
+					meshletTotalTriangles += renderer.Meshlets->GetTriangleCount();
+					meshletVisibleTriangles += meshletDrawList.VisibleTriangles;
+					meshletDraws += meshletDrawList.Counts.size();
+					SetupModelUniforms(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
+					renderer.Meshlets->Render(meshletDrawList);
+					drawCalls++;
+				} else {
+					RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
+					drawCalls++;
+				}
+				ix = end;
+			}
 
 			// Draw our ImGui content
 			RenderImGui();
@@ -879,8 +1403,15 @@ int main() {
 			time.LastFrame = time.CurrentFrame;
 		}
 
+		// Stop loading before the scene goes away, so no callbacks try to touch it
+		AssetLoader::Shutdown();
+
 		// Nullify scene so that we can release references
 		Application::Instance().ActiveScene = nullptr;
+		MeshRegistry::Clear();
+		TextureRegistry::Clear();
+		TextureStreamer::Clear();
+		PixelUploadRing::Shutdown();
 		ShutdownImGui();
 	}	
 